@@ -0,0 +1,82 @@
+/*************************************************************
+******************** ANIMATION CONTAINER *********************
+**************************************************************/
+
+/*
+On-flash animation format, written by OTA upload and the host tools:
+ - AnimHeader, then payloadBytes of frame data
+ - ANIM_ENC_RAW565: frameCount frames of width*height RGB565 pixels each,
+   in the same byte order as the nyancat[] arrays (native little-endian)
+ - ANIM_ENC_RLE565: frameCount + 1 uint32 offsets (relative to the payload
+   start, the last one is the end), then each frame as an RLE565 stream
+   (rle565.h) of the same native-order pixels; frameBytes is still the
+   decoded size
+ - ANIM_ENC_PAL8 (version 2): a palette of ANIM_PALETTE_SIZE RGB565 colours,
+   then frameCount frames of width*height one-byte palette indices (half
+   the size of RAW565; tools/anim_import --pal8 builds the palette)
+ - ANIM_FLAG_DURATIONS (version 2): the payload ends with frameCount uint16
+   display times in milliseconds, one per frame (offsets and frame sizes
+   above are unchanged, they just stop before the table). Without it every
+   frame lasts one loop() iteration
+ - headerCrc32 covers the header up to that field, payloadCrc32 the payload
+
+Version 1 containers (no flags) are still accepted.
+
+Plain C++ (no Arduino dependencies) so the host tools share it.
+*/
+
+#pragma once
+
+#include <stdint.h>
+#include <stddef.h>
+
+const uint16_t ANIM_VERSION = 2;
+const uint16_t ANIM_VERSION_MIN = 1;   // oldest version still accepted
+
+// Header flags
+const uint8_t ANIM_FLAG_DURATIONS = 0x01; // per-frame durations table at the end of the payload
+
+// Frame encodings
+const uint8_t ANIM_ENC_RAW565 = 0; // uncompressed native-order RGB565
+const uint8_t ANIM_ENC_RLE565 = 1; // offset table + RLE565 frames
+const uint8_t ANIM_ENC_PAL8 = 2;   // RGB565 palette + 8-bit indexed frames
+
+const uint16_t ANIM_PALETTE_SIZE = 256;
+const uint32_t ANIM_PALETTE_BYTES = ANIM_PALETTE_SIZE * 2;
+
+struct __attribute__((packed)) AnimHeader {
+  char magic[4];         // "NYAN"
+  uint16_t version;      // ANIM_VERSION
+  uint16_t headerSize;   // sizeof(AnimHeader), payload starts here
+  uint16_t width;
+  uint16_t height;
+  uint16_t frameCount;
+  uint8_t encoding;      // ANIM_ENC_*
+  uint8_t flags;         // ANIM_FLAG_* (version 2; 0 in version 1)
+  uint32_t frameBytes;   // bytes per frame
+  uint32_t payloadBytes; // bytes after the header
+  uint32_t payloadCrc32;
+  uint32_t headerCrc32;  // CRC of all header bytes before this field
+};
+
+// Incremental CRC-32 (IEEE 802.3); start with crc = 0
+uint32_t crc32Update(uint32_t crc, const void* data, size_t length);
+
+// Fill in header fields derived from the others (sizes, CRCs)
+void animHeaderFinish(AnimHeader& header, uint32_t payloadCrc32);
+
+// Check magic, version, sizes and header CRC; maxBytes bounds header + payload
+bool animHeaderValid(const AnimHeader& header, uint32_t maxBytes);
+
+// Decode frame index of a validated payload into width*height pixels; false if the frame is malformed
+bool animDecodeFrame(const AnimHeader& header, const uint8_t* payload, int index, uint16_t* pixels);
+
+// Size of the durations table at the end of the payload (0 without ANIM_FLAG_DURATIONS)
+uint32_t animDurationsBytes(const AnimHeader& header);
+
+// Display time of frame index in milliseconds from a validated payload; 0 if the container has no durations
+uint16_t animFrameDurationMs(const AnimHeader& header, const uint8_t* payload, int index);
+
+// Check the durations table of a CRC-checked payload: every entry non-zero (true without a table).
+// A timed container is stepped by its durations alone, so a zero would stop the animation
+bool animDurationsValid(const AnimHeader& header, const uint8_t* payload);
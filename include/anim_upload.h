@@ -0,0 +1,32 @@
+/*************************************************************
+********************** ANIMATION UPLOAD **********************
+**************************************************************/
+
+/*
+OTA animation upload (PUT /animation, body = animation container):
+ - streamed into the inactive flash slot one 4 KB sector at a time
+   (erase, write, read back and compare). An erase or write stops the
+   flash cache on both cores (a sector erase typically for tens of ms),
+   so each loop() does at most UPLOAD_FLASH_OPS_PER_POLL of them; loops
+   that wait for network data erase the next sectors ahead of it
+ - the response reports the longest erase and write stall next to the
+   worst frame time during the upload
+ - header validated as soon as it arrives, payload CRC accumulated
+   as the data streams in
+ - the new slot becomes active only after the CRC matches; the previous
+   animation keeps playing until then
+ - a client that stops sending is dropped after WEB_IDLE_TIMEOUT, and the
+   next upload may start
+
+  curl -T animation.nyan http://<clock-ip>/animation
+*/
+
+#pragma once
+
+#include <stdint.h>
+
+const uint8_t UPLOAD_FLASH_OPS_PER_POLL = 1; // sector erases or writes per loop()
+const uint16_t UPLOAD_SECTOR_SIZE = 4096;
+
+// Register PUT /animation with the web server
+void animationUploadBegin();
@@ -0,0 +1,82 @@
+/*************************************************************
+************************* ANIMATION **************************
+**************************************************************/
+
+/*
+Source of animation frames for the renderer:
+ - ANIM_SLOT_BUILTIN: the nyancat[] frames compiled into the firmware
+ - slots 0/1: containers in the anim0/anim1 flash partitions (see
+   partitions.csv), memory-mapped so raw frames are read like nyancat[]
+ - compressed (RLE565) and palette (PAL8) containers are decoded ahead by
+   a task on the other core into a ring of frame buffers in PSRAM
+   (frame_ring.h); the renderer only ever gets finished frames. The ring
+   is reserved whole or not at all: without PSRAM (six full frames don't
+   fit in SRAM) compressed slots are refused and the SRAM stays free for
+   the prefetch staging
+ - raw frames can be staged in SRAM a frame ahead (frame_prefetch.h), so
+   the blit doesn't stall on flash cache misses
+ - decoded frames are also kept in an LRU cache (frame_cache.h) sized by
+   animationSetCacheBudget(), so a looping animation is decoded only once
+   when all its frames fit
+
+Containers with a durations table (anim_container.h, tools/anim_import)
+give every frame its own display time; the renderer steps those on a timer
+instead of one frame per loop().
+
+The active slot is stored in NVS and restored at boot; a slot whose
+header or payload CRC does not check out falls back to the built-in frames.
+*/
+
+#pragma once
+
+#include <stdint.h>
+#include <stddef.h>
+#include "frame_cache.h"
+#include "frame_ring.h"
+
+const int ANIM_SLOT_BUILTIN = -1;
+const uint8_t ANIM_FLASH_SLOTS = 2;
+const uint8_t ANIM_PARTITION_SUBTYPE = 0x40; // custom data subtype in partitions.csv
+const uint32_t ANIM_MAX_FRAME_BYTES = 320 * 170 * 2; // decode/cache/prefetch buffers are reserved at this size
+
+// PSRAM for cached decoded frames of compressed slots (with the ring only); call before animationBegin
+void animationSetCacheBudget(size_t psramBytes);
+
+// Reserve the decode buffers and restore the active slot from NVS (call once in setup)
+void animationBegin();
+
+// Switch to a slot; returns false (and keeps the current one) if it is not valid
+bool animationSelect(int slot, bool persist = true);
+
+int animationActiveSlot();
+int animationFrameCount();
+int animationWidth();
+int animationHeight();
+
+// Display time of frame index in milliseconds; 0 if the active animation is untimed (one frame per loop)
+uint16_t animationFrameDurationMs(int index);
+
+// Changes whenever another animation is selected (the renderer restarts its timeline)
+uint32_t animationGeneration();
+
+// Pixels of frame index (native-order RGB565, width*height); call once per rendered frame.
+// Compressed slots return the last finished frame if index isn't decoded yet (counted as an underrun)
+const uint16_t* animationFrameData(int index);
+
+// Raw frames: stage frame index in SRAM for the next animationFrameData() (call after the blit)
+void animationPrefetch(int index);
+
+// Use (or stop using) frame prefetch; the staging buffer is reserved on first use
+void animationSetPrefetch(bool enabled);
+
+// Decoder state for compressed slots
+bool animationCompressed();
+const FrameRingStats& animationDecoderStats();
+uint32_t animationDecodeMicros(bool average); // last or average decode time per frame (misses only)
+const FrameCache& animationFrameCache();
+
+// The compiled-in frames (contiguous, native-order RGB565), whichever slot is active
+const uint16_t* animationBuiltinFrames(int& count, int& width, int& height);
+
+// Flash partition backing a slot (nullptr for the built-in slot or if missing)
+const void* animationPartition(int slot);
@@ -0,0 +1,30 @@
+/*************************************************************
+************************ ARENA SPRITE ************************
+**************************************************************/
+
+/*
+16-bit TFT_eSprite whose pixel buffer is carved from a memory arena
+(mem_arena.h) instead of TFT_eSPI's own calloc, so each sprite lands in
+the tier its use calls for: the panel frame buffer in DMA-capable SRAM,
+the overlays in fast internal SRAM. The arena owns the buffer: never call
+deleteSprite() on an arena sprite.
+*/
+
+#pragma once
+
+#include <TFT_eSPI.h>
+#include "mem_arena.h"
+
+class ArenaSprite : public TFT_eSprite {
+public:
+  explicit ArenaSprite(TFT_eSPI* tft) : TFT_eSprite(tft) {}
+  ~ArenaSprite() {
+    if (arenaBuffer) _created = false; // keep TFT_eSprite from freeing arena memory
+  }
+
+  // createSprite(), then move the buffer into tier; keeps TFT_eSPI's heap buffer if the arena is full
+  void* createArenaSprite(int16_t width, int16_t height, const char* owner, mem_tier_t tier);
+
+private:
+  bool arenaBuffer = false;
+};
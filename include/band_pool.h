@@ -0,0 +1,44 @@
+/*************************************************************
+************************* BAND POOL **************************
+**************************************************************/
+
+/*
+Fork/join over horizontal bands of a frame, so both cores share the pixel
+work of the blit and composite stages:
+ - bandPoolRun() splits rows 0..rows-1 into bands, wakes the helpers and
+   takes part itself; it returns when every band is done (join)
+ - DYNAMIC: threads take the next free band from an atomic counter, so a
+   core busy with WiFi simply takes fewer bands
+ - STATIC: band i always runs on thread i % threads (no shared counter)
+
+On the device the helper is a FreeRTOS task pinned to the other core; on
+the host (tools/band_bench) helpers are std::threads. Jobs must only touch
+their own rows and must not call TFT_eSPI or anything else that isn't
+safe on two cores at once.
+*/
+
+#pragma once
+
+#include <stdint.h>
+
+typedef enum {
+  BAND_SCHEDULE_DYNAMIC,
+  BAND_SCHEDULE_STATIC
+} band_schedule_t;
+
+// Work for rows y0..y1-1
+typedef void (*band_job_t)(int y0, int y1, void* context);
+
+const uint8_t BAND_MAX_THREADS = 16; // caller included
+const int BAND_ROWS = 10;            // default band height (17 bands on a 170-row frame)
+
+// Start threads-1 helpers (device: at most one per other core)
+void bandPoolBegin(uint8_t threads, band_schedule_t schedule);
+void bandPoolEnd();
+
+// Use only the first threads threads for the next runs (1 = caller only)
+void bandPoolSetActive(uint8_t threads);
+uint8_t bandPoolActive();
+
+// Run job over rows 0..rows-1 in bands of bandRows rows
+void bandPoolRun(int rows, int bandRows, band_job_t job, void* context);
@@ -0,0 +1,25 @@
+/*************************************************************
+************************* BENCHMARK **************************
+**************************************************************/
+
+/*
+Boot-time throughput checks, built with -D BENCHMARK_KERNELS and printed
+to Serial before the clock starts.
+*/
+
+#pragma once
+
+struct NyanLayers;
+
+// Time each pixel kernel on a full 320x170 frame and print MB/s
+void benchmarkPixelKernels();
+
+// Time a banded frame composite (blit + four keyed overlays) on 1 and 2 cores
+void benchmarkBandPool();
+
+// Time the animation blit reading flash vs. a frame staged in SRAM (call after animationBegin)
+void benchmarkFramePrefetch();
+
+// Time a second of layered playback (advance + dirty-rect repaint) against the full-frame blit, and what it pushes
+// (call after nyanLayersInit; leaves the layers reset)
+void benchmarkLayers(NyanLayers& layers);
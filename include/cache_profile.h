@@ -0,0 +1,32 @@
+/*************************************************************
+*********************** CACHE PROFILING **********************
+**************************************************************/
+
+/*
+Stall counters of the core running loop(), built with -D CACHE_PROFILING:
+ - the Xtensa LX7 performance monitor counts cycles, instruction-side
+   stall cycles (instruction fetch waiting, e.g. an ICache refill from
+   flash) and data-side stall cycles (loads waiting on the DCache, XIP
+   flash or PSRAM)
+ - the ESP32-S3 caches sit outside the core and expose no miss counter,
+   so stall cycles are the measure of what misses cost: metrics.cpp charges
+   them to the render stages and reports them per frame
+Only the loop() core is counted; the band helper's stalls show up as the
+caller waiting for its bands.
+*/
+
+#pragma once
+
+#include <stdint.h>
+
+struct CacheCounters {
+  uint32_t cycles;
+  uint32_t instructionStalls; // cycles
+  uint32_t dataStalls;        // cycles
+};
+
+// Program and start the counters on the calling core (call from setup)
+void cacheProfileBegin();
+
+// Current counter values (free running; subtract two reads)
+void cacheProfileRead(CacheCounters& counters);
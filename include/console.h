@@ -0,0 +1,32 @@
+/*************************************************************
+************************** CONSOLE ***************************
+**************************************************************/
+
+/*
+Serial command console for on-site diagnosis:
+ - polled from loop() with a time budget (CONSOLE_BUDGET_US), never blocks
+ - input is collected into a fixed line buffer and split in place,
+   so parsing allocates nothing (console_line.h)
+ - long outputs (help, stats, trace, quality, mem, screenshot) are
+   streamed one line per step, only while the serial TX buffer has room,
+   spread across as many frames as needed (consoleStreamContinue)
+*/
+
+#pragma once
+
+#include <Arduino.h>
+#include "console_line.h"
+
+const uint8_t CONSOLE_MAX_COMMANDS = 16;
+
+// Command handler: argv[0] is the command name
+typedef void (*ConsoleHandler)(int argc, char** argv);
+
+// Register a command (call from setup)
+bool consoleRegister(const char* name, const char* help, ConsoleHandler handler);
+
+// Start a streamed response (replaces any stream still running)
+void consoleStream(ConsoleStreamStep step);
+
+// Read and execute commands, continue streamed output (call once per loop)
+void consolePoll();
@@ -0,0 +1,70 @@
+/*************************************************************
+*********************** CONSOLE LINE *************************
+**************************************************************/
+
+/*
+Input line handling for the serial console (console.cpp):
+ - characters are collected into a fixed buffer; '\r' is ignored and
+   '\n' ends the line
+ - a line longer than the buffer is reported once, at its '\n', and
+   dropped as a whole
+ - a finished line is split in place at spaces and tabs into at most
+   CONSOLE_MAX_ARGS words; anything after the last one is ignored
+Nothing allocates. Word pointers stay valid until the next character is fed.
+
+Streamed output (long responses) goes through consoleStreamContinue():
+ - one step prints one line, and a step runs only while the serial TX
+   buffer has CONSOLE_MIN_TX_ROOM bytes free, so the write never blocks;
+   streamed lines are kept shorter than that
+ - the steps of one poll stop at CONSOLE_BUDGET_US; the rest follows on
+   the next polls
+
+Plain C++ (no Arduino dependencies) so the host console check shares it;
+Print is only passed through to the steps.
+*/
+
+#pragma once
+
+#include <stdint.h>
+#include <stddef.h>
+
+const size_t CONSOLE_LINE_LENGTH = 64;    // max command line length
+const uint8_t CONSOLE_MAX_ARGS = 4;       // command name + 3 arguments
+const unsigned long CONSOLE_BUDGET_US = 300; // time allowed per poll
+const int CONSOLE_MIN_TX_ROOM = 112;      // stream a line only when this much TX room is free (UART FIFO is 128)
+
+class Print;
+
+typedef enum {
+  CONSOLE_LINE_PENDING,   // line not finished yet
+  CONSOLE_LINE_READY,     // complete line, split it with consoleLineSplit()
+  CONSOLE_LINE_TOO_LONG   // complete line that did not fit, dropped
+} console_line_t;
+
+struct ConsoleLine {
+  char text[CONSOLE_LINE_LENGTH];
+  uint8_t length;
+  bool overflow;
+  bool done;              // last character ended the line: start over on the next one
+};
+
+// Start with an empty line
+void consoleLineInit(ConsoleLine& line);
+
+// Add one input character
+console_line_t consoleLineFeed(ConsoleLine& line, char c);
+
+// Split a READY line in place into argv (CONSOLE_MAX_ARGS entries), return the word count
+int consoleLineSplit(ConsoleLine& line, char** argv);
+
+// Streamed output step: print line 'index', return false when there is nothing left
+typedef bool (*ConsoleStreamStep)(Print& out, uint32_t index);
+
+struct ConsoleStream {
+  ConsoleStreamStep step;   // nullptr when no response is being streamed
+  uint32_t index;           // next line
+};
+
+// Run stream steps into out while room() >= CONSOLE_MIN_TX_ROOM and now() - start < CONSOLE_BUDGET_US;
+// returns true while lines are left
+bool consoleStreamContinue(ConsoleStream& stream, Print& out, int (*room)(), unsigned long (*now)(), unsigned long start);
@@ -0,0 +1,55 @@
+/*************************************************************
+************************ DIRTY REGION ************************
+**************************************************************/
+
+/*
+The parts of a frame that changed since the last push, as a short list of
+rectangles the display backends send on their own (pushRegion() in
+display_backend.h):
+ - rectangles are clipped to the frame and never overlap: an added one is
+   merged with every rectangle it overlaps or touches, and with any whose
+   bounding box costs at most DIRTY_MERGE_SLACK extra pixels (each
+   rectangle costs a window setup on the bus, about that many pixels)
+ - when the list is full the added rectangle is merged with the one whose
+   union adds the fewest pixels
+ - dirtyPixels() is what the push will send; past DIRTY_FULL_PERCENT of
+   the frame a full push is cheaper
+
+Plain C++ (no Arduino dependencies) so the host tools share it.
+*/
+
+#pragma once
+
+#include <stdint.h>
+
+const uint8_t DIRTY_MAX_RECTS = 24;
+const int32_t DIRTY_MERGE_SLACK = 256;   // pixels
+const uint8_t DIRTY_FULL_PERCENT = 60;   // of the frame
+
+struct DirtyRect {
+  int16_t x, y, w, h;
+};
+
+struct DirtyRegion {
+  int16_t width, height;
+  DirtyRect rects[DIRTY_MAX_RECTS];
+  uint8_t count;
+  bool full;             // the whole frame (one rect)
+};
+
+// Empty region for frames of width x height
+void dirtyInit(DirtyRegion& region, int width, int height);
+void dirtyClear(DirtyRegion& region);
+
+// Add a rectangle (clipped; empty ones are ignored)
+void dirtyAdd(DirtyRegion& region, int x, int y, int w, int h);
+void dirtyAdd(DirtyRegion& region, const DirtyRect& rect);
+
+// Mark the whole frame
+void dirtyAll(DirtyRegion& region);
+
+// Pixels covered (rects never overlap)
+uint32_t dirtyPixels(const DirtyRegion& region);
+
+// True if a push of the region costs more than a full frame
+bool dirtyWorthFullPush(const DirtyRegion& region);
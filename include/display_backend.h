@@ -0,0 +1,81 @@
+/*************************************************************
+********************** DISPLAY BACKEND ***********************
+**************************************************************/
+
+/*
+Where a finished frame goes. loop() composes mainSprite and hands its
+buffer to one of:
+ - tft: TFT_eSPI pushImage, the CPU drives the 8-bit bus for the whole
+   transfer (lcd_backend.h)
+ - i80-dma: esp_lcd i80 driver on the LCD_CAM peripheral, GDMA streams the
+   buffer while the CPU carries on (lcd_backend.h)
+ - framebuffer: copies into memory, for host tools and for timing the
+   firmware without a panel (here, no Arduino dependencies)
+
+Frames are full screen, RGB565 in sprite byte order. pushRegion() sends
+only the rectangles of a dirty region (dirty_region.h) out of the same
+full-screen buffer. Either may return before the transfer has finished:
+the buffer must not be written again until waitIdle() returns.
+*/
+
+#pragma once
+
+#include <stdint.h>
+#include <stddef.h>
+#include "dirty_region.h"
+
+typedef enum {
+  DISPLAY_BACKEND_TFT,
+  DISPLAY_BACKEND_I80_DMA,
+  DISPLAY_BACKEND_FRAMEBUFFER
+} display_backend_t;
+
+class DisplayBackend {
+public:
+  virtual ~DisplayBackend() {}
+
+  virtual const char* name() const = 0;
+
+  // Prepare for frames of width x height taken from buffer; false if this backend can't
+  virtual bool begin(int width, int height, const uint16_t* buffer) = 0;
+
+  // Start sending a frame
+  virtual void pushFrame(const uint16_t* pixels) = 0;
+
+  // Start sending the rectangles of region (pixels is the whole frame)
+  virtual void pushRegion(const uint16_t* pixels, const DirtyRegion& region) = 0;
+
+  // True while a pushed frame is still being read
+  virtual bool busy() = 0;
+
+  // Block until the last pushed frame has been read completely
+  virtual void waitIdle() = 0;
+
+  // micros() when the last pushed frame was completely on the panel (0 if this backend can't tell)
+  uint32_t lastFrameDoneMicros() const { return frameDoneMicros; }
+
+protected:
+  volatile uint32_t frameDoneMicros = 0;
+};
+
+// Copy of the last frame in memory (synchronous)
+class FramebufferBackend : public DisplayBackend {
+public:
+  ~FramebufferBackend() override;
+
+  const char* name() const override { return "framebuffer"; }
+  bool begin(int width, int height, const uint16_t* buffer) override;
+  void pushFrame(const uint16_t* pixels) override;
+  void pushRegion(const uint16_t* pixels, const DirtyRegion& region) override;
+  bool busy() override { return false; }
+  void waitIdle() override {}
+
+  const uint16_t* pixels() const { return framebuffer; }
+  uint32_t frames() const { return frameCount; }
+
+private:
+  uint16_t* framebuffer = nullptr;
+  size_t pixelCount = 0;
+  int width = 0;
+  uint32_t frameCount = 0;
+};
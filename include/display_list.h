@@ -0,0 +1,89 @@
+/*************************************************************
+*********************** DISPLAY LIST *************************
+**************************************************************/
+
+/*
+Per-frame list of draw commands for the sprites that make up the screen.
+loop() records the whole frame every time and the list works out what
+actually has to be drawn:
+ - state commands (text colour, font, datum, size) only take effect at the
+   next draw on that sprite, so consecutive changes collapse and values the
+   sprite already has are never set again (also across frames)
+ - commands are recorded in groups (one per panel); a group whose commands
+   are identical to last frame's is culled, unless its target was
+   overdrawn this frame (mainSprite under the animation) or invalidated
+ - execution is batched per target, in registration order: each overlay
+   sprite's commands run together, then the sprites they are composited
+   into; adjacent same-colour fills within a group are merged, and
+   consecutive composites within a group run as one banded pass on both
+   cores (band_pool.h)
+
+Rules for callers: groups on one target must not overlap, each group sets
+the text state it draws with (culling only compares the group's own
+commands), an overlay must be registered before the target it is
+composited into, and nothing else may draw into a registered sprite
+between dlBeginFrame() and dlExecute() (call dlInvalidate() after drawing
+into one directly).
+*/
+
+#pragma once
+
+#include <TFT_eSPI.h>
+
+const uint8_t DL_MAX_TARGETS = 6;
+const uint8_t DL_MAX_GROUPS = 16;     // group ids 0..DL_MAX_GROUPS-1, unique across targets
+const uint8_t DL_MAX_COMMANDS = 96;   // per frame
+const uint16_t DL_TEXT_POOL = 512;    // bytes of text per frame
+
+// Command counts for the last frame (dlBeginFrame() resets them)
+struct DisplayListStats {
+  uint16_t recorded;     // commands recorded, state changes included
+  uint16_t stateElided;  // state changes collapsed or already in effect
+  uint16_t culled;       // draw commands in groups identical to last frame
+  uint16_t merged;       // fills folded into an adjacent fill
+  uint16_t executed;     // draw calls and state changes issued to TFT_eSPI
+  uint16_t overflowed;   // commands dropped because the list was full
+};
+
+// Register a sprite (setup); returns the target id
+int dlRegisterTarget(TFT_eSprite& sprite);
+
+void dlBeginFrame();
+void dlOverdrawn(int target);  // target's pixels were replaced this frame: run all its groups
+void dlInvalidate(int target); // force all groups on target to run this frame
+void dlInvalidateAll();
+
+// Start a group: the following commands draw into target
+void dlGroup(int target, uint8_t id);
+
+// State
+void dlSetTextColor(uint16_t colour); // transparent background
+void dlSetTextColor(uint16_t colour, uint16_t background);
+void dlSetTextDatum(uint8_t datum);
+void dlSetTextFont(uint8_t font);
+void dlSetFreeFont(const GFXfont* font);
+void dlSetTextSize(uint8_t size);
+
+// Drawing (font 0 = current font)
+void dlFillSprite(uint16_t colour);
+void dlFillRect(int x, int y, int w, int h, uint16_t colour);
+void dlFillRoundRect(int x, int y, int w, int h, int r, uint16_t colour);
+void dlDrawRoundRect(int x, int y, int w, int h, int r, uint16_t colour);
+void dlFillCircle(int x, int y, int r, uint16_t colour);
+void dlDrawCircle(int x, int y, int r, uint16_t colour);
+void dlDrawString(const char* text, int x, int y, uint8_t font = 0);
+void dlComposite(int overlay, int x, int y); // keyed blit of a registered sprite (black = transparent)
+
+// Run the commands recorded for target (-1 = every target, in registration order)
+void dlExecute(int target = -1);
+
+/*
+After dlExecute(): whether a group's commands differ from last frame's (or
+its target was invalidated), also on an overdrawn target where nothing is
+culled, and whether any group on a target did. Callers that push only the
+changed parts of a frame use these for the panels on it.
+*/
+bool dlGroupChanged(uint8_t id);
+bool dlTargetChanged(int target);
+
+const DisplayListStats& dlLastFrameStats();
@@ -0,0 +1,37 @@
+/*************************************************************
+******************** FRAMEBUFFER STREAM **********************
+**************************************************************/
+
+/*
+Live view of the composed framebuffer over HTTP (GET /stream):
+ - chunked response, one stream frame every FB_STREAM_INTERVAL ms at most
+ - the framebuffer is split into full-width bands of FB_STREAM_BAND_ROWS rows,
+   so each band is contiguous and is copied with one memcpy (one band at a
+   time, never the whole frame)
+ - keyframes carry every band, deltas only the bands whose hash changed
+ - at most FB_STREAM_BANDS_PER_POLL bands are written per loop() iteration;
+   each band is copied (and hashed for the next delta) just before it goes
+   out, so a frame's bands may come from successive rendered frames but a
+   change is never lost
+ - writes go only as far as the socket has room (availableForWrite); the
+   rest of the copied band waits for the next poll, so a slow viewer lowers
+   the stream rate instead of stalling loop()
+
+Wire format (little-endian):
+  frame header (16 bytes): "NYFB", type (0 = key, 1 = delta), reserved,
+                           rect count (u16), sequence (u32), width (u16), height (u16)
+  per rect   (8 bytes):    x, y, w, h (u16 each), then w*h RGB565 pixels,
+                           high byte first (sprite byte order)
+*/
+
+#pragma once
+
+#include <stdint.h>
+
+const unsigned long FB_STREAM_INTERVAL = 100;   // min ms between stream frames (10 fps cap)
+const uint8_t FB_STREAM_BAND_ROWS = 10;         // rows per band (320x10 = 6400 bytes)
+const uint8_t FB_STREAM_BANDS_PER_POLL = 2;     // bands written per poll
+const uint16_t FB_STREAM_KEYFRAME_INTERVAL = 50; // stream frames between keyframes
+
+// Register GET /stream for a width x height sprite buffer
+void framebufferStreamBegin(const uint16_t* buffer, int width, int height);
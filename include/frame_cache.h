@@ -0,0 +1,68 @@
+/*************************************************************
+************************* FRAME CACHE ************************
+**************************************************************/
+
+/*
+Decoded frames kept for reuse, for animations that loop over the same
+frames (a compressed nyancat decodes each of its 17 frames once):
+ - the decoder asks frameCacheFill() for a frame; a hit copies the cached
+   pixels, a miss decodes and keeps a copy, evicting the least recently
+   used entry when all buffers are taken
+ - the caller sizes it: as many frame buffers as fit the memory budget
+   (the firmware reserves them in PSRAM only, next to the decode ring;
+   without PSRAM compressed slots are refused); zero buffers simply
+   decodes every time
+ - stats: hits/misses, bytes held and decode time saved (decode time of
+   the cached frame minus the copy)
+
+Used by a single thread (the decoder task). Plain C++ (no Arduino
+dependencies) so the host tools share it.
+*/
+
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+#include "frame_ring.h"
+
+const uint8_t FRAME_CACHE_MAX_ENTRIES = 64;
+
+// Microsecond clock (micros() on the device)
+typedef uint32_t (*frame_clock_t)();
+
+struct FrameCacheStats {
+  uint32_t hits;
+  uint32_t misses;
+  uint32_t evictions;
+  uint32_t bytesHeld;     // frames currently cached
+  uint32_t msSaved;       // decode time avoided by hits
+};
+
+struct FrameCacheEntry {
+  uint16_t* pixels;
+  int frame;              // -1 = empty
+  uint32_t lastUse;
+  uint32_t decodeMicros;  // what it cost to decode
+};
+
+struct FrameCache {
+  FrameCacheEntry entries[FRAME_CACHE_MAX_ENTRIES];
+  uint8_t capacity;
+  size_t frameBytes;
+  uint32_t useClock;
+  uint32_t usSaved;       // below one millisecond, carried into msSaved
+  FrameCacheStats stats;
+};
+
+// Frame buffers that fit budget bytes (capped at frameCount and FRAME_CACHE_MAX_ENTRIES)
+uint8_t frameCacheEntriesFor(size_t budget, size_t frameBytes, int frameCount);
+
+// Set up the cache over count buffers of frameBytes each (empty, stats cleared)
+void frameCacheInit(FrameCache& cache, uint16_t* const* buffers, uint8_t count, size_t frameBytes);
+
+// Fill pixels with frame: from the cache, or by decode (timed with clock) and kept; false if decode fails
+bool frameCacheFill(FrameCache& cache, int frame, uint16_t* pixels, frame_decode_t decode, void* context,
+                    frame_clock_t clock);
+
+// Hit rate in percent (0 before the first lookup)
+uint8_t frameCacheHitPercent(const FrameCache& cache);
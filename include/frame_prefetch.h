@@ -0,0 +1,54 @@
+/*************************************************************
+*********************** FRAME PREFETCH ***********************
+**************************************************************/
+
+/*
+Copies the next uncompressed animation frame from flash (XIP) into a
+staging buffer in internal SRAM on the other core, while loop() composes
+and pushes the current one, so the blit reads SRAM instead of stalling on
+flash cache misses:
+ - framePrefetchRequest() after the blit: start copying the predicted next
+   frame (the staging buffer is free again once the blit is done)
+ - framePrefetchTake() at the next blit: the staging buffer if it holds that
+   frame (waiting for the rest of the copy if it is still running), else
+   nullptr and the caller blits from flash (a miss, e.g. after a sync jump)
+
+Raw frames only; compressed slots are decoded into PSRAM (frame_ring.h).
+*/
+
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+
+struct FramePrefetchStats {
+  uint32_t hits;          // staged in time
+  uint32_t late;          // copy still running at the blit (waited for it)
+  uint32_t misses;        // wrong or no frame staged: blit from flash
+  uint32_t copyMicros;    // last copy flash -> SRAM
+  uint32_t waitMicros;    // total time spent waiting for late copies
+};
+
+// Reserve the staging buffer (internal SRAM arena) for frames up to maxFrameBytes and start the copy task; false if it doesn't fit
+bool framePrefetchReserve(size_t maxFrameBytes);
+
+// Start prefetching frames of frameBytes; false if the staging buffer is too small (or not reserved)
+bool framePrefetchBegin(size_t frameBytes);
+
+// Stop prefetching (the buffer stays reserved, the task idle)
+void framePrefetchEnd();
+
+// Prefetch on/off (off: every blit reads flash; for comparing stall time)
+void framePrefetchSetEnabled(bool enabled);
+bool framePrefetchEnabled();
+
+// Start copying frameBytes of frame index from source (call after the current blit; nothing to do if it is already staged)
+void framePrefetchRequest(int index, const uint16_t* source, size_t frameBytes);
+
+// Staged pixels of frame index, or nullptr to read it from flash
+const uint16_t* framePrefetchTake(int index);
+
+// Wait for any copy in flight and drop what is staged (before the source mapping goes away)
+void framePrefetchCancel();
+
+const FramePrefetchStats& framePrefetchStats();
@@ -0,0 +1,77 @@
+/*************************************************************
+************************* FRAME RING *************************
+**************************************************************/
+
+/*
+Decoded-frame ring between a decoder (producer, on the other core or a
+host thread) and the renderer (consumer), single producer/single consumer:
+ - the producer decodes the frames that follow the last one it made (or
+   the restart point the renderer left after a miss) into free slots, up
+   to `ahead` frames beyond the one on screen
+ - frameRingAcquire() hands the renderer the frame it asked for if it is
+   ready; frames decoded ahead that were skipped are dropped. On a miss
+   (underrun) it returns the last finished frame again, so the renderer
+   only ever blits complete frames
+ - read-ahead adapts: every underrun adds a frame of depth, and after
+   FRAME_RING_SHRINK_FRAMES hits in a row one is given back
+
+The slot buffers and the decode function are supplied by the caller.
+Plain C++ (no Arduino dependencies) so the host tools share it.
+*/
+
+#pragma once
+
+#include <stdint.h>
+#include <atomic>
+
+const uint8_t FRAME_RING_SLOTS = 6;                   // including the frame on screen
+const uint8_t FRAME_RING_MIN_AHEAD = 1;
+const uint8_t FRAME_RING_MAX_AHEAD = FRAME_RING_SLOTS - 1;
+const uint16_t FRAME_RING_SHRINK_FRAMES = 300;        // hits in a row before read-ahead drops by one
+
+// Decode frame index into pixels; false if the frame is malformed
+typedef bool (*frame_decode_t)(int index, uint16_t* pixels, void* context);
+
+struct FrameRingStats {
+  uint32_t shown;        // frames handed out as requested
+  uint32_t underruns;    // requested frame not decoded in time
+  uint32_t decoded;
+  uint32_t discarded;    // decoded but skipped (timeline jumped or caught up)
+  uint32_t decodeErrors;
+  uint8_t ahead;         // current read-ahead depth
+};
+
+struct FrameRing {
+  uint16_t* slots[FRAME_RING_SLOTS];
+  int slotFrame[FRAME_RING_SLOTS];
+  int frameCount;
+  frame_decode_t decode;
+  void* context;
+
+  // Producer/consumer positions (counts; slot = count % FRAME_RING_SLOTS)
+  std::atomic<uint32_t> head;     // slots filled by the producer
+  std::atomic<uint32_t> tail;     // slots given back by the consumer
+  std::atomic<int> restart;       // next frame for the producer after a miss (-1 = none)
+  std::atomic<uint8_t> ahead;
+  std::atomic<bool> enabled, producing;
+
+  // Producer only
+  int nextFrame;
+
+  // Consumer only
+  bool holding;                   // slot tail is on screen
+  uint16_t hitStreak;
+  FrameRingStats stats;
+};
+
+// Set up the ring (slots: FRAME_RING_SLOTS buffers of one frame each) and enable the producer
+void frameRingInit(FrameRing& ring, uint16_t* const* slots, int frameCount, frame_decode_t decode, void* context);
+
+// Disable the producer and wait until it has left frameRingProduce()
+void frameRingStop(FrameRing& ring);
+
+// Producer: decode one frame if there is room; false if there was nothing to do
+bool frameRingProduce(FrameRing& ring);
+
+// Consumer: pixels for frame index (or the last finished frame on a miss; nullptr before the first)
+const uint16_t* frameRingAcquire(FrameRing& ring, int index);
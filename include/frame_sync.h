@@ -0,0 +1,29 @@
+/*************************************************************
+************************ FRAME SYNC **************************
+**************************************************************/
+
+/*
+Lockstep animation across several clocks (see sync_clock.h):
+ - SYNC_MODE_LEADER multicasts the timeline every SYNC_BEACON_INTERVAL ms
+ - SYNC_MODE_FOLLOWER locks its frame index to the received timeline and
+   falls back to free-running when beacons stop
+*/
+
+#pragma once
+
+#include <stdint.h>
+
+typedef enum {
+  SYNC_MODE_OFF,      // free-running, one frame per loop() (default)
+  SYNC_MODE_LEADER,   // own timeline, broadcast to followers
+  SYNC_MODE_FOLLOWER  // timeline taken from the leader's beacons
+} sync_mode_t;
+
+// Configure the mode and the timeline used when leading
+void frameSyncBegin(sync_mode_t mode, uint32_t framePeriodUs, uint16_t frameCount);
+
+// Send/receive beacons (call once per loop)
+void frameSyncPoll();
+
+// Frame index from the shared timeline, or -1 when not synchronised
+int frameSyncCurrentFrame();
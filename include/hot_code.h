@@ -0,0 +1,21 @@
+/*************************************************************
+************************** HOT CODE **************************
+**************************************************************/
+
+/*
+HOT_CODE marks the functions every frame spends its time in (pixel kernels,
+band workers, blit/composite jobs, loop()). With -D HOT_CODE_IRAM they are
+linked into IRAM instead of flash, so they never wait for an instruction
+cache refill over the flash bus; without it (and on the host) it expands
+to nothing. IRAM comes out of the same pool as the heap on the ESP32-S3,
+so keep the list short.
+*/
+
+#pragma once
+
+#if defined(ARDUINO) && defined(HOT_CODE_IRAM)
+#include <esp_attr.h>
+#define HOT_CODE IRAM_ATTR
+#else
+#define HOT_CODE
+#endif
@@ -0,0 +1,72 @@
+/*************************************************************
+************************* INPUT LOG **************************
+**************************************************************/
+
+/*
+Record/replay of the external inputs the clock logic sees, so two firmware
+builds can be compared on exactly the same frame sequence:
+ - main.cpp reads time, buttons, NTP time, the IP address and WiFi events
+   only through the input* functions below
+ - LIVE: they pass straight through (WiFi events are queued and handled in
+   loop(), which also keeps the event handler off the WiFi task)
+ - RECORDING: results are appended to a compact log in PSRAM, together with
+   a snapshot of the clock state and a hash of every frame
+ - REPLAYING: results come from the log instead, WiFi is left alone, and
+   every frame hash is checked against the recording
+
+The log is fetched with GET /inputlog and loaded back (on the same or a
+different build) with PUT /inputlog; recording and replay are refused while
+an upload is writing the buffer. Console: "rec start|stop|replay|status".
+
+Record encoding: one tag byte, type in the low 3 bits, argument in the high
+5 bits (31 = a varint argument follows). Buttons and the IP address are
+only logged when they change; replay peeks at the next record to find out
+whether the value changed at this call. Frame times themselves (micros())
+stay live, they are what is being measured.
+*/
+
+#pragma once
+
+#include <Arduino.h>
+#include <time.h>
+
+const size_t INPUT_LOG_BYTES = 1024 * 1024;    // log buffer in PSRAM (~1 hour of frames)
+const uint8_t INPUT_WIFI_QUEUE = 8;            // WiFi events waiting for loop()
+const size_t INPUT_LOG_CHUNK = 4096;           // bytes per HTTP read/write step
+
+typedef enum {
+  INPUT_LIVE,
+  INPUT_RECORDING,
+  INPUT_REPLAYING
+} input_mode_t;
+
+input_mode_t inputMode();
+
+// Start recording; state (stateSize bytes) is stored so replay starts from it
+bool inputRecordStart(const void* state, size_t stateSize);
+void inputRecordStop();
+
+// Start replaying the loaded/recorded log; restores state, false if it doesn't match
+bool inputReplayStart(void* state, size_t stateSize);
+
+// Inputs
+unsigned long inputMillis();
+int inputDigitalRead(uint8_t pin);
+bool inputGetLocalTime(struct tm* info, uint16_t* millisIntoSecond = nullptr); // phase within the second (optional)
+uint32_t inputLocalIP();
+
+// WiFi events: queue from the event callback, take them in loop()
+void inputQueueWiFiEvent(int event);
+bool inputNextWiFiEvent(int& event);
+
+// False while replaying: WiFi must not be reconfigured by recorded decisions
+bool inputWiFiLive();
+
+// Frame boundary: records or verifies the frame hash and tracks frame time
+void inputFrameEnd(uint32_t frameHash, uint32_t frameMicros);
+
+// Console status line
+void inputPrintStatus(Print& out);
+
+// Register GET/PUT /inputlog
+void inputLogBegin();
@@ -0,0 +1,33 @@
+/*************************************************************
+************************ LCD BACKENDS ************************
+**************************************************************/
+
+/*
+Display backends for the T-Display-S3 panel (ST7789, 8-bit parallel bus):
+ - tft: the frame goes through TFT_eSPI's CPU-driven parallel writes
+ - i80-dma: the esp_lcd i80 bus takes over the same pins (LCD_CAM + GDMA);
+   TFT_eSPI has already initialised the panel, so only the address window
+   is set once and every frame is a single RAMWR transfer. The transfer
+   done callback (ISR) releases the buffer for the next frame. Region
+   pushes set a window per dirty rect and restore the full one for the
+   next full frame.
+
+After an i80-dma backend has started, TFT_eSPI can no longer draw on the
+panel directly (the pins belong to LCD_CAM). GDMA needs a frame buffer in
+internal RAM, or in PSRAM aligned to 64 bytes; an ArenaSprite in the
+MEM_TIER_DMA arena provides one (arena_sprite.h).
+*/
+
+#pragma once
+
+#include <TFT_eSPI.h>
+#include "display_backend.h"
+
+const uint32_t LCD_I80_PCLK_HZ = 10000000; // ST7789 write cycle is 66 ns minimum
+const uint8_t LCD_I80_QUEUE_DEPTH = 4;     // transactions queued in the driver
+const int LCD_I80_X_OFFSET = 0;            // panel RAM offsets in rotation 1 (170x320 ST7789)
+const int LCD_I80_Y_OFFSET = 35;
+const size_t LCD_I80_STAGING_BYTES = 4096;   // per buffer (two, from the MEM_TIER_DMA arena)
+
+// Start the requested backend for frames from sprite, falling back to tft if it can't start
+DisplayBackend* lcdBackendBegin(display_backend_t kind, TFT_eSPI& tft, TFT_eSprite& sprite);
@@ -0,0 +1,49 @@
+/*************************************************************
+************************* MEMORY ARENAS **********************
+**************************************************************/
+
+/*
+Large buffers (sprites, decode ring, frame cache, prefetch staging,
+screenshot/remote-display/input-log buffers) come from three arenas that
+are reserved once at the start of setup(), one per memory tier:
+ - MEM_TIER_DMA: internal SRAM that GDMA can read (the panel frame buffer)
+ - MEM_TIER_INTERNAL: fast internal SRAM for buffers touched every frame
+ - MEM_TIER_PSRAM: large buffers that tolerate PSRAM latency
+Allocations are carved from the arena in 64-byte aligned pieces (GDMA
+reads PSRAM in 64-byte lines) and never freed, so nothing fragments the
+heap WiFi and lwIP allocate from at run time. A request that doesn't fit
+its tier falls back along a fixed chain (DMA -> PSRAM, INTERNAL -> PSRAM,
+PSRAM -> INTERNAL); every piece is recorded per owner for the report.
+*/
+
+#pragma once
+
+#include <Arduino.h>
+
+typedef enum {
+  MEM_TIER_DMA,
+  MEM_TIER_INTERNAL,
+  MEM_TIER_PSRAM,
+  MEM_TIER_COUNT
+} mem_tier_t;
+
+const size_t MEM_ARENA_ALIGN = 64;
+const uint8_t MEM_ARENA_MAX_OWNERS = 24;
+
+// Reserve the arenas; a tier that can't be reserved in full gets its largest free block
+void memArenaBegin(size_t dmaBytes, size_t internalBytes, size_t psramBytes);
+
+// bytes for owner from tier (or the next tier in its chain), zeroed; nullptr if none has room
+void* memArenaAlloc(const char* owner, size_t bytes, mem_tier_t tier);
+
+// Bytes still free in a tier's own arena (its fallback not counted)
+size_t memArenaFree(mem_tier_t tier);
+
+// Tier a pointer was carved from (MEM_TIER_COUNT if it isn't from an arena)
+mem_tier_t memArenaTierOf(const void* pointer);
+
+const char* memTierName(mem_tier_t tier);
+
+// Bytes reserved/used per tier, then per owner, one line per call (ConsoleStreamStep, false when done;
+// boot report and "mem" console command)
+bool memArenaPrintReportLine(Print& out, uint32_t index);
@@ -0,0 +1,62 @@
+/*************************************************************
+************************** METRICS ***************************
+**************************************************************/
+
+/*
+Frame timing and device health counters, exported in Prometheus text
+format on GET /metrics. Everything is fixed-size: the counters are plain
+globals and the response is formatted into a preallocated buffer. A
+response that outgrows the buffer fails the scrape (500, with the size it
+needs, also on Serial) instead of being cut short. The buffer is written
+only as far as the socket has room, over as many polls as it takes, so a
+slow scraper never stalls loop(); one scrape at a time (503 otherwise).
+*/
+
+#pragma once
+
+#include <stdint.h>
+#include "wifi_state.h"
+#include "tick_latency.h"
+
+class Print;
+
+// Render stages timed inside loop() (in execution order)
+typedef enum {
+  STAGE_INPUT,     // buttons, WiFi state machine, time keeping
+  STAGE_PUSH_WAIT, // waiting for the previous frame's transfer before mainSprite is reused
+  STAGE_BLIT,      // animation frame -> mainSprite
+  STAGE_DRAW,      // overlay sprite contents (display list)
+  STAGE_COMPOSITE, // clock panels on mainSprite, overlay sprites -> mainSprite
+  STAGE_PUSH,      // mainSprite -> panel (or starting the transfer, for the DMA backend)
+  STAGE_NETWORK,   // HTTP server poll
+  STAGE_CONSOLE,   // serial console poll
+  STAGE_COUNT
+} render_stage_t;
+
+const uint32_t METRICS_FRAME_BUDGET_US = 33333; // frames slower than this count as dropped (30 fps)
+const uint8_t METRICS_HISTOGRAM_BUCKETS = 10;   // frame time histogram buckets (plus +Inf)
+const uint8_t METRICS_TRACE_FRAMES = 64;        // per-frame stage timings kept for "trace"
+
+// Frame timing
+void metricsFrameBegin();
+void metricsStageEnd(render_stage_t stage); // time since the previous mark is charged to stage
+void metricsFrameEnd();
+
+// Events
+void metricsWiFiTransition(wifi_state_t from, wifi_state_t to);
+void metricsReconnectAttempt();
+void metricsNtpSync(int32_t offsetMillis); // measured clock correction at sync
+void metricsDisplayList(uint16_t recorded, uint16_t executed); // draw commands this frame
+void metricsQuality(uint8_t level, uint32_t transitions); // adaptive quality level after a change
+void metricsTickLatency(const TickLatencyStats& stats, uint32_t leadMicros); // after each new second shown
+void metricsPush(uint32_t bytes, uint8_t rects, bool region); // frame sent to the panel, whole or as dirty rects
+
+// Latest frame time in microseconds (0 before the first frame)
+uint32_t metricsLastFrameMicros();
+
+// Register GET /metrics with the web server
+void metricsBegin();
+
+// Console output one line per call (ConsoleStreamStep, false when done): summary and frame trace
+bool metricsPrintStatsLine(Print& out, uint32_t index);
+bool metricsPrintTraceLine(Print& out, uint32_t index);
@@ -0,0 +1,95 @@
+/*************************************************************
+*********************** LAYERED NYANCAT **********************
+**************************************************************/
+
+/*
+The built-in animation split into layers, so the scenery can move at the
+panel's frame rate while the cat keeps the art's own:
+ - background: one colour per row, sampled from the art (its vignette is
+   vertical)
+ - starfield: NYAN_STAR_COUNT twinkling stars drawn procedurally, on two
+   parallax planes scrolling left at NYAN_SCROLL_PX_PER_S and twice that
+ - rainbow: the art's six stripes as a square wave scrolling at
+   NYAN_SCROLL_PX_PER_S, ending under the pop-tart
+ - cat: cut out of each art frame at boot and drawn straight from the
+   frame data (row spans), advancing every NYAN_ART_FRAME_MS
+
+The cut-out floods each frame from its edges through the colours of the
+scenery (background, white stars, rainbow stripes and the blends of
+neighbouring ones): what the flood can't reach is inside the cat's dark
+outline. Of that, only the largest 8-connected piece is kept, which drops
+stray blends of stars and stripes.
+
+nyanLayersAdvance() moves the scene to a time and adds what changed to a
+dirty region (old and new star boxes, the columns swept by the rainbow's
+steps, the old and new cat box); nyanLayersDraw() repaints a rectangle
+with all layers, back to front. Everything is a function of the time, so
+a replay draws the same frames.
+
+Plain C++ (no Arduino dependencies) so the host tools share it.
+*/
+
+#pragma once
+
+#include <stdint.h>
+#include <stddef.h>
+#include "dirty_region.h"
+
+const uint16_t NYAN_ART_FRAME_MS = 70;     // cat frame time of the original art
+const uint16_t NYAN_SCROLL_PX_PER_S = 120; // rainbow and the slower star plane
+const uint8_t NYAN_STAR_COUNT = 12;
+const uint8_t NYAN_STAR_SIZE = 7;          // star box, pixels square
+const int NYAN_RAINBOW_TOP = 63;           // top of the red stripe on a low segment
+const int NYAN_RAINBOW_STRIPE = 12;        // stripe height
+const int NYAN_RAINBOW_WAVE = 5;           // high segments are this much higher
+const int NYAN_RAINBOW_SEGMENT = 32;       // wave segment width
+const int NYAN_RAINBOW_END = 96;           // right end (under the pop-tart)
+const size_t NYAN_MAX_CAT_SPANS = 3072;    // all frames (the built-in art needs about 2300)
+const uint8_t NYAN_MAX_FRAMES = 32;
+const int NYAN_MAX_HEIGHT = 240;
+
+// Cat pixels frame[y * width + x .. + length - 1]
+struct CatSpan {
+  int16_t y, x, length;
+};
+
+struct CatFrame {
+  uint16_t first, count;   // spans
+  DirtyRect bounds;
+};
+
+struct NyanLayers {
+  const uint16_t* frames;  // native-order RGB565, frameCount x width x height
+  int frameCount, width, height;
+  CatSpan* spans;
+  CatFrame cats[NYAN_MAX_FRAMES];
+  uint16_t rowColour[NYAN_MAX_HEIGHT]; // background, native order
+  // Scene last passed to nyanLayersAdvance()
+  uint32_t scroll;         // pixels scrolled (slow plane)
+  uint32_t twinkle;        // star phase step
+  int catFrame;
+  bool placed;             // false until the first advance (everything dirty)
+};
+
+/*
+Cut the cat out of every frame (frames contiguous, as in nyancat[]) into
+spans (capacity entries); false if the art doesn't fit or no cat is found.
+Needs about 3 bytes per pixel of scratch memory while it runs (malloc).
+*/
+bool nyanLayersInit(NyanLayers& layers, const uint16_t* frames, int frameCount, int width, int height,
+                    CatSpan* spans, size_t capacity);
+
+// Total spans used by all frames
+size_t nyanLayersSpanCount(const NyanLayers& layers);
+
+// Cat frame shown at timeMs (the art's own rate)
+int nyanLayersCatFrame(const NyanLayers& layers, uint32_t timeMs);
+
+// Move the scene to timeMs with catFrame showing, adding every area that changes to region
+void nyanLayersAdvance(NyanLayers& layers, uint32_t timeMs, int catFrame, DirtyRegion& region);
+
+// Forget the last scene: the next advance marks the whole frame
+void nyanLayersReset(NyanLayers& layers);
+
+// Repaint rect of dst (width x height, sprite byte order) with every layer of the current scene
+void nyanLayersDraw(const NyanLayers& layers, uint16_t* dst, const DirtyRect& rect);
@@ -0,0 +1,50 @@
+/*************************************************************
+*********************** PIXEL KERNELS ************************
+**************************************************************/
+
+/*
+Bulk RGB565 pixel operations used by the compositor:
+ - copy with byte swap (flash image -> sprite buffer)
+ - colour-keyed copy (overlay sprite -> main sprite)
+ - solid fill
+
+All buffers are in TFT_eSprite byte order (high byte first) except the
+source of the swap copy, which is in the native order of the nyancat[] data.
+The key copy and half-width copy handle two pixels per 32-bit load/store;
+define PIXEL_KERNELS_SCALAR to force the plain per-pixel versions. Copy and
+fill are always per-pixel loops.
+*/
+
+#pragma once
+
+#include <stdint.h>
+#include <stddef.h>
+
+// Swap the bytes of a single RGB565 value (native <-> sprite order)
+static inline uint16_t pixelSwap(uint16_t colour) {
+  return (uint16_t)((colour << 8) | (colour >> 8));
+}
+
+// Copy count pixels, swapping the bytes of each one
+void pixelCopySwap(uint16_t* dst, const uint16_t* src, size_t count);
+
+// Copy count pixels, skipping every pixel equal to key (key in buffer order)
+void pixelKeyCopy(uint16_t* dst, const uint16_t* src, size_t count, uint16_t key);
+
+// Copy count pixels from every other source pixel, each written twice (half horizontal resolution), with the byte swap
+void pixelCopySwapHalf(uint16_t* dst, const uint16_t* src, size_t count);
+
+// Fill count pixels with colour (colour in buffer order)
+void pixelFill(uint16_t* dst, uint16_t colour, size_t count);
+
+/*
+Rectangle helpers working on whole surfaces:
+ - dst/dstWidth/dstHeight describe the destination surface
+ - the source rectangle is clipped against the destination
+*/
+void pixelBlitSwapRect(uint16_t* dst, int dstWidth, int dstHeight, int x, int y,
+                       const uint16_t* src, int srcWidth, int srcHeight);
+void pixelKeyBlitRect(uint16_t* dst, int dstWidth, int dstHeight, int x, int y,
+                      const uint16_t* src, int srcWidth, int srcHeight, uint16_t key);
+void pixelFillRect(uint16_t* dst, int dstWidth, int dstHeight, int x, int y,
+                   int w, int h, uint16_t colour);
@@ -0,0 +1,91 @@
+/*************************************************************
+********************** ADAPTIVE QUALITY **********************
+**************************************************************/
+
+/*
+Steps the rendering down when frames stop fitting their budget, and back
+up once there is headroom again, instead of letting the display stutter.
+Levels are cumulative (each keeps the savings of the ones before it;
+CLOCK_ONLY has no animation to slow down, so it renders every loop again):
+ - FULL
+ - REDUCED_OVERLAYS: overlay sprites redrawn every QUALITY_OVERLAY_INTERVAL
+   frames (still composited every frame)
+ - HALF_RES: the animation is blitted at half resolution (2x2 pixels)
+ - HALF_RATE: a frame is rendered every other loop (animation at half rate)
+ - CLOCK_ONLY: no animation, the clock on black
+
+The controller sorts each displayed frame's period (time since the
+previous displayed frame) into a small histogram relative to the budget
+(target x frame interval of the level). Every QUALITY_WINDOW_FRAMES
+frames it decides:
+ - down one level if QUALITY_DOWN_PERCENT of the window was over budget
+ - up one level after QUALITY_UP_WINDOWS windows in a row with
+   QUALITY_UP_PERCENT under QUALITY_HEADROOM_PERCENT of the budget, and
+   not before QUALITY_UP_HOLD_MS since the last change (hysteresis)
+Every transition is kept in a log with its time.
+
+Plain C++ (no Arduino dependencies).
+*/
+
+#pragma once
+
+#include <stdint.h>
+
+typedef enum {
+  QUALITY_FULL,
+  QUALITY_REDUCED_OVERLAYS,
+  QUALITY_HALF_RES,
+  QUALITY_HALF_RATE,
+  QUALITY_CLOCK_ONLY,
+  QUALITY_LEVEL_COUNT
+} quality_level_t;
+
+const uint8_t QUALITY_WINDOW_FRAMES = 30;
+const uint8_t QUALITY_DOWN_PERCENT = 20;      // of the window over budget
+const uint8_t QUALITY_UP_PERCENT = 90;        // of the window with headroom
+const uint8_t QUALITY_HEADROOM_PERCENT = 70;  // of the budget
+const uint8_t QUALITY_UP_WINDOWS = 3;
+const uint32_t QUALITY_UP_HOLD_MS = 5000;
+const uint8_t QUALITY_OVERLAY_INTERVAL = 4;   // frames between overlay redraws from REDUCED_OVERLAYS on
+const uint8_t QUALITY_LOG_SIZE = 16;
+
+// Window histogram buckets, as a percentage of the budget
+const uint8_t QUALITY_BUCKETS = 5;
+const uint16_t QUALITY_BUCKET_BOUNDS[QUALITY_BUCKETS - 1] = { 50, QUALITY_HEADROOM_PERCENT, 100, 150 };
+
+struct QualityTransition {
+  uint32_t atMillis;
+  quality_level_t from, to;
+  uint8_t overPercent;      // window that triggered it
+  uint8_t headroomPercent;
+  bool pinned;              // set by hand, not by the controller
+};
+
+struct QualityController {
+  uint32_t targetMicros;
+  quality_level_t level;
+  bool pinned;
+  uint16_t histogram[QUALITY_BUCKETS];
+  uint8_t windowFrames;
+  uint8_t calmWindows;
+  uint32_t changedMillis;
+  QualityTransition log[QUALITY_LOG_SIZE];
+  uint8_t logNext;
+  uint32_t transitions;
+};
+
+void qualityInit(QualityController& controller, uint32_t targetMicros);
+
+// A frame was displayed periodMicros after the previous one; true if the level changed
+bool qualityFrame(QualityController& controller, uint32_t periodMicros, uint32_t nowMillis);
+
+// Hold a level (controller off), or hand back to the controller with QUALITY_LEVEL_COUNT
+void qualityPin(QualityController& controller, quality_level_t level, uint32_t nowMillis);
+
+// Loops per displayed frame at a level (2 from HALF_RATE on)
+uint8_t qualityFrameInterval(quality_level_t level);
+
+const char* qualityLevelName(quality_level_t level);
+
+// Transition n (0 = oldest kept); false past the end
+bool qualityTransition(const QualityController& controller, uint8_t n, QualityTransition& transition);
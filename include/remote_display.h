@@ -0,0 +1,32 @@
+/*************************************************************
+*********************** REMOTE DISPLAY ***********************
+**************************************************************/
+
+/*
+Remote-display mode: frames pushed by a host over UDP (see remote_frame.h
+for the protocol and tools/remote_sender for the reference sender).
+*/
+
+#pragma once
+
+#include <stdint.h>
+#include "remote_frame.h"
+
+// Allocate the jitter buffer and start listening on REMOTE_PORT
+bool remoteDisplayBegin();
+
+// Move received packets into the jitter buffer (bounded per call)
+void remoteDisplayPoll();
+
+/*
+Decode due frames for display into frame (width x height):
+ - overlay = false: decoded straight into frame
+ - overlay = true: decoded into a persistent canvas that is copied into
+   frame, so overlays drawn on top never overwrite remote content
+*/
+void remoteDisplayRender(uint16_t* frame, int width, int height, bool overlay);
+
+// Ack the frames applied since the last call (call after the panel push)
+void remoteDisplayShown();
+
+const RemoteStats& remoteDisplayStats();
@@ -0,0 +1,103 @@
+/*************************************************************
+*********************** REMOTE FRAMES ************************
+**************************************************************/
+
+/*
+Protocol and jitter buffer for remote-display mode:
+ - the host sends each frame as UDP packets, one rectangle strip per packet,
+   raw or RLE565-coded, pixels in sprite byte order (high byte first)
+ - packets wait in a small jitter buffer until their frame is complete and
+   REMOTE_JITTER_US has passed since its first packet arrived
+ - complete frames are decoded straight into the target framebuffer in
+   frame order; incomplete frames overtaken by a newer complete one are
+   dropped and a keyframe is requested in the next ack
+ - after a frame is shown the device acks it, echoing the sender timestamp,
+   so the sender can measure end-to-end latency on its own clock
+
+Plain C++ (no Arduino dependencies) so the host sender/benchmark shares it.
+*/
+
+#pragma once
+
+#include <stdint.h>
+#include <stddef.h>
+
+const uint16_t REMOTE_PORT = 7866;
+const size_t REMOTE_MAX_PACKET = 1400;  // fits one Ethernet/WiFi MTU
+const uint8_t REMOTE_SLOTS = 96;        // packets held in the jitter buffer (~132 KB, one raw keyframe)
+const uint32_t REMOTE_JITTER_US = 20000; // playout delay after a frame's first packet
+
+// Packet flags
+const uint8_t REMOTE_FLAG_RLE = 0x01;      // payload is RLE565, otherwise raw pixels
+const uint8_t REMOTE_FLAG_KEYFRAME = 0x02; // frame repaints the whole screen
+
+// Ack flags
+const uint8_t REMOTE_ACK_NEED_KEYFRAME = 0x01; // a frame was dropped since the last ack
+
+// Packet header (little-endian, 28 bytes), followed by payloadLength bytes
+struct __attribute__((packed)) RemotePacketHeader {
+  char magic[4];          // "NYRD"
+  uint8_t version;        // REMOTE_VERSION
+  uint8_t flags;
+  uint16_t payloadLength;
+  uint32_t frameId;       // increments per frame
+  uint16_t packetIndex;   // 0..packetCount-1 within the frame
+  uint16_t packetCount;
+  uint32_t senderMicros;  // sender clock when the frame was encoded
+  uint16_t x, y, w, h;    // rectangle covered by this packet
+};
+
+// Ack sent back to the sender once a frame reached the panel
+struct __attribute__((packed)) RemoteAck {
+  char magic[4];          // "NYRA"
+  uint8_t version;
+  uint8_t flags;
+  uint16_t reserved;
+  uint32_t frameId;
+  uint32_t senderMicros;  // echoed from the frame's packets
+  uint32_t holdMicros;    // device time from last packet arrival to panel push
+};
+
+const uint8_t REMOTE_VERSION = 1;
+
+// Jitter buffer statistics
+struct RemoteStats {
+  uint32_t packetsReceived;
+  uint32_t packetsRejected;  // malformed, duplicate or late
+  uint32_t framesShown;
+  uint32_t framesDropped;
+  uint32_t decodeErrors;
+  uint32_t lastHoldMicros;
+};
+
+struct RemoteSlot {
+  bool used;
+  uint16_t length;
+  uint32_t arrivalMicros;
+  uint8_t data[REMOTE_MAX_PACKET];
+};
+
+struct RemoteJitterBuffer {
+  RemoteSlot* slots;     // REMOTE_SLOTS entries, caller-provided storage
+  bool anyShown;
+  uint32_t lastShownFrame;
+  bool needKeyframe;
+  RemoteStats stats;
+};
+
+void remoteJitterInit(RemoteJitterBuffer& buffer, RemoteSlot* slots);
+
+// Store a received packet; returns false if it was rejected
+bool remoteJitterPush(RemoteJitterBuffer& buffer, const uint8_t* packet, size_t length, uint32_t nowMicros);
+
+/*
+Decode every frame that is due into target (width x height, stride = width).
+Returns true if at least one frame was applied; ack then describes the newest.
+*/
+bool remoteJitterApply(RemoteJitterBuffer& buffer, uint16_t* target, int width, int height,
+                       uint32_t nowMicros, RemoteAck& ack);
+
+// Fill in a packet header
+void remotePacketInit(RemotePacketHeader& header, uint32_t frameId, uint16_t packetIndex, uint16_t packetCount,
+                      uint32_t senderMicros, uint8_t flags, uint16_t x, uint16_t y, uint16_t w, uint16_t h,
+                      uint16_t payloadLength);
@@ -0,0 +1,32 @@
+/*************************************************************
+*********************** RLE565 CODEC *************************
+**************************************************************/
+
+/*
+Run-length coding for 16-bit pixels (PackBits style), used for remote
+display updates. Pixels are copied as-is, so the byte order of the input
+is preserved.
+
+Token byte:
+ - 0x80 | (n - 1): run, the next pixel repeats n times (n = 1..128)
+ - n - 1:          literal, n pixels follow (n = 1..128)
+
+Rectangles are coded row after row as one continuous stream.
+Plain C++ (no Arduino dependencies) so the host tools share it.
+*/
+
+#pragma once
+
+#include <stdint.h>
+#include <stddef.h>
+
+// Worst case encoded size for count pixels
+static inline size_t rle565MaxSize(size_t count) {
+  return count * 2 + (count + 127) / 128;
+}
+
+// Encode a w x h rectangle (stride in pixels); returns bytes written or 0 if out is too small
+size_t rle565EncodeRect(const uint16_t* src, int stride, int w, int h, uint8_t* out, size_t capacity);
+
+// Decode into a w x h rectangle (stride in pixels); returns false on malformed/short input
+bool rle565DecodeRect(const uint8_t* in, size_t length, uint16_t* dst, int stride, int w, int h);
@@ -0,0 +1,29 @@
+/*************************************************************
+************************ SCREENSHOTS *************************
+**************************************************************/
+
+/*
+Screenshot capture for bug reports, over HTTP (GET /screenshot) or the
+serial console ("screenshot" command):
+ - the composed framebuffer is copied once into PSRAM when the request
+   arrives (between frames, well under a frame time), so later frames can
+   keep drawing while the copy is encoded
+ - the copy is encoded band by band (see screenshot_codec.h) and written a
+   few pieces per loop(), bounded like every other network/console output
+ - serial output is base64 in lines "SHOT BEGIN", "SHOT <data>", "SHOT END"
+   so it can be cut out of a mixed serial log
+ - one capture at a time; a capture abandoned for SCREENSHOT_STALE_MS is
+   released so a dropped client cannot lock it
+
+Decode either form with tools/screenshot_png.
+*/
+
+#pragma once
+
+#include <stdint.h>
+
+const uint8_t SCREENSHOT_CHUNKS_PER_POLL = 2;      // HTTP pieces written per loop()
+const unsigned long SCREENSHOT_STALE_MS = 5000;    // abandoned capture timeout
+
+// Register GET /screenshot and the console command for a width x height sprite buffer
+void screenshotBegin(const uint16_t* buffer, int width, int height);
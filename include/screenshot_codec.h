@@ -0,0 +1,71 @@
+/*************************************************************
+********************* SCREENSHOT CODEC ***********************
+**************************************************************/
+
+/*
+Screenshot stream format, produced on the device a piece at a time and
+decoded by tools/screenshot_png:
+ - ScreenshotHeader
+ - one record per band of SCREENSHOT_BAND_ROWS full-width rows:
+   u16 length, then the band as RLE565 (pixel art compresses well)
+ - ScreenshotTrailer with the CRC-32 of the raw pixel bytes
+
+The encoder keeps no state beyond the band index, so each piece it
+produces is bounded by screenshotChunkCapacity() and memory stays fixed
+however large the image is.
+
+Plain C++ (no Arduino dependencies) so the host tools share it.
+*/
+
+#pragma once
+
+#include <stdint.h>
+#include <stddef.h>
+
+const uint8_t SCREENSHOT_VERSION = 1;
+const uint16_t SCREENSHOT_BAND_ROWS = 10;
+
+// Header flags
+const uint8_t SCREENSHOT_FLAG_SWAPPED = 0x01; // pixels high byte first (sprite byte order)
+
+// Stream header (little-endian, 12 bytes)
+struct __attribute__((packed)) ScreenshotHeader {
+  char magic[4];      // "NYSS"
+  uint8_t version;    // SCREENSHOT_VERSION
+  uint8_t flags;      // SCREENSHOT_FLAG_*
+  uint16_t bandRows;
+  uint16_t width;
+  uint16_t height;
+};
+
+// Stream trailer (8 bytes)
+struct __attribute__((packed)) ScreenshotTrailer {
+  char magic[4];        // "NYSE"
+  uint32_t pixelCrc32;  // CRC of the pixels as stored (before any swap)
+};
+
+struct ScreenshotEncoder {
+  const uint16_t* pixels;
+  int width, height;
+  uint8_t flags;
+  int nextBand;         // -1 while the header is pending
+  int bandCount;
+  bool finished;
+  uint32_t crc;
+  uint8_t* out;         // caller-provided, screenshotChunkCapacity(width) bytes
+};
+
+// Bytes needed for the largest piece the encoder produces
+size_t screenshotChunkCapacity(int width);
+
+void screenshotEncoderInit(ScreenshotEncoder& encoder, const uint16_t* pixels, int width, int height,
+                           uint8_t flags, uint8_t* out);
+
+// Write the next piece of the stream to encoder.out; returns its length, 0 once complete
+size_t screenshotEncodeNext(ScreenshotEncoder& encoder);
+
+// Read the image size from a stream; false if the header is not valid
+bool screenshotReadHeader(const uint8_t* data, size_t length, int& width, int& height);
+
+// Decode a complete stream into width*height native-order pixels; false if malformed or corrupt
+bool screenshotDecode(const uint8_t* data, size_t length, uint16_t* pixels);
@@ -0,0 +1,78 @@
+/*************************************************************
+************************ SYNC CLOCK **************************
+**************************************************************/
+
+/*
+Shared animation timeline for a wall of clocks:
+ - the leader multicasts a beacon with its clock, the timeline epoch,
+   the frame period and the frame count
+ - followers estimate (leader clock - local clock) from the beacons and
+   derive the frame index from the leader's timeline
+
+Jitter filtering: network delay only ever makes a beacon look older, so the
+largest offset seen over the last SYNC_WINDOW beacons is the best estimate.
+The applied offset slews towards it by at most SYNC_SLEW_MS per beacon and
+steps only when it is more than SYNC_STEP_MS away.
+
+Plain C++ (no Arduino dependencies) so the host sync tool shares it.
+*/
+
+#pragma once
+
+#include <stdint.h>
+
+// Multicast group and port for beacons
+#define SYNC_MULTICAST_GROUP 239, 78, 89, 65
+const uint16_t SYNC_PORT = 7865;
+
+const uint8_t SYNC_WINDOW = 16;                  // beacons kept for the offset filter
+const int32_t SYNC_SLEW_MS = 2;                  // max offset correction per beacon
+const int32_t SYNC_STEP_MS = 100;                // larger errors are corrected at once
+const unsigned long SYNC_BEACON_INTERVAL = 200;  // ms between leader beacons
+const unsigned long SYNC_LOST_TIMEOUT = 5000;    // follower unlocks after this long without beacons
+
+// Beacon packet (little-endian, 24 bytes)
+struct __attribute__((packed)) SyncBeacon {
+  char magic[4];        // "NYSY"
+  uint8_t version;      // SYNC_VERSION
+  uint8_t reserved[3];
+  uint32_t sequence;    // incremented per beacon
+  uint32_t leaderMillis; // leader clock when sent
+  uint32_t epochMillis;  // timeline origin, leader clock
+  uint32_t framePeriodUs; // duration of one animation frame
+  uint16_t frameCount;  // frames in the animation loop
+  uint16_t reserved2;
+};
+
+const uint8_t SYNC_VERSION = 1;
+
+// Follower clock state
+struct SyncClock {
+  int32_t samples[SYNC_WINDOW]; // recent (leader - local) offsets
+  uint8_t sampleCount;
+  uint8_t nextSample;
+  int32_t offset;               // applied offset: leader = local + offset
+  bool locked;                  // at least one beacon received
+  uint32_t lastBeaconMillis;    // local clock at the last beacon
+  uint32_t epochMillis;
+  uint32_t framePeriodUs;
+  uint16_t frameCount;
+};
+
+// Fill in a beacon for the given timeline
+void syncBeaconInit(SyncBeacon& beacon, uint32_t sequence, uint32_t leaderMillis,
+                    uint32_t epochMillis, uint32_t framePeriodUs, uint16_t frameCount);
+
+// Check magic and version of a received packet
+bool syncBeaconValid(const void* data, int length);
+
+void syncClockReset(SyncClock& clock);
+
+// Feed a beacon received at local time localMillis
+void syncClockSample(SyncClock& clock, const SyncBeacon& beacon, uint32_t localMillis);
+
+// Timeline position (microseconds since the leader's epoch) at local time localMillis
+uint64_t syncClockTimelineMicros(const SyncClock& clock, uint32_t localMillis);
+
+// Animation frame index at local time localMillis
+uint16_t syncClockFrame(const SyncClock& clock, uint32_t localMillis);
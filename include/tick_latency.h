@@ -0,0 +1,57 @@
+/*************************************************************
+*********************** TICK LATENCY *************************
+**************************************************************/
+
+/*
+Keeps the seconds display in phase with the real second boundary:
+ - the local second counter is aligned to the sub-second phase of the
+   NTP time (main.cpp), so "the boundary" is a known millis() instant
+ - a frame needs some time from loop() start until its pixels are on the
+   panel; the new second is drawn in the first frame that starts no earlier
+   than that render time before the boundary, so it lands just after it.
+   The render time is the shortest of the last TICK_LEAD_FRAMES frames:
+   erring short means a little later, never ahead of the real second
+ - tick-to-photon latency is measured for every frame that shows a new
+   second: from the boundary until the backend reports the frame complete
+   on the panel (negative = shown early)
+
+"Photon" is the end of the transfer into panel RAM; the panel's own scan
+adds up to one refresh period on top, which can't be observed here.
+
+Plain C++ (no Arduino dependencies).
+*/
+
+#pragma once
+
+#include <stdint.h>
+
+const uint8_t TICK_LEAD_FRAMES = 8;           // render times the lead is taken from
+const uint32_t TICK_LEAD_MAX_US = 100000;     // longer frames are not waited for
+const uint8_t TICK_HISTOGRAM_BUCKETS = 6;     // latency histogram buckets (plus +Inf)
+const uint32_t TICK_HISTOGRAM_BOUNDS_US[TICK_HISTOGRAM_BUCKETS] = { 5000, 10000, 20000, 35000, 50000, 100000 };
+
+struct TickLatencyStats {
+  uint32_t ticks;           // new seconds shown (and measured)
+  uint32_t early;           // shown before the boundary
+  int32_t lastMicros;
+  int32_t minMicros, maxMicros;
+  int64_t totalMicros;
+  uint32_t histogram[TICK_HISTOGRAM_BUCKETS + 1]; // by latency, early ones in the first bucket
+};
+
+struct TickLatency {
+  uint32_t renderMicros[TICK_LEAD_FRAMES]; // loop() start until complete on the panel
+  uint8_t renderNext, renderCount;
+  TickLatencyStats stats;
+};
+
+void tickLatencyInit(TickLatency& tick);
+
+// A rendered frame took renderMicros from loop() start until it was complete on the panel
+void tickLatencyFrame(TickLatency& tick, uint32_t renderMicros);
+
+// How long before a boundary the frame showing the new second should start
+uint32_t tickLatencyLeadMicros(const TickLatency& tick);
+
+// The frame with a new second was complete on the panel latencyMicros after the boundary
+void tickLatencyShown(TickLatency& tick, int32_t latencyMicros);
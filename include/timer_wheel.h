@@ -0,0 +1,93 @@
+/*************************************************************
+************************ TIMER WHEEL *************************
+**************************************************************/
+
+/*
+Timer service on a hierarchical timing wheel (millisecond ticks):
+ - TIMER_WHEEL_LEVELS levels of TIMER_WHEEL_SLOTS slots; level L slots are
+   64^L ms wide, so the wheel spans 64^4 ms (4.6 hours). Later deadlines
+   wait in the last slot of the top level and are placed again from there
+ - a timer sits in the slot of its deadline at the lowest level that can
+   hold it; when level 0 wraps, the next slot of level 1 is spread over
+   level 0, and so on up (each timer moves down at most LEVELS - 1 times)
+ - arm and cancel are O(1) list operations; an occupancy bitmap per level
+   lets advancing skip empty slots and answers "next deadline" with one
+   bit scan per level plus one slot list
+ - timers are caller-owned (no allocation); callbacks run inside
+   timerWheelAdvance() and may arm or cancel any timer, including their own
+   and others due at the same tick (the due slot is moved to a list the
+   wheel still owns and is run one timer at a time, so those are unlinked
+   like any other)
+
+Periodic timers are re-armed on their own schedule (deadline + period),
+skipping periods that were missed entirely, so they don't drift.
+Times are millis() values and may wrap.
+
+Plain C++ (no Arduino dependencies).
+*/
+
+#pragma once
+
+#include <stdint.h>
+
+const uint8_t TIMER_WHEEL_LEVELS = 4;
+const uint8_t TIMER_WHEEL_SLOT_BITS = 6;
+const uint8_t TIMER_WHEEL_SLOTS = 1 << TIMER_WHEEL_SLOT_BITS;
+const uint8_t TIMER_DUE_LEVEL = TIMER_WHEEL_LEVELS; // Timer::level of timers in TimerWheel::due
+
+typedef void (*timer_callback_t)(void* context);
+
+struct Timer {
+  Timer* next;              // slot list, while armed
+  Timer* prev;
+  uint32_t deadline;        // millis() it fires at
+  uint32_t period;          // re-armed this long after the deadline (0 = one-shot)
+  timer_callback_t callback;
+  void* context;
+  const char* name;
+  bool armed;
+  uint8_t level, slot;
+};
+
+struct TimerWheel {
+  Timer* slots[TIMER_WHEEL_LEVELS][TIMER_WHEEL_SLOTS];
+  uint64_t occupied[TIMER_WHEEL_LEVELS]; // bit per non-empty slot
+  Timer* due;               // timers of the tick being expired, not run yet
+  uint32_t next;            // first tick not processed yet
+  uint32_t now;             // time of the last advance (what callbacks see as "now")
+  uint16_t armedCount;
+  uint32_t fired;           // callbacks run since init
+};
+
+// Saved arm state of a timer (for the input record/replay state)
+struct TimerSnapshot {
+  uint32_t deadline;
+  uint32_t period;
+  bool armed;
+};
+
+// Empty wheel at time now
+void timerWheelInit(TimerWheel& wheel, uint32_t now);
+
+// Set up a timer (not armed)
+void timerInit(Timer& timer, const char* name, timer_callback_t callback, void* context);
+
+// Arm (or re-arm) to fire delayMillis after the wheel's now, then every periodMillis if not 0
+void timerArm(TimerWheel& wheel, Timer& timer, uint32_t delayMillis, uint32_t periodMillis = 0);
+
+// Arm at an absolute deadline (one not after the wheel's now fires at the next advance to a later time)
+void timerArmAt(TimerWheel& wheel, Timer& timer, uint32_t deadline, uint32_t periodMillis = 0);
+
+void timerCancel(TimerWheel& wheel, Timer& timer);
+
+// Milliseconds until the timer fires (0 if due or not armed)
+uint32_t timerRemaining(const TimerWheel& wheel, const Timer& timer);
+
+// Run everything due up to and including now; returns the number of callbacks run
+uint32_t timerWheelAdvance(TimerWheel& wheel, uint32_t now);
+
+// Earliest deadline of all armed timers; false if none is armed
+bool timerWheelNextDeadline(const TimerWheel& wheel, uint32_t& deadline);
+
+void timerSave(const Timer& timer, TimerSnapshot& snapshot);
+void timerRestore(TimerWheel& wheel, Timer& timer, const TimerSnapshot& snapshot);
@@ -0,0 +1,69 @@
+/*************************************************************
+************************ WEB SERVER **************************
+**************************************************************/
+
+/*
+Minimal non-blocking HTTP/1.1 server:
+ - fixed pool of connections, no heap allocation per request
+ - polled from loop() with a time budget so it never starves rendering
+ - handlers are called once per poll until they report completion,
+   which lets long responses (streams, uploads) be spread over many frames
+*/
+
+#pragma once
+
+#include <Arduino.h>
+#include <WiFi.h>
+
+// Server parameters
+const uint16_t WEB_SERVER_PORT = 80;
+const uint8_t WEB_MAX_CONNECTIONS = 4;         // simultaneous clients
+const unsigned long WEB_IDLE_TIMEOUT = 10000;  // drop clients that send/take no data for 10s (headers or handler)
+const unsigned long WEB_POLL_BUDGET_US = 2000; // max time spent per poll
+
+// Connection states
+typedef enum {
+  WEB_CONN_FREE,    // slot unused
+  WEB_CONN_HEADERS, // reading request line and headers
+  WEB_CONN_HANDLER  // request parsed, handler running
+} web_conn_state_t;
+
+// One client connection and its parsed request
+struct WebConnection {
+  WiFiClient client;
+  web_conn_state_t state;
+  char method[8];             // GET, PUT, ...
+  char path[48];              // request path (query string stripped)
+  char line[96];              // header line being assembled
+  uint8_t lineLength;
+  uint32_t contentLength;     // from Content-Length, 0 if absent
+  uint32_t handlerCalls;      // 0 on the first handler call
+  unsigned long lastActivity; // millis() of last read/write
+  uint32_t scratch[4];        // per-request handler state
+};
+
+/*
+Route handler:
+ - called on every poll while the request is active
+ - return true to be called again, false when the response is complete
+*/
+typedef bool (*WebHandler)(WebConnection& conn);
+
+// Register a handler for method + exact path (call before webServerBegin)
+bool webServerOn(const char* method, const char* path, WebHandler handler);
+
+// Start listening
+void webServerBegin();
+
+// Accept, parse and service clients, bounded by WEB_POLL_BUDGET_US
+void webServerPoll();
+
+// Response helpers
+void webSendHeader(WebConnection& conn, int status, const char* contentType, bool chunked);
+void webSendChunk(WebConnection& conn, const void* data, size_t length);
+void webSendChunkParts(WebConnection& conn, const void* a, size_t aLength, const void* b, size_t bLength);
+void webEndChunks(WebConnection& conn);
+void webSendText(WebConnection& conn, int status, const char* text);
+
+// True if conn is still running the handler for method + path (a dropped client's slot may serve another request)
+bool webConnectionServes(const WebConnection* conn, const char* method, const char* path);
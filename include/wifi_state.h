@@ -0,0 +1,27 @@
+/*************************************************************
+************************ WIFI STATES *************************
+**************************************************************/
+
+#pragma once
+
+// WiFi connection states
+typedef enum {
+  WIFI_STATE_DISCONNECTED, // not connected, idle
+  WIFI_STATE_CONNECTING,   // attempting to connect
+  WIFI_STATE_CONNECTED,    // successfully connected
+  WIFI_STATE_RECONNECTING, // lost connection, trying to reconnect
+  WIFI_STATE_FAILED,       // connection failed (after max retries)
+  WIFI_STATE_COUNT         // number of states (not a state)
+} wifi_state_t;
+
+// Lowercase state name for logs and metrics labels
+static inline const char* wifiStateName(wifi_state_t state) {
+  switch (state) {
+    case WIFI_STATE_DISCONNECTED: return "disconnected";
+    case WIFI_STATE_CONNECTING: return "connecting";
+    case WIFI_STATE_CONNECTED: return "connected";
+    case WIFI_STATE_RECONNECTING: return "reconnecting";
+    case WIFI_STATE_FAILED: return "failed";
+    default: return "unknown";
+  }
+}
@@ -0,0 +1,125 @@
+/*************************************************************
+******************** ANIMATION CONTAINER *********************
+**************************************************************/
+
+#include <string.h>
+#include "anim_container.h"
+#include "rle565.h"
+
+// Nibble table keeps the CRC cheap without a 1 KB table
+static const uint32_t crcNibbleTable[16] = {
+  0x00000000, 0x1DB71064, 0x3B6E20C8, 0x26D930AC, 0x76DC4190, 0x6B6B51F4, 0x4DB26158, 0x5005713C,
+  0xEDB88320, 0xF00F9344, 0xD6D6A3E8, 0xCB61B38C, 0x9B64C2B0, 0x86D3D2D4, 0xA00AE278, 0xBDBDF21C
+};
+
+uint32_t crc32Update(uint32_t crc, const void* data, size_t length) {
+  const uint8_t* bytes = (const uint8_t*)data;
+  crc = ~crc;
+  while (length--) {
+    crc ^= *bytes++;
+    crc = (crc >> 4) ^ crcNibbleTable[crc & 0x0F];
+    crc = (crc >> 4) ^ crcNibbleTable[crc & 0x0F];
+  }
+  return ~crc;
+}
+
+void animHeaderFinish(AnimHeader& header, uint32_t payloadCrc32) {
+  memcpy(header.magic, "NYAN", 4);
+  header.version = ANIM_VERSION;
+  header.headerSize = sizeof(AnimHeader);
+  header.payloadCrc32 = payloadCrc32;
+  header.headerCrc32 = crc32Update(0, &header, offsetof(AnimHeader, headerCrc32));
+}
+
+uint32_t animDurationsBytes(const AnimHeader& header) {
+  return (header.flags & ANIM_FLAG_DURATIONS) ? (uint32_t)header.frameCount * 2 : 0;
+}
+
+// Function to get the payload bytes before the durations table
+static uint32_t frameDataBytes(const AnimHeader& header) {
+  return header.payloadBytes - animDurationsBytes(header);
+}
+
+bool animHeaderValid(const AnimHeader& header, uint32_t maxBytes) {
+  if (memcmp(header.magic, "NYAN", 4) != 0 || header.version < ANIM_VERSION_MIN || header.version > ANIM_VERSION ||
+      header.headerSize != sizeof(AnimHeader)) {
+    return false;
+  }
+  if (header.flags & ~ANIM_FLAG_DURATIONS || (header.version < 2 && header.flags)) {
+    return false;
+  }
+  if (header.headerCrc32 != crc32Update(0, &header, offsetof(AnimHeader, headerCrc32))) {
+    return false;
+  }
+  if (header.width == 0 || header.height == 0 || header.frameCount == 0) {
+    return false;
+  }
+  if (header.frameBytes != (uint32_t)header.width * header.height * 2) {
+    return false;
+  }
+  if (header.payloadBytes < animDurationsBytes(header)) {
+    return false;
+  }
+  if (header.encoding == ANIM_ENC_RAW565 && frameDataBytes(header) != header.frameBytes * header.frameCount) {
+    return false;
+  }
+  if (header.encoding == ANIM_ENC_RLE565 && frameDataBytes(header) < ((uint32_t)header.frameCount + 1) * 4) {
+    return false;
+  }
+  if (header.encoding == ANIM_ENC_PAL8 &&
+      (header.version < 2 ||
+       frameDataBytes(header) != ANIM_PALETTE_BYTES + (uint32_t)header.width * header.height * header.frameCount)) {
+    return false;
+  }
+  if (header.encoding != ANIM_ENC_RAW565 && header.encoding != ANIM_ENC_RLE565 && header.encoding != ANIM_ENC_PAL8) {
+    return false;
+  }
+  return (uint64_t)header.headerSize + header.payloadBytes <= maxBytes;
+}
+
+bool animDecodeFrame(const AnimHeader& header, const uint8_t* payload, int index, uint16_t* pixels) {
+  if (index < 0 || index >= header.frameCount) {
+    return false;
+  }
+  if (header.encoding == ANIM_ENC_RAW565) {
+    memcpy(pixels, payload + (size_t)index * header.frameBytes, header.frameBytes);
+    return true;
+  }
+  if (header.encoding == ANIM_ENC_PAL8) {
+    // Palette copied out first: the lookups then hit RAM instead of the (flash) payload
+    uint16_t palette[ANIM_PALETTE_SIZE];
+    memcpy(palette, payload, ANIM_PALETTE_BYTES);
+    size_t count = (size_t)header.width * header.height;
+    const uint8_t* indices = payload + ANIM_PALETTE_BYTES + (size_t)index * count;
+    for (size_t i = 0; i < count; i++) {
+      pixels[i] = palette[indices[i]];
+    }
+    return true;
+  }
+
+  uint32_t start, end;
+  memcpy(&start, payload + (size_t)index * 4, 4);
+  memcpy(&end, payload + (size_t)index * 4 + 4, 4);
+  if (start > end || end > frameDataBytes(header)) {
+    return false;
+  }
+  return rle565DecodeRect(payload + start, end - start, pixels, header.width, header.width, header.height);
+}
+
+uint16_t animFrameDurationMs(const AnimHeader& header, const uint8_t* payload, int index) {
+  if (!(header.flags & ANIM_FLAG_DURATIONS) || index < 0 || index >= header.frameCount) {
+    return 0;
+  }
+  uint16_t duration;
+  memcpy(&duration, payload + frameDataBytes(header) + (size_t)index * 2, 2);
+  return duration;
+}
+
+bool animDurationsValid(const AnimHeader& header, const uint8_t* payload) {
+  for (int i = 0; i < header.frameCount && (header.flags & ANIM_FLAG_DURATIONS); i++) {
+    if (animFrameDurationMs(header, payload, i) == 0) {
+      return false;
+    }
+  }
+  return true;
+}
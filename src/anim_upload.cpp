@@ -0,0 +1,187 @@
+/*************************************************************
+********************** ANIMATION UPLOAD **********************
+**************************************************************/
+
+#include <Arduino.h>
+#include <esp_partition.h>
+#include "anim_upload.h"
+#include "anim_container.h"
+#include "animation.h"
+#include "metrics.h"
+#include "web_server.h"
+
+// Upload in progress (one at a time)
+static WebConnection* uploader = nullptr;
+static const esp_partition_t* target = nullptr;
+static int targetSlot = 0;
+static AnimHeader header;
+static uint32_t received = 0;     // body bytes consumed
+static uint32_t written = 0;      // bytes committed to flash
+static uint32_t erased = 0;       // bytes erased (ahead of written while waiting for data)
+static uint32_t eraseEnd = 0;     // content length rounded up to whole sectors
+static uint32_t payloadCrc = 0;
+static uint16_t sectorFill = 0;
+
+// Impact on rendering while the upload runs
+static unsigned long uploadStart = 0;
+static uint32_t uploadFrames = 0, uploadWorstFrame = 0;
+static uint32_t eraseWorstMicros = 0, writeWorstMicros = 0; // longest flash stall of each kind
+
+// Sector staging and read-back buffers
+static uint8_t sectorBuffer[UPLOAD_SECTOR_SIZE];
+static uint8_t verifyBuffer[UPLOAD_SECTOR_SIZE];
+
+// Function to erase the next sector of the upload; returns false on flash errors
+static bool eraseSector() {
+  unsigned long start = micros();
+  esp_err_t result = esp_partition_erase_range(target, erased, UPLOAD_SECTOR_SIZE);
+  eraseWorstMicros = max(eraseWorstMicros, (uint32_t)(micros() - start));
+  if (result != ESP_OK) return false;
+  erased += UPLOAD_SECTOR_SIZE;
+  return true;
+}
+
+// Function to write and verify the staged sector (already erased); returns false on flash errors
+static bool flushSector() {
+  unsigned long start = micros();
+  esp_err_t result = esp_partition_write(target, written, sectorBuffer, sectorFill);
+  writeWorstMicros = max(writeWorstMicros, (uint32_t)(micros() - start));
+  if (result != ESP_OK) return false;
+  if (esp_partition_read(target, written, verifyBuffer, sectorFill) != ESP_OK) return false;
+  if (memcmp(sectorBuffer, verifyBuffer, sectorFill) != 0) return false;
+  written += UPLOAD_SECTOR_SIZE;
+  sectorFill = 0;
+  return true;
+}
+
+// Function to end the upload with an error, leaving the target slot unusable
+static bool failUpload(WebConnection& conn, int status, const char* reason) {
+  if (target && written > 0) {
+    esp_partition_erase_range(target, 0, UPLOAD_SECTOR_SIZE); // invalidate the header
+  }
+  Serial.printf("upload: failed after %u bytes: %s", (unsigned)received, reason);
+  webSendText(conn, status, reason);
+  uploader = nullptr;
+  return false;
+}
+
+// Function to start an upload on the first handler call
+static bool startUpload(WebConnection& conn) {
+  if (uploader && uploader != &conn && webConnectionServes(uploader, "PUT", "/animation")) {
+    webSendText(conn, 409, "upload already in progress\n");
+    return false;
+  }
+
+  // Always write the slot that is not playing
+  targetSlot = animationActiveSlot() == 0 ? 1 : 0;
+  target = (const esp_partition_t*)animationPartition(targetSlot);
+  if (!target) {
+    webSendText(conn, 503, "no animation partition\n");
+    return false;
+  }
+  if (conn.contentLength < sizeof(AnimHeader) || conn.contentLength > target->size) {
+    webSendText(conn, 413, "bad content length\n");
+    return false;
+  }
+
+  uploader = &conn;
+  received = 0;
+  written = 0;
+  erased = 0;
+  eraseEnd = (conn.contentLength + UPLOAD_SECTOR_SIZE - 1) / UPLOAD_SECTOR_SIZE * UPLOAD_SECTOR_SIZE;
+  eraseWorstMicros = writeWorstMicros = 0;
+  payloadCrc = 0;
+  sectorFill = 0;
+  uploadStart = millis();
+  uploadFrames = 0;
+  uploadWorstFrame = 0;
+  return true;
+}
+
+// PUT /animation handler
+static bool handleUpload(WebConnection& conn) {
+  if (conn.handlerCalls == 0 && !startUpload(conn)) {
+    return false;
+  }
+
+  // Track frame times while flash writes are interleaved with rendering
+  if (conn.handlerCalls > 0) {
+    uploadFrames++;
+    uploadWorstFrame = max(uploadWorstFrame, metricsLastFrameMicros());
+  }
+
+  // Flash operations (sector erases and writes) stall the cache on both cores: a bounded number per poll
+  uint8_t flashOps = 0;
+  while (flashOps < UPLOAD_FLASH_OPS_PER_POLL) {
+    // A full (or the last) staged sector goes out once its flash is erased
+    if (sectorFill == UPLOAD_SECTOR_SIZE || (sectorFill && received == conn.contentLength)) {
+      bool ok = erased > written ? flushSector() : eraseSector();
+      if (!ok) return failUpload(conn, 500, "flash write failed\n");
+      flashOps++;
+      continue;
+    }
+    if (received == conn.contentLength) break;
+
+    int available = conn.client.available();
+    if (available <= 0) {
+      if (!conn.client.connected()) return failUpload(conn, 400, "connection closed early\n");
+      break; // wait for more data
+    }
+
+    // Fill the staging sector
+    size_t want = min((size_t)(UPLOAD_SECTOR_SIZE - sectorFill), (size_t)(conn.contentLength - received));
+    int count = conn.client.read(sectorBuffer + sectorFill, min(want, (size_t)available));
+    if (count <= 0) return true;
+
+    // Header checks as soon as it is complete; CRC over payload bytes only
+    uint32_t offset = received;
+    if (offset < sizeof(AnimHeader) && offset + count >= sizeof(AnimHeader)) {
+      memcpy(&header, sectorBuffer, sizeof(header)); // header sits at the start of the first sector
+      if (!animHeaderValid(header, target->size) || header.headerSize + header.payloadBytes != conn.contentLength) {
+        return failUpload(conn, 400, "invalid animation header\n");
+      }
+    }
+    uint32_t payloadStart = offset < sizeof(AnimHeader) ? sizeof(AnimHeader) - offset : 0;
+    if (payloadStart < (uint32_t)count) {
+      payloadCrc = crc32Update(payloadCrc, sectorBuffer + sectorFill + payloadStart, count - payloadStart);
+    }
+
+    sectorFill += count;
+    received += count;
+    conn.lastActivity = millis();
+  }
+
+  // A poll left with flash budget (waiting on the network) erases ahead of the data
+  if (flashOps < UPLOAD_FLASH_OPS_PER_POLL && erased < eraseEnd) {
+    if (!eraseSector()) return failUpload(conn, 500, "flash erase failed\n");
+  }
+
+  if (received < conn.contentLength || sectorFill) {
+    return true;
+  }
+
+  // Everything written and read back: check the payload, then switch
+  if (payloadCrc != header.payloadCrc32) {
+    return failUpload(conn, 400, "payload CRC mismatch\n");
+  }
+  if (!animationSelect(targetSlot)) {
+    return failUpload(conn, 500, "slot verification failed\n");
+  }
+
+  unsigned long elapsed = max(1UL, millis() - uploadStart);
+  char summary[200];
+  snprintf(summary, sizeof(summary),
+           "slot %d active: %u frames, %u bytes in %lu ms (%.1f KB/s), %u frames rendered, worst %.1f ms"
+           " (flash stall: erase %.1f ms, write %.1f ms)\n",
+           targetSlot, header.frameCount, (unsigned)received, elapsed, received / 1.024 / elapsed,
+           (unsigned)uploadFrames, uploadWorstFrame / 1000.0, eraseWorstMicros / 1000.0, writeWorstMicros / 1000.0);
+  Serial.print("upload: ");
+  Serial.print(summary);
+  webSendText(conn, 201, summary);
+  uploader = nullptr;
+  return false;
+}
+
+void animationUploadBegin() {
+  webServerOn("PUT", "/animation", handleUpload);
+}
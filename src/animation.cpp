@@ -0,0 +1,346 @@
+/*************************************************************
+************************* ANIMATION **************************
+**************************************************************/
+
+#include <Arduino.h>
+#include <Preferences.h>
+#include <esp_partition.h>
+#include <freertos/FreeRTOS.h>
+#include <freertos/task.h>
+#include "animation.h"
+#include "anim_container.h"
+#include "frame_cache.h"
+#include "frame_prefetch.h"
+#include "frame_ring.h"
+#include "mem_arena.h"
+#include "nyancat.h"
+
+const uint32_t DECODER_STACK = 4096;     // bytes
+const uint32_t DECODER_IDLE_MS = 5;      // re-check interval while the ring is full
+const uint32_t DECODER_FIRST_FRAME_MS = 250; // longest wait for frame 0 when a slot is selected
+
+static const char* partitionNames[ANIM_FLASH_SLOTS] = { "anim0", "anim1" };
+
+// Active source (swapped between frames, so a single pointer update is atomic for the renderer)
+static int activeSlot = ANIM_SLOT_BUILTIN;
+static const uint16_t* activeFrames = nullptr;
+static int activeCount = 0, activeWidth = 0, activeHeight = 0;
+static spi_flash_mmap_handle_t activeMapping = 0;
+static bool activeMapped = false;
+
+// Compressed slots: frames come from the decoder task (other core) through the ring
+static AnimHeader activeHeader;
+static const uint8_t* activePayload = nullptr;
+static bool activeCompressed = false;
+static FrameRing decoderRing;
+static uint16_t* ringSlots[FRAME_RING_SLOTS];
+static bool ringReserved = false;
+static TaskHandle_t decoderTask = nullptr;
+static uint32_t decodeMicrosTotal = 0, decodeMicrosLast = 0, decodeCount = 0;
+
+// Decoded frames kept for the next loop of the animation (filled by the decoder task)
+static FrameCache frameCache;
+static uint16_t* cacheBuffers[FRAME_CACHE_MAX_ENTRIES];
+static uint8_t cacheBufferCount = 0;
+static size_t cacheBudgetPsram = 0;
+
+// Per-frame durations of the active slot (nullptr payload: untimed)
+static AnimHeader timingHeader;
+static const uint8_t* timingPayload = nullptr;
+static uint32_t generation = 0;
+
+// Raw frames: next frame staged in SRAM by the prefetch task (other core)
+static bool prefetchWanted = false;
+
+const void* animationPartition(int slot) {
+  if (slot < 0 || slot >= ANIM_FLASH_SLOTS) return nullptr;
+  return esp_partition_find_first(ESP_PARTITION_TYPE_DATA, (esp_partition_subtype_t)ANIM_PARTITION_SUBTYPE,
+                                  partitionNames[slot]);
+}
+
+// Function to point the renderer at the compiled-in frames
+static void useBuiltin() {
+  activeSlot = ANIM_SLOT_BUILTIN;
+  activeFrames = nyancat[0];
+  activeCount = framesNumber;
+  activeWidth = aniWidth;
+  activeHeight = aniHeigth;
+  timingPayload = nullptr;
+}
+
+const uint16_t* animationBuiltinFrames(int& count, int& width, int& height) {
+  count = framesNumber;
+  width = aniWidth;
+  height = aniHeigth;
+  return nyancat[0];
+}
+
+static uint32_t clockMicros() {
+  return micros();
+}
+
+// Function to decode one frame of the active slot (cache miss)
+static bool decodeSlotFrame(int index, uint16_t* pixels, void* context) {
+  unsigned long start = micros();
+  bool ok = animDecodeFrame(activeHeader, activePayload, index, pixels);
+  decodeMicrosLast = micros() - start;
+  decodeMicrosTotal += decodeMicrosLast;
+  decodeCount++;
+  return ok;
+}
+
+// Decode callback for the ring (decoder task): cached copy, or decode
+static bool decodeFrame(int index, uint16_t* pixels, void* context) {
+  return frameCacheFill(frameCache, index, pixels, decodeSlotFrame, nullptr, clockMicros);
+}
+
+// Function to reserve the decode ring and frame cache once (full-size frames, from the PSRAM arena). The ring
+// is taken whole or not at all: a partial ring can't decode, and slots falling back to the internal arena
+// would strand the SRAM the prefetch staging needs
+static void reserveDecodeBuffers() {
+  if (memArenaFree(MEM_TIER_PSRAM) < FRAME_RING_SLOTS * (size_t)ANIM_MAX_FRAME_BYTES) {
+    Serial.println("animation: no PSRAM for the decode ring, compressed slots disabled");
+    return;
+  }
+  for (uint8_t i = 0; i < FRAME_RING_SLOTS; i++) {
+    ringSlots[i] = (uint16_t*)memArenaAlloc("decode ring", ANIM_MAX_FRAME_BYTES, MEM_TIER_PSRAM);
+  }
+  ringReserved = true;
+
+  uint8_t entries = frameCacheEntriesFor(min(cacheBudgetPsram, memArenaFree(MEM_TIER_PSRAM)), ANIM_MAX_FRAME_BYTES,
+                                         FRAME_CACHE_MAX_ENTRIES);
+  while (cacheBufferCount < entries) {
+    cacheBuffers[cacheBufferCount++] = (uint16_t*)memArenaAlloc("frame cache", ANIM_MAX_FRAME_BYTES, MEM_TIER_PSRAM);
+  }
+}
+
+// Function to point the frame cache at as many reserved buffers as the animation can use
+static void resetCache(const AnimHeader& header) {
+  uint8_t entries = cacheBufferCount;
+  if (entries > header.frameCount) entries = header.frameCount;
+  frameCacheInit(frameCache, cacheBuffers, entries, header.frameBytes);
+}
+
+// Decoder task: fill the ring, sleep when it is full until the renderer takes a frame
+static void decoderLoop(void* parameter) {
+  for (;;) {
+    if (!frameRingProduce(decoderRing)) {
+      ulTaskNotifyTake(pdTRUE, pdMS_TO_TICKS(DECODER_IDLE_MS));
+    }
+  }
+}
+
+// Function to stop decoding (before the mapping it reads from goes away)
+static void stopDecoder() {
+  if (activeCompressed) {
+    frameRingStop(decoderRing);
+    activeCompressed = false;
+  }
+}
+
+// Function to start decoding a mapped compressed slot; false without a ring or for oversized frames
+static bool startDecoder(const AnimHeader& header, const uint8_t* payload) {
+  if (!ringReserved || header.frameBytes > ANIM_MAX_FRAME_BYTES) {
+    Serial.println(ringReserved ? "animation: frames too large to decode" : "animation: compressed slots need PSRAM");
+    return false;
+  }
+  if (!decoderTask) {
+    BaseType_t otherCore = xPortGetCoreID() ^ 1;
+    if (xTaskCreatePinnedToCore(decoderLoop, "decoder", DECODER_STACK, nullptr, 1, &decoderTask, otherCore) != pdPASS) {
+      decoderTask = nullptr;
+      return false;
+    }
+  }
+
+  activeHeader = header;
+  activePayload = payload;
+  decodeMicrosTotal = decodeMicrosLast = decodeCount = 0;
+  resetCache(header);
+  frameRingInit(decoderRing, ringSlots, header.frameCount, decodeFrame, nullptr);
+  activeCompressed = true;
+  xTaskNotifyGive(decoderTask);
+
+  // Frame 0 ready before the first render; the task stays the ring's only producer (it also owns frameCache)
+  unsigned long start = millis();
+  while (decoderRing.head.load() == 0 && millis() - start < DECODER_FIRST_FRAME_MS) {
+    vTaskDelay(1);
+  }
+  return true;
+}
+
+// Function to use the prefetch staging buffer for the active source (raw frames only)
+static void updatePrefetch() {
+  if (prefetchWanted && !activeCompressed) {
+    if (!framePrefetchBegin((size_t)activeWidth * activeHeight * 2)) {
+      Serial.println("animation: frame too large for prefetch, blitting from flash");
+    }
+  } else {
+    framePrefetchEnd();
+  }
+}
+
+// Function to map and verify a flash slot; returns false if it is not usable
+static bool mapSlot(int slot, const uint16_t*& frames, AnimHeader& header, spi_flash_mmap_handle_t& mapping) {
+  const esp_partition_t* partition = (const esp_partition_t*)animationPartition(slot);
+  if (!partition) return false;
+
+  if (esp_partition_read(partition, 0, &header, sizeof(header)) != ESP_OK ||
+      !animHeaderValid(header, partition->size)) {
+    return false;
+  }
+
+  const void* mapped;
+  if (esp_partition_mmap(partition, 0, header.headerSize + header.payloadBytes, SPI_FLASH_MMAP_DATA,
+                         &mapped, &mapping) != ESP_OK) {
+    return false;
+  }
+
+  // Payload CRC through the cache mapping
+  const uint8_t* payload = (const uint8_t*)mapped + header.headerSize;
+  if (crc32Update(0, payload, header.payloadBytes) != header.payloadCrc32) {
+    spi_flash_munmap(mapping);
+    return false;
+  }
+  if (!animDurationsValid(header, payload)) {
+    Serial.printf("animation: slot %d has a zero frame duration, not used\n", slot);
+    spi_flash_munmap(mapping);
+    return false;
+  }
+  frames = (const uint16_t*)payload;
+  return true;
+}
+
+bool animationSelect(int slot, bool persist) {
+  framePrefetchCancel(); // nothing may still be reading the old source
+  if (slot == ANIM_SLOT_BUILTIN) {
+    stopDecoder();
+    if (activeMapped) spi_flash_munmap(activeMapping);
+    activeMapped = false;
+    useBuiltin();
+  } else {
+    const uint16_t* frames;
+    AnimHeader header;
+    spi_flash_mmap_handle_t mapping;
+    if (!mapSlot(slot, frames, header, mapping)) {
+      return false;
+    }
+    bool wasCompressed = activeCompressed;
+    stopDecoder();
+    if (header.encoding != ANIM_ENC_RAW565 && !startDecoder(header, (const uint8_t*)frames)) {
+      spi_flash_munmap(mapping);
+      if (wasCompressed) {
+        // The previous slot lost its decoder too: fall back to the built-in frames
+        if (activeMapped) spi_flash_munmap(activeMapping);
+        activeMapped = false;
+        useBuiltin();
+        updatePrefetch();
+        generation++;
+      }
+      return false;
+    }
+    if (activeMapped) spi_flash_munmap(activeMapping);
+    activeMapping = mapping;
+    activeMapped = true;
+    activeSlot = slot;
+    activeFrames = frames;
+    activeCount = header.frameCount;
+    activeWidth = header.width;
+    activeHeight = header.height;
+    timingHeader = header;
+    timingPayload = (header.flags & ANIM_FLAG_DURATIONS) ? (const uint8_t*)frames : nullptr;
+  }
+  updatePrefetch();
+  generation++;
+
+  if (persist) {
+    Preferences preferences;
+    preferences.begin("nyancat", false);
+    preferences.putInt("animSlot", activeSlot);
+    preferences.end();
+  }
+  return true;
+}
+
+void animationBegin() {
+  reserveDecodeBuffers();
+  useBuiltin();
+
+  Preferences preferences;
+  preferences.begin("nyancat", true);
+  int slot = preferences.getInt("animSlot", ANIM_SLOT_BUILTIN);
+  preferences.end();
+
+  if (slot != ANIM_SLOT_BUILTIN && !animationSelect(slot, false)) {
+    Serial.printf("animation: slot %d invalid, using built-in frames\n", slot);
+  }
+}
+
+int animationActiveSlot() {
+  return activeSlot;
+}
+
+int animationFrameCount() {
+  return activeCount;
+}
+
+int animationWidth() {
+  return activeWidth;
+}
+
+int animationHeight() {
+  return activeHeight;
+}
+
+uint16_t animationFrameDurationMs(int index) {
+  return timingPayload ? animFrameDurationMs(timingHeader, timingPayload, index) : 0;
+}
+
+uint32_t animationGeneration() {
+  return generation;
+}
+
+const uint16_t* animationFrameData(int index) {
+  if (activeCompressed) {
+    const uint16_t* pixels = frameRingAcquire(decoderRing, index);
+    xTaskNotifyGive(decoderTask); // a slot may have come free
+    return pixels;
+  }
+  const uint16_t* staged = framePrefetchTake(index);
+  if (staged) return staged;
+  return activeFrames + (size_t)index * activeWidth * activeHeight;
+}
+
+void animationPrefetch(int index) {
+  if (activeCompressed || index < 0 || index >= activeCount) return;
+  size_t pixels = (size_t)activeWidth * activeHeight;
+  framePrefetchRequest(index, activeFrames + (size_t)index * pixels, pixels * 2);
+}
+
+void animationSetPrefetch(bool enabled) {
+  prefetchWanted = enabled && framePrefetchReserve(ANIM_MAX_FRAME_BYTES);
+  if (enabled && !prefetchWanted) {
+    Serial.println("animation: no memory for frame prefetch, blitting from flash");
+  }
+  updatePrefetch();
+}
+
+bool animationCompressed() {
+  return activeCompressed;
+}
+
+const FrameRingStats& animationDecoderStats() {
+  return decoderRing.stats;
+}
+
+uint32_t animationDecodeMicros(bool average) {
+  if (!average) return decodeMicrosLast;
+  return decodeCount ? decodeMicrosTotal / decodeCount : 0;
+}
+
+void animationSetCacheBudget(size_t psramBytes) {
+  cacheBudgetPsram = psramBytes;
+}
+
+const FrameCache& animationFrameCache() {
+  return frameCache;
+}
@@ -0,0 +1,23 @@
+/*************************************************************
+************************ ARENA SPRITE ************************
+**************************************************************/
+
+#include "arena_sprite.h"
+
+void* ArenaSprite::createArenaSprite(int16_t width, int16_t height, const char* owner, mem_tier_t tier) {
+  void* original = createSprite(width, height);
+  if (!original) {
+    return nullptr;
+  }
+
+  // Same size as TFT_eSprite allocates (one spare pixel per frame)
+  uint8_t* buffer = (uint8_t*)memArenaAlloc(owner, ((size_t)width * height + 1) * sizeof(uint16_t), tier);
+  if (!buffer) {
+    return original;
+  }
+  free(original);
+  _img8_1 = _img8 = buffer;
+  _img = (uint16_t*)buffer;
+  arenaBuffer = true;
+  return buffer;
+}
@@ -0,0 +1,194 @@
+/*************************************************************
+************************* BAND POOL **************************
+**************************************************************/
+
+#include <atomic>
+#include "band_pool.h"
+#include "hot_code.h"
+
+#ifdef ARDUINO
+#include <freertos/FreeRTOS.h>
+#include <freertos/task.h>
+#else
+#include <condition_variable>
+#include <mutex>
+#include <thread>
+#endif
+
+const uint32_t BAND_HELPER_STACK = 3072; // bytes, device helper task
+const int BAND_MAX_BANDS = 255;          // bands per run (8-bit field in the claim word)
+
+/*
+Run handshake:
+ - run word: run number << 5 | threads taking part (helpers wake on a change)
+ - claim word: low 16 bits of the run number << 16 | bands << 8 | next band;
+   a helper that wakes late sees another run number and stays out
+ - the job itself is only read by a thread that owns a band of the current
+   run, and the caller doesn't return (or change it) until all are done
+*/
+struct BandJob {
+  band_job_t job;
+  void* context;
+  int rows, bandRows;
+};
+static BandJob current;
+
+static std::atomic<uint32_t> runWord(0);
+static std::atomic<uint32_t> claimWord(0);
+static std::atomic<int> bandsDone(0);
+
+static uint8_t helperCount = 0, activeThreads = 1;
+static band_schedule_t scheduleMode = BAND_SCHEDULE_DYNAMIC;
+
+#ifdef ARDUINO
+static TaskHandle_t helperTasks[BAND_MAX_THREADS - 1];
+#else
+static std::thread helperThreads[BAND_MAX_THREADS - 1];
+static std::mutex wakeMutex;
+static std::condition_variable wakeSignal;
+static bool stopping = false;
+#endif
+
+HOT_CODE static void runBand(int band) {
+  int y0 = band * current.bandRows;
+  int y1 = y0 + current.bandRows < current.rows ? y0 + current.bandRows : current.rows;
+  current.job(y0, y1, current.context);
+  bandsDone.fetch_add(1, std::memory_order_release);
+}
+
+// Function to do thread index's share of the run identified by run
+HOT_CODE static void work(uint32_t run, uint8_t index) {
+  if (index >= (run & 31)) {
+    return; // not taking part in this run
+  }
+  uint32_t tag = ((run >> 5) & 0xFFFF) << 16;
+  uint32_t claim = claimWord.load(std::memory_order_acquire);
+  if ((claim & 0xFFFF0000u) != tag) {
+    return;
+  }
+  int bands = (claim >> 8) & 0xFF;
+
+  if (scheduleMode == BAND_SCHEDULE_STATIC) {
+    for (int band = index; band < bands; band += run & 31) runBand(band);
+    return;
+  }
+
+  while ((claim & 0xFFFF0000u) == tag && (int)(claim & 0xFF) < bands) {
+    if (claimWord.compare_exchange_weak(claim, claim + 1, std::memory_order_acq_rel)) {
+      runBand(claim & 0xFF);
+      claim = claimWord.load(std::memory_order_acquire);
+    }
+  }
+}
+
+#ifdef ARDUINO
+// Helper task: one run per notification
+static void bandHelper(void* parameter) {
+  uint8_t index = (uint8_t)(uintptr_t)parameter;
+  uint32_t last = runWord.load();
+  for (;;) {
+    ulTaskNotifyTake(pdTRUE, portMAX_DELAY);
+    uint32_t run = runWord.load(std::memory_order_acquire);
+    if (run == last) continue;
+    last = run;
+    work(run, index);
+  }
+}
+#else
+// Helper thread: one run per change of the run word
+static void bandHelper(uint8_t index) {
+  uint32_t last = runWord.load();
+  for (;;) {
+    {
+      std::unique_lock<std::mutex> lock(wakeMutex);
+      wakeSignal.wait(lock, [&] { return stopping || runWord.load() != last; });
+      if (stopping) return;
+    }
+    uint32_t run = runWord.load(std::memory_order_acquire);
+    last = run;
+    work(run, index);
+  }
+}
+#endif
+
+void bandPoolBegin(uint8_t threads, band_schedule_t schedule) {
+  bandPoolEnd();
+  scheduleMode = schedule;
+  if (threads > BAND_MAX_THREADS) threads = BAND_MAX_THREADS;
+
+#ifdef ARDUINO
+  // One helper per other core, same priority as the caller
+  if (threads > portNUM_PROCESSORS) threads = portNUM_PROCESSORS;
+  BaseType_t core = xPortGetCoreID();
+  UBaseType_t priority = uxTaskPriorityGet(nullptr);
+  for (uint8_t i = 1; i < threads; i++) {
+    if (xTaskCreatePinnedToCore(bandHelper, "bands", BAND_HELPER_STACK, (void*)(uintptr_t)i, priority,
+                                &helperTasks[helperCount], (core + i) % portNUM_PROCESSORS) != pdPASS) {
+      break;
+    }
+    helperCount++;
+  }
+#else
+  stopping = false;
+  for (uint8_t i = 1; i < threads; i++) {
+    helperThreads[helperCount++] = std::thread(bandHelper, i);
+  }
+#endif
+  activeThreads = helperCount + 1;
+}
+
+void bandPoolEnd() {
+#ifdef ARDUINO
+  for (uint8_t i = 0; i < helperCount; i++) vTaskDelete(helperTasks[i]);
+#else
+  {
+    std::lock_guard<std::mutex> lock(wakeMutex);
+    stopping = true;
+  }
+  wakeSignal.notify_all();
+  for (uint8_t i = 0; i < helperCount; i++) helperThreads[i].join();
+#endif
+  helperCount = 0;
+  activeThreads = 1;
+}
+
+void bandPoolSetActive(uint8_t threads) {
+  activeThreads = threads < 1 ? 1 : threads > helperCount + 1 ? helperCount + 1 : threads;
+}
+
+uint8_t bandPoolActive() {
+  return activeThreads;
+}
+
+HOT_CODE void bandPoolRun(int rows, int bandRows, band_job_t job, void* context) {
+  int bands = (rows + bandRows - 1) / bandRows;
+  if (activeThreads == 1 || bands <= 1 || bands > BAND_MAX_BANDS) {
+    for (int y0 = 0; y0 < rows; y0 += bandRows) job(y0, y0 + bandRows < rows ? y0 + bandRows : rows, context);
+    return;
+  }
+
+  // Fork: publish the job, then the run word
+  current.job = job;
+  current.context = context;
+  current.rows = rows;
+  current.bandRows = bandRows;
+  bandsDone.store(0, std::memory_order_relaxed);
+  uint32_t number = (runWord.load(std::memory_order_relaxed) >> 5) + 1;
+  claimWord.store((number & 0xFFFF) << 16 | (uint32_t)bands << 8, std::memory_order_relaxed);
+  uint32_t run = number << 5 | activeThreads;
+  runWord.store(run, std::memory_order_release);
+
+#ifdef ARDUINO
+  for (uint8_t i = 0; i + 1 < activeThreads; i++) xTaskNotifyGive(helperTasks[i]);
+#else
+  {
+    std::lock_guard<std::mutex> lock(wakeMutex); // no lost wakeup between a helper's check and wait
+  }
+  wakeSignal.notify_all();
+#endif
+
+  // The caller is thread 0, then join
+  work(run, 0);
+  while (bandsDone.load(std::memory_order_acquire) < bands) {
+  }
+}
@@ -0,0 +1,209 @@
+/*************************************************************
+************************* BENCHMARK **************************
+**************************************************************/
+
+#include <Arduino.h>
+#include "benchmark.h"
+#include "pixel_kernels.h"
+#include "band_pool.h"
+#include "animation.h"
+#include "nyan_layers.h"
+#include "dirty_region.h"
+#include <esp_heap_caps.h>
+
+// Print one benchmark line: bytes moved per call, averaged over runs
+static void reportThroughput(const char* name, unsigned long totalMicros, size_t bytes, int runs) {
+  double mbPerSecond = (double)bytes * runs / (totalMicros ? totalMicros : 1);
+  Serial.printf("%-10s %8.1f MB/s (%lu us/frame)\n", name, mbPerSecond, totalMicros / runs);
+}
+
+// Per-pixel loops the word-at-a-time kernels are measured against (what PIXEL_KERNELS_SCALAR builds)
+static void perPixelKeyCopy(uint16_t* dst, const uint16_t* src, size_t count, uint16_t key) {
+  for (size_t i = 0; i < count; i++) {
+    if (src[i] != key) dst[i] = src[i];
+  }
+}
+
+static void perPixelCopySwapHalf(uint16_t* dst, const uint16_t* src, size_t count) {
+  for (size_t i = 0; i < count; i++) dst[i] = pixelSwap(src[i & ~(size_t)1]);
+}
+
+void benchmarkPixelKernels() {
+  const int width = 320, height = 170, runs = 20;
+  const size_t pixels = (size_t)width * height;
+  uint16_t* src = (uint16_t*)malloc(pixels * 2);
+  uint16_t* dst = (uint16_t*)malloc(pixels * 2);
+  if (!src || !dst) {
+    Serial.println("benchmark: not enough memory");
+    free(src);
+    free(dst);
+    return;
+  }
+
+  // Half transparent source so the key path sees both branches
+  for (size_t i = 0; i < pixels; i++) {
+    src[i] = (i % width) < width / 2 ? 0 : (uint16_t)(i * 2654435761u >> 16);
+  }
+
+  unsigned long start = micros();
+  for (int i = 0; i < runs; i++) pixelCopySwap(dst, src, pixels);
+  reportThroughput("copy-swap", micros() - start, pixels * 2, runs);
+
+  // Word-at-a-time kernels, each followed by its per-pixel loop
+  start = micros();
+  for (int i = 0; i < runs; i++) pixelKeyCopy(dst, src, pixels, 0);
+  reportThroughput("key-copy", micros() - start, pixels * 2, runs);
+  start = micros();
+  for (int i = 0; i < runs; i++) perPixelKeyCopy(dst, src, pixels, 0);
+  reportThroughput(" per-pixel", micros() - start, pixels * 2, runs);
+
+  start = micros();
+  for (int i = 0; i < runs; i++) pixelCopySwapHalf(dst, src, pixels);
+  reportThroughput("swap-half", micros() - start, pixels * 2, runs);
+  start = micros();
+  for (int i = 0; i < runs; i++) perPixelCopySwapHalf(dst, src, pixels);
+  reportThroughput(" per-pixel", micros() - start, pixels * 2, runs);
+
+  start = micros();
+  for (int i = 0; i < runs; i++) pixelFill(dst, (uint16_t)i, pixels);
+  reportThroughput("fill", micros() - start, pixels * 2, runs);
+
+  free(src);
+  free(dst);
+}
+
+
+// Frame composite timed by benchmarkBandPool: the clock's overlay layout on a full frame
+struct BenchFrame {
+  uint16_t* dst;
+  const uint16_t* background;
+  const uint16_t* overlay;
+};
+
+static const struct {
+  int x, y, w, h;
+} benchLayers[] = {
+  { 7, 8, 218, 26 }, { 235, 30, 80, 40 }, { 231, 100, 100, 64 }, { 5, 145, 70, 20 }
+};
+
+// Band job: background rows with the byte swap, then every overlay clipped to the band
+static void benchCompositeBand(int y0, int y1, void* context) {
+  const BenchFrame& frame = *(const BenchFrame*)context;
+  const int width = 320;
+  pixelCopySwap(frame.dst + y0 * width, frame.background + y0 * width, (size_t)(y1 - y0) * width);
+  for (const auto& layer : benchLayers) {
+    pixelKeyBlitRect(frame.dst + y0 * width, width, y1 - y0, layer.x, layer.y - y0,
+                     frame.overlay, layer.w, layer.h, 0);
+  }
+}
+
+void benchmarkBandPool() {
+  const int width = 320, height = 170, runs = 50;
+  const size_t pixels = (size_t)width * height;
+  uint16_t* background = (uint16_t*)malloc(pixels * 2);
+  uint16_t* overlay = (uint16_t*)malloc(pixels * 2);
+  uint16_t* dst = (uint16_t*)malloc(pixels * 2);
+  if (!background || !overlay || !dst) {
+    Serial.println("benchmark: not enough memory");
+    free(background);
+    free(overlay);
+    free(dst);
+    return;
+  }
+  for (size_t i = 0; i < pixels; i++) {
+    background[i] = (uint16_t)(i * 2654435761u >> 16);
+    overlay[i] = (i % 7) < 3 ? 0 : (uint16_t)i;
+  }
+
+  BenchFrame frame = { dst, background, overlay };
+  uint8_t threads = bandPoolActive();
+  for (uint8_t active = 1; active <= threads; active++) {
+    bandPoolSetActive(active);
+    unsigned long start = micros();
+    for (int i = 0; i < runs; i++) bandPoolRun(height, BAND_ROWS, benchCompositeBand, &frame);
+    unsigned long total = micros() - start;
+    Serial.printf("composite  %u core%s %6lu us/frame\n", (unsigned)active, active > 1 ? "s" : " ", total / runs);
+  }
+  bandPoolSetActive(threads);
+
+  free(background);
+  free(overlay);
+  free(dst);
+}
+
+void benchmarkFramePrefetch() {
+  if (animationCompressed()) {
+    Serial.println("prefetch: animation is compressed, nothing to prefetch");
+    return;
+  }
+  const int frames = animationFrameCount();
+  const size_t pixels = (size_t)animationWidth() * animationHeight();
+  uint16_t* staging = (uint16_t*)heap_caps_malloc(pixels * 2, MALLOC_CAP_INTERNAL | MALLOC_CAP_8BIT);
+  uint16_t* dst = (uint16_t*)malloc(pixels * 2);
+  if (!staging || !dst) {
+    Serial.println("benchmark: not enough memory");
+    free(staging);
+    free(dst);
+    return;
+  }
+
+  // Every frame once per round; the frames are far larger than the flash cache, so each blit misses
+  const int runs = frames * 2;
+  unsigned long start = micros();
+  for (int i = 0; i < runs; i++) pixelCopySwap(dst, animationFrameData(i % frames), pixels);
+  unsigned long flashMicros = micros() - start;
+
+  unsigned long copyMicros = 0, sramMicros = 0;
+  for (int i = 0; i < runs; i++) {
+    start = micros();
+    memcpy(staging, animationFrameData(i % frames), pixels * 2); // the prefetch task's copy
+    copyMicros += micros() - start;
+    start = micros();
+    pixelCopySwap(dst, staging, pixels);
+    sramMicros += micros() - start;
+  }
+
+  Serial.printf("blit flash %6lu us/frame, sram %6lu us/frame (stall %ld us), copy %lu us on the other core\n",
+                flashMicros / runs, sramMicros / runs, (long)(flashMicros - sramMicros) / runs, copyMicros / runs);
+  free(staging);
+  free(dst);
+}
+
+void benchmarkLayers(NyanLayers& layers) {
+  const size_t pixels = (size_t)layers.width * layers.height;
+  uint16_t* dst = (uint16_t*)malloc(pixels * 2);
+  if (!dst) {
+    Serial.println("benchmark: not enough memory");
+    return;
+  }
+
+  // 60 displayed frames, one second of scene time: each way once per frame
+  const int runs = 60;
+  unsigned long start = micros();
+  for (int i = 0; i < runs; i++) pixelCopySwap(dst, layers.frames + (i % layers.frameCount) * pixels, pixels);
+  unsigned long blitMicros = micros() - start;
+
+  DirtyRegion region;
+  dirtyInit(region, layers.width, layers.height);
+  nyanLayersReset(layers);
+  uint32_t bytes = 0, rects = 0;
+  unsigned long layeredMicros = 0;
+  for (int i = 0; i <= runs; i++) {
+    uint32_t timeMs = i * 1000 / runs;
+    start = micros();
+    dirtyClear(region);
+    nyanLayersAdvance(layers, timeMs, nyanLayersCatFrame(layers, timeMs), region);
+    for (uint8_t r = 0; r < region.count; r++) nyanLayersDraw(layers, dst, region.rects[r]);
+    if (i > 0) { // the first frame paints everything
+      layeredMicros += micros() - start;
+      bytes += dirtyPixels(region) * 2;
+      rects += region.count;
+    }
+  }
+  nyanLayersReset(layers);
+
+  Serial.printf("layers  blit %6lu us/frame, %u bytes; layered %6lu us/frame, %u bytes in %u rects\n",
+                blitMicros / runs, (unsigned)(pixels * 2), layeredMicros / runs, (unsigned)(bytes / runs),
+                (unsigned)(rects / runs));
+  free(dst);
+}
@@ -0,0 +1,46 @@
+/*************************************************************
+*********************** CACHE PROFILING **********************
+**************************************************************/
+
+#ifdef CACHE_PROFILING
+
+#include <eri.h>
+#include "cache_profile.h"
+
+// Performance monitor registers (ERI addresses, Xtensa LX7)
+const uint32_t PERFMON_PGM = 0x101000;      // global enable
+const uint32_t PERFMON_PM0 = 0x101080;      // counter values, 4 bytes apart
+const uint32_t PERFMON_PMCTRL0 = 0x101100;  // counter configuration
+
+// Event selectors and sub-event masks
+const uint32_t PERFMON_SELECT_CYCLES = 0;
+const uint32_t PERFMON_SELECT_D_STALL = 3;
+const uint32_t PERFMON_SELECT_I_STALL = 4;
+const uint32_t PERFMON_MASK_ALL = 0xFFFF;    // every stall reason: a miss in the S3's external caches is a bus stall
+
+const uint8_t COUNTER_CYCLES = 0;
+const uint8_t COUNTER_I_STALL = 1;
+const uint8_t COUNTER_D_STALL = 2;
+
+// Function to program one counter: count select/mask at every interrupt level
+static void configureCounter(uint8_t id, uint32_t select, uint32_t mask) {
+  const uint32_t kernelCount = 1, traceLevel = 15;
+  eri_write(PERFMON_PMCTRL0 + id * 4, (mask << 16) | (select << 8) | (traceLevel << 4) | (kernelCount << 3));
+  eri_write(PERFMON_PM0 + id * 4, 0);
+}
+
+void cacheProfileBegin() {
+  eri_write(PERFMON_PGM, 0);
+  configureCounter(COUNTER_CYCLES, PERFMON_SELECT_CYCLES, 1);
+  configureCounter(COUNTER_I_STALL, PERFMON_SELECT_I_STALL, PERFMON_MASK_ALL);
+  configureCounter(COUNTER_D_STALL, PERFMON_SELECT_D_STALL, PERFMON_MASK_ALL);
+  eri_write(PERFMON_PGM, 1);
+}
+
+void cacheProfileRead(CacheCounters& counters) {
+  counters.cycles = eri_read(PERFMON_PM0 + COUNTER_CYCLES * 4);
+  counters.instructionStalls = eri_read(PERFMON_PM0 + COUNTER_I_STALL * 4);
+  counters.dataStalls = eri_read(PERFMON_PM0 + COUNTER_D_STALL * 4);
+}
+
+#endif
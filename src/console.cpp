@@ -0,0 +1,92 @@
+/*************************************************************
+************************** CONSOLE ***************************
+**************************************************************/
+
+#include "console.h"
+
+struct ConsoleCommand {
+  const char* name;
+  const char* help;
+  ConsoleHandler handler;
+};
+
+static ConsoleCommand commands[CONSOLE_MAX_COMMANDS];
+static uint8_t commandCount = 0;
+
+// Input line being assembled
+static ConsoleLine line = {};
+
+// Streamed response in progress
+static ConsoleStream stream = {};
+
+bool consoleRegister(const char* name, const char* help, ConsoleHandler handler) {
+  if (commandCount >= CONSOLE_MAX_COMMANDS) {
+    return false;
+  }
+  commands[commandCount++] = { name, help, handler };
+  return true;
+}
+
+void consoleStream(ConsoleStreamStep step) {
+  stream.step = step;
+  stream.index = 0;
+}
+
+// Function to list the registered commands, one per step
+static bool printHelpLine(Print& out, uint32_t index) {
+  if (index >= commandCount) {
+    return false;
+  }
+  out.printf("%s - %s\n", commands[index].name, commands[index].help);
+  return index + 1 < commandCount;
+}
+
+// Function to report the TX room for the stream
+static int serialRoom() {
+  return Serial.availableForWrite();
+}
+
+// Function to split the line in place and run the matching command
+static void executeLine() {
+  char* argv[CONSOLE_MAX_ARGS];
+  int argc = consoleLineSplit(line, argv);
+  if (argc == 0) {
+    return;
+  }
+
+  if (strcmp(argv[0], "help") == 0) {
+    consoleStream(printHelpLine);
+    return;
+  }
+  for (uint8_t i = 0; i < commandCount; i++) {
+    if (strcmp(argv[0], commands[i].name) == 0) {
+      commands[i].handler(argc, argv);
+      return;
+    }
+  }
+  Serial.print("unknown command: ");
+  Serial.println(argv[0]);
+}
+
+void consolePoll() {
+  unsigned long start = micros();
+
+  // Continue a streamed response while there is TX room; new commands wait until it is done
+  if (consoleStreamContinue(stream, Serial, serialRoom, micros, start)) {
+    return;
+  }
+
+  // Collect input without blocking
+  while (Serial.available() > 0 && micros() - start < CONSOLE_BUDGET_US) {
+    int c = Serial.read();
+    if (c < 0) break;
+
+    console_line_t result = consoleLineFeed(line, (char)c);
+    if (result == CONSOLE_LINE_TOO_LONG) {
+      Serial.println("line too long");
+    } else if (result == CONSOLE_LINE_READY) {
+      executeLine();
+      if (stream.step) return; // the command started a stream
+    }
+  }
+}
@@ -0,0 +1,59 @@
+/*************************************************************
+*********************** CONSOLE LINE *************************
+**************************************************************/
+
+#include "console_line.h"
+
+void consoleLineInit(ConsoleLine& line) {
+  line.text[0] = '\0';
+  line.length = 0;
+  line.overflow = false;
+  line.done = false;
+}
+
+console_line_t consoleLineFeed(ConsoleLine& line, char c) {
+  if (line.done) {
+    consoleLineInit(line);
+  }
+  if (c == '\r') {
+    return CONSOLE_LINE_PENDING;
+  }
+
+  if (c == '\n') {
+    line.text[line.length] = '\0';
+    line.done = true;
+    return line.overflow ? CONSOLE_LINE_TOO_LONG : CONSOLE_LINE_READY;
+  }
+
+  if (line.length < CONSOLE_LINE_LENGTH - 1) {
+    line.text[line.length++] = c;
+  } else {
+    line.overflow = true;
+  }
+  return CONSOLE_LINE_PENDING;
+}
+
+int consoleLineSplit(ConsoleLine& line, char** argv) {
+  int argc = 0;
+  char* cursor = line.text;
+  while (*cursor && argc < CONSOLE_MAX_ARGS) {
+    while (*cursor == ' ' || *cursor == '\t') *cursor++ = '\0';
+    if (!*cursor) break;
+    argv[argc++] = cursor;
+    while (*cursor && *cursor != ' ' && *cursor != '\t') cursor++;
+  }
+  *cursor = '\0'; // the last word ends here even when more follow
+  return argc;
+}
+
+bool consoleStreamContinue(ConsoleStream& stream, Print& out, int (*room)(), unsigned long (*now)(), unsigned long start) {
+  while (stream.step && now() - start < CONSOLE_BUDGET_US) {
+    if (room() < CONSOLE_MIN_TX_ROOM) {
+      break;
+    }
+    if (!stream.step(out, stream.index++)) {
+      stream.step = nullptr;
+    }
+  }
+  return stream.step != nullptr;
+}
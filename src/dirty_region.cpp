@@ -0,0 +1,103 @@
+/*************************************************************
+************************ DIRTY REGION ************************
+**************************************************************/
+
+#include "dirty_region.h"
+
+static inline int32_t area(const DirtyRect& r) {
+  return (int32_t)r.w * r.h;
+}
+
+static DirtyRect unite(const DirtyRect& a, const DirtyRect& b) {
+  int16_t x0 = a.x < b.x ? a.x : b.x;
+  int16_t y0 = a.y < b.y ? a.y : b.y;
+  int16_t x1 = a.x + a.w > b.x + b.w ? a.x + a.w : b.x + b.w;
+  int16_t y1 = a.y + a.h > b.y + b.h ? a.y + a.h : b.y + b.h;
+  return { x0, y0, (int16_t)(x1 - x0), (int16_t)(y1 - y0) };
+}
+
+static inline bool overlaps(const DirtyRect& a, const DirtyRect& b) {
+  return a.x < b.x + b.w && b.x < a.x + a.w && a.y < b.y + b.h && b.y < a.y + a.h;
+}
+
+// Function to get the pixels a union of a and b adds beyond the two (negative when they overlap)
+static inline int32_t unionCost(const DirtyRect& a, const DirtyRect& b) {
+  return area(unite(a, b)) - area(a) - area(b);
+}
+
+void dirtyInit(DirtyRegion& region, int width, int height) {
+  region.width = width;
+  region.height = height;
+  dirtyClear(region);
+}
+
+void dirtyClear(DirtyRegion& region) {
+  region.count = 0;
+  region.full = false;
+}
+
+void dirtyAdd(DirtyRegion& region, int x, int y, int w, int h) {
+  int x1 = x + w, y1 = y + h;
+  if (x < 0) x = 0;
+  if (y < 0) y = 0;
+  if (x1 > region.width) x1 = region.width;
+  if (y1 > region.height) y1 = region.height;
+  if (x1 <= x || y1 <= y || region.full) {
+    return;
+  }
+  DirtyRect added = { (int16_t)x, (int16_t)y, (int16_t)(x1 - x), (int16_t)(y1 - y) };
+
+  // Fold in every rect it overlaps or nearly adjoins; the union may reach others, so rescan after each
+  for (;;) {
+    bool merged = false;
+    for (uint8_t i = 0; i < region.count; i++) {
+      if (overlaps(region.rects[i], added) || unionCost(region.rects[i], added) <= DIRTY_MERGE_SLACK) {
+        added = unite(region.rects[i], added);
+        region.rects[i] = region.rects[--region.count];
+        merged = true;
+        break;
+      }
+    }
+    if (merged) continue;
+    if (region.count < DIRTY_MAX_RECTS) break;
+
+    // Full: merge with the rect that costs the fewest extra pixels
+    uint8_t cheapest = 0;
+    int32_t cheapestCost = unionCost(region.rects[0], added);
+    for (uint8_t i = 1; i < region.count; i++) {
+      int32_t cost = unionCost(region.rects[i], added);
+      if (cost < cheapestCost) {
+        cheapest = i;
+        cheapestCost = cost;
+      }
+    }
+    added = unite(region.rects[cheapest], added);
+    region.rects[cheapest] = region.rects[--region.count];
+  }
+
+  region.rects[region.count++] = added;
+  region.full = area(added) == (int32_t)region.width * region.height;
+}
+
+void dirtyAdd(DirtyRegion& region, const DirtyRect& rect) {
+  dirtyAdd(region, rect.x, rect.y, rect.w, rect.h);
+}
+
+void dirtyAll(DirtyRegion& region) {
+  region.rects[0] = { 0, 0, region.width, region.height };
+  region.count = 1;
+  region.full = true;
+}
+
+uint32_t dirtyPixels(const DirtyRegion& region) {
+  uint32_t pixels = 0;
+  for (uint8_t i = 0; i < region.count; i++) {
+    pixels += area(region.rects[i]);
+  }
+  return pixels;
+}
+
+bool dirtyWorthFullPush(const DirtyRegion& region) {
+  return region.full ||
+         dirtyPixels(region) * 100 > (uint32_t)region.width * region.height * DIRTY_FULL_PERCENT;
+}
@@ -0,0 +1,36 @@
+/*************************************************************
+********************** DISPLAY BACKEND ***********************
+**************************************************************/
+
+#include <stdlib.h>
+#include <string.h>
+#include "display_backend.h"
+
+FramebufferBackend::~FramebufferBackend() {
+  free(framebuffer);
+}
+
+bool FramebufferBackend::begin(int frameWidth, int frameHeight, const uint16_t* /* buffer: copied, not used in place */) {
+  free(framebuffer);
+  width = frameWidth;
+  pixelCount = (size_t)frameWidth * frameHeight;
+  framebuffer = (uint16_t*)calloc(pixelCount, sizeof(uint16_t));
+  frameCount = 0;
+  return framebuffer != nullptr;
+}
+
+void FramebufferBackend::pushFrame(const uint16_t* pixels) {
+  memcpy(framebuffer, pixels, pixelCount * sizeof(uint16_t));
+  frameCount++;
+}
+
+void FramebufferBackend::pushRegion(const uint16_t* pixels, const DirtyRegion& region) {
+  for (uint8_t i = 0; i < region.count; i++) {
+    const DirtyRect& rect = region.rects[i];
+    for (int y = rect.y; y < rect.y + rect.h; y++) {
+      size_t offset = (size_t)y * width + rect.x;
+      memcpy(framebuffer + offset, pixels + offset, rect.w * sizeof(uint16_t));
+    }
+  }
+  frameCount++;
+}
@@ -0,0 +1,448 @@
+/*************************************************************
+*********************** DISPLAY LIST *************************
+**************************************************************/
+
+#include "display_list.h"
+#include "pixel_kernels.h"
+#include "band_pool.h"
+#include "hot_code.h"
+
+// Command opcodes (state changes first)
+enum {
+  DL_OP_TEXT_COLOR,
+  DL_OP_TEXT_DATUM,
+  DL_OP_TEXT_FONT,
+  DL_OP_FREE_FONT,
+  DL_OP_TEXT_SIZE,
+  DL_OP_FILL_SPRITE,   // first draw op
+  DL_OP_FILL_RECT,
+  DL_OP_FILL_ROUND_RECT,
+  DL_OP_DRAW_ROUND_RECT,
+  DL_OP_FILL_CIRCLE,
+  DL_OP_DRAW_CIRCLE,
+  DL_OP_DRAW_STRING,
+  DL_OP_COMPOSITE,
+  DL_OP_MERGED,        // fill folded into an earlier one
+  DL_OP_BATCHED        // composite run together with an earlier one
+};
+
+struct DisplayCommand {
+  uint8_t op;
+  uint8_t target;
+  uint8_t group;
+  uint8_t value;          // font, datum, size or overlay target
+  int16_t x, y, w, h, r;
+  uint16_t colour, background;
+  const GFXfont* freeFont;
+  uint16_t text;          // offset into textPool
+};
+
+// Text state of a sprite (known = set through the list at least once)
+struct TextState {
+  bool colourKnown, datumKnown, fontKnown, sizeKnown;
+  uint16_t colour, background;
+  uint8_t datum, textFont, size;
+  const GFXfont* freeFont;
+};
+
+// Registered sprites
+static TFT_eSprite* targets[DL_MAX_TARGETS];
+static uint8_t targetCount = 0;
+static TextState wanted[DL_MAX_TARGETS];  // as recorded
+static TextState applied[DL_MAX_TARGETS]; // as last set on the sprite
+static bool runAll[DL_MAX_TARGETS];       // overdrawn or invalidated this frame
+static bool invalidated[DL_MAX_TARGETS];  // invalidated this frame
+static bool targetChanged[DL_MAX_TARGETS];
+
+// Group hashes from the previous frame
+static uint32_t groupHash[DL_MAX_GROUPS];
+static bool groupHashValid[DL_MAX_GROUPS];
+static bool groupCulled[DL_MAX_GROUPS];
+static bool groupOverflow[DL_MAX_GROUPS]; // commands dropped this frame
+static bool groupChanged[DL_MAX_GROUPS];  // commands differ from last frame's (whether or not culling was allowed)
+
+// Frame being recorded
+static DisplayCommand commands[DL_MAX_COMMANDS];
+static uint8_t commandCount = 0;
+static char textPool[DL_TEXT_POOL];
+static uint16_t textUsed = 0;
+static uint8_t currentTarget = 0, currentGroup = 0;
+static uint16_t stateRecorded = 0, stateCalls = 0, drawCalls = 0;
+static DisplayListStats stats;
+
+int dlRegisterTarget(TFT_eSprite& sprite) {
+  if (targetCount >= DL_MAX_TARGETS) {
+    return -1;
+  }
+  targets[targetCount] = &sprite;
+  memset(&wanted[targetCount], 0, sizeof(TextState));
+  memset(&applied[targetCount], 0, sizeof(TextState));
+  return targetCount++;
+}
+
+void dlBeginFrame() {
+  commandCount = 0;
+  textUsed = 0;
+  stateRecorded = stateCalls = drawCalls = 0;
+  memset(&stats, 0, sizeof(stats));
+  memset(runAll, 0, sizeof(runAll));
+  memset(invalidated, 0, sizeof(invalidated));
+  memset(targetChanged, 0, sizeof(targetChanged));
+  memset(groupOverflow, 0, sizeof(groupOverflow));
+  memset(groupChanged, 0, sizeof(groupChanged));
+}
+
+void dlOverdrawn(int target) {
+  if (target >= 0 && target < targetCount) runAll[target] = true;
+}
+
+void dlInvalidate(int target) {
+  if (target < 0 || target >= targetCount) return;
+  runAll[target] = true;
+  invalidated[target] = true;
+  memset(&applied[target], 0, sizeof(TextState)); // the sprite's text state may have been changed too
+}
+
+void dlInvalidateAll() {
+  for (uint8_t i = 0; i < targetCount; i++) dlInvalidate(i);
+}
+
+void dlGroup(int target, uint8_t id) {
+  currentTarget = (target >= 0 && target < targetCount) ? target : 0;
+  currentGroup = id < DL_MAX_GROUPS ? id : DL_MAX_GROUPS - 1;
+}
+
+// Function to append a command for the current group; nullptr when the list is full
+static DisplayCommand* record(uint8_t op) {
+  stats.recorded++;
+  if (commandCount >= DL_MAX_COMMANDS) {
+    stats.overflowed++;
+    groupOverflow[currentGroup] = true;
+    return nullptr;
+  }
+  DisplayCommand* command = &commands[commandCount++];
+  memset(command, 0, sizeof(*command));
+  command->op = op;
+  command->target = currentTarget;
+  command->group = currentGroup;
+  return command;
+}
+
+
+/*************************************************************
+************************* RECORDING **************************
+**************************************************************/
+
+// State commands take effect when executed (see applyState) and feed the group hash
+static void recordState(uint8_t op, uint8_t value, uint16_t colour, uint16_t background, const GFXfont* font) {
+  stateRecorded++;
+  DisplayCommand* command = record(op);
+  if (!command) return;
+  command->value = value;
+  command->colour = colour;
+  command->background = background;
+  command->freeFont = font;
+}
+
+void dlSetTextColor(uint16_t colour) {
+  dlSetTextColor(colour, colour);
+}
+
+void dlSetTextColor(uint16_t colour, uint16_t background) {
+  recordState(DL_OP_TEXT_COLOR, 0, colour, background, nullptr);
+}
+
+void dlSetTextDatum(uint8_t datum) {
+  recordState(DL_OP_TEXT_DATUM, datum, 0, 0, nullptr);
+}
+
+void dlSetTextFont(uint8_t font) {
+  recordState(DL_OP_TEXT_FONT, font, 0, 0, nullptr);
+}
+
+void dlSetFreeFont(const GFXfont* font) {
+  recordState(DL_OP_FREE_FONT, 1, 0, 0, font);
+}
+
+void dlSetTextSize(uint8_t size) {
+  recordState(DL_OP_TEXT_SIZE, size, 0, 0, nullptr);
+}
+
+static void recordShape(uint8_t op, int x, int y, int w, int h, int r, uint16_t colour) {
+  DisplayCommand* command = record(op);
+  if (!command) return;
+  command->x = x;
+  command->y = y;
+  command->w = w;
+  command->h = h;
+  command->r = r;
+  command->colour = colour;
+}
+
+void dlFillSprite(uint16_t colour) {
+  recordShape(DL_OP_FILL_SPRITE, 0, 0, 0, 0, 0, colour);
+}
+
+void dlFillRect(int x, int y, int w, int h, uint16_t colour) {
+  recordShape(DL_OP_FILL_RECT, x, y, w, h, 0, colour);
+}
+
+void dlFillRoundRect(int x, int y, int w, int h, int r, uint16_t colour) {
+  recordShape(DL_OP_FILL_ROUND_RECT, x, y, w, h, r, colour);
+}
+
+void dlDrawRoundRect(int x, int y, int w, int h, int r, uint16_t colour) {
+  recordShape(DL_OP_DRAW_ROUND_RECT, x, y, w, h, r, colour);
+}
+
+void dlFillCircle(int x, int y, int r, uint16_t colour) {
+  recordShape(DL_OP_FILL_CIRCLE, x, y, 0, 0, r, colour);
+}
+
+void dlDrawCircle(int x, int y, int r, uint16_t colour) {
+  recordShape(DL_OP_DRAW_CIRCLE, x, y, 0, 0, r, colour);
+}
+
+void dlDrawString(const char* text, int x, int y, uint8_t font) {
+  size_t length = strlen(text) + 1;
+  if (textUsed + length > DL_TEXT_POOL) {
+    stats.recorded++;
+    stats.overflowed++;
+    groupOverflow[currentGroup] = true;
+    return;
+  }
+  DisplayCommand* command = record(DL_OP_DRAW_STRING);
+  if (!command) return;
+  command->x = x;
+  command->y = y;
+  command->value = font;
+  command->text = textUsed;
+  memcpy(textPool + textUsed, text, length);
+  textUsed += length;
+}
+
+void dlComposite(int overlay, int x, int y) {
+  DisplayCommand* command = record(DL_OP_COMPOSITE);
+  if (!command) return;
+  command->value = overlay;
+  command->x = x;
+  command->y = y;
+}
+
+
+/*************************************************************
+************************* EXECUTION **************************
+**************************************************************/
+
+static inline uint32_t hashMix(uint32_t hash, uint32_t value) {
+  return (hash ^ value) * 16777619u;
+}
+
+static uint32_t hashCommand(uint32_t hash, const DisplayCommand& c) {
+  hash = hashMix(hash, c.op | c.value << 8);
+  hash = hashMix(hash, (uint16_t)c.x | (uint32_t)(uint16_t)c.y << 16);
+  hash = hashMix(hash, (uint16_t)c.w | (uint32_t)(uint16_t)c.h << 16);
+  hash = hashMix(hash, (uint16_t)c.r);
+  hash = hashMix(hash, c.colour | (uint32_t)c.background << 16);
+  hash = hashMix(hash, (uint32_t)(uintptr_t)c.freeFont);
+  if (c.op == DL_OP_DRAW_STRING) {
+    for (const char* text = textPool + c.text; *text; text++) hash = hashMix(hash, (uint8_t)*text);
+  }
+  return hash;
+}
+
+// Function to decide which groups on target are identical to last frame
+static void cullGroups(uint8_t target) {
+  uint32_t hashes[DL_MAX_GROUPS];
+  bool present[DL_MAX_GROUPS] = { false };
+  for (uint8_t i = 0; i < commandCount; i++) {
+    const DisplayCommand& c = commands[i];
+    if (c.target != target) continue;
+    if (!present[c.group]) {
+      present[c.group] = true;
+      hashes[c.group] = 2166136261u;
+    }
+    hashes[c.group] = hashCommand(hashes[c.group], c);
+  }
+
+  for (uint8_t group = 0; group < DL_MAX_GROUPS; group++) {
+    if (!present[group]) continue;
+    // An incomplete group is neither culled nor remembered
+    bool same = !invalidated[target] && !groupOverflow[group] && groupHashValid[group] &&
+                groupHash[group] == hashes[group];
+    groupCulled[group] = same && !runAll[target];
+    groupChanged[group] = !same;
+    targetChanged[target] |= !same;
+    groupHash[group] = hashes[group];
+    groupHashValid[group] = !groupOverflow[group];
+  }
+}
+
+// Function to record a state command into the wanted state
+static void applyState(uint8_t target, const DisplayCommand& c) {
+  TextState& state = wanted[target];
+  switch (c.op) {
+    case DL_OP_TEXT_COLOR: state.colourKnown = true; state.colour = c.colour; state.background = c.background; break;
+    case DL_OP_TEXT_DATUM: state.datumKnown = true; state.datum = c.value; break;
+    case DL_OP_TEXT_FONT:  state.fontKnown = true; state.textFont = c.value; state.freeFont = nullptr; break;
+    case DL_OP_FREE_FONT:  state.fontKnown = true; state.textFont = 1; state.freeFont = c.freeFont; break;
+    case DL_OP_TEXT_SIZE:  state.sizeKnown = true; state.size = c.value; break;
+  }
+}
+
+// Function to bring the sprite's text state up to the wanted state before a draw
+static void flushState(uint8_t target) {
+  TFT_eSprite& sprite = *targets[target];
+  const TextState& want = wanted[target];
+  TextState& have = applied[target];
+
+  if (want.colourKnown && (!have.colourKnown || want.colour != have.colour || want.background != have.background)) {
+    sprite.setTextColor(want.colour, want.background);
+    stateCalls++;
+  }
+  if (want.datumKnown && (!have.datumKnown || want.datum != have.datum)) {
+    sprite.setTextDatum(want.datum);
+    stateCalls++;
+  }
+  if (want.fontKnown && (!have.fontKnown || want.textFont != have.textFont || want.freeFont != have.freeFont)) {
+    if (want.freeFont) sprite.setFreeFont(want.freeFont);
+    else sprite.setTextFont(want.textFont);
+    stateCalls++;
+  }
+  if (want.sizeKnown && (!have.sizeKnown || want.size != have.size)) {
+    sprite.setTextSize(want.size);
+    stateCalls++;
+  }
+  have = want;
+}
+
+// Function to fold the next fills of the same group into this one while they form a rectangle
+static void mergeFills(uint8_t index, DisplayCommand& fill) {
+  for (uint8_t i = index + 1; i < commandCount; i++) {
+    DisplayCommand& next = commands[i];
+    if (next.target != fill.target) continue;
+    if (next.op != DL_OP_FILL_RECT || next.group != fill.group || next.colour != fill.colour) return;
+
+    if (next.x == fill.x && next.w == fill.w && next.y == fill.y + fill.h) {
+      fill.h += next.h; // stacked below
+    } else if (next.y == fill.y && next.h == fill.h && next.x == fill.x + fill.w) {
+      fill.w += next.w; // side by side
+    } else {
+      return;
+    }
+    next.op = DL_OP_MERGED;
+    stats.merged++;
+  }
+}
+
+// Composites run together across both cores, band by band
+struct CompositeBatch {
+  uint16_t* dst;
+  int width, top;
+  uint8_t count;
+  struct {
+    const uint16_t* src;
+    int x, y, w, h;
+  } layers[DL_MAX_TARGETS];
+};
+static CompositeBatch batch;
+
+// Band job: every layer of the batch, clipped to rows y0..y1 (relative to batch.top)
+HOT_CODE static void compositeBand(int y0, int y1, void* context) {
+  const CompositeBatch& b = *(const CompositeBatch*)context;
+  int top = b.top + y0;
+  for (uint8_t i = 0; i < b.count; i++) {
+    pixelKeyBlitRect(b.dst + top * b.width, b.width, y1 - y0, b.layers[i].x, b.layers[i].y - top,
+                     b.layers[i].src, b.layers[i].w, b.layers[i].h, pixelSwap(TFT_BLACK));
+  }
+}
+
+// Function to composite this overlay and the ones recorded right after it in the same group
+static void composite(uint8_t index, DisplayCommand& first) {
+  TFT_eSprite& sprite = *targets[first.target];
+  batch.dst = (uint16_t*)sprite.getPointer();
+  batch.width = sprite.width();
+  batch.count = 0;
+  int top = sprite.height(), bottom = 0;
+
+  for (uint8_t i = index; i < commandCount; i++) {
+    DisplayCommand& c = commands[i];
+    if (c.target != first.target) continue;
+    if (c.op != DL_OP_COMPOSITE || c.group != first.group || batch.count == DL_MAX_TARGETS) break;
+
+    TFT_eSprite& overlay = *targets[c.value];
+    batch.layers[batch.count++] = { (const uint16_t*)overlay.getPointer(), c.x, c.y, overlay.width(), overlay.height() };
+    top = min(top, max((int)c.y, 0));
+    bottom = max(bottom, min(c.y + (int)overlay.height(), (int)sprite.height()));
+    if (i != index) {
+      c.op = DL_OP_BATCHED;
+      drawCalls++;
+    }
+  }
+
+  if (bottom > top) {
+    batch.top = top;
+    bandPoolRun(bottom - top, BAND_ROWS, compositeBand, &batch);
+  }
+}
+
+static void draw(uint8_t index, DisplayCommand& c) {
+  TFT_eSprite& sprite = *targets[c.target];
+  switch (c.op) {
+    case DL_OP_FILL_SPRITE:     sprite.fillSprite(c.colour); break;
+    case DL_OP_FILL_RECT:       mergeFills(index, c); sprite.fillRect(c.x, c.y, c.w, c.h, c.colour); break;
+    case DL_OP_FILL_ROUND_RECT: sprite.fillRoundRect(c.x, c.y, c.w, c.h, c.r, c.colour); break;
+    case DL_OP_DRAW_ROUND_RECT: sprite.drawRoundRect(c.x, c.y, c.w, c.h, c.r, c.colour); break;
+    case DL_OP_FILL_CIRCLE:     sprite.fillCircle(c.x, c.y, c.r, c.colour); break;
+    case DL_OP_DRAW_CIRCLE:     sprite.drawCircle(c.x, c.y, c.r, c.colour); break;
+    case DL_OP_DRAW_STRING:
+      if (c.value) sprite.drawString(textPool + c.text, c.x, c.y, c.value);
+      else sprite.drawString(textPool + c.text, c.x, c.y);
+      break;
+    case DL_OP_COMPOSITE:       composite(index, c); break;
+    default:
+      return; // merged or batched away
+  }
+  drawCalls++;
+}
+
+static void executeTarget(uint8_t target) {
+  cullGroups(target);
+  for (uint8_t i = 0; i < commandCount; i++) {
+    DisplayCommand& c = commands[i];
+    if (c.target != target) continue;
+
+    if (c.op < DL_OP_FILL_SPRITE) {
+      applyState(target, c);
+      continue;
+    }
+    if (groupCulled[c.group]) {
+      stats.culled++;
+      continue;
+    }
+    flushState(target);
+    draw(i, c);
+  }
+}
+
+void dlExecute(int target) {
+  if (target >= 0) {
+    if (target < targetCount) executeTarget(target);
+  } else {
+    for (uint8_t i = 0; i < targetCount; i++) executeTarget(i);
+  }
+  stats.stateElided = stateRecorded - stateCalls;
+  stats.executed = drawCalls + stateCalls;
+}
+
+bool dlGroupChanged(uint8_t id) {
+  return id < DL_MAX_GROUPS && groupChanged[id];
+}
+
+bool dlTargetChanged(int target) {
+  return target >= 0 && target < targetCount && targetChanged[target];
+}
+
+const DisplayListStats& dlLastFrameStats() {
+  return stats;
+}
@@ -0,0 +1,180 @@
+/*************************************************************
+******************** FRAMEBUFFER STREAM **********************
+**************************************************************/
+
+#include "fb_stream.h"
+#include "web_server.h"
+
+const uint8_t FB_STREAM_MAX_BANDS = 32;
+const size_t FB_STREAM_MAX_BAND_BYTES = 320 * FB_STREAM_BAND_ROWS * 2;
+const size_t FB_STREAM_CHUNK_OVERHEAD = 8 + 2 + 8; // size line, CRLF, rect header
+
+// Stream frame types
+enum {
+  FB_FRAME_KEY = 0,
+  FB_FRAME_DELTA = 1
+};
+
+// Framebuffer being streamed
+static const uint16_t* frameBuffer = nullptr;
+static int frameWidth = 0, frameHeight = 0, bandCount = 0;
+
+// Stream state (a single viewer at a time)
+static WebConnection* viewer = nullptr;
+static uint32_t sentHash[FB_STREAM_MAX_BANDS]; // band hashes as last sent to the viewer
+static uint32_t pendingMask = 0;               // bands still to send in the current frame
+static uint32_t frameSequence = 0;
+static uint16_t framesSinceKey = 0;
+static unsigned long lastStreamFrame = 0;
+
+// Chunk on its way to the viewer: a copy of one band (or the frame header), written as the socket takes it
+static uint8_t outBuffer[FB_STREAM_MAX_BAND_BYTES + FB_STREAM_CHUNK_OVERHEAD];
+static size_t outLength = 0, outSent = 0;
+
+// Function to get the rows of a band
+static int bandRows(int band) {
+  return min((int)FB_STREAM_BAND_ROWS, frameHeight - band * FB_STREAM_BAND_ROWS);
+}
+
+// Function to hash band pixels (FNV-1a over 32-bit words)
+static uint32_t hashPixels(const void* pixels, size_t bytes) {
+  const uint32_t* words = (const uint32_t*)pixels;
+  size_t count = bytes / 4;
+  uint32_t hash = 2166136261u;
+  while (count--) {
+    hash = (hash ^ *words++) * 16777619u;
+  }
+  return hash;
+}
+
+// Function to hash one band of the framebuffer as it is now
+static uint32_t hashBand(int band) {
+  return hashPixels(frameBuffer + band * FB_STREAM_BAND_ROWS * frameWidth, (size_t)bandRows(band) * frameWidth * 2);
+}
+
+// Function to stage one chunk (parts a and b) in outBuffer; returns where b went
+static uint8_t* stageChunk(const void* a, size_t aLength, const void* b, size_t bLength) {
+  int sizeLength = sprintf((char*)outBuffer, "%X\r\n", (unsigned)(aLength + bLength));
+  uint8_t* out = outBuffer + sizeLength;
+  memcpy(out, a, aLength);
+  if (b) memcpy(out + aLength, b, bLength);
+  memcpy(out + aLength + bLength, "\r\n", 2);
+  outLength = sizeLength + aLength + bLength + 2;
+  outSent = 0;
+  return out + aLength;
+}
+
+// Function to write as much of the staged chunk as the socket has room for; true when all of it is out
+static bool drainChunk(WebConnection& conn) {
+  while (outSent < outLength) {
+    int room = conn.client.availableForWrite();
+    if (room <= 0) {
+      return false; // slow viewer: try again next poll rather than block loop()
+    }
+    size_t written = conn.client.write(outBuffer + outSent, min((size_t)room, outLength - outSent));
+    if (!written) {
+      return false;
+    }
+    outSent += written;
+    conn.lastActivity = millis();
+  }
+  return true;
+}
+
+// Function to start a new stream frame; returns false if nothing changed
+static bool beginStreamFrame(WebConnection& conn) {
+  bool keyframe = framesSinceKey == 0;
+  uint32_t mask = 0;
+  uint16_t rects = 0;
+
+  for (int band = 0; band < bandCount; band++) {
+    if (keyframe || hashBand(band) != sentHash[band]) {
+      mask |= 1u << band;
+      rects++;
+    }
+  }
+  if (!mask) {
+    return false;
+  }
+
+  uint8_t header[16] = { 'N', 'Y', 'F', 'B', (uint8_t)(keyframe ? FB_FRAME_KEY : FB_FRAME_DELTA), 0 };
+  memcpy(header + 6, &rects, 2);
+  memcpy(header + 8, &frameSequence, 4);
+  uint16_t width = frameWidth, height = frameHeight;
+  memcpy(header + 12, &width, 2);
+  memcpy(header + 14, &height, 2);
+  stageChunk(header, sizeof(header), nullptr, 0);
+
+  pendingMask = mask;
+  frameSequence++;
+  framesSinceKey = (framesSinceKey + 1) % FB_STREAM_KEYFRAME_INTERVAL;
+  return true;
+}
+
+// Function to stage one band as it is now; its hash is taken from the copy, so sentHash is what the viewer gets
+static void stageBand(int band) {
+  uint16_t rect[4];
+  rect[0] = 0;
+  rect[1] = band * FB_STREAM_BAND_ROWS;
+  rect[2] = frameWidth;
+  rect[3] = bandRows(band);
+  size_t bytes = (size_t)rect[2] * rect[3] * 2;
+  const uint8_t* copy = stageChunk(rect, sizeof(rect), frameBuffer + rect[1] * frameWidth, bytes);
+  sentHash[band] = hashPixels(copy, bytes);
+}
+
+// GET /stream handler
+static bool handleStream(WebConnection& conn) {
+  if (conn.handlerCalls == 0) {
+    // Only one viewer; a viewer whose slot was freed or now serves another request is stale
+    if (viewer && viewer != &conn && webConnectionServes(viewer, "GET", "/stream")) {
+      webSendText(conn, 503, "stream busy\n");
+      return false;
+    }
+    viewer = &conn;
+    pendingMask = 0;
+    outLength = outSent = 0;
+    framesSinceKey = 0; // start with a keyframe
+    lastStreamFrame = 0;
+    webSendHeader(conn, 200, "application/octet-stream", true);
+  }
+
+  // Finish the chunk a slow viewer left unsent
+  if (!drainChunk(conn)) {
+    return conn.client.connected();
+  }
+  conn.lastActivity = millis(); // caught up: waiting for the next frame or a change is not idling
+
+  // Start the next frame once the previous one is out and the interval has passed
+  if (!pendingMask) {
+    if (millis() - lastStreamFrame < FB_STREAM_INTERVAL) {
+      return true;
+    }
+    lastStreamFrame = millis();
+    if (!beginStreamFrame(conn) || !drainChunk(conn)) {
+      return conn.client.connected();
+    }
+  }
+
+  // Send a bounded number of bands per poll, each copied and hashed just before it goes out
+  for (uint8_t sent = 0; sent < FB_STREAM_BANDS_PER_POLL && pendingMask; sent++) {
+    int band = __builtin_ctz(pendingMask);
+    pendingMask &= pendingMask - 1;
+    stageBand(band);
+    if (!drainChunk(conn)) {
+      break;
+    }
+  }
+  return conn.client.connected();
+}
+
+void framebufferStreamBegin(const uint16_t* buffer, int width, int height) {
+  if (width * FB_STREAM_BAND_ROWS * 2 > (int)FB_STREAM_MAX_BAND_BYTES) {
+    return; // bands wider than the out buffer
+  }
+  frameBuffer = buffer;
+  frameWidth = width;
+  frameHeight = height;
+  bandCount = min((height + FB_STREAM_BAND_ROWS - 1) / FB_STREAM_BAND_ROWS, (int)FB_STREAM_MAX_BANDS);
+  webServerOn("GET", "/stream", handleStream);
+}
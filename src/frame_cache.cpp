@@ -0,0 +1,81 @@
+/*************************************************************
+************************* FRAME CACHE ************************
+**************************************************************/
+
+#include <string.h>
+#include "frame_cache.h"
+
+uint8_t frameCacheEntriesFor(size_t budget, size_t frameBytes, int frameCount) {
+  if (frameBytes == 0 || frameCount <= 0) return 0;
+  size_t entries = budget / frameBytes;
+  if (entries > (size_t)frameCount) entries = frameCount;
+  if (entries > FRAME_CACHE_MAX_ENTRIES) entries = FRAME_CACHE_MAX_ENTRIES;
+  return (uint8_t)entries;
+}
+
+void frameCacheInit(FrameCache& cache, uint16_t* const* buffers, uint8_t count, size_t frameBytes) {
+  if (count > FRAME_CACHE_MAX_ENTRIES) count = FRAME_CACHE_MAX_ENTRIES;
+  for (uint8_t i = 0; i < count; i++) {
+    cache.entries[i].pixels = buffers[i];
+    cache.entries[i].frame = -1;
+    cache.entries[i].lastUse = 0;
+    cache.entries[i].decodeMicros = 0;
+  }
+  cache.capacity = count;
+  cache.frameBytes = frameBytes;
+  cache.useClock = 0;
+  cache.usSaved = 0;
+  cache.stats = FrameCacheStats();
+}
+
+bool frameCacheFill(FrameCache& cache, int frame, uint16_t* pixels, frame_decode_t decode, void* context,
+                    frame_clock_t clock) {
+  if (cache.capacity == 0) {
+    return decode(frame, pixels, context);
+  }
+
+  // Hit, or the entry to reuse: an empty one, else the least recently used
+  FrameCacheEntry* victim = &cache.entries[0];
+  for (uint8_t i = 0; i < cache.capacity; i++) {
+    FrameCacheEntry& entry = cache.entries[i];
+    if (entry.frame == frame) {
+      uint32_t start = clock();
+      memcpy(pixels, entry.pixels, cache.frameBytes);
+      uint32_t copyMicros = clock() - start;
+      entry.lastUse = ++cache.useClock;
+      cache.stats.hits++;
+      if (entry.decodeMicros > copyMicros) {
+        cache.usSaved += entry.decodeMicros - copyMicros;
+        cache.stats.msSaved += cache.usSaved / 1000;
+        cache.usSaved %= 1000;
+      }
+      return true;
+    }
+    if (victim->frame >= 0 && (entry.frame < 0 || entry.lastUse < victim->lastUse)) {
+      victim = &entry;
+    }
+  }
+
+  cache.stats.misses++;
+  uint32_t start = clock();
+  if (!decode(frame, pixels, context)) {
+    return false;
+  }
+  uint32_t decodeMicros = clock() - start;
+
+  if (victim->frame >= 0) {
+    cache.stats.evictions++;
+  } else {
+    cache.stats.bytesHeld += cache.frameBytes;
+  }
+  memcpy(victim->pixels, pixels, cache.frameBytes);
+  victim->frame = frame;
+  victim->lastUse = ++cache.useClock;
+  victim->decodeMicros = decodeMicros;
+  return true;
+}
+
+uint8_t frameCacheHitPercent(const FrameCache& cache) {
+  uint32_t lookups = cache.stats.hits + cache.stats.misses;
+  return lookups ? (uint8_t)((uint64_t)cache.stats.hits * 100 / lookups) : 0;
+}
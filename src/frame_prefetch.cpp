@@ -0,0 +1,123 @@
+/*************************************************************
+*********************** FRAME PREFETCH ***********************
+**************************************************************/
+
+#include <Arduino.h>
+#include <freertos/FreeRTOS.h>
+#include <freertos/task.h>
+#include <atomic>
+#include "frame_prefetch.h"
+#include "mem_arena.h"
+
+const uint32_t PREFETCH_STACK = 2048; // bytes
+
+typedef enum {
+  PREFETCH_IDLE,
+  PREFETCH_COPYING,
+  PREFETCH_READY
+} prefetch_state_t;
+
+static uint16_t* staging = nullptr;   // internal SRAM
+static size_t stagingBytes = 0;
+static bool stagingInUse = false;
+static TaskHandle_t prefetchTask = nullptr;
+static bool prefetchOn = true;
+static FramePrefetchStats stats;
+
+// Copy job (written by loop() while IDLE/READY, read by the task while COPYING)
+static std::atomic<int> state(PREFETCH_IDLE);
+static int stagedIndex = -1;
+static const uint16_t* copySource = nullptr;
+static size_t copyBytes = 0;
+
+// Copy task (other core): flash -> staging, one frame per notification
+static void prefetchLoop(void* parameter) {
+  for (;;) {
+    ulTaskNotifyTake(pdTRUE, portMAX_DELAY);
+    if (state.load() != PREFETCH_COPYING) continue;
+    unsigned long start = micros();
+    memcpy(staging, copySource, copyBytes);
+    stats.copyMicros = micros() - start;
+    state.store(PREFETCH_READY);
+  }
+}
+
+// Function to wait for a copy in flight (it has had the whole frame to run, so it is nearly done)
+static void waitForCopy() {
+  if (state.load() != PREFETCH_COPYING) return;
+  unsigned long start = micros();
+  while (state.load() == PREFETCH_COPYING) {
+  }
+  stats.waitMicros += micros() - start;
+}
+
+bool framePrefetchReserve(size_t maxFrameBytes) {
+  if (staging) return stagingBytes >= maxFrameBytes;
+  if (!prefetchTask) {
+    BaseType_t otherCore = xPortGetCoreID() ^ 1;
+    if (xTaskCreatePinnedToCore(prefetchLoop, "prefetch", PREFETCH_STACK, nullptr, 1, &prefetchTask, otherCore) != pdPASS) {
+      prefetchTask = nullptr;
+      return false;
+    }
+  }
+  staging = (uint16_t*)memArenaAlloc("prefetch", maxFrameBytes, MEM_TIER_INTERNAL);
+  stagingBytes = staging ? maxFrameBytes : 0;
+  return staging != nullptr;
+}
+
+bool framePrefetchBegin(size_t frameBytes) {
+  framePrefetchCancel();
+  stagingInUse = staging && frameBytes <= stagingBytes;
+  return stagingInUse;
+}
+
+void framePrefetchEnd() {
+  framePrefetchCancel();
+  stagingInUse = false;
+}
+
+void framePrefetchSetEnabled(bool enabled) {
+  framePrefetchCancel();
+  prefetchOn = enabled;
+}
+
+bool framePrefetchEnabled() {
+  return prefetchOn && stagingInUse;
+}
+
+void framePrefetchRequest(int index, const uint16_t* source, size_t frameBytes) {
+  if (!framePrefetchEnabled() || frameBytes > stagingBytes) return;
+  if (stagedIndex == index && state.load() != PREFETCH_IDLE) return; // still staged (a frame shown for several loops)
+  waitForCopy(); // only after a miss: the previous copy was never taken
+  stagedIndex = index;
+  copySource = source;
+  copyBytes = frameBytes;
+  state.store(PREFETCH_COPYING);
+  xTaskNotifyGive(prefetchTask);
+}
+
+const uint16_t* framePrefetchTake(int index) {
+  if (!framePrefetchEnabled()) return nullptr;
+  int current = state.load();
+  if (current == PREFETCH_IDLE || stagedIndex != index) {
+    stats.misses++;
+    return nullptr;
+  }
+  if (current == PREFETCH_COPYING) {
+    stats.late++;
+    waitForCopy();
+  } else {
+    stats.hits++;
+  }
+  return staging;
+}
+
+void framePrefetchCancel() {
+  waitForCopy();
+  state.store(PREFETCH_IDLE);
+  stagedIndex = -1;
+}
+
+const FramePrefetchStats& framePrefetchStats() {
+  return stats;
+}
@@ -0,0 +1,104 @@
+/*************************************************************
+************************* FRAME RING *************************
+**************************************************************/
+
+#include "frame_ring.h"
+
+void frameRingInit(FrameRing& ring, uint16_t* const* slots, int frameCount, frame_decode_t decode, void* context) {
+  for (uint8_t i = 0; i < FRAME_RING_SLOTS; i++) {
+    ring.slots[i] = slots[i];
+    ring.slotFrame[i] = -1;
+  }
+  ring.frameCount = frameCount;
+  ring.decode = decode;
+  ring.context = context;
+  ring.head.store(0);
+  ring.tail.store(0);
+  ring.restart.store(-1);
+  ring.ahead.store(FRAME_RING_MIN_AHEAD + 1);
+  ring.nextFrame = 0;
+  ring.holding = false;
+  ring.hitStreak = 0;
+  ring.stats = FrameRingStats();
+  ring.stats.ahead = ring.ahead.load();
+  ring.producing.store(false);
+  ring.enabled.store(true);
+}
+
+void frameRingStop(FrameRing& ring) {
+  ring.enabled.store(false);
+  while (ring.producing.load()) {
+  }
+}
+
+bool frameRingProduce(FrameRing& ring) {
+  // Announce first, then check: frameRingStop() waits for this flag
+  ring.producing.store(true);
+  if (!ring.enabled.load()) {
+    ring.producing.store(false);
+    return false;
+  }
+
+  int restart = ring.restart.exchange(-1);
+  if (restart >= 0) {
+    ring.nextFrame = restart;
+  }
+
+  // Slot tail is on screen; up to `ahead` more may wait behind it
+  uint32_t head = ring.head.load(std::memory_order_relaxed);
+  uint32_t tail = ring.tail.load(std::memory_order_acquire);
+  if (head - tail >= (uint32_t)ring.ahead.load(std::memory_order_relaxed) + 1) {
+    ring.producing.store(false);
+    return false;
+  }
+
+  uint8_t slot = head % FRAME_RING_SLOTS;
+  int frame = ring.nextFrame;
+  ring.nextFrame = (frame + 1) % ring.frameCount;
+  if (ring.decode(frame, ring.slots[slot], ring.context)) {
+    ring.slotFrame[slot] = frame;
+    ring.stats.decoded++;
+    ring.head.store(head + 1, std::memory_order_release);
+  } else {
+    ring.stats.decodeErrors++; // skipped; the renderer keeps the previous frame
+  }
+  ring.producing.store(false);
+  return true;
+}
+
+const uint16_t* frameRingAcquire(FrameRing& ring, int index) {
+  uint32_t tail = ring.tail.load(std::memory_order_relaxed);
+  uint32_t head = ring.head.load(std::memory_order_acquire);
+  if (ring.holding && ring.slotFrame[tail % FRAME_RING_SLOTS] == index) {
+    return ring.slots[tail % FRAME_RING_SLOTS]; // same frame again
+  }
+
+  // Step through the ready frames, giving back the one on screen each time
+  while (tail + ring.holding < head) {
+    if (ring.holding) tail++;
+    ring.holding = true;
+    uint8_t slot = tail % FRAME_RING_SLOTS;
+    if (ring.slotFrame[slot] == index) {
+      ring.tail.store(tail, std::memory_order_release);
+      ring.stats.shown++;
+      if (++ring.hitStreak >= FRAME_RING_SHRINK_FRAMES) {
+        ring.hitStreak = 0;
+        uint8_t ahead = ring.ahead.load();
+        if (ahead > FRAME_RING_MIN_AHEAD) ring.ahead.store(ahead - 1);
+      }
+      ring.stats.ahead = ring.ahead.load();
+      return ring.slots[slot];
+    }
+    ring.stats.discarded++;
+  }
+  ring.tail.store(tail, std::memory_order_release);
+
+  // Underrun: decode further ahead, and carry on after the frame that was missed
+  ring.stats.underruns++;
+  ring.hitStreak = 0;
+  uint8_t ahead = ring.ahead.load();
+  if (ahead < FRAME_RING_MAX_AHEAD) ring.ahead.store(ahead + 1);
+  ring.stats.ahead = ring.ahead.load();
+  ring.restart.store((index + 1) % ring.frameCount);
+  return ring.holding ? ring.slots[tail % FRAME_RING_SLOTS] : nullptr;
+}
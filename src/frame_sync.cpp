@@ -0,0 +1,87 @@
+/*************************************************************
+************************ FRAME SYNC **************************
+**************************************************************/
+
+#include <Arduino.h>
+#include <WiFi.h>
+#include <WiFiUdp.h>
+#include "frame_sync.h"
+#include "sync_clock.h"
+
+static sync_mode_t syncMode = SYNC_MODE_OFF;
+static WiFiUDP syncSocket;
+static IPAddress boundAddress;     // local IP the multicast socket was opened on
+static SyncClock syncClock;        // follower state (leader uses offset 0)
+static SyncBeacon leaderBeacon;
+static uint32_t leaderSequence = 0;
+static unsigned long lastBeaconSent = 0;
+
+void frameSyncBegin(sync_mode_t mode, uint32_t framePeriodUs, uint16_t frameCount) {
+  syncMode = mode;
+  syncClockReset(syncClock);
+
+  // The leader's timeline starts now and follows its own clock
+  if (mode == SYNC_MODE_LEADER) {
+    syncClock.epochMillis = millis();
+    syncClock.framePeriodUs = framePeriodUs;
+    syncClock.frameCount = frameCount;
+    syncClock.locked = true;
+  }
+}
+
+// Function to (re)open the multicast socket whenever the IP address changes
+static bool ensureSocket() {
+  IPAddress localAddress = WiFi.localIP();
+  if (localAddress == boundAddress) {
+    return (uint32_t)boundAddress != 0;
+  }
+  syncSocket.stop();
+  boundAddress = localAddress;
+  if ((uint32_t)localAddress == 0) {
+    return false;
+  }
+  syncSocket.beginMulticast(IPAddress(SYNC_MULTICAST_GROUP), SYNC_PORT);
+  return true;
+}
+
+void frameSyncPoll() {
+  if (syncMode == SYNC_MODE_OFF || !ensureSocket()) {
+    return;
+  }
+
+  unsigned long now = millis();
+
+  if (syncMode == SYNC_MODE_LEADER) {
+    if (now - lastBeaconSent >= SYNC_BEACON_INTERVAL) {
+      syncBeaconInit(leaderBeacon, leaderSequence++, now, syncClock.epochMillis,
+                     syncClock.framePeriodUs, syncClock.frameCount);
+      syncSocket.beginPacket(IPAddress(SYNC_MULTICAST_GROUP), SYNC_PORT);
+      syncSocket.write((const uint8_t*)&leaderBeacon, sizeof(leaderBeacon));
+      syncSocket.endPacket();
+      lastBeaconSent = now;
+    }
+    return;
+  }
+
+  // Follower: drain every queued beacon (non-blocking)
+  SyncBeacon beacon;
+  int length;
+  while ((length = syncSocket.parsePacket()) > 0) {
+    int received = syncSocket.read((uint8_t*)&beacon, sizeof(beacon));
+    if (received == length && syncBeaconValid(&beacon, received)) {
+      syncClockSample(syncClock, beacon, millis());
+    }
+  }
+
+  // Unlock when the leader goes quiet (millis() again: a beacon drained above may be stamped after `now`)
+  if (syncClock.locked && millis() - syncClock.lastBeaconMillis > SYNC_LOST_TIMEOUT) {
+    syncClockReset(syncClock);
+  }
+}
+
+int frameSyncCurrentFrame() {
+  if (syncMode == SYNC_MODE_OFF || !syncClock.locked) {
+    return -1;
+  }
+  return syncClockFrame(syncClock, millis());
+}
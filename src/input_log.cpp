@@ -0,0 +1,458 @@
+/*************************************************************
+************************* INPUT LOG **************************
+**************************************************************/
+
+#include <WiFi.h>
+#include "input_log.h"
+#include "web_server.h"
+#include "mem_arena.h"
+
+// Record types (low 3 bits of the tag byte)
+enum {
+  REC_MILLIS = 0,     // arg: delta from the previous millis value
+  REC_DIGITAL = 1,    // arg: pin << 1 | level (only on change)
+  REC_WIFI_EVENT = 2, // arg: event id
+  REC_LOCAL_TIME = 3, // arg: 0 = failed, 1 = ok and varints epoch, milliseconds into the second follow
+  REC_LOCAL_IP = 4,   // arg: address (only on change)
+  REC_FRAME = 5       // arg: frame hash
+};
+
+const uint8_t REC_ARG_VARINT = 31;
+const size_t REC_MAX_BYTES = 1 + 5 + 5 + 2; // tag, varint argument, varint epoch, varint milliseconds
+const uint8_t INPUT_MAX_PINS = 49;      // GPIO0..48
+
+// Log header (little-endian), followed by stateSize bytes of state, then records
+struct __attribute__((packed)) InputLogHeader {
+  char magic[4];            // "NYIR"
+  uint16_t version;
+  uint16_t stateSize;
+  uint32_t startMillis;     // millis() when recording started
+  uint32_t frames;
+  uint64_t frameMicrosTotal; // summed frame time while recording
+};
+
+const uint16_t INPUT_LOG_VERSION = 2; // 2: local time records carry the sub-second phase
+
+static input_mode_t mode = INPUT_LIVE;
+static uint8_t* logBuffer = nullptr;
+static size_t logLength = 0;   // bytes in use (header, state, records)
+static uint32_t logGeneration = 0; // bumped whenever the buffer starts over (recording, upload)
+static size_t replayOffset = 0;
+static InputLogHeader header;
+
+// Last values seen (recording) or replayed
+static unsigned long lastMillis = 0;
+static uint8_t pinLevels[INPUT_MAX_PINS];
+static uint32_t localIP = 0;
+static bool localIPKnown = false;
+
+// Replay results
+static uint32_t replayFrames = 0, replayMismatches = 0, firstMismatch = 0;
+static uint64_t replayFrameMicros = 0;
+static uint32_t replayWorstMicros = 0;
+
+// WiFi events from the event task (single producer, single consumer)
+static volatile int wifiQueue[INPUT_WIFI_QUEUE];
+static volatile uint8_t wifiHead = 0, wifiTail = 0;
+
+input_mode_t inputMode() {
+  return mode;
+}
+
+bool inputWiFiLive() {
+  return mode != INPUT_REPLAYING;
+}
+
+// Function to reset the per-session value tracking
+static void resetTracking(unsigned long startMillis) {
+  lastMillis = startMillis;
+  memset(pinLevels, 0xFF, sizeof(pinLevels)); // unknown: first read is always logged
+  localIPKnown = false;
+}
+
+// PUT /inputlog writing into logBuffer (nullptr when none is running)
+static WebConnection* logUploader = nullptr;
+
+// Function to check whether logBuffer is free to record into or replay from: reserved at boot (PSRAM boards
+// only) and not being overwritten by an upload
+static bool logAvailable() {
+  if (logUploader && !webConnectionServes(logUploader, "PUT", "/inputlog")) {
+    logUploader = nullptr; // the upload's connection was dropped (its slot may serve another request by now)
+  }
+  return logBuffer && !logUploader;
+}
+
+
+/*************************************************************
+************************* RECORDING **************************
+**************************************************************/
+
+static void putVarint(uint32_t value) {
+  while (value >= 0x80) {
+    logBuffer[logLength++] = (uint8_t)(value | 0x80);
+    value >>= 7;
+  }
+  logBuffer[logLength++] = (uint8_t)value;
+}
+
+// Function to append one record; recording stops when the buffer is full
+static void putRecord(uint8_t type, uint32_t arg) {
+  if (mode != INPUT_RECORDING) return;
+  if (logLength + REC_MAX_BYTES > INPUT_LOG_BYTES) {
+    inputRecordStop();
+    Serial.println("rec: log full, recording stopped");
+    return;
+  }
+  if (arg < REC_ARG_VARINT) {
+    logBuffer[logLength++] = (uint8_t)(type | arg << 3);
+  } else {
+    logBuffer[logLength++] = (uint8_t)(type | REC_ARG_VARINT << 3);
+    putVarint(arg);
+  }
+}
+
+bool inputRecordStart(const void* state, size_t stateSize) {
+  if (mode != INPUT_LIVE || !logAvailable() || sizeof(header) + stateSize > INPUT_LOG_BYTES) {
+    return false;
+  }
+  memcpy(header.magic, "NYIR", 4);
+  header.version = INPUT_LOG_VERSION;
+  header.stateSize = (uint16_t)stateSize;
+  header.startMillis = millis();
+  header.frames = 0;
+  header.frameMicrosTotal = 0;
+  memcpy(logBuffer + sizeof(header), state, stateSize);
+  logLength = sizeof(header) + stateSize;
+  logGeneration++;
+
+  resetTracking(header.startMillis);
+  mode = INPUT_RECORDING;
+  return true;
+}
+
+void inputRecordStop() {
+  if (mode != INPUT_RECORDING) return;
+  memcpy(logBuffer, &header, sizeof(header));
+  mode = INPUT_LIVE;
+}
+
+
+/*************************************************************
+************************** REPLAYING *************************
+**************************************************************/
+
+// Function to end the replay and report how it compared with the recording
+static void finishReplay(const char* reason) {
+  mode = INPUT_LIVE;
+  Serial.printf("replay: %s after %u of %u frames, %u hash mismatches",
+                reason, (unsigned)replayFrames, (unsigned)header.frames, (unsigned)replayMismatches);
+  if (replayMismatches) Serial.printf(" (first at frame %u)", (unsigned)firstMismatch);
+  Serial.println();
+  if (replayFrames && header.frames) {
+    Serial.printf("replay: avg frame %u us (recorded %u us), worst %u us\n",
+                  (unsigned)(replayFrameMicros / replayFrames),
+                  (unsigned)(header.frameMicrosTotal / header.frames), (unsigned)replayWorstMicros);
+  }
+}
+
+static bool getVarint(uint32_t& value) {
+  value = 0;
+  for (uint8_t shift = 0; shift < 35 && replayOffset < logLength; shift += 7) {
+    uint8_t byte = logBuffer[replayOffset++];
+    value |= (uint32_t)(byte & 0x7F) << shift;
+    if (!(byte & 0x80)) return true;
+  }
+  return false;
+}
+
+// Function to look at the next record without consuming it; false at the end of the log
+static bool peekRecord(uint8_t& type, uint32_t& arg) {
+  if (mode != INPUT_REPLAYING) return false;
+  if (replayOffset >= logLength) {
+    finishReplay("complete");
+    return false;
+  }
+  size_t saved = replayOffset;
+  uint8_t tag = logBuffer[replayOffset++];
+  type = tag & 0x07;
+  arg = tag >> 3;
+  bool valid = arg != REC_ARG_VARINT || getVarint(arg);
+  replayOffset = saved;
+  if (!valid) finishReplay("truncated log");
+  return valid;
+}
+
+static void skipRecord() {
+  uint8_t tag = logBuffer[replayOffset++];
+  uint32_t ignored;
+  if ((tag >> 3) == REC_ARG_VARINT) getVarint(ignored);
+}
+
+// Function to consume a record that must be of the given type; false (and live mode) if not
+static bool takeRecord(uint8_t type, uint32_t& arg) {
+  uint8_t nextType;
+  if (!peekRecord(nextType, arg)) return false;
+  if (nextType != type) {
+    Serial.printf("replay: expected record %u, found %u at offset %u\n", type, nextType, (unsigned)replayOffset);
+    finishReplay("diverged");
+    return false;
+  }
+  skipRecord();
+  return true;
+}
+
+bool inputReplayStart(void* state, size_t stateSize) {
+  if (mode != INPUT_LIVE || !logAvailable() || logLength < sizeof(header)) {
+    return false;
+  }
+  memcpy(&header, logBuffer, sizeof(header));
+  if (memcmp(header.magic, "NYIR", 4) != 0 || header.version != INPUT_LOG_VERSION ||
+      header.stateSize != stateSize || sizeof(header) + stateSize > logLength) {
+    return false;
+  }
+  memcpy(state, logBuffer + sizeof(header), stateSize);
+  replayOffset = sizeof(header) + stateSize;
+
+  resetTracking(header.startMillis);
+  replayFrames = replayMismatches = firstMismatch = 0;
+  replayFrameMicros = 0;
+  replayWorstMicros = 0;
+  wifiTail = wifiHead; // live events from before the replay are irrelevant
+  mode = INPUT_REPLAYING;
+  return true;
+}
+
+
+/*************************************************************
+*************************** INPUTS ***************************
+**************************************************************/
+
+unsigned long inputMillis() {
+  if (mode == INPUT_REPLAYING) {
+    uint32_t delta;
+    if (takeRecord(REC_MILLIS, delta)) {
+      lastMillis += delta;
+      return lastMillis;
+    }
+  }
+
+  unsigned long now = millis();
+  putRecord(REC_MILLIS, now - lastMillis);
+  lastMillis = now;
+  return now;
+}
+
+int inputDigitalRead(uint8_t pin) {
+  if (mode == INPUT_REPLAYING && pin < INPUT_MAX_PINS) {
+    uint8_t type;
+    uint32_t arg;
+    if (peekRecord(type, arg) && type == REC_DIGITAL && (arg >> 1) == pin) {
+      skipRecord();
+      pinLevels[pin] = arg & 1;
+    }
+    if (mode == INPUT_REPLAYING) return pinLevels[pin];
+  }
+
+  int level = digitalRead(pin);
+  if (mode == INPUT_RECORDING && pin < INPUT_MAX_PINS && pinLevels[pin] != level) {
+    putRecord(REC_DIGITAL, (uint32_t)pin << 1 | (level & 1));
+    pinLevels[pin] = level;
+  }
+  return level;
+}
+
+bool inputGetLocalTime(struct tm* info, uint16_t* millisIntoSecond) {
+  if (mode == INPUT_REPLAYING) {
+    uint32_t ok, epoch, phase;
+    if (takeRecord(REC_LOCAL_TIME, ok)) {
+      if (!ok) return false;
+      if (getVarint(epoch) && getVarint(phase)) {
+        time_t seconds = epoch;
+        localtime_r(&seconds, info);
+        if (millisIntoSecond) *millisIntoSecond = (uint16_t)phase;
+        return true;
+      }
+      finishReplay("truncated log");
+    }
+  }
+
+  bool ok = getLocalTime(info);
+  uint16_t phase = 0;
+  if (ok) {
+    // Read the clock once more for the phase, and take the seconds from the same reading
+    struct timeval now;
+    gettimeofday(&now, nullptr);
+    time_t seconds = now.tv_sec;
+    localtime_r(&seconds, info);
+    phase = (uint16_t)(now.tv_usec / 1000);
+  }
+  if (millisIntoSecond) *millisIntoSecond = phase;
+  if (mode == INPUT_RECORDING) {
+    putRecord(REC_LOCAL_TIME, ok ? 1 : 0);
+    if (ok && mode == INPUT_RECORDING) {
+      putVarint((uint32_t)mktime(info));
+      putVarint(phase);
+    }
+  }
+  return ok;
+}
+
+uint32_t inputLocalIP() {
+  if (mode == INPUT_REPLAYING) {
+    uint8_t type;
+    uint32_t arg;
+    if (peekRecord(type, arg) && type == REC_LOCAL_IP) {
+      skipRecord();
+      localIP = arg;
+    }
+    if (mode == INPUT_REPLAYING) return localIP;
+  }
+
+  uint32_t address = (uint32_t)WiFi.localIP();
+  if (mode == INPUT_RECORDING && (!localIPKnown || address != localIP)) {
+    putRecord(REC_LOCAL_IP, address);
+    localIPKnown = true;
+  }
+  localIP = address;
+  return address;
+}
+
+void inputQueueWiFiEvent(int event) {
+  uint8_t next = (wifiHead + 1) % INPUT_WIFI_QUEUE;
+  if (next == wifiTail) return; // full: loop() is far behind, drop
+  wifiQueue[wifiHead] = event;
+  __sync_synchronize(); // publish the entry before the index (other core)
+  wifiHead = next;
+}
+
+bool inputNextWiFiEvent(int& event) {
+  if (mode == INPUT_REPLAYING) {
+    wifiTail = wifiHead; // live events are ignored while replaying
+    uint8_t type;
+    uint32_t arg;
+    if (peekRecord(type, arg) && type == REC_WIFI_EVENT) {
+      skipRecord();
+      event = (int)arg;
+      return true;
+    }
+    if (mode == INPUT_REPLAYING) return false;
+  }
+
+  if (wifiTail == wifiHead) {
+    return false;
+  }
+  event = wifiQueue[wifiTail];
+  wifiTail = (wifiTail + 1) % INPUT_WIFI_QUEUE;
+  putRecord(REC_WIFI_EVENT, (uint32_t)event);
+  return true;
+}
+
+void inputFrameEnd(uint32_t frameHash, uint32_t frameMicros) {
+  if (mode == INPUT_RECORDING) {
+    putRecord(REC_FRAME, frameHash);
+    header.frames++;
+    header.frameMicrosTotal += frameMicros;
+    return;
+  }
+
+  uint32_t recordedHash;
+  if (mode == INPUT_REPLAYING && takeRecord(REC_FRAME, recordedHash)) {
+    if (recordedHash != frameHash && replayMismatches++ == 0) {
+      firstMismatch = replayFrames;
+    }
+    replayFrames++;
+    replayFrameMicros += frameMicros;
+    replayWorstMicros = max(replayWorstMicros, frameMicros);
+    if (replayOffset >= logLength) finishReplay("complete");
+  }
+}
+
+void inputPrintStatus(Print& out) {
+  static const char* modeNames[] = { "live", "recording", "replaying" };
+  out.printf("rec: %s, log %u bytes, %u frames", modeNames[mode], (unsigned)logLength,
+             (unsigned)(mode == INPUT_REPLAYING ? replayFrames : header.frames));
+  if (mode == INPUT_RECORDING && header.frames) {
+    out.printf(", %u bytes/frame", (unsigned)((logLength - sizeof(header) - header.stateSize) / header.frames));
+  }
+  out.println();
+}
+
+
+/*************************************************************
+************************ HTTP TRANSFER ***********************
+**************************************************************/
+
+// GET /inputlog handler: the recorded log as octet stream
+static bool handleDownload(WebConnection& conn) {
+  if (conn.handlerCalls == 0) {
+    if (mode == INPUT_RECORDING || logLength == 0) {
+      webSendText(conn, 409, "no finished recording\n");
+      return false;
+    }
+    webSendHeader(conn, 200, "application/octet-stream", true);
+    conn.scratch[1] = logGeneration;
+  }
+
+  // A recording or upload started since then rewrites the buffer: end the response unfinished (no final chunk)
+  uint32_t& offset = conn.scratch[0];
+  if (mode == INPUT_RECORDING || conn.scratch[1] != logGeneration || offset > logLength) {
+    Serial.println("inputlog: download aborted, the log changed");
+    return false;
+  }
+  size_t length = min(INPUT_LOG_CHUNK, logLength - offset);
+  if (length == 0) {
+    webEndChunks(conn);
+    return false;
+  }
+  webSendChunk(conn, logBuffer + offset, length);
+  offset += length;
+  return conn.client.connected();
+}
+
+// PUT /inputlog handler: load a log for replay
+static bool handleUpload(WebConnection& conn) {
+  if (conn.handlerCalls == 0) {
+    if (mode != INPUT_LIVE || !logAvailable()) {
+      webSendText(conn, 409, "recorder busy or no PSRAM\n");
+      return false;
+    }
+    if (conn.contentLength < sizeof(InputLogHeader) || conn.contentLength > INPUT_LOG_BYTES) {
+      webSendText(conn, 413, "bad content length\n");
+      return false;
+    }
+    logLength = 0;
+    logGeneration++;
+    logUploader = &conn; // no recording or replay until the log is complete
+  }
+
+  uint32_t& received = conn.scratch[0];
+  int available = conn.client.available();
+  if (available <= 0) {
+    if (conn.client.connected()) return true;
+    logUploader = nullptr;
+    webSendText(conn, 400, "connection closed early\n");
+    return false;
+  }
+  size_t want = min((size_t)(conn.contentLength - received), min(INPUT_LOG_CHUNK, (size_t)available));
+  int count = conn.client.read(logBuffer + received, want);
+  if (count > 0) {
+    received += count;
+    conn.lastActivity = millis();
+  }
+  if (received < conn.contentLength) {
+    return true;
+  }
+
+  logLength = received;
+  logUploader = nullptr;
+  webSendText(conn, 201, "log loaded, start with \"rec replay\"\n");
+  return false;
+}
+
+void inputLogBegin() {
+  if (psramFound()) {
+    logBuffer = (uint8_t*)memArenaAlloc("input log", INPUT_LOG_BYTES, MEM_TIER_PSRAM);
+  }
+  webServerOn("GET", "/inputlog", handleDownload);
+  webServerOn("PUT", "/inputlog", handleUpload);
+}
@@ -0,0 +1,282 @@
+/*************************************************************
+************************ LCD BACKENDS ************************
+**************************************************************/
+
+#include <Arduino.h>
+#include <esp_heap_caps.h>
+#include <esp_lcd_panel_io.h>
+#include <soc/soc_memory_layout.h>
+#include <freertos/FreeRTOS.h>
+#include <freertos/semphr.h>
+#include "lcd_backend.h"
+#include "mem_arena.h"
+
+// ST7789 commands
+const int ST7789_CASET = 0x2A;
+const int ST7789_RASET = 0x2B;
+const int ST7789_RAMWR = 0x2C;
+const int ST7789_RAMWRC = 0x3C; // write memory continue (next chunk of the same window)
+
+const size_t LCD_I80_PSRAM_ALIGN = 64; // GDMA block size for PSRAM buffers
+
+// TFT_eSPI pushImage with the CPU driving the bus (what pushSprite does)
+class TftBackend : public DisplayBackend {
+public:
+  explicit TftBackend(TFT_eSPI& tft) : tft(tft) {}
+
+  const char* name() const override { return "tft"; }
+
+  bool begin(int frameWidth, int frameHeight, const uint16_t* buffer) override {
+    width = frameWidth;
+    height = frameHeight;
+    return true;
+  }
+
+  void pushFrame(const uint16_t* pixels) override {
+    bool swapBytes = tft.getSwapBytes();
+    tft.setSwapBytes(false); // already in panel byte order
+    tft.pushImage(0, 0, width, height, (uint16_t*)pixels);
+    tft.setSwapBytes(swapBytes);
+    frameDoneMicros = micros();
+  }
+
+  void pushRegion(const uint16_t* pixels, const DirtyRegion& region) override {
+    bool swapBytes = tft.getSwapBytes();
+    tft.setSwapBytes(false);
+    tft.startWrite();
+    for (uint8_t i = 0; i < region.count; i++) {
+      const DirtyRect& rect = region.rects[i];
+      tft.setAddrWindow(rect.x, rect.y, rect.w, rect.h);
+      for (int y = rect.y; y < rect.y + rect.h; y++) {
+        tft.pushPixels(pixels + (size_t)y * width + rect.x, rect.w);
+      }
+    }
+    tft.endWrite();
+    tft.setSwapBytes(swapBytes);
+    frameDoneMicros = micros();
+  }
+
+  bool busy() override { return false; }
+  void waitIdle() override {}
+
+private:
+  TFT_eSPI& tft;
+  int width = 0, height = 0;
+};
+
+// esp_lcd i80 bus on LCD_CAM, frames sent by GDMA
+class I80DmaBackend : public DisplayBackend {
+public:
+  ~I80DmaBackend() override;
+
+  const char* name() const override { return "i80-dma"; }
+  bool begin(int width, int height, const uint16_t* buffer) override;
+  void pushFrame(const uint16_t* pixels) override;
+  void pushRegion(const uint16_t* pixels, const DirtyRegion& region) override;
+  bool busy() override;
+  void waitIdle() override;
+
+private:
+  static bool transferDone(esp_lcd_panel_io_handle_t io, void* context, void* event); // IDF 4.4 callback order
+  void setWindow(int x, int y, int w, int h);
+  void queue(int command, const void* data, size_t bytes);
+  void waitPending(uint8_t queued);
+
+  esp_lcd_i80_bus_handle_t bus = nullptr;
+  esp_lcd_panel_io_handle_t io = nullptr;
+  SemaphoreHandle_t done = nullptr; // given once per finished transfer
+  int width = 0, height = 0;
+  size_t frameBytes = 0;
+  uint8_t pending = 0;              // transfers queued and not waited for yet
+  bool windowFull = true;           // the address window covers the whole frame
+  uint16_t* staging[2] = {};        // partial rows packed for GDMA (nullptr: region pushes send whole frames)
+};
+
+// Function to check that GDMA can read a buffer
+static bool dmaReadable(const void* buffer) {
+  return esp_ptr_dma_capable(buffer) ||
+         (esp_ptr_dma_ext_capable(buffer) && (uintptr_t)buffer % LCD_I80_PSRAM_ALIGN == 0);
+}
+
+I80DmaBackend::~I80DmaBackend() {
+  waitIdle();
+  if (io) esp_lcd_panel_io_del(io);
+  if (bus) esp_lcd_del_i80_bus(bus);
+  if (done) vSemaphoreDelete(done);
+}
+
+bool I80DmaBackend::begin(int frameWidth, int frameHeight, const uint16_t* buffer) {
+  width = frameWidth;
+  height = frameHeight;
+  frameBytes = (size_t)width * height * 2;
+  if (!dmaReadable(buffer)) {
+    Serial.println("i80-dma: frame buffer is not DMA readable");
+    return false;
+  }
+
+  done = xSemaphoreCreateCounting(LCD_I80_QUEUE_DEPTH + 1, 0);
+  if (!done) {
+    return false;
+  }
+
+  // Staging for region pushes: rows of a partial-width rect aren't contiguous in the frame
+  for (uint8_t i = 0; i < 2; i++) {
+    staging[i] = (uint16_t*)memArenaAlloc("i80 staging", LCD_I80_STAGING_BYTES, MEM_TIER_DMA);
+    if (!staging[i] || !dmaReadable(staging[i])) {
+      Serial.println("i80-dma: no DMA staging, region pushes send whole frames");
+      staging[0] = staging[1] = nullptr;
+      break;
+    }
+  }
+
+  // Same pins TFT_eSPI used (User_Setup for the T-Display-S3)
+  esp_lcd_i80_bus_config_t busConfig = {};
+  busConfig.dc_gpio_num = TFT_DC;
+  busConfig.wr_gpio_num = TFT_WR;
+  const int dataPins[8] = { TFT_D0, TFT_D1, TFT_D2, TFT_D3, TFT_D4, TFT_D5, TFT_D6, TFT_D7 };
+  for (int i = 0; i < 8; i++) {
+    busConfig.data_gpio_nums[i] = dataPins[i];
+  }
+  busConfig.bus_width = 8;
+  busConfig.max_transfer_bytes = frameBytes;
+  busConfig.psram_trans_align = LCD_I80_PSRAM_ALIGN;
+  busConfig.sram_trans_align = 4;
+  if (esp_lcd_new_i80_bus(&busConfig, &bus) != ESP_OK) {
+    Serial.println("i80-dma: bus setup failed");
+    return false;
+  }
+
+  esp_lcd_panel_io_i80_config_t ioConfig = {};
+  ioConfig.cs_gpio_num = TFT_CS;
+  ioConfig.pclk_hz = LCD_I80_PCLK_HZ;
+  ioConfig.trans_queue_depth = LCD_I80_QUEUE_DEPTH;
+  ioConfig.on_color_trans_done = transferDone;
+  ioConfig.user_ctx = this;
+  ioConfig.lcd_cmd_bits = 8;
+  ioConfig.lcd_param_bits = 8;
+  ioConfig.dc_levels.dc_idle_level = 0;
+  ioConfig.dc_levels.dc_cmd_level = 0;
+  ioConfig.dc_levels.dc_dummy_level = 0;
+  ioConfig.dc_levels.dc_data_level = 1;
+  if (esp_lcd_new_panel_io_i80(bus, &ioConfig, &io) != ESP_OK) {
+    Serial.println("i80-dma: panel IO setup failed");
+    esp_lcd_del_i80_bus(bus);
+    bus = nullptr;
+    return false;
+  }
+
+  // Full frames leave the window alone: every RAMWR starts again at its top-left corner
+  setWindow(0, 0, width, height);
+  return true;
+}
+
+// Function to set the panel address window (waits for the queued transfers: tx_param drains the queue)
+void I80DmaBackend::setWindow(int x, int y, int w, int h) {
+  int x0 = LCD_I80_X_OFFSET + x, y0 = LCD_I80_Y_OFFSET + y;
+  int x1 = x0 + w - 1, y1 = y0 + h - 1;
+  const uint8_t columns[4] = { (uint8_t)(x0 >> 8), (uint8_t)(x0 & 0xFF), (uint8_t)(x1 >> 8), (uint8_t)(x1 & 0xFF) };
+  const uint8_t rows[4] = { (uint8_t)(y0 >> 8), (uint8_t)(y0 & 0xFF), (uint8_t)(y1 >> 8), (uint8_t)(y1 & 0xFF) };
+  esp_lcd_panel_io_tx_param(io, ST7789_CASET, columns, sizeof(columns));
+  esp_lcd_panel_io_tx_param(io, ST7789_RASET, rows, sizeof(rows));
+  windowFull = x == 0 && y == 0 && w == width && h == height;
+}
+
+// Function to queue a pixel transfer (returns at once; transferDone gives done when it's finished)
+void I80DmaBackend::queue(int command, const void* data, size_t bytes) {
+  pending++;
+  esp_lcd_panel_io_tx_color(io, command, data, bytes);
+}
+
+// Function to wait until at most queued transfers are still on their way
+void I80DmaBackend::waitPending(uint8_t queued) {
+  while (pending > queued) {
+    xSemaphoreTake(done, portMAX_DELAY);
+    pending--;
+  }
+}
+
+// Transfer done (ISR): the buffer may be written again
+bool IRAM_ATTR I80DmaBackend::transferDone(esp_lcd_panel_io_handle_t io, void* context, void* event) {
+  I80DmaBackend* backend = (I80DmaBackend*)context;
+  backend->frameDoneMicros = micros();
+  BaseType_t woken = pdFALSE;
+  xSemaphoreGiveFromISR(backend->done, &woken);
+  return woken == pdTRUE;
+}
+
+void I80DmaBackend::pushFrame(const uint16_t* pixels) {
+  waitIdle(); // one frame in flight
+  if (!windowFull) {
+    setWindow(0, 0, width, height);
+  }
+  queue(ST7789_RAMWR, pixels, frameBytes);
+}
+
+/*
+Each rect is its own address window. Full-width rects are contiguous in the
+frame and go straight from it; others are packed a few rows at a time into
+the two staging buffers in turn (RAMWR, then RAMWRC for the following
+chunks), so packing one chunk overlaps sending the last. The window
+commands wait for the queue to drain, so only the last rect is still on
+its way when this returns.
+*/
+void I80DmaBackend::pushRegion(const uint16_t* pixels, const DirtyRegion& region) {
+  if (!staging[0]) {
+    pushFrame(pixels);
+    return;
+  }
+  uint8_t next = 0;
+  for (uint8_t i = 0; i < region.count; i++) {
+    const DirtyRect& rect = region.rects[i];
+    waitIdle(); // the window commands would wait for the queue anyway
+    setWindow(rect.x, rect.y, rect.w, rect.h);
+
+    const uint16_t* first = pixels + (size_t)rect.y * width + rect.x;
+    if (rect.w == width) {
+      queue(ST7789_RAMWR, first, (size_t)rect.w * rect.h * 2);
+      continue;
+    }
+    int chunkRows = LCD_I80_STAGING_BYTES / 2 / rect.w;
+    for (int row = 0; row < rect.h; row += chunkRows) {
+      int rows = min(chunkRows, rect.h - row);
+      waitPending(1); // the other buffer may still be on its way, this one not
+      uint16_t* packed = staging[next];
+      for (int y = 0; y < rows; y++) {
+        memcpy(packed + y * rect.w, first + (size_t)(row + y) * width, rect.w * 2);
+      }
+      queue(row == 0 ? ST7789_RAMWR : ST7789_RAMWRC, packed, (size_t)rows * rect.w * 2);
+      next ^= 1;
+    }
+  }
+}
+
+bool I80DmaBackend::busy() {
+  return pending && uxSemaphoreGetCount(done) < pending;
+}
+
+void I80DmaBackend::waitIdle() {
+  waitPending(0);
+}
+
+DisplayBackend* lcdBackendBegin(display_backend_t kind, TFT_eSPI& tft, TFT_eSprite& sprite) {
+  DisplayBackend* backend = nullptr;
+  if (kind == DISPLAY_BACKEND_I80_DMA) {
+    backend = new I80DmaBackend();
+  } else if (kind == DISPLAY_BACKEND_FRAMEBUFFER) {
+    backend = new FramebufferBackend();
+  }
+
+  const uint16_t* buffer = (const uint16_t*)sprite.getPointer();
+  if (backend && !backend->begin(sprite.width(), sprite.height(), buffer)) {
+    Serial.printf("display: %s unavailable, using tft\n", backend->name());
+    delete backend;
+    backend = nullptr;
+  }
+  if (!backend) {
+    backend = new TftBackend(tft);
+    backend->begin(sprite.width(), sprite.height(), buffer);
+  }
+
+  Serial.printf("display: %s backend\n", backend->name());
+  return backend;
+}
@@ -7,7 +7,32 @@
 #include <TFT_eSPI.h> // for TFT display control
 #include <WiFi.h>     // for WiFi connectivity
 #include "time.h"     // for time functions
-#include "nyancat.h"  // custom header for animation frames
+#include "animation.h"     // animation frames (built-in nyancat or uploaded)
+#include "frame_prefetch.h" // next raw frame staged in SRAM
+#include "anim_upload.h"   // OTA animation upload endpoint
+#include "pixel_kernels.h" // bulk pixel copy/fill routines
+#include "band_pool.h"     // blit/composite bands shared by both cores
+#include "benchmark.h"     // boot-time throughput checks (BENCHMARK_KERNELS)
+#include "web_server.h"    // non-blocking HTTP server
+#include "fb_stream.h"     // live framebuffer stream endpoint
+#include "metrics.h"       // frame timing and health metrics (/metrics)
+#include "wifi_state.h"    // WiFi connection state machine states
+#include "frame_sync.h"    // multicast animation sync between clocks
+#include "remote_display.h" // frames pushed from a host over UDP
+#include "console.h"       // serial command console
+#include "screenshot.h"    // screen capture over HTTP and serial
+#include "input_log.h"     // input record/replay for reproducible benchmarks
+#include "display_list.h"  // per-frame draw command list
+#include "lcd_backend.h"   // panel output (TFT_eSPI or esp_lcd i80 DMA)
+#include "mem_arena.h"     // buffers placed by memory tier, reserved at boot
+#include "arena_sprite.h"  // sprites with arena buffers
+#include "quality.h"       // adaptive quality under frame-budget pressure
+#include "tick_latency.h"  // seconds shown in phase with the real second
+#include "timer_wheel.h"   // timers for the periodic work and timeouts
+#include "cache_profile.h" // stall counters per stage (CACHE_PROFILING)
+#include "hot_code.h"      // IRAM placement of the per-frame loops (HOT_CODE_IRAM)
+#include "dirty_region.h"  // changed rectangles of a frame, pushed on their own
+#include "nyan_layers.h"   // built-in animation as scenery and cat layers
 
 // Button pins - using GPIO pins connected to physical buttons
 int BootButton = 0; // GPIO0 for left button (used to decrease brightness)
@@ -16,18 +41,105 @@ int KeyButton = 14; // GPIO14 for right button (used to increase brightness)
 /* 
 Create display and sprite objects:
  - lcd: Main display object
- - mainSprite: Primary drawing surface
+ - mainSprite: Primary drawing surface (buffer in DMA-capable RAM for the i80 backend)
  - secondsSprite: For displaying seconds separately
  - infoSprite: For FPS and connection info
  - fpsSprite: For second FPS counter (bottom left)
  - calendarSprite: For date/timezone header
 */
 TFT_eSPI lcd = TFT_eSPI();
-TFT_eSprite mainSprite = TFT_eSprite(&lcd);
-TFT_eSprite secondsSprite = TFT_eSprite(&lcd);
-TFT_eSprite infoSprite = TFT_eSprite(&lcd);
-TFT_eSprite fpsSprite = TFT_eSprite(&lcd);
-TFT_eSprite calendarSprite = TFT_eSprite(&lcd);
+ArenaSprite mainSprite = ArenaSprite(&lcd);
+ArenaSprite secondsSprite = ArenaSprite(&lcd);
+ArenaSprite infoSprite = ArenaSprite(&lcd);
+ArenaSprite fpsSprite = ArenaSprite(&lcd);
+ArenaSprite calendarSprite = ArenaSprite(&lcd);
+
+/*
+Memory arenas, reserved at the start of setup() (report at boot and with "mem"):
+ - dma: mainSprite (GDMA source), i80 staging for dirty-rect pushes
+ - internal: overlay sprites, frame prefetch staging, screenshot chunk
+ - psram: decode ring, frame cache, screenshot snapshot, remote display, input log, layer spans
+*/
+const size_t arenaDmaBytes = 118 * 1024;
+const size_t arenaInternalBytes = 148 * 1024;
+const size_t arenaPsramBytes = 4608 * 1024;
+
+/* 
+Panel output for the finished frame:
+ - DISPLAY_BACKEND_I80_DMA: GDMA sends mainSprite while loop() carries on (falls back to TFT if it can't start)
+ - DISPLAY_BACKEND_TFT: TFT_eSPI pushes it with the CPU
+ - DISPLAY_BACKEND_FRAMEBUFFER: no panel output, for timing everything else
+*/
+const display_backend_t displayBackendKind = DISPLAY_BACKEND_I80_DMA;
+DisplayBackend* display = nullptr;
+
+/* 
+Band compositing (animation blit and overlay composites):
+ - compositeThreads: 2 = both cores, 1 = everything in loop()
+ - bandSchedule: DYNAMIC lets the core that isn't busy with WiFi take more bands
+*/
+const uint8_t compositeThreads = 2;
+const band_schedule_t bandSchedule = BAND_SCHEDULE_DYNAMIC;
+
+// Decoded-frame cache for compressed animations (all 17 nyancat frames need 1.85 MB)
+const size_t frameCacheBudgetPsram = 2 * 1024 * 1024;
+
+/*
+Adaptive quality: steps down (fewer overlay redraws, half-resolution animation, half
+animation rate, clock only) when frames miss the budget, and back up with headroom.
+Off while recording/replaying inputs, so those frames stay comparable.
+*/
+const bool adaptiveQuality = true;
+QualityController quality;
+quality_level_t renderLevel = QUALITY_FULL; // level of the frame being rendered
+uint32_t loopCount = 0;                     // HALF_RATE renders every other loop
+unsigned long lastShownMicros = 0;          // when the previous rendered frame was pushed
+uint8_t overlaysSkipped = 0;                // frames since the overlay sprites were last redrawn
+
+// Stage the next raw animation frame in SRAM while the current one is composed (needs 106 KB of SRAM)
+const bool framePrefetch = true;
+
+/*
+Layered playback of the built-in animation (console "layers"):
+ - the starfield and rainbow are recomputed for every displayed frame and
+   the cat advances at the art's own rate (nyan_layers.h), instead of the
+   art frames being blitted one per loop
+ - only what changed is repainted and pushed: the scenery's dirty rects,
+   plus the overlay panels that changed (dirty_region.h); the areas under
+   the overlays are repainted every frame so their keyed composites land
+   on fresh pixels
+ - only with the built-in slot, above QUALITY_HALF_RES and without remote
+   display; the blit runs otherwise, and the first layered frame after it
+   repaints and pushes everything
+*/
+bool layeredPlayback = false;
+NyanLayers nyanLayers;
+bool layersReady = false;       // the cat was cut out of the built-in frames at boot
+bool layeredShown = false;      // the last rendered frame was layered
+DirtyRegion dirtyRegion;        // this frame's changes (layered frames)
+
+// Display list targets (overlays before mainSprite, which they are composited into)
+int calendarTarget, infoTarget, secondsTarget, fpsTarget, mainTarget;
+
+// Overlay sprites and where they are composited onto mainSprite (set in setup() from the clock position)
+struct OverlayPlacement {
+  int target;
+  int x, y, w, h;
+};
+const uint8_t OVERLAY_COUNT = 4;
+OverlayPlacement overlayPlacements[OVERLAY_COUNT];
+
+// Display list groups, one per panel
+typedef enum {
+  PANEL_CALENDAR,
+  PANEL_WEEKDAY,
+  PANEL_WIFI,
+  PANEL_SECONDS,
+  PANEL_FPS,
+  PANEL_CLOCK,
+  PANEL_HUD,
+  PANEL_COMPOSITE
+} panel_t;
 
 // WiFi credentials - replace with your network info
 const char* wifiNetwork = "YOUR_SSID"; // change to your SSID name
@@ -59,58 +171,121 @@ char currentMonth[6];  // Month abbreviation (3 letters)
 char currentYear[5];   // YYYY
 char weekdayName[10];  // full weekday name
 String weekdayString;  // weekday as String object
-String lastWeekday;    // cached weekday string
 
 // Time tracking variables
-unsigned long lastMillis = 0, elapsedSeconds = 0, lastNTPSync = 0;
+unsigned long lastMillis = 0, elapsedSeconds = 0;
 const unsigned long ntpSyncInterval = 600000; // sync every 10min
+const unsigned long ntpRetryInterval = 1000;  // after a failed sync
 time_t lastSyncedTime = 0;
 
+/*
+Timers (timer_wheel.h) instead of millis() comparisons polled every frame:
+ - the wheel advances once per loop, to the frame's inputMillis(), so a
+   replay fires them on the same frames as the recording
+ - the end-of-loop delay runs until the next deadline when that fits in the
+   frame budget, so the frame that handles it starts on time
+*/
+TimerWheel timers;
+Timer secondTimer;       // the next second is due (one render lead before its boundary)
+Timer fpsTimer;          // FPS readout, every fpsInterval
+Timer ntpTimer;          // next NTP sync
+Timer wifiCheckTimer;    // WiFi state machine, every WIFI_CHECK_INTERVAL
+Timer wifiTimeoutTimer;  // connection attempt gave no IP in time
+Timer wifiRecoveryTimer; // retry after WIFI_STATE_FAILED
+Timer animationTimer;    // next frame of a timed animation (per-frame durations)
+Timer* const clockTimers[] = { &secondTimer, &fpsTimer, &ntpTimer, &wifiCheckTimer, &wifiTimeoutTimer, &wifiRecoveryTimer,
+                               &animationTimer };
+const uint8_t CLOCK_TIMER_COUNT = sizeof(clockTimers) / sizeof(clockTimers[0]);
+bool secondDue = false;  // secondTimer fired; taken by the next loop that renders
+
+/*
+Seconds display in phase with the real second (tick_latency.h):
+ - lastMillis is the millis() of the current second's boundary, aligned to
+   the sub-second phase of the NTP time at every sync
+ - the new second is drawn by the frame that starts one render lead before
+   the boundary, and the tick-to-photon latency of that frame is measured
+*/
+TickLatency tickLatency;
+bool secondTicked = false;            // this frame shows a new second
+bool pushedTick = false;              // the frame on its way to the panel shows a new second
+unsigned long loopStartMicros = 0;    // start of this loop (render time of the frame)
+unsigned long pushedStartMicros = 0;  // start of the loop that pushed the frame on its way (0 = none)
+unsigned long pushedReturnMicros = 0; // pushFrame() returned (backends that can't report completion)
+unsigned long tickBoundaryMicros = 0; // micros() of the boundary of the second last shown
+
 // Animation control variables
 int animationFrame = 0;       // current frame of animation
+uint32_t animationShown = 0;  // animationGeneration() the timeline was started for
 long frameStartTime = 0;      // time when current frame started
 unsigned long frameCount = 0; // total frames rendered
 double framesPerSecond = 0;   // calculated FPS
 
 // Timing intervals for various updates
 unsigned long lastFPSCalculation = 0;
-unsigned long wifiFailedTime = 0;       // track when failure occurred
 const unsigned long fpsInterval = 1000; // update FPS interval
-unsigned long lastTimeUpdate = 0;       // last time NTP time was updated
+
+/* 
+Frame sync for several clocks side by side:
+ - SYNC_MODE_LEADER on one unit (or run tools/sync_beacon on a host)
+ - SYNC_MODE_FOLLOWER on the others
+ - in sync mode the animation runs on a timeline of syncFramePeriodUs per frame
+*/
+sync_mode_t syncMode = SYNC_MODE_OFF;
+const uint32_t syncFramePeriodUs = 50000; // 20 fps animation timeline
+
+/* 
+Remote-display mode:
+ - remoteDisplayMode: show frames sent by a host (tools/remote_sender) instead of the animation
+ - remoteOverlay: keep the clock panels composited on top of the remote frames
+*/
+bool remoteDisplayMode = false;
+bool remoteOverlay = true;
+
+/* 
+Input record/replay (console "rec"):
+ - ClockState is everything loop() carries between frames; it is stored with
+   a recording and restored before replaying it
+ - requests from the console take effect at the start of the next frame
+*/
+struct ClockState {
+  unsigned long lastMillis, elapsedSeconds;
+  time_t lastSyncedTime;
+  int animationFrame;
+  unsigned long frameCount, lastFPSCalculation;
+  double framesPerSecond;
+  int brightness;
+  wifi_state_t wifiState;
+  uint32_t timersNow;
+  TimerSnapshot timers[CLOCK_TIMER_COUNT]; // clockTimers, in order
+  bool secondDue;
+  uint8_t reconnectAttempts;
+  uint16_t wifiColour;
+  uint32_t ipAddress;
+};
+bool recordRequested = false;
+bool replayRequested = false;
 
 // Display settings
 int clockXPosition = 231;       // X position of clock display
 int clockYPosition = 8;         // Y position of clock display
 int brightness = 100;           // initial backlight brightness (0-255)
 bool brightnessChanged = false; // flag for brightness changes
+bool hudEnabled = false;        // frame time / heap readout (toggled with the "hud" console command)
 
 // Optimization variables
-bool staticElementsDrawn = false; // flag for static elements
 String cachedTimeString;          // cached time string
 String cachedDateString;          // cached date string
 String cachedCalendarString;      // cached calendar string
-String lastSecond;                // last second value for comparison
-String lastFPSString = "0";       // cached FPS string
 bool forceRedraw = true;          // force full redraw on first loop
 
-// WiFi connection states
-typedef enum {
-  WIFI_STATE_DISCONNECTED, // not connected, idle
-  WIFI_STATE_CONNECTING,   // attempting to connect
-  WIFI_STATE_CONNECTED,    // successfully connected
-  WIFI_STATE_RECONNECTING, // lost connection, trying to reconnect
-  WIFI_STATE_FAILED        // connection failed (after max retries)
-} wifi_state_t;
-
 // WiFi connection parameters
 const unsigned long WIFI_CHECK_INTERVAL = 5000;   // 5 seconds between checks
 const unsigned long WIFI_CONNECT_TIMEOUT = 10000; // 10 second connection timeout
+const unsigned long WIFI_RECOVERY_DELAY = 120000; // 2 minutes in WIFI_STATE_FAILED before starting over
 const uint8_t MAX_RECONNECT_ATTEMPTS = 3;         // max retries before giving up
 
 // WiFi state variables
 wifi_state_t wifiState = WIFI_STATE_DISCONNECTED;
-unsigned long lastWifiCheck = 0;
-unsigned long wifiConnectStart = 0;
 uint8_t reconnectAttempts = 0;
 uint16_t wifiColour = TFT_GREEN;
 
@@ -119,18 +294,83 @@ uint16_t wifiColour = TFT_GREEN;
 ********************** HELPER FUNCTIONS **********************
 **************************************************************/
 
-// Function to update time from NTP server
-void updateCurrentTime(bool forceNTPSync = false) {
-  if (forceNTPSync || millis() - lastNTPSync > ntpSyncInterval) {
-    struct tm timeinfo;
-    // Synchronize time from NTP server
-    if (getLocalTime(&timeinfo)) {
-      lastSyncedTime = mktime(&timeinfo);
-      lastNTPSync = millis();
-      elapsedSeconds = 0;
+// Function to change WiFi state (all transitions go through here for metrics)
+void setWiFiState(wifi_state_t newState) {
+  metricsWiFiTransition(wifiState, newState);
+  wifiState = newState;
+}
+
+// Function to hash the composed frame (FNV-1a over 32-bit words) for replay checks
+uint32_t frameHash() {
+  const uint32_t* words = (const uint32_t*)mainSprite.getPointer();
+  size_t count = (size_t)mainSprite.width() * mainSprite.height() / 2;
+  uint32_t hash = 2166136261u;
+  while (count--) {
+    hash = (hash ^ *words++) * 16777619u;
+  }
+  return hash;
+}
+
+// Band job: rows y0..y1 of the animation frame (context) into mainSprite, with the byte swap
+HOT_CODE void blitAnimationBand(int y0, int y1, void* context) {
+  uint16_t* dst = (uint16_t*)mainSprite.getPointer() + y0 * mainSprite.width();
+  pixelBlitSwapRect(dst, mainSprite.width(), y1 - y0, 0, -y0,
+                    (const uint16_t*)context, animationWidth(), animationHeight());
+}
+
+// Band job for QUALITY_HALF_RES: every other source pixel and row, each drawn 2x2
+HOT_CODE void blitAnimationBandHalf(int y0, int y1, void* context) {
+  const uint16_t* src = (const uint16_t*)context;
+  int width = min(mainSprite.width(), (int16_t)animationWidth());
+  int rows = min(y1, animationHeight());
+  uint16_t* dst = (uint16_t*)mainSprite.getPointer() + y0 * mainSprite.width();
+  for (int y = y0; y < rows; y++, dst += mainSprite.width()) {
+    if ((y & 1) && y > y0) {
+      memcpy(dst, dst - mainSprite.width(), width * sizeof(uint16_t)); // repeat the row above
+    } else {
+      pixelCopySwapHalf(dst, src + (size_t)(y & ~1) * animationWidth(), width);
     }
   }
-  
+}
+
+// Function to get how long before a second boundary the frame showing it starts (live only, so replays tick alike)
+unsigned long secondsLeadMillis() {
+  return inputMode() == INPUT_LIVE ? tickLatencyLeadMicros(tickLatency) / 1000 : 0;
+}
+
+// Function to arm secondTimer for the next second (one render lead before its boundary)
+void armSecondTimer() {
+  timerArmAt(timers, secondTimer, lastMillis + 1000 - secondsLeadMillis());
+}
+
+// Function to sync the local second count with NTP (retried soon if that fails)
+void syncTime() {
+  struct tm timeinfo;
+  uint16_t millisIntoSecond;
+  if (!inputGetLocalTime(&timeinfo, &millisIntoSecond)) {
+    timerArm(timers, ntpTimer, ntpRetryInterval);
+    return;
+  }
+  // Record how far the local seconds count had drifted from NTP time
+  unsigned long syncMillis = inputMillis();
+  if (lastSyncedTime != 0) {
+    struct timeval now;
+    gettimeofday(&now, nullptr);
+    int64_t localMillis = (int64_t)(lastSyncedTime + elapsedSeconds) * 1000 + (long)(syncMillis - lastMillis);
+    int64_t ntpMillis = (int64_t)now.tv_sec * 1000 + now.tv_usec / 1000;
+    metricsNtpSync((int32_t)(ntpMillis - localMillis));
+  } else {
+    metricsNtpSync(0);
+  }
+  lastSyncedTime = mktime(&timeinfo);
+  lastMillis = syncMillis - millisIntoSecond; // boundary of the current second
+  elapsedSeconds = 0;
+  timerArm(timers, ntpTimer, ntpSyncInterval);
+  armSecondTimer();
+}
+
+// Function to format the time strings from the local second count
+void updateCurrentTime() {
   time_t currentTime = lastSyncedTime + elapsedSeconds;
   struct tm* timeinfo = localtime(&currentTime);
   
@@ -150,26 +390,32 @@ void updateCurrentTime(bool forceNTPSync = false) {
   cachedCalendarString = "T-Display-S3 Clock (" + timezoneString + (dstEnabled ? " DST" : "") + ")";
 }
 
-// Function to handle WiFi events
+// Function to queue WiFi events (runs on the WiFi task; handled in loop())
 void WiFiEvent(WiFiEvent_t event) {
+  inputQueueWiFiEvent(event);
+}
+
+// Function to handle WiFi events
+void handleWiFiEvent(WiFiEvent_t event) {
   switch(event) {
     case SYSTEM_EVENT_STA_CONNECTED:
       break;
     
     case SYSTEM_EVENT_STA_GOT_IP:
       if (wifiState == WIFI_STATE_CONNECTING || wifiState == WIFI_STATE_RECONNECTING) {
-        wifiState = WIFI_STATE_CONNECTED;
-        ipAddress = WiFi.localIP().toString();
+        setWiFiState(WIFI_STATE_CONNECTED);
+        ipAddress = IPAddress(inputLocalIP()).toString();
         reconnectAttempts = 0;
-        lastNTPSync = 0; // force NTP sync on reconnection
+        timerCancel(timers, wifiTimeoutTimer);
+        timerArm(timers, ntpTimer, 0); // force NTP sync on reconnection
         forceRedraw = true;
       }
       break;
     
     case SYSTEM_EVENT_STA_DISCONNECTED:
       if (wifiState == WIFI_STATE_CONNECTED) {
-        wifiState = WIFI_STATE_RECONNECTING;
-        wifiConnectStart = millis();
+        setWiFiState(WIFI_STATE_RECONNECTING);
+        timerArm(timers, wifiTimeoutTimer, WIFI_CONNECT_TIMEOUT);
         forceRedraw = true;
       }
       break;
@@ -179,73 +425,74 @@ void WiFiEvent(WiFiEvent_t event) {
   }
 }
 
+// Function to handle the WiFi events queued since the last call
+void processWiFiEvents() {
+  int event;
+  while (inputNextWiFiEvent(event)) {
+    handleWiFiEvent((WiFiEvent_t)event);
+  }
+}
+
 // Function to start WiFi connection
 void startWiFi() {
-  WiFi.disconnect(true);  // true = disable auto-reconnect
-  delay(100); // short delay to allow WiFi to disconnect
-  WiFi.begin(wifiNetwork, wifiPassword);
-  wifiState = WIFI_STATE_CONNECTING;
-  wifiConnectStart = millis();
+  if (inputWiFiLive()) { // a replay only re-enacts the state changes
+    WiFi.disconnect(true);  // true = disable auto-reconnect
+    delay(100); // short delay to allow WiFi to disconnect
+    WiFi.begin(wifiNetwork, wifiPassword);
+  }
+  setWiFiState(WIFI_STATE_CONNECTING);
+  timerArm(timers, wifiTimeoutTimer, WIFI_CONNECT_TIMEOUT);
   reconnectAttempts = 0;
 }
 
-// Function to handle WiFi connection timeout
-void WiFiTimeout() {
+// Function to handle WiFi connection timeout (wifiTimeoutTimer)
+void WiFiTimeout(void* context) {
+  if (wifiState != WIFI_STATE_CONNECTING && wifiState != WIFI_STATE_RECONNECTING) {
+    return;
+  }
   // Attempt to reconnect
   if (wifiState == WIFI_STATE_RECONNECTING && ++reconnectAttempts >= MAX_RECONNECT_ATTEMPTS) {
-    wifiState = WIFI_STATE_FAILED;
-    wifiFailedTime = millis();
+    setWiFiState(WIFI_STATE_FAILED);
+    timerArm(timers, wifiRecoveryTimer, WIFI_RECOVERY_DELAY);
   } else {
     // Try again if connection is lost/fails
-    WiFi.disconnect(true); // true = disable auto-reconnect
-    delay(100); // short delay to allow WiFi to disconnect
-    WiFi.begin(wifiNetwork, wifiPassword); // start reconnection
-    wifiConnectStart = millis();
-    wifiState = WIFI_STATE_RECONNECTING;
+    if (inputWiFiLive()) {
+      WiFi.disconnect(true); // true = disable auto-reconnect
+      delay(100); // short delay to allow WiFi to disconnect
+      WiFi.begin(wifiNetwork, wifiPassword); // start reconnection
+    }
+    metricsReconnectAttempt();
+    timerArm(timers, wifiTimeoutTimer, WIFI_CONNECT_TIMEOUT);
+    setWiFiState(WIFI_STATE_RECONNECTING);
   }
 }
 
-// Function to try WiFi recovery if needed
-void WiFiRecovery(unsigned long currentMillis) {
-  // Attempt recovery after 2 minutes
-  if (currentMillis - wifiFailedTime > 120000) { // 2 minutes
-    wifiState = WIFI_STATE_DISCONNECTED;
+// Function to try WiFi recovery after WIFI_RECOVERY_DELAY (wifiRecoveryTimer)
+void WiFiRecovery(void* context) {
+  if (wifiState == WIFI_STATE_FAILED) {
+    setWiFiState(WIFI_STATE_DISCONNECTED); // the next check starts over
   }
 }
 
-// Function to update WiFi connection status
+// Function to update WiFi connection status (wifiCheckTimer; timeouts have their own timers)
 void updateWiFiStatus() {
-  unsigned long currentMillis = millis();
-  
-  // Manage connection attempts periodically
-  if (currentMillis - lastWifiCheck < WIFI_CHECK_INTERVAL) {
-    return;
-  }
-  lastWifiCheck = currentMillis;
-  
   switch (wifiState) {
     case WIFI_STATE_DISCONNECTED:
       startWiFi();
       break;
       
-    case WIFI_STATE_CONNECTING:
-    case WIFI_STATE_RECONNECTING:
-      if (currentMillis - wifiConnectStart > WIFI_CONNECT_TIMEOUT) {
-        WiFiTimeout();
-      }
-      break;
-      
-    case WIFI_STATE_FAILED:
-      WiFiRecovery(currentMillis);
-      break;
-      
-    case WIFI_STATE_CONNECTED:
+    case WIFI_STATE_CONNECTED: {
       // Verify IP address is still valid
-      if (ipAddress != WiFi.localIP().toString()) {
-        ipAddress = WiFi.localIP().toString();
+      String currentAddress = IPAddress(inputLocalIP()).toString();
+      if (ipAddress != currentAddress) {
+        ipAddress = currentAddress;
         forceRedraw = true;
       }
       break;
+    }
+
+    default:
+      break;
   }
 
   // Update visual indicator based on state (colour swapped circle colours)
@@ -265,86 +512,135 @@ void updateWiFiStatus() {
       newColour = 0x001F; // swapped green
   }
 
-  // Always redraw the status area when state changes or forced
-  if (newColour != wifiColour || forceRedraw) {
-    wifiColour = newColour;
+  wifiColour = newColour; // drawn by drawWiFiPanel()
+}
 
-    // Clear the entire status area (both circle and text)
-    infoSprite.fillRect(0, 39, 80, 35, TFT_BLACK);
-    
-    // Redraw the static "WIFI:" label
-    infoSprite.setTextFont(0);
-    infoSprite.setTextDatum(4); // center alignment
-    infoSprite.drawString("WIFI:", 30, 44, 2);
-    
-    // Redraw the status circle
-    infoSprite.fillCircle(60, 44, 5, wifiColour);
-    infoSprite.drawCircle(60, 44, 5, TFT_WHITE);
-    
-    // Clear and redraw the status text area with proper alignment
-    infoSprite.fillRect(0, 60, 100, 10, TFT_BLACK);
-    infoSprite.setTextFont(0);
-    infoSprite.setTextDatum(4); // center alignment
-    
-    if (wifiState == WIFI_STATE_CONNECTED) {
-      infoSprite.drawString(ipAddress, 43, 60, 1); // was 40, 60, 1
-    } else {
-      const char* statusText = "";
-      switch(wifiState) {
-        case WIFI_STATE_CONNECTING: statusText = "CONNECTING"; break;
-        case WIFI_STATE_RECONNECTING: statusText = "RECONNECTING"; break;
-        case WIFI_STATE_FAILED: statusText = "FAILED"; break;
-        default: statusText = "OFFLINE"; break;
-      }
-      infoSprite.drawString(statusText, 43, 60, 1); // was 40, 60, 1
-    }
-    forceRedraw = false;
+// Function to flag the next second as due (secondTimer; the next loop that renders shows it)
+void secondTimerFired(void* context) {
+  secondDue = true;
+}
+
+// Function to update the FPS readout (fpsTimer)
+void updateFps(void* context) {
+  unsigned long now = timers.now;
+  framesPerSecond = (double)frameCount * 1000 / (now - lastFPSCalculation);
+  frameCount = 0;
+  lastFPSCalculation = now;
+}
+
+// Function to sync with NTP when due (ntpTimer)
+void ntpTimerFired(void* context) {
+  syncTime();
+  updateCurrentTime();
+}
+
+// Function to run the WiFi state machine (wifiCheckTimer)
+void wifiCheckTimerFired(void* context) {
+  updateWiFiStatus();
+}
+
+// Function to step a timed animation (animationTimer): each frame stays up for its own duration
+// - the next deadline follows from the last one, so rounding and late loops don't add up
+// - frames whose whole duration has passed already are skipped to stay on the original timeline
+void animationTimerFired(void* context) {
+  uint32_t deadline = animationTimer.deadline;
+  int frame = animationFrame;
+  do {
+    frame = (frame + 1) % animationFrameCount();
+    uint16_t duration = animationFrameDurationMs(frame);
+    if (duration == 0) return; // switched to an untimed animation
+    deadline += duration;
+  } while ((int32_t)(deadline - timers.now) <= 0);
+  if (frameSyncCurrentFrame() < 0) {
+    animationFrame = frame; // in sync mode the shared timeline picks the frame
   }
+  timerArmAt(timers, animationTimer, deadline);
 }
 
-// Function to draw all static elements once
-void drawStaticElements() {
-  if (!staticElementsDrawn) {
-    /* 
-    Calendar header with timezone info:
-    - White rounded rectangle border
-    - Displays device name, timezone, and DST status if enabled
-    */
-    calendarSprite.fillSprite(TFT_BLACK);
-    calendarSprite.drawRoundRect(0, 0, 217, 26, 3, TFT_WHITE);
-    calendarSprite.drawString(cachedCalendarString, 8, 4, 2);
-    calendarSprite.pushToSprite(&mainSprite, clockXPosition-224, clockYPosition, TFT_BLACK);
-
-    /* 
-    Weekday display (right panel):
-    - White rounded rectangle border
-    - Displays current weekday in short format
-    */
-    infoSprite.fillSprite(TFT_BLACK);
-    infoSprite.drawRoundRect(0, 0, 80, 34, 3, TFT_WHITE);
-    
-    /*
-    FPS display (bottom left):
-    - White rounded rectangle border
-    - Displays current FPS
-    */
-    fpsSprite.fillSprite(TFT_BLACK);
-    fpsSprite.drawRoundRect(0, 0, 50, 20, 3, TFT_WHITE);
-    
-    /* 
-    Connection status display:
-    - "WIFI:" text
-    - IP address below in default font
-    */
-    infoSprite.drawString("WIFI:", 30, 44, 2);
-    infoSprite.setTextFont(0);
-
-    // Draw initial WiFi status circle
-    infoSprite.fillRect(55, 39, 10, 10, TFT_BLACK);
-    infoSprite.fillCircle(60, 44, 5, wifiColour);
-    infoSprite.drawCircle(60, 44, 5, TFT_WHITE);
-    
-    staticElementsDrawn = true;
+// Function to start the active animation from its first frame at nowMillis (on another animation being selected)
+void startAnimationTimeline(uint32_t nowMillis) {
+  animationShown = animationGeneration();
+  animationFrame = 0;
+  timerCancel(timers, animationTimer);
+  uint16_t duration = animationFrameDurationMs(0);
+  if (duration) {
+    timerArmAt(timers, animationTimer, nowMillis + duration);
+  }
+}
+
+// Function to predict the frame the next rendered loop shows (for the prefetch)
+int nextAnimationFrame() {
+  int next = (animationFrame + 1) % animationFrameCount();
+  if (animationFrameDurationMs(animationFrame) == 0 || !animationTimer.armed) {
+    return next;
+  }
+  uint32_t untilNextRender = METRICS_FRAME_BUDGET_US / 1000 * qualityFrameInterval(renderLevel);
+  return timerRemaining(timers, animationTimer) <= untilNextRender ? next : animationFrame;
+}
+
+// Function to set up the clock's timers (the NTP and second timers are armed by the first sync)
+void timersBegin() {
+  timerWheelInit(timers, inputMillis());
+  lastFPSCalculation = timers.now;
+  timerInit(secondTimer, "second", secondTimerFired, nullptr);
+  timerInit(fpsTimer, "fps", updateFps, nullptr);
+  timerInit(ntpTimer, "ntp", ntpTimerFired, nullptr);
+  timerInit(wifiCheckTimer, "wifi check", wifiCheckTimerFired, nullptr);
+  timerInit(wifiTimeoutTimer, "wifi timeout", WiFiTimeout, nullptr);
+  timerInit(wifiRecoveryTimer, "wifi recovery", WiFiRecovery, nullptr);
+  timerInit(animationTimer, "animation", animationTimerFired, nullptr);
+  timerArm(timers, fpsTimer, fpsInterval, fpsInterval);
+  timerArm(timers, wifiCheckTimer, WIFI_CHECK_INTERVAL, WIFI_CHECK_INTERVAL);
+}
+
+// Function to record the calendar header (device name, timezone and DST status)
+void drawCalendarPanel() {
+  dlGroup(calendarTarget, PANEL_CALENDAR);
+  dlFillSprite(TFT_BLACK);
+  dlDrawRoundRect(0, 0, 217, 26, 3, TFT_WHITE);
+  dlSetTextColor(TFT_WHITE);
+  dlSetTextDatum(0); // top-left
+  dlDrawString(cachedCalendarString.c_str(), 8, 4, 2);
+}
+
+// Function to record the weekday panel (right, top of infoSprite)
+void drawWeekdayPanel() {
+  char weekday[4];
+  for (int i = 0; i < 3; i++) weekday[i] = toupper(weekdayName[i]); // MON, TUE, etc.
+  weekday[3] = '\0';
+
+  dlGroup(infoTarget, PANEL_WEEKDAY);
+  dlFillRect(0, 0, 80, 34, TFT_BLACK); // clear only weekday area
+  dlDrawRoundRect(0, 0, 80, 34, 3, TFT_WHITE);
+  dlSetFreeFont(&Orbitron_Light_24);   // set larger font
+  dlSetTextColor(TFT_WHITE);
+  dlSetTextDatum(4); // center alignment
+  dlDrawString(weekday, 38, 14); // centered (was 40, 14)
+}
+
+// Function to record the connection status ("WIFI:", status circle, IP or state below)
+void drawWiFiPanel() {
+  dlGroup(infoTarget, PANEL_WIFI);
+  dlFillRect(0, 39, 80, 35, TFT_BLACK); // clear the entire status area (both circle and text)
+  dlSetTextFont(1);  // default font, no free font (the status text uses font 1)
+  dlSetTextColor(TFT_WHITE);
+  dlSetTextDatum(4); // center alignment
+  dlDrawString("WIFI:", 30, 44, 2);
+  dlFillCircle(60, 44, 5, wifiColour);
+  dlDrawCircle(60, 44, 5, TFT_WHITE);
+  dlFillRect(0, 60, 100, 10, TFT_BLACK);
+
+  if (wifiState == WIFI_STATE_CONNECTED) {
+    dlDrawString(ipAddress.c_str(), 43, 60, 1); // was 40, 60, 1
+  } else {
+    const char* statusText = "";
+    switch(wifiState) {
+      case WIFI_STATE_CONNECTING: statusText = "CONNECTING"; break;
+      case WIFI_STATE_RECONNECTING: statusText = "RECONNECTING"; break;
+      case WIFI_STATE_FAILED: statusText = "FAILED"; break;
+      default: statusText = "OFFLINE"; break;
+    }
+    dlDrawString(statusText, 43, 60, 1); // was 40, 60, 1
   }
 }
 
@@ -355,8 +651,8 @@ void adjustBrightness() {
   const int step = 25; // step size (25 provides 7 steps between 100-250)
   
   // Read current button states (active LOW)
-  uint8_t currBootBtn = digitalRead(BootButton);
-  uint8_t currKeyBtn = digitalRead(KeyButton);
+  uint8_t currBootBtn = inputDigitalRead(BootButton);
+  uint8_t currKeyBtn = inputDigitalRead(KeyButton);
   
   // Detect falling edge (HIGH->LOW transition) on Boot button
   if (prevBootBtn == HIGH && currBootBtn == LOW) {
@@ -375,6 +671,515 @@ void adjustBrightness() {
   prevKeyBtn = currKeyBtn;
 }
 
+// Function to copy the state loop() carries between frames
+ClockState saveClockState() {
+  ClockState state;
+  memset(&state, 0, sizeof(state)); // padding is part of the recording
+  state.lastMillis = lastMillis;
+  state.elapsedSeconds = elapsedSeconds;
+  state.lastSyncedTime = lastSyncedTime;
+  state.animationFrame = animationFrame;
+  state.frameCount = frameCount;
+  state.lastFPSCalculation = lastFPSCalculation;
+  state.framesPerSecond = framesPerSecond;
+  state.brightness = brightness;
+  state.wifiState = wifiState;
+  state.timersNow = timers.now;
+  for (uint8_t i = 0; i < CLOCK_TIMER_COUNT; i++) {
+    timerSave(*clockTimers[i], state.timers[i]);
+  }
+  state.secondDue = secondDue;
+  state.reconnectAttempts = reconnectAttempts;
+  state.wifiColour = wifiColour;
+  state.ipAddress = (uint32_t)WiFi.localIP();
+  return state;
+}
+
+// Function to restore a saved state (everything is repainted on the next frame)
+void restoreClockState(const ClockState& state) {
+  lastMillis = state.lastMillis;
+  elapsedSeconds = state.elapsedSeconds;
+  lastSyncedTime = state.lastSyncedTime;
+  animationFrame = state.animationFrame;
+  frameCount = state.frameCount;
+  lastFPSCalculation = state.lastFPSCalculation;
+  framesPerSecond = state.framesPerSecond;
+  brightness = state.brightness;
+  analogWrite(TFT_BL, brightness);
+  setWiFiState(state.wifiState);
+  // The replay's clock starts over at the recording's: rebuild the wheel at that time
+  timerWheelInit(timers, state.timersNow);
+  for (uint8_t i = 0; i < CLOCK_TIMER_COUNT; i++) {
+    timerRestore(timers, *clockTimers[i], state.timers[i]);
+  }
+  secondDue = state.secondDue;
+  reconnectAttempts = state.reconnectAttempts;
+  wifiColour = state.wifiColour;
+  ipAddress = IPAddress(state.ipAddress).toString();
+}
+
+// Function to start a recording or replay requested from the console
+void startRequestedInputLog() {
+  if (recordRequested) {
+    ClockState state = saveClockState();
+    Serial.println(inputRecordStart(&state, sizeof(state)) ? "rec: recording" : "rec: cannot record (busy, log upload running or no PSRAM)");
+    updateCurrentTime(); // replay does the same, so both start from identical time strings
+    forceRedraw = true;
+  }
+  if (replayRequested) {
+    ClockState state;
+    if (inputReplayStart(&state, sizeof(state))) {
+      restoreClockState(state);
+      updateCurrentTime(); // re-derive the time strings from the restored clock
+      Serial.println("rec: replaying");
+    } else {
+      Serial.println("rec: no valid log for this build");
+    }
+    forceRedraw = true;
+  }
+  recordRequested = replayRequested = false;
+}
+
+// Function to record the frame time and free heap readout on mainSprite
+void drawHud() {
+  char text[32];
+  snprintf(text, sizeof(text), "%.1fms %uk", metricsLastFrameMicros() / 1000.0, (unsigned)(ESP.getFreeHeap() / 1024));
+  dlGroup(mainTarget, PANEL_HUD);
+  dlFillRect(5, 128, 90, 12, TFT_BLACK);
+  dlSetTextColor(TFT_WHITE, TFT_BLACK);
+  dlSetTextDatum(0); // top-left
+  dlDrawString(text, 8, 130, 1);
+}
+
+// Function to record the overlay sprite contents (calendar, info, seconds, FPS)
+void drawOverlayPanels() {
+  drawCalendarPanel();
+  drawWeekdayPanel();
+  drawWiFiPanel();
+
+  /* 
+  Seconds display (rendered separately for smoother updates)
+  */
+  dlGroup(secondsTarget, PANEL_SECONDS);
+  dlFillSprite(TFT_BLACK);
+  dlSetFreeFont(&Orbitron_Light_32);
+  dlSetTextColor(TFT_WHITE);
+  dlSetTextDatum(0); // top-left
+  dlDrawString(currentSecond, 9, 6);
+
+  /* 
+  FPS counter (bottom left)
+  */
+  char currentFPS[12];
+  snprintf(currentFPS, sizeof(currentFPS), "%d", (int)framesPerSecond);
+  dlGroup(fpsTarget, PANEL_FPS);
+  dlFillSprite(TFT_BLACK);
+  dlSetTextFont(1);
+  dlSetTextSize(1);
+  dlSetTextColor(TFT_WHITE);
+  dlSetTextDatum(4); // center alignment
+  dlDrawRoundRect(0, 0, 50, 20, 3, TFT_WHITE);
+  dlDrawString("FPS", 32, 10, 1);
+  dlDrawString(currentFPS, 15, 10, 1);
+}
+
+/*
+Function to draw the clock panels and composite the overlay sprites onto mainSprite:
+ - every panel is recorded into the display list each frame
+ - the list skips overlay panels that are unchanged since the last frame and
+   state changes that are already in effect (see display_list.h)
+ - from QUALITY_REDUCED_OVERLAYS on, the overlay sprites are redrawn only every
+   QUALITY_OVERLAY_INTERVAL frames (the last contents are composited meanwhile)
+*/
+void drawClockOverlay() {
+  dlBeginFrame();
+  dlOverdrawn(mainTarget); // the blit stage repainted all of mainSprite (layered: at least everything under the panels)
+  // Overlay sprites are redrawn only every few frames from QUALITY_REDUCED_OVERLAYS on
+  bool overlays = forceRedraw || secondTicked || renderLevel < QUALITY_REDUCED_OVERLAYS ||
+                  ++overlaysSkipped >= QUALITY_OVERLAY_INTERVAL;
+  if (overlays) {
+    overlaysSkipped = 0;
+  }
+  if (forceRedraw) {
+    dlInvalidateAll();
+    forceRedraw = false;
+  }
+
+  // Overlay sprites
+  if (overlays) {
+    drawOverlayPanels();
+  }
+
+  /* 
+  Clock display rendering:
+  - Purple text on white background
+  - Two rounded rectangles: one for time, one for date
+  - Time "HH:MM" (24-hour, font 4) and date "DD Mon 'YY" (font 2), centered
+  */
+  dlGroup(mainTarget, PANEL_CLOCK);
+  dlSetTextColor(PURPLE_COLOUR, TFT_WHITE);
+  dlSetTextDatum(4); // center alignment
+  dlFillRoundRect(clockXPosition, clockYPosition, 80, 26, 3, TFT_WHITE);      // time display background (top rectangle)
+  dlFillRoundRect(clockXPosition, clockYPosition + 70, 80, 16, 3, TFT_WHITE); // date display background
+  dlDrawString(cachedTimeString.c_str(), clockXPosition+40, clockYPosition+13, 4);
+  dlDrawString(cachedDateString.c_str(), clockXPosition+40, clockYPosition+78, 2);
+
+  // Diagnostic readout above the FPS counter
+  if (hudEnabled) {
+    drawHud();
+  }
+
+  /* 
+  Combine all sprites onto main display:
+  - calendarSprite: Top-left position
+  - secondsSprite: Below main time display
+  - infoSprite: Bottom-right position
+  - fpsSprite: Bottom-left position
+  */
+  dlGroup(mainTarget, PANEL_COMPOSITE);
+  for (uint8_t i = 0; i < OVERLAY_COUNT; i++) {
+    dlComposite(overlayPlacements[i].target, overlayPlacements[i].x, overlayPlacements[i].y);
+  }
+
+  // Overlay sprites first (when redrawn this frame), then everything on mainSprite
+  if (overlays) {
+    dlExecute(calendarTarget);
+    dlExecute(infoTarget);
+    dlExecute(secondsTarget);
+    dlExecute(fpsTarget);
+  }
+  metricsStageEnd(STAGE_DRAW);
+  dlExecute(mainTarget);
+  metricsStageEnd(STAGE_COMPOSITE);
+
+  const DisplayListStats& listStats = dlLastFrameStats();
+  metricsDisplayList(listStats.recorded, listStats.executed);
+}
+
+// Function to cut the cat out of the built-in frames for layered playback (after mainSprite is created)
+void layersBegin() {
+  int count, width, height;
+  const uint16_t* frames = animationBuiltinFrames(count, width, height);
+  CatSpan* spans = (CatSpan*)memArenaAlloc("layer spans", NYAN_MAX_CAT_SPANS * sizeof(CatSpan), MEM_TIER_PSRAM);
+  unsigned long start = millis();
+  layersReady = spans && width == mainSprite.width() && height == mainSprite.height() &&
+                nyanLayersInit(nyanLayers, frames, count, width, height, spans, NYAN_MAX_CAT_SPANS);
+  dirtyInit(dirtyRegion, mainSprite.width(), mainSprite.height());
+  if (layersReady) {
+    Serial.printf("layers: cat cut out of %d frames, %u spans in %lu ms\n", count,
+                  (unsigned)nyanLayersSpanCount(nyanLayers), millis() - start);
+  } else {
+    Serial.println("layers: no cat found in the built-in frames, layered playback unavailable");
+  }
+}
+
+// Function to check whether this frame is rendered from the layers
+bool layeredFrame() {
+  return layeredPlayback && layersReady && !remoteDisplayMode && animationActiveSlot() == ANIM_SLOT_BUILTIN &&
+         renderLevel < QUALITY_HALF_RES;
+}
+
+// Function to bring mainSprite to the layered scene at nowMillis: the dirty rects, and the areas under the overlays
+// (everything after a blit frame or a forced redraw)
+void drawLayers(uint32_t nowMillis, bool repaintAll) {
+  dirtyClear(dirtyRegion);
+  if (repaintAll) {
+    nyanLayersReset(nyanLayers);
+  }
+  // In sync mode the shared timeline picks the cat frame, so clocks side by side stay in step
+  int catFrame = frameSyncCurrentFrame() >= 0 ? animationFrame % nyanLayers.frameCount
+                                              : nyanLayersCatFrame(nyanLayers, nowMillis);
+  nyanLayersAdvance(nyanLayers, nowMillis, catFrame, dirtyRegion);
+
+  uint16_t* pixels = (uint16_t*)mainSprite.getPointer();
+  for (uint8_t i = 0; i < dirtyRegion.count; i++) {
+    nyanLayersDraw(nyanLayers, pixels, dirtyRegion.rects[i]);
+  }
+  DirtyRegion under;
+  dirtyInit(under, mainSprite.width(), mainSprite.height()); // clips the placements to the sprite
+  for (uint8_t i = 0; i < OVERLAY_COUNT; i++) {
+    const OverlayPlacement& overlay = overlayPlacements[i];
+    dirtyAdd(under, overlay.x, overlay.y, overlay.w, overlay.h);
+  }
+  for (uint8_t i = 0; i < under.count; i++) {
+    nyanLayersDraw(nyanLayers, pixels, under.rects[i]);
+  }
+}
+
+// Function to add the panels whose pixels changed this frame to the dirty region (after drawClockOverlay)
+void addChangedPanels() {
+  for (uint8_t i = 0; i < OVERLAY_COUNT; i++) {
+    const OverlayPlacement& overlay = overlayPlacements[i];
+    if (dlTargetChanged(overlay.target)) {
+      dirtyAdd(dirtyRegion, overlay.x, overlay.y, overlay.w, overlay.h);
+    }
+  }
+  if (dlGroupChanged(PANEL_CLOCK)) {
+    dirtyAdd(dirtyRegion, clockXPosition, clockYPosition, 80, 26);
+    dirtyAdd(dirtyRegion, clockXPosition, clockYPosition + 70, 80, 16);
+  }
+  if (dlGroupChanged(PANEL_HUD)) {
+    dirtyAdd(dirtyRegion, 5, 128, 90, 12);
+  }
+}
+
+// Function to send the composed frame: whole, or a layered frame's dirty region when that is smaller
+void pushToPanel(bool layered) {
+  uint16_t* pixels = (uint16_t*)mainSprite.getPointer();
+  if (layered) {
+    addChangedPanels();
+    if (!dirtyWorthFullPush(dirtyRegion)) {
+      display->pushRegion(pixels, dirtyRegion);
+      metricsPush(dirtyPixels(dirtyRegion) * 2, dirtyRegion.count, true);
+      return;
+    }
+  }
+  display->pushFrame(pixels);
+  metricsPush((uint32_t)mainSprite.width() * mainSprite.height() * 2, 1, false);
+}
+
+// Function to measure the frame that just reached the panel: render time, and latency if it showed a new second
+void measureTickLatency() {
+  if (!pushedStartMicros) return;
+  uint32_t done = display->lastFrameDoneMicros();
+  if (done == 0 || (long)(done - pushedStartMicros) < 0) {
+    done = pushedReturnMicros;
+  }
+  if (inputMode() == INPUT_LIVE) {
+    tickLatencyFrame(tickLatency, done - pushedStartMicros);
+    if (pushedTick) {
+      tickLatencyShown(tickLatency, (int32_t)(done - tickBoundaryMicros));
+      metricsTickLatency(tickLatency.stats, tickLatencyLeadMicros(tickLatency));
+    }
+  }
+  pushedStartMicros = 0;
+  pushedTick = false;
+}
+
+// Function to pick the end-of-loop delay: 1 ms, or until the next timer deadline when the next
+// frame can start that late and still fit in the frame budget (e.g. one render lead before a second)
+unsigned long loopDelay() {
+  uint32_t deadline;
+  if (inputMode() != INPUT_LIVE || loopCount % qualityFrameInterval(renderLevel) != 0 ||
+      !timerWheelNextDeadline(timers, deadline)) {
+    return 1;
+  }
+  long untilDeadline = (long)(deadline - millis());
+  unsigned long spent = (micros() - loopStartMicros) / 1000;
+  if (untilDeadline > 1 && spent + untilDeadline <= METRICS_FRAME_BUDGET_US / 1000) {
+    return untilDeadline;
+  }
+  return 1;
+}
+
+// Function to format the wall-clock time (HH:MM:SS) of an earlier millis() reading
+void formatClockTime(uint32_t atMillis, char* text, size_t size) {
+  time_t at = lastSyncedTime + elapsedSeconds - (time_t)((millis() - atMillis) / 1000);
+  struct tm timeinfo;
+  localtime_r(&at, &timeinfo);
+  strftime(text, size, "%H:%M:%S", &timeinfo);
+}
+
+// Function to feed the quality controller the period of the frame just pushed (live input only)
+void updateQuality() {
+  unsigned long now = micros();
+  uint32_t period = now - lastShownMicros;
+  bool first = lastShownMicros == 0;
+  lastShownMicros = now;
+  if (first || !adaptiveQuality || inputMode() != INPUT_LIVE) return;
+
+  if (qualityFrame(quality, period, millis())) {
+    QualityTransition transition;
+    qualityTransition(quality, min(quality.transitions, (uint32_t)QUALITY_LOG_SIZE) - 1, transition);
+    char clock[9];
+    formatClockTime(transition.atMillis, clock, sizeof(clock));
+    Serial.printf("quality: %s -> %s at %s (uptime %u ms, %u%% over budget, %u%% with headroom)\n",
+                  qualityLevelName(transition.from), qualityLevelName(transition.to), clock,
+                  (unsigned)transition.atMillis, (unsigned)transition.overPercent, (unsigned)transition.headroomPercent);
+    metricsQuality(quality.level, quality.transitions);
+  }
+}
+
+
+/*************************************************************
+********************** CONSOLE COMMANDS **********************
+**************************************************************/
+
+// Function to print one line of "stats": the playback line, then the metrics summary
+bool consoleStatsLine(Print& out, uint32_t index) {
+  if (index == 0) {
+    out.printf("fps %.1f, animation slot %d (%d frames)\n", framesPerSecond, animationActiveSlot(), animationFrameCount());
+    return true;
+  }
+  return metricsPrintStatsLine(out, index - 1);
+}
+
+// Console "stats": frame timing, heap and connection summary (streamed over several loops)
+void consoleStats(int argc, char** argv) {
+  consoleStream(consoleStatsLine);
+}
+
+// Console "trace": per-stage timings of the recent frames (streamed over several loops)
+void consoleTrace(int argc, char** argv) {
+  consoleStream(metricsPrintTraceLine);
+}
+
+// Console "brightness <100-250>": set the backlight
+void consoleBrightness(int argc, char** argv) {
+  if (argc > 1) {
+    brightness = constrain(atoi(argv[1]), 100, 250); // same range as the buttons
+    analogWrite(TFT_BL, brightness);
+  }
+  Serial.printf("brightness %d\n", brightness);
+}
+
+// Console "ntp": force an NTP sync now
+void consoleNtp(int argc, char** argv) {
+  syncTime();
+  updateCurrentTime();
+  Serial.printf("time %s:%s:%s\n", currentHour, currentMinute, currentSecond);
+}
+
+// Console "anim <builtin|0|1>": switch animation slot
+void consoleAnimation(int argc, char** argv) {
+  if (argc > 1) {
+    int slot = strcmp(argv[1], "builtin") == 0 ? ANIM_SLOT_BUILTIN : atoi(argv[1]);
+    if (!animationSelect(slot)) {
+      Serial.println("slot not valid");
+    }
+  }
+  Serial.printf("animation slot %d (%d frames, %s)\n", animationActiveSlot(), animationFrameCount(),
+                animationFrameDurationMs(0) ? "timed" : "one frame per loop");
+  if (animationCompressed()) {
+    const FrameRingStats& decoder = animationDecoderStats();
+    Serial.printf("decoder: %u decoded (avg %u us), %u shown, %u underruns, %u discarded, %u errors, read-ahead %u\n",
+                  (unsigned)decoder.decoded, (unsigned)animationDecodeMicros(true), (unsigned)decoder.shown,
+                  (unsigned)decoder.underruns, (unsigned)decoder.discarded, (unsigned)decoder.decodeErrors,
+                  (unsigned)decoder.ahead);
+    const FrameCache& cache = animationFrameCache();
+    Serial.printf("cache: %u/%u frames, %u KB, %u%% hits (%u/%u), %u evictions, %u ms decode saved\n",
+                  (unsigned)(cache.stats.bytesHeld / (cache.frameBytes ? cache.frameBytes : 1)),
+                  (unsigned)cache.capacity, (unsigned)(cache.stats.bytesHeld / 1024),
+                  (unsigned)frameCacheHitPercent(cache), (unsigned)cache.stats.hits,
+                  (unsigned)(cache.stats.hits + cache.stats.misses), (unsigned)cache.stats.evictions,
+                  (unsigned)cache.stats.msSaved);
+  }
+}
+
+// Console "prefetch [on|off]": raw frame prefetch, for comparing blit stall time ("stats" blit stage)
+void consolePrefetch(int argc, char** argv) {
+  if (argc > 1) {
+    framePrefetchSetEnabled(strcmp(argv[1], "off") != 0);
+  }
+  const FramePrefetchStats& prefetch = framePrefetchStats();
+  Serial.printf("prefetch %s: %u hits, %u late (%u us waited), %u misses, last copy %u us\n",
+                framePrefetchEnabled() ? "on" : "off", (unsigned)prefetch.hits, (unsigned)prefetch.late,
+                (unsigned)prefetch.waitMicros, (unsigned)prefetch.misses, (unsigned)prefetch.copyMicros);
+}
+
+// Function to print one line of "quality": the current level, then the transition log
+bool consoleQualityLine(Print& out, uint32_t index) {
+  QualityTransition transition;
+  if (index == 0) {
+    out.printf("quality %s (%s), %u transitions\n", qualityLevelName(quality.level),
+               !adaptiveQuality ? "off" : quality.pinned ? "pinned" : "auto", (unsigned)quality.transitions);
+    return qualityTransition(quality, 0, transition);
+  }
+  if (!qualityTransition(quality, index - 1, transition)) {
+    return false;
+  }
+  char clock[9];
+  formatClockTime(transition.atMillis, clock, sizeof(clock));
+  out.printf("  %s (uptime %9u ms) %-16s -> %-16s", clock, (unsigned)transition.atMillis,
+             qualityLevelName(transition.from), qualityLevelName(transition.to));
+  if (transition.pinned) {
+    out.println(" pinned");
+  } else {
+    out.printf(" %u%% over budget, %u%% with headroom\n", (unsigned)transition.overPercent,
+               (unsigned)transition.headroomPercent);
+  }
+  return qualityTransition(quality, index, transition);
+}
+
+// Console "quality [auto|0-4|name]": pin a quality level or hand it back to the controller, then show the log
+void consoleQuality(int argc, char** argv) {
+  if (argc > 1) {
+    quality_level_t level = QUALITY_LEVEL_COUNT; // auto
+    if (isdigit((unsigned char)argv[1][0])) {
+      level = (quality_level_t)constrain(atoi(argv[1]), 0, QUALITY_LEVEL_COUNT - 1);
+    } else {
+      for (uint8_t i = 0; i < QUALITY_LEVEL_COUNT; i++) {
+        if (strcmp(argv[1], qualityLevelName((quality_level_t)i)) == 0) level = (quality_level_t)i;
+      }
+      if (level == QUALITY_LEVEL_COUNT && strcmp(argv[1], "auto") != 0) {
+        Serial.println("level not valid");
+        return;
+      }
+    }
+    qualityPin(quality, level, millis());
+    metricsQuality(quality.level, quality.transitions);
+    forceRedraw = true;
+  }
+  consoleStream(consoleQualityLine);
+}
+
+// Console "mem": arena use per tier and owner
+void consoleMemory(int argc, char** argv) {
+  consoleStream(memArenaPrintReportLine);
+}
+
+// Console "hud": toggle the frame time readout
+void consoleHud(int argc, char** argv) {
+  hudEnabled = !hudEnabled;
+  forceRedraw = true; // repaint the panels the HUD area overlapped
+  Serial.println(hudEnabled ? "hud on" : "hud off");
+}
+
+// Console "layers [on|off]": layered playback of the built-in animation (compare "stats" blit and push lines)
+void consoleLayers(int argc, char** argv) {
+  if (argc > 1) {
+    layeredPlayback = strcmp(argv[1], "off") != 0;
+  }
+  if (!layersReady) {
+    Serial.println("layers unavailable (no cat cut out of the built-in frames)");
+    return;
+  }
+  Serial.printf("layers %s (%s), cat every %u ms, scenery %u px/s, %u cat spans\n", layeredPlayback ? "on" : "off",
+                layeredShown ? "showing" : "needs the built-in animation above half-res quality",
+                (unsigned)NYAN_ART_FRAME_MS, (unsigned)NYAN_SCROLL_PX_PER_S, (unsigned)nyanLayersSpanCount(nyanLayers));
+}
+
+// Console "rec <start|stop|replay|status>": input record/replay
+void consoleRecord(int argc, char** argv) {
+  const char* action = argc > 1 ? argv[1] : "status";
+  if (strcmp(action, "start") == 0) {
+    recordRequested = true;
+  } else if (strcmp(action, "stop") == 0) {
+    inputRecordStop();
+  } else if (strcmp(action, "replay") == 0) {
+    replayRequested = true;
+  } else if (strcmp(action, "status") != 0) {
+    Serial.println("usage: rec <start|stop|replay|status>");
+    return;
+  }
+  inputPrintStatus(Serial);
+}
+
+// Function to register the console commands
+void registerConsoleCommands() {
+  consoleRegister("stats", "frame timing, heap and connection summary", consoleStats);
+  consoleRegister("trace", "per-stage timings of the last frames", consoleTrace);
+  consoleRegister("brightness", "<100-250> set backlight", consoleBrightness);
+  consoleRegister("ntp", "force an NTP sync", consoleNtp);
+  consoleRegister("anim", "<builtin|0|1> switch animation", consoleAnimation);
+  consoleRegister("prefetch", "[on|off] raw frame prefetch into SRAM", consolePrefetch);
+  consoleRegister("quality", "[auto|0-4|name] adaptive quality level and transitions", consoleQuality);
+  consoleRegister("mem", "memory arenas: bytes per tier and owner", consoleMemory);
+  consoleRegister("hud", "toggle frame time overlay", consoleHud);
+  consoleRegister("layers", "[on|off] layered playback: scenery per frame, cat at the art rate, dirty-rect pushes", consoleLayers);
+  consoleRegister("rec", "<start|stop|replay|status> input record/replay", consoleRecord);
+}
+
 
 /*************************************************************
 *********************** MAIN FUNCTIONS ***********************
@@ -382,6 +1187,25 @@ void adjustBrightness() {
 
 // SETUP FUNCTION - runs once at startup
 void setup(void) {
+  Serial.begin(115200);
+
+  // Reserve the memory arenas before anything else allocates
+  memArenaBegin(arenaDmaBytes, arenaInternalBytes, arenaPsramBytes);
+
+#ifdef CACHE_PROFILING
+  // Stall counters on the loop() core (setup and loop run on the same core)
+  cacheProfileBegin();
+#endif
+
+  // Helper on the other core for banded blits and composites
+  bandPoolBegin(compositeThreads, bandSchedule);
+
+#ifdef BENCHMARK_KERNELS
+  // Report pixel kernel and band throughput before anything else uses the heap
+  benchmarkPixelKernels();
+  benchmarkBandPool();
+#endif
+
   // Initialize button pins with internal pull-up resistors
   pinMode(BootButton, INPUT_PULLUP);
   pinMode(KeyButton, INPUT_PULLUP);
@@ -403,14 +1227,18 @@ void setup(void) {
   // Display initial connection message
   lcd.print("Connecting to WiFi - please wait");
   
+  // Timers for the periodic work and timeouts (WiFi uses them from here on)
+  timersBegin();
+
   // Initialize WiFi connection
-  wifiState = WIFI_STATE_DISCONNECTED; // will transition to CONNECTING in first update
+  setWiFiState(WIFI_STATE_DISCONNECTED); // will transition to CONNECTING in first update
   startWiFi();
   
   // Wait for initial connection with timeout
   unsigned long connectionStartTime = millis();
   while (wifiState != WIFI_STATE_CONNECTED) {
-    updateWiFiStatus(); // WiFi state machine
+    processWiFiEvents();
+    timerWheelAdvance(timers, inputMillis()); // WiFi timeouts
     
     if (millis() - connectionStartTime > WIFI_CONNECT_TIMEOUT * 2) {
       if (wifiState == WIFI_STATE_FAILED) {
@@ -463,65 +1291,109 @@ void setup(void) {
     }
   }
 
-  // Force initial NTP sync and set tracking variables
-  updateCurrentTime(true);
-  lastMillis = millis();
+  // Force initial NTP sync (also aligns the seconds to the NTP phase and arms the NTP and second timers)
+  syncTime();
+  updateCurrentTime();
   
   // Display sync success
   lcd.println("Time synced!\n\nStarting NyanCat clock...");
   delay(3000);
   
+  // Select the animation (built-in, or the last uploaded one if it verifies)
+  animationSetCacheBudget(frameCacheBudgetPsram);
+  animationBegin();
+#ifdef BENCHMARK_KERNELS
+  benchmarkFramePrefetch();
+#endif
+
   // Initialize sprites for main display
   lcd.fillScreen(TFT_BLACK);
   
   // Create main sprite (drawing surface)
-  mainSprite.createSprite(320, 170);
+  mainSprite.createArenaSprite(320, 170, "main sprite",
+                               displayBackendKind == DISPLAY_BACKEND_I80_DMA ? MEM_TIER_DMA : MEM_TIER_INTERNAL);
   mainSprite.setSwapBytes(true);      // swap colour rendering for images
-  mainSprite.setTextDatum(4);         // center alignment
-  mainSprite.setTextColor(TFT_WHITE);
   
   // Create calendar header sprite
-  calendarSprite.createSprite(218, 26);
-  calendarSprite.setTextColor(TFT_WHITE);
+  calendarSprite.createArenaSprite(218, 26, "overlay sprites", MEM_TIER_INTERNAL);
   
   // Create sprites for the right panels
-  secondsSprite.createSprite(80, 40);
-  infoSprite.createSprite(100, 64);
-  fpsSprite.createSprite(70, 20);
+  secondsSprite.createArenaSprite(80, 40, "overlay sprites", MEM_TIER_INTERNAL);
+  infoSprite.createArenaSprite(100, 64, "overlay sprites", MEM_TIER_INTERNAL);
+  fpsSprite.createArenaSprite(70, 20, "overlay sprites", MEM_TIER_INTERNAL);
   
-  // Configure text settings for info sprites
-  secondsSprite.setTextColor(TFT_WHITE);
-  secondsSprite.setFreeFont(&Orbitron_Light_32); // orbitron font size 32
+  // Register the sprites with the display list (text settings are set per panel there)
+  calendarTarget = dlRegisterTarget(calendarSprite);
+  infoTarget = dlRegisterTarget(infoSprite);
+  secondsTarget = dlRegisterTarget(secondsSprite);
+  fpsTarget = dlRegisterTarget(fpsSprite);
+  mainTarget = dlRegisterTarget(mainSprite);
+  overlayPlacements[0] = { calendarTarget, clockXPosition - 224, clockYPosition, calendarSprite.width(), calendarSprite.height() };
+  overlayPlacements[1] = { secondsTarget, clockXPosition + 4, clockYPosition + 22, secondsSprite.width(), secondsSprite.height() };
+  overlayPlacements[2] = { infoTarget, clockXPosition, clockYPosition + 70 + 16 + 6, infoSprite.width(), infoSprite.height() };
+  overlayPlacements[3] = { fpsTarget, 5, 145, fpsSprite.width(), fpsSprite.height() };
 
-  infoSprite.setTextDatum(4); // center alignment
-  infoSprite.setTextColor(TFT_WHITE);
-  infoSprite.setFreeFont(&Orbitron_Light_24); // orbitron font size 24
-  
-  fpsSprite.setTextDatum(4); // center alignment
-  fpsSprite.setTextFont(1);  // use default font
-  fpsSprite.setTextSize(1);  // smallest size
-  fpsSprite.setTextColor(TFT_WHITE);
+  // Scenery and cat layers of the built-in animation
+  layersBegin();
+#ifdef BENCHMARK_KERNELS
+  benchmarkLayers(nyanLayers);
+#endif
   
   // Get initial time and cache strings
   updateCurrentTime();
-  lastSecond = String(currentSecond);
   
   // Clear any existing display artifacts
   lcd.fillScreen(TFT_BLACK);
   mainSprite.fillSprite(TFT_BLACK);
   
-  // Draw static elements immediately
-  drawStaticElements();
+  // Draw the panels immediately
+  drawClockOverlay();
   
-  // Push initial state to display
-  mainSprite.pushSprite(0, 0);
+  // Take over the panel (TFT_eSPI can't draw on it directly after this) and push initial state
+  display = lcdBackendBegin(displayBackendKind, lcd, mainSprite);
+  display->pushFrame((uint16_t*)mainSprite.getPointer());
+
+  // Frame prefetch (staging buffer from the internal arena)
+  animationSetPrefetch(framePrefetch);
+
+  // Start the HTTP endpoints (served from loop() between frames)
+  framebufferStreamBegin((uint16_t*)mainSprite.getPointer(), mainSprite.width(), mainSprite.height());
+  screenshotBegin((uint16_t*)mainSprite.getPointer(), mainSprite.width(), mainSprite.height());
+  metricsBegin();
+  qualityInit(quality, METRICS_FRAME_BUDGET_US);
+  tickLatencyInit(tickLatency);
+  animationUploadBegin();
+  inputLogBegin();
+  webServerBegin();
+
+  // Listen for remote-display frames when enabled
+  if (remoteDisplayMode) {
+    remoteDisplayBegin();
+  }
+
+  // Join the animation timeline shared between clocks (no-op when off)
+  frameSyncBegin(syncMode, syncFramePeriodUs, animationFrameCount());
+
+  // Serial diagnostics (type "help" at 115200 baud)
+  registerConsoleCommands();
+
+  // Where the large buffers ended up (streamed by the console from the first loops on)
+  consoleStream(memArenaPrintReportLine);
 }
 
 
 // MAIN LOOP - runs continuously
-void loop() {
+HOT_CODE void loop() {
   static bool firstLoop = true;
-  frameStartTime = millis(); // record frame start time for FPS calculation
+  metricsFrameBegin();
+  loopStartMicros = micros();
+  startRequestedInputLog(); // recording/replay begins on a frame boundary
+  frameStartTime = inputMillis(); // record frame start time for FPS calculation
+
+  // Quality level of this frame (full while recording/replaying, so those frames compare)
+  renderLevel = adaptiveQuality && inputMode() == INPUT_LIVE ? quality.level : QUALITY_FULL;
+  bool renderThisLoop = loopCount++ % qualityFrameInterval(renderLevel) == 0;
+  bool layered = renderThisLoop && layeredFrame();
 
   // Force update on first loop iteration
   if (firstLoop) {
@@ -533,137 +1405,126 @@ void loop() {
   // Check for brightness adjustments
   adjustBrightness();
 
-  // Check the WiFi connection state
-  updateWiFiStatus();
+  // Handle WiFi events
+  processWiFiEvents();
 
-  // Update time tracking every second
-  unsigned long currentMillis = millis();
-  if (currentMillis - lastMillis >= 1000) {
-    elapsedSeconds++;
-    lastMillis = currentMillis;
-    updateCurrentTime(); // will only sync with NTP when needed
+  // A new animation (upload or console) starts from its first frame, on its own timeline if it is timed
+  unsigned long currentMillis = inputMillis();
+  if (animationGeneration() != animationShown) {
+    startAnimationTimeline(currentMillis);
   }
-  
-  /* 
-  Draw current animation frame at position (0,0)
-  - This is the only element that needs to be redrawn every frame
-  */
-  mainSprite.pushImage(0, 0, aniWidth, aniHeigth, nyancat[animationFrame]);
 
-  // Draw all static elements (only once, unless forced)
-  if (!staticElementsDrawn || forceRedraw) {
-    drawStaticElements();
-    forceRedraw = false;
+  // Run the timers due by now (second, FPS, NTP sync, WiFi checks and timeouts, timed animation frames)
+  timerWheelAdvance(timers, currentMillis);
+
+  // Count the seconds on the aligned boundaries; a frame starting within the lead of the next one shows it
+  // (HALF_RATE: only loops that render, so the tick isn't lost on a skipped one)
+  secondTicked = false;
+  if (secondDue && renderThisLoop) {
+    while ((long)(currentMillis + secondsLeadMillis() - lastMillis) >= 1000) {
+      elapsedSeconds++;
+      lastMillis += 1000; // stays on the boundary however late this loop is
+      secondTicked = true;
+    }
+    secondDue = false;
+    armSecondTimer(); // also when the lead has shrunk since it was armed and the second isn't due yet
+  }
+  if (secondTicked) {
+    tickBoundaryMicros = micros() + (long)(lastMillis - currentMillis) * 1000;
+    updateCurrentTime();
   }
 
-  /* 
-  Clock display rendering:
-  - Purple text on white background
-  - Two rounded rectangles: one for time, one for date
-  */
-  mainSprite.setTextColor(PURPLE_COLOUR, TFT_WHITE);
-  mainSprite.fillRoundRect(clockXPosition, clockYPosition, 80, 26, 3, TFT_WHITE);      // time display background (top rectangle)
-  mainSprite.fillRoundRect(clockXPosition, clockYPosition + 70, 80, 16, 3, TFT_WHITE); // date display background
-  
-  /* 
-  Time display: "HH:MM" (24-hour format)
-  - Uses cached time string for efficiency
-  */
-  mainSprite.drawString(
-    cachedTimeString,
-    clockXPosition+40, // centered horizontally
-    clockYPosition+13, // vertical position in top rectangle
-    4 // font size 4
-  );
-  
-  /* 
-  Date format: "DD Mon 'YY" (e.g., "15 Jul '23")
-  - Uses cached date string for efficiency
-  */
-  mainSprite.drawString(
-    cachedDateString, 
-    clockXPosition+40, // centered horizontally in 80px wide rectangle
-    clockYPosition+78, // vertical position in bottom rectangle
-    2 // font size 2
-  );
-  
-  /* 
-  Seconds display (rendered separately for smoother updates)
-  - Only redrawn when the second value actually changes
-  */
-  if (lastSecond != String(currentSecond) || forceRedraw) {
-    secondsSprite.fillSprite(TFT_BLACK);
-    secondsSprite.setFreeFont(&Orbitron_Light_32);
-    secondsSprite.drawString(String(currentSecond), 9, 6);
-    lastSecond = String(currentSecond);
+  // Collect packets from the remote-display host
+  if (remoteDisplayMode) {
+    remoteDisplayPoll();
   }
-  
-  /* 
-  Weekday display (right panel):
-  - Only update when weekday changes
-  */
-  String currentWeekday = weekdayString.substring(0, 3); // get first 3 letters of weekday
-  currentWeekday.toUpperCase(); // convert to uppercase (MON, TUE, etc.)
+  metricsStageEnd(STAGE_INPUT);
 
-  if (lastWeekday != currentWeekday || forceRedraw) {
-      // Update right panel with weekday
-      infoSprite.fillRect(0, 0, 80, 34, TFT_BLACK); // clear only weekday area
-      infoSprite.setFreeFont(&Orbitron_Light_24);   // set larger font
-      infoSprite.drawRoundRect(0, 0, 80, 34, 3, TFT_WHITE);
-      infoSprite.drawString(currentWeekday, 38, 14); // centered (was 40, 14)
-      lastWeekday = currentWeekday;
+  // The previous frame may still be on its way to the panel: wait before overwriting mainSprite
+  display->waitIdle();
+  measureTickLatency();
+  metricsStageEnd(STAGE_PUSH_WAIT);
+  if (remoteDisplayMode) {
+    remoteDisplayShown(); // ack the frame now that it reached the panel
   }
   
   /* 
-  FPS counter (bottom left):
-  - Only update when FPS value changes
+  Draw current animation frame at position (0,0)
+  - This is the only element that needs to be redrawn every frame
+  - Copied straight into the sprite buffer with the byte swap pushImage would do
+  - In remote-display mode the host's latest frame is decoded here instead
+  - Layered playback repaints only what changed in the scenery and cat layers
   */
-  String currentFPS = String((int)framesPerSecond);
-  if (lastFPSString != currentFPS || forceRedraw) {
-      // Update bottom-left FPS counter
-      fpsSprite.fillSprite(TFT_BLACK);
-      fpsSprite.setTextFont(1);
-      fpsSprite.setTextSize(1);
-      fpsSprite.drawRoundRect(0, 0, 50, 20, 3, TFT_WHITE);
-      fpsSprite.drawString("FPS", 32, 10, 1);
-      fpsSprite.drawString(currentFPS, 15, 10, 1);
-      lastFPSString = currentFPS;
+  if (!renderThisLoop) {
+    // HALF_RATE: nothing to draw on this loop
+  } else if (layered) {
+    drawLayers(currentMillis, forceRedraw || !layeredShown);
+  } else if (remoteDisplayMode) {
+    remoteDisplayRender((uint16_t*)mainSprite.getPointer(), mainSprite.width(), mainSprite.height(), remoteOverlay);
+  } else if (renderLevel == QUALITY_CLOCK_ONLY) {
+    pixelFill((uint16_t*)mainSprite.getPointer(), TFT_BLACK, mainSprite.width() * mainSprite.height());
+  } else {
+    const uint16_t* frame = animationFrameData(animationFrame); // compressed: already decoded on the other core
+    if (frame) {
+      bandPoolRun(mainSprite.height(), BAND_ROWS,
+                  renderLevel >= QUALITY_HALF_RES ? blitAnimationBandHalf : blitAnimationBand, (void*)frame);
+    }
+    animationPrefetch(nextAnimationFrame()); // copied while this frame is composed
   }
+  metricsStageEnd(STAGE_BLIT);
 
-  /* 
-  Combine all sprites onto main display:
-  - calendarSprite: Top-left position
-  - secondsSprite: Below main time display
-  - infoSprite: Bottom-right position
-  - fpsSprite: Bottom-left position
-  */
-  calendarSprite.pushToSprite(&mainSprite, clockXPosition-224, clockYPosition, TFT_BLACK);
-  secondsSprite.pushToSprite(&mainSprite, clockXPosition+4, clockYPosition+22, TFT_BLACK);
-  infoSprite.pushToSprite(&mainSprite, clockXPosition, clockYPosition+70+16+6, TFT_BLACK);
-  fpsSprite.pushToSprite(&mainSprite, 5, 145, TFT_BLACK);
-  
-  // Final render of complete display to screen
-  mainSprite.pushSprite(0, 0);
+  // Clock panels and overlay sprites (optional on top of remote content)
+  if (renderThisLoop && (!remoteDisplayMode || remoteOverlay)) {
+    drawClockOverlay();
+  }
   
-  // Update time from NTP server once per second
-  if (millis() - lastTimeUpdate >= 1000) {
-    updateCurrentTime(); // will only sync as per ntpSyncInterval value
-    lastTimeUpdate = millis();
+  // Final render of the display to screen, whole or the dirty rects (returns early with the DMA backend)
+  if (renderThisLoop) {
+    pushToPanel(layered);
+    layeredShown = layered;
+    pushedStartMicros = loopStartMicros;
+    pushedReturnMicros = micros();
+    pushedTick = secondTicked;
   }
+  metricsStageEnd(STAGE_PUSH);
+
+  // Serve HTTP clients while the composed frame is stable (time-bounded)
+  webServerPoll();
+  metricsStageEnd(STAGE_NETWORK);
+
+  // Serial console (time-bounded, streams long responses across frames)
+  consolePoll();
+  metricsStageEnd(STAGE_CONSOLE);
   
-  // Calculate and display FPS once per second
-  frameCount++;
-  if (millis() - lastFPSCalculation >= fpsInterval) {
-    framesPerSecond = (double)frameCount * 1000 / (millis() - lastFPSCalculation);
-    frameCount = 0;
-    lastFPSCalculation = millis();
+  // Feed the quality controller the time between displayed frames
+  if (renderThisLoop) {
+    updateQuality();
+  }
+
+  // Count frames for the FPS readout (fpsTimer)
+  if (renderThisLoop) {
+    frameCount++;
   }
   
   // Advance to the next animation frame (loops back to 0 when reaching the end)
-  animationFrame++;
-  if (animationFrame == framesNumber) {
-    animationFrame = 0;
+  // - in sync mode the frame comes from the shared timeline instead
+  // - timed animations are stepped by animationTimer
+  frameSyncPoll();
+  int syncedFrame = frameSyncCurrentFrame();
+  if (syncedFrame >= 0) {
+    animationFrame = syncedFrame % animationFrameCount();
+  } else if (renderThisLoop && animationFrameDurationMs(animationFrame) == 0) {
+    animationFrame++;
+    if (animationFrame >= animationFrameCount()) { // >= as an upload may switch to a shorter animation
+      animationFrame = 0;
+    }
   }
 
-  delay(1); // small delay to reduce CPU usage
+  metricsFrameEnd();
+
+  // Recording/replay: log or check what this frame showed (outside the timed part)
+  if (inputMode() != INPUT_LIVE) {
+    inputFrameEnd(frameHash(), metricsLastFrameMicros());
+  }
+  delay(loopDelay()); // small delay to reduce CPU usage, longer to start the next frame on a timer deadline
 }
@@ -0,0 +1,135 @@
+/*************************************************************
+************************* MEMORY ARENAS **********************
+**************************************************************/
+
+#include <esp_heap_caps.h>
+#include "mem_arena.h"
+
+static const char* tierNames[MEM_TIER_COUNT] = { "dma", "internal", "psram" };
+
+// heap_caps for each tier's reservation
+static const uint32_t tierCaps[MEM_TIER_COUNT] = {
+  MALLOC_CAP_DMA | MALLOC_CAP_INTERNAL,
+  MALLOC_CAP_INTERNAL | MALLOC_CAP_8BIT,
+  MALLOC_CAP_SPIRAM | MALLOC_CAP_8BIT
+};
+
+// Where a tier's requests go when it is full (GDMA can also read 64-byte aligned PSRAM)
+static const mem_tier_t tierFallback[MEM_TIER_COUNT] = { MEM_TIER_PSRAM, MEM_TIER_PSRAM, MEM_TIER_INTERNAL };
+
+struct Arena {
+  uint8_t* base;
+  size_t size;
+  size_t used;
+};
+
+struct OwnerUse {
+  const char* owner;
+  mem_tier_t tier;
+  size_t bytes;
+  uint16_t pieces;
+};
+
+static Arena arenas[MEM_TIER_COUNT];
+static OwnerUse owners[MEM_ARENA_MAX_OWNERS];
+static uint8_t ownerCount = 0;
+static size_t failedBytes = 0;
+
+// Function to reserve one tier, settling for the largest free block if the full size isn't there
+static void reserve(mem_tier_t tier, size_t bytes) {
+  Arena& arena = arenas[tier];
+  arena.used = 0;
+  arena.size = 0;
+  if (bytes == 0) return;
+  size_t largest = heap_caps_get_largest_free_block(tierCaps[tier]);
+  if (bytes > largest) bytes = largest & ~(MEM_ARENA_ALIGN - 1);
+  arena.base = bytes ? (uint8_t*)heap_caps_aligned_alloc(MEM_ARENA_ALIGN, bytes, tierCaps[tier]) : nullptr;
+  if (arena.base) arena.size = bytes;
+}
+
+// Function to add a piece to its owner's line in the report
+static void record(const char* owner, mem_tier_t tier, size_t bytes) {
+  for (uint8_t i = 0; i < ownerCount; i++) {
+    if (owners[i].tier == tier && strcmp(owners[i].owner, owner) == 0) {
+      owners[i].bytes += bytes;
+      owners[i].pieces++;
+      return;
+    }
+  }
+  if (ownerCount < MEM_ARENA_MAX_OWNERS) {
+    owners[ownerCount++] = { owner, tier, bytes, 1 };
+  }
+}
+
+void memArenaBegin(size_t dmaBytes, size_t internalBytes, size_t psramBytes) {
+  reserve(MEM_TIER_DMA, dmaBytes);
+  reserve(MEM_TIER_INTERNAL, internalBytes);
+  reserve(MEM_TIER_PSRAM, psramFound() ? psramBytes : 0);
+}
+
+void* memArenaAlloc(const char* owner, size_t bytes, mem_tier_t tier) {
+  size_t rounded = (bytes + MEM_ARENA_ALIGN - 1) & ~(MEM_ARENA_ALIGN - 1);
+  mem_tier_t candidate = tier;
+  for (uint8_t attempt = 0; attempt < 2; attempt++) {
+    Arena& arena = arenas[candidate];
+    if (arena.base && arena.size - arena.used >= rounded) {
+      uint8_t* piece = arena.base + arena.used;
+      arena.used += rounded;
+      record(owner, candidate, rounded);
+      memset(piece, 0, bytes);
+      return piece;
+    }
+    candidate = tierFallback[candidate];
+  }
+  failedBytes += rounded;
+  Serial.printf("arena: no room for %s (%u bytes)\n", owner, (unsigned)bytes);
+  return nullptr;
+}
+
+size_t memArenaFree(mem_tier_t tier) {
+  const Arena& arena = arenas[tier];
+  return arena.base ? arena.size - arena.used : 0;
+}
+
+mem_tier_t memArenaTierOf(const void* pointer) {
+  const uint8_t* address = (const uint8_t*)pointer;
+  for (uint8_t tier = 0; tier < MEM_TIER_COUNT; tier++) {
+    const Arena& arena = arenas[tier];
+    if (arena.base && address >= arena.base && address < arena.base + arena.size) {
+      return (mem_tier_t)tier;
+    }
+  }
+  return MEM_TIER_COUNT;
+}
+
+const char* memTierName(mem_tier_t tier) {
+  return tier < MEM_TIER_COUNT ? tierNames[tier] : "heap";
+}
+
+bool memArenaPrintReportLine(Print& out, uint32_t index) {
+  if (index == 0) {
+    out.println("memory arenas (bytes):");
+    return true;
+  }
+  index--;
+  if (index < MEM_TIER_COUNT) {
+    const Arena& arena = arenas[index];
+    out.printf("  %-8s %8u used of %8u reserved\n", tierNames[index], (unsigned)arena.used, (unsigned)arena.size);
+    return true;
+  }
+  index -= MEM_TIER_COUNT;
+  if (index < ownerCount) {
+    const OwnerUse& use = owners[index];
+    out.printf("  %-16s %-8s %8u (%u piece%s)\n", use.owner, tierNames[use.tier], (unsigned)use.bytes,
+               (unsigned)use.pieces, use.pieces == 1 ? "" : "s");
+    return true;
+  }
+  index -= ownerCount;
+  if (index == 0 && failedBytes) {
+    out.printf("  not placed: %u bytes\n", (unsigned)failedBytes);
+    return true;
+  }
+  out.printf("heap left: internal %u, psram %u\n", (unsigned)heap_caps_get_free_size(MALLOC_CAP_INTERNAL),
+             (unsigned)heap_caps_get_free_size(MALLOC_CAP_SPIRAM));
+  return false;
+}
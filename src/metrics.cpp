@@ -0,0 +1,485 @@
+/*************************************************************
+************************** METRICS ***************************
+**************************************************************/
+
+#include <Arduino.h>
+#include <stdarg.h>
+#include "metrics.h"
+#include "web_server.h"
+#include "animation.h"
+#include "frame_prefetch.h"
+#include "cache_profile.h"
+
+// Histogram bucket upper bounds in microseconds
+static const uint32_t histogramBounds[METRICS_HISTOGRAM_BUCKETS] = {
+  2500, 5000, 10000, 16667, 20000, 33333, 50000, 100000, 250000, 1000000
+};
+
+static const char* stageNames[STAGE_COUNT] = {
+  "input", "push_wait", "blit", "draw", "composite", "push", "network", "console"
+};
+
+// Frame timing counters
+static uint32_t frameStart = 0, stageMark = 0, lastFrameMicros = 0;
+static uint64_t frameMicrosTotal = 0;
+static uint32_t frameCountTotal = 0, droppedFrames = 0;
+static uint32_t histogramCounts[METRICS_HISTOGRAM_BUCKETS + 1]; // last bucket is +Inf
+static uint64_t stageMicrosTotal[STAGE_COUNT];
+static uint32_t stageMicrosLast[STAGE_COUNT];
+
+#ifdef CACHE_PROFILING
+// Stall cycles of the loop() core per stage (instruction / data side)
+static CacheCounters profileMark;
+static uint64_t stageIStallTotal[STAGE_COUNT], stageDStallTotal[STAGE_COUNT];
+static uint32_t stageIStallLast[STAGE_COUNT], stageDStallLast[STAGE_COUNT];
+#endif
+
+// Ring of recent frames for the console trace
+struct FrameTrace {
+  uint32_t startMillis;
+  uint32_t totalMicros;
+  uint32_t stageMicros[STAGE_COUNT];
+};
+static FrameTrace trace[METRICS_TRACE_FRAMES];
+static uint8_t traceNext = 0;
+
+// Network and time counters
+static uint32_t wifiTransitions[WIFI_STATE_COUNT]; // transitions into each state
+static wifi_state_t wifiCurrent = WIFI_STATE_DISCONNECTED;
+static uint32_t reconnectAttempts = 0;
+static uint32_t ntpSyncs = 0;
+static int32_t ntpOffsetMillis = 0;
+static unsigned long ntpLastSync = 0;
+
+// Display list command counts (before / after elision)
+static uint64_t drawRecordedTotal = 0, drawExecutedTotal = 0;
+static uint16_t drawRecordedLast = 0, drawExecutedLast = 0;
+
+// Bytes sent to the panel (full frames, or the dirty rects of layered playback)
+static uint64_t pushBytesTotal = 0;
+static uint32_t pushBytesLast = 0, pushFramesTotal = 0, pushRegionFrames = 0;
+static uint8_t pushRectsLast = 0;
+
+// Adaptive quality (quality.h)
+static uint8_t qualityLevel = 0;
+static uint32_t qualityTransitions = 0;
+
+// Seconds tick-to-photon latency (tick_latency.h)
+static TickLatencyStats tickStats;
+static uint32_t tickLeadMicros = 0;
+
+void metricsFrameBegin() {
+  frameStart = micros();
+  stageMark = frameStart;
+#ifdef CACHE_PROFILING
+  cacheProfileRead(profileMark);
+#endif
+}
+
+void metricsStageEnd(render_stage_t stage) {
+  uint32_t now = micros();
+  uint32_t elapsed = now - stageMark;
+  stageMark = now;
+  stageMicrosLast[stage] = elapsed;
+  stageMicrosTotal[stage] += elapsed;
+#ifdef CACHE_PROFILING
+  CacheCounters counters;
+  cacheProfileRead(counters);
+  stageIStallLast[stage] = counters.instructionStalls - profileMark.instructionStalls;
+  stageDStallLast[stage] = counters.dataStalls - profileMark.dataStalls;
+  stageIStallTotal[stage] += stageIStallLast[stage];
+  stageDStallTotal[stage] += stageDStallLast[stage];
+  profileMark = counters;
+#endif
+}
+
+void metricsFrameEnd() {
+  uint32_t elapsed = micros() - frameStart;
+  lastFrameMicros = elapsed;
+  frameMicrosTotal += elapsed;
+  frameCountTotal++;
+  if (elapsed > METRICS_FRAME_BUDGET_US) {
+    droppedFrames++;
+  }
+
+  uint8_t bucket = 0;
+  while (bucket < METRICS_HISTOGRAM_BUCKETS && elapsed > histogramBounds[bucket]) {
+    bucket++;
+  }
+  histogramCounts[bucket]++;
+
+  FrameTrace& entry = trace[traceNext];
+  entry.startMillis = millis() - elapsed / 1000;
+  entry.totalMicros = elapsed;
+  memcpy(entry.stageMicros, stageMicrosLast, sizeof(entry.stageMicros));
+  traceNext = (traceNext + 1) % METRICS_TRACE_FRAMES;
+}
+
+void metricsWiFiTransition(wifi_state_t from, wifi_state_t to) {
+  if (from == to) return;
+  wifiTransitions[to]++;
+  wifiCurrent = to;
+}
+
+void metricsReconnectAttempt() {
+  reconnectAttempts++;
+}
+
+void metricsNtpSync(int32_t offsetMillis) {
+  ntpSyncs++;
+  ntpOffsetMillis = offsetMillis;
+  ntpLastSync = millis();
+}
+
+void metricsDisplayList(uint16_t recorded, uint16_t executed) {
+  drawRecordedLast = recorded;
+  drawExecutedLast = executed;
+  drawRecordedTotal += recorded;
+  drawExecutedTotal += executed;
+}
+
+void metricsQuality(uint8_t level, uint32_t transitions) {
+  qualityLevel = level;
+  qualityTransitions = transitions;
+}
+
+void metricsTickLatency(const TickLatencyStats& stats, uint32_t leadMicros) {
+  tickStats = stats;
+  tickLeadMicros = leadMicros;
+}
+
+void metricsPush(uint32_t bytes, uint8_t rects, bool region) {
+  pushBytesTotal += bytes;
+  pushBytesLast = bytes;
+  pushRectsLast = rects;
+  pushFramesTotal++;
+  if (region) pushRegionFrames++;
+}
+
+uint32_t metricsLastFrameMicros() {
+  return lastFrameMicros;
+}
+
+
+/*************************************************************
+********************* PROMETHEUS EXPORT **********************
+**************************************************************/
+
+// Response buffer (preallocated, reused for every scrape)
+static char metricsBuffer[9728];
+static size_t metricsLength = 0;
+static size_t metricsNeeded = 0;    // bytes the full response needs (more than the buffer: truncated)
+static WebConnection* scraper = nullptr; // connection metricsBuffer is being sent to
+
+// Function to append formatted text; what doesn't fit is counted in metricsNeeded, not written
+static void append(const char* format, ...) {
+  size_t room = sizeof(metricsBuffer) - metricsLength;
+  va_list args;
+  va_start(args, format);
+  int written = vsnprintf(metricsBuffer + metricsLength, room, format, args);
+  va_end(args);
+  if (written <= 0) return;
+  metricsNeeded += written;
+  if ((size_t)written < room) {
+    metricsLength += written;
+  } else {
+    metricsLength = sizeof(metricsBuffer) - 1; // cut short: later lines only add to metricsNeeded
+  }
+}
+
+// Function to format all metrics into metricsBuffer
+static void formatMetrics() {
+  metricsLength = 0;
+  metricsNeeded = 0;
+
+  // Frame time histogram (cumulative buckets, seconds)
+  append("# TYPE nyan_frame_seconds histogram\n");
+  uint32_t cumulative = 0;
+  for (uint8_t i = 0; i < METRICS_HISTOGRAM_BUCKETS; i++) {
+    cumulative += histogramCounts[i];
+    append("nyan_frame_seconds_bucket{le=\"%.4f\"} %u\n", histogramBounds[i] / 1e6, (unsigned)cumulative);
+  }
+  cumulative += histogramCounts[METRICS_HISTOGRAM_BUCKETS];
+  append("nyan_frame_seconds_bucket{le=\"+Inf\"} %u\n", (unsigned)cumulative);
+  append("nyan_frame_seconds_sum %.6f\n", frameMicrosTotal / 1e6);
+  append("nyan_frame_seconds_count %u\n", (unsigned)frameCountTotal);
+
+  append("# TYPE nyan_frames_dropped_total counter\n");
+  append("nyan_frames_dropped_total %u\n", (unsigned)droppedFrames);
+
+  // Per-stage timings
+  append("# TYPE nyan_stage_seconds_total counter\n");
+  for (uint8_t i = 0; i < STAGE_COUNT; i++) {
+    append("nyan_stage_seconds_total{stage=\"%s\"} %.6f\n", stageNames[i], stageMicrosTotal[i] / 1e6);
+  }
+  append("# TYPE nyan_stage_last_seconds gauge\n");
+  for (uint8_t i = 0; i < STAGE_COUNT; i++) {
+    append("nyan_stage_last_seconds{stage=\"%s\"} %.6f\n", stageNames[i], stageMicrosLast[i] / 1e6);
+  }
+
+#ifdef CACHE_PROFILING
+  // Stall cycles on the loop() core (cache refills from flash/PSRAM)
+  append("# TYPE nyan_stage_stall_cycles_total counter\n");
+  for (uint8_t i = 0; i < STAGE_COUNT; i++) {
+    append("nyan_stage_stall_cycles_total{stage=\"%s\",side=\"instruction\"} %llu\n", stageNames[i],
+           (unsigned long long)stageIStallTotal[i]);
+    append("nyan_stage_stall_cycles_total{stage=\"%s\",side=\"data\"} %llu\n", stageNames[i],
+           (unsigned long long)stageDStallTotal[i]);
+  }
+#endif
+
+  // Draw commands recorded in the display list vs issued after elision
+  append("# TYPE nyan_draw_commands_total counter\n");
+  append("nyan_draw_commands_total{phase=\"recorded\"} %llu\n", (unsigned long long)drawRecordedTotal);
+  append("nyan_draw_commands_total{phase=\"executed\"} %llu\n", (unsigned long long)drawExecutedTotal);
+  append("# TYPE nyan_draw_commands_last gauge\n");
+  append("nyan_draw_commands_last{phase=\"recorded\"} %u\n", (unsigned)drawRecordedLast);
+  append("nyan_draw_commands_last{phase=\"executed\"} %u\n", (unsigned)drawExecutedLast);
+
+  // Panel traffic
+  append("# TYPE nyan_push_bytes_total counter\n");
+  append("nyan_push_bytes_total %llu\n", (unsigned long long)pushBytesTotal);
+  append("# TYPE nyan_push_frames_total counter\n");
+  append("nyan_push_frames_total{mode=\"full\"} %u\n", (unsigned)(pushFramesTotal - pushRegionFrames));
+  append("nyan_push_frames_total{mode=\"region\"} %u\n", (unsigned)pushRegionFrames);
+  append("# TYPE nyan_push_bytes_last gauge\n");
+  append("nyan_push_bytes_last %u\n", (unsigned)pushBytesLast);
+  append("# TYPE nyan_push_rects_last gauge\n");
+  append("nyan_push_rects_last %u\n", (unsigned)pushRectsLast);
+
+  // Adaptive quality (0 = full)
+  append("# TYPE nyan_quality_level gauge\n");
+  append("nyan_quality_level %u\n", (unsigned)qualityLevel);
+  append("# TYPE nyan_quality_transitions_total counter\n");
+  append("nyan_quality_transitions_total %u\n", (unsigned)qualityTransitions);
+
+  // New second on the panel, measured from the real second boundary (early ones in the first bucket)
+  append("# TYPE nyan_tick_latency_seconds histogram\n");
+  cumulative = 0;
+  for (uint8_t i = 0; i < TICK_HISTOGRAM_BUCKETS; i++) {
+    cumulative += tickStats.histogram[i];
+    append("nyan_tick_latency_seconds_bucket{le=\"%.3f\"} %u\n", TICK_HISTOGRAM_BOUNDS_US[i] / 1e6, (unsigned)cumulative);
+  }
+  cumulative += tickStats.histogram[TICK_HISTOGRAM_BUCKETS];
+  append("nyan_tick_latency_seconds_bucket{le=\"+Inf\"} %u\n", (unsigned)cumulative);
+  append("nyan_tick_latency_seconds_sum %.6f\n", tickStats.totalMicros / 1e6);
+  append("nyan_tick_latency_seconds_count %u\n", (unsigned)tickStats.ticks);
+  append("# TYPE nyan_tick_early_total counter\n");
+  append("nyan_tick_early_total %u\n", (unsigned)tickStats.early);
+  append("# TYPE nyan_tick_lead_seconds gauge\n");
+  append("nyan_tick_lead_seconds %.6f\n", tickLeadMicros / 1e6);
+
+  // Raw frame prefetch into SRAM
+  const FramePrefetchStats& prefetch = framePrefetchStats();
+  append("# TYPE nyan_prefetch_frames_total counter\n");
+  append("nyan_prefetch_frames_total{result=\"hit\"} %u\n", (unsigned)prefetch.hits);
+  append("nyan_prefetch_frames_total{result=\"late\"} %u\n", (unsigned)prefetch.late);
+  append("nyan_prefetch_frames_total{result=\"miss\"} %u\n", (unsigned)prefetch.misses);
+  append("# TYPE nyan_prefetch_wait_seconds_total counter\n");
+  append("nyan_prefetch_wait_seconds_total %.6f\n", prefetch.waitMicros / 1e6);
+  append("# TYPE nyan_prefetch_copy_seconds gauge\n");
+  append("nyan_prefetch_copy_seconds %.6f\n", prefetch.copyMicros / 1e6);
+
+  // Background decoder (compressed animations only)
+  if (animationCompressed()) {
+    const FrameRingStats& decoder = animationDecoderStats();
+    append("# TYPE nyan_decoder_frames_total counter\n");
+    append("nyan_decoder_frames_total{result=\"shown\"} %u\n", (unsigned)decoder.shown);
+    append("nyan_decoder_frames_total{result=\"underrun\"} %u\n", (unsigned)decoder.underruns);
+    append("nyan_decoder_frames_total{result=\"discarded\"} %u\n", (unsigned)decoder.discarded);
+    append("nyan_decoder_frames_total{result=\"error\"} %u\n", (unsigned)decoder.decodeErrors);
+    append("# TYPE nyan_decoder_read_ahead_frames gauge\n");
+    append("nyan_decoder_read_ahead_frames %u\n", (unsigned)decoder.ahead);
+    append("# TYPE nyan_decoder_frame_seconds gauge\n");
+    append("nyan_decoder_frame_seconds %.6f\n", animationDecodeMicros(true) / 1e6);
+
+    // Decoded-frame cache
+    const FrameCache& cache = animationFrameCache();
+    append("# TYPE nyan_frame_cache_lookups_total counter\n");
+    append("nyan_frame_cache_lookups_total{result=\"hit\"} %u\n", (unsigned)cache.stats.hits);
+    append("nyan_frame_cache_lookups_total{result=\"miss\"} %u\n", (unsigned)cache.stats.misses);
+    append("# TYPE nyan_frame_cache_evictions_total counter\n");
+    append("nyan_frame_cache_evictions_total %u\n", (unsigned)cache.stats.evictions);
+    append("# TYPE nyan_frame_cache_bytes gauge\n");
+    append("nyan_frame_cache_bytes{kind=\"held\"} %u\n", (unsigned)cache.stats.bytesHeld);
+    append("nyan_frame_cache_bytes{kind=\"capacity\"} %u\n", (unsigned)(cache.capacity * cache.frameBytes));
+    append("# TYPE nyan_frame_cache_saved_seconds_total counter\n");
+    append("nyan_frame_cache_saved_seconds_total %.3f\n", cache.stats.msSaved / 1e3);
+  }
+
+  // Memory
+  append("# TYPE nyan_heap_free_bytes gauge\n");
+  append("nyan_heap_free_bytes %u\n", (unsigned)ESP.getFreeHeap());
+  append("# TYPE nyan_heap_min_free_bytes gauge\n");
+  append("nyan_heap_min_free_bytes %u\n", (unsigned)ESP.getMinFreeHeap());
+  append("# TYPE nyan_heap_max_alloc_bytes gauge\n");
+  append("nyan_heap_max_alloc_bytes %u\n", (unsigned)ESP.getMaxAllocHeap());
+  append("# TYPE nyan_psram_size_bytes gauge\n");
+  append("nyan_psram_size_bytes %u\n", (unsigned)ESP.getPsramSize());
+  append("# TYPE nyan_psram_free_bytes gauge\n");
+  append("nyan_psram_free_bytes %u\n", (unsigned)ESP.getFreePsram());
+
+  // WiFi
+  append("# TYPE nyan_wifi_transitions_total counter\n");
+  for (uint8_t i = 0; i < WIFI_STATE_COUNT; i++) {
+    append("nyan_wifi_transitions_total{to=\"%s\"} %u\n", wifiStateName((wifi_state_t)i), (unsigned)wifiTransitions[i]);
+  }
+  append("# TYPE nyan_wifi_state gauge\n");
+  for (uint8_t i = 0; i < WIFI_STATE_COUNT; i++) {
+    append("nyan_wifi_state{state=\"%s\"} %d\n", wifiStateName((wifi_state_t)i), wifiCurrent == i ? 1 : 0);
+  }
+  append("# TYPE nyan_wifi_reconnects_total counter\n");
+  append("nyan_wifi_reconnects_total %u\n", (unsigned)reconnectAttempts);
+
+  // NTP
+  append("# TYPE nyan_ntp_syncs_total counter\n");
+  append("nyan_ntp_syncs_total %u\n", (unsigned)ntpSyncs);
+  append("# TYPE nyan_ntp_offset_seconds gauge\n");
+  append("nyan_ntp_offset_seconds %.3f\n", ntpOffsetMillis / 1e3);
+  append("# TYPE nyan_ntp_last_sync_age_seconds gauge\n");
+  append("nyan_ntp_last_sync_age_seconds %.3f\n", ntpSyncs ? (millis() - ntpLastSync) / 1e3 : -1.0);
+
+  // Uptime
+  append("# TYPE nyan_uptime_seconds gauge\n");
+  append("nyan_uptime_seconds %.3f\n", millis() / 1e3);
+}
+
+// GET /metrics handler; a response that doesn't fit fails the scrape rather than losing its tail unnoticed
+// - the buffer goes out only as far as the socket has room, the rest on later polls (offset in scratch[0])
+// - one scrape at a time: a second one while the buffer is still being sent gets 503
+static bool handleMetrics(WebConnection& conn) {
+  uint32_t& sent = conn.scratch[0];
+  if (conn.handlerCalls == 0) {
+    if (scraper && scraper != &conn && webConnectionServes(scraper, "GET", "/metrics")) {
+      webSendText(conn, 503, "metrics busy\n");
+      return false;
+    }
+    formatMetrics();
+    if (metricsNeeded > metricsLength) {
+      char reason[96];
+      snprintf(reason, sizeof(reason), "metrics need %u bytes, buffer holds %u\n", (unsigned)metricsNeeded,
+               (unsigned)sizeof(metricsBuffer));
+      Serial.print(reason);
+      webSendText(conn, 500, reason);
+      return false;
+    }
+    webSendHeader(conn, 200, "text/plain; version=0.0.4", false);
+    scraper = &conn;
+    sent = 0;
+  }
+
+  while (sent < metricsLength) {
+    int room = conn.client.availableForWrite();
+    if (room <= 0) {
+      return conn.client.connected(); // slow scraper: continue next poll rather than block loop()
+    }
+    size_t written = conn.client.write((const uint8_t*)metricsBuffer + sent, min((size_t)room, metricsLength - sent));
+    if (!written) {
+      return conn.client.connected();
+    }
+    sent += written;
+    conn.lastActivity = millis();
+  }
+  scraper = nullptr;
+  return false;
+}
+
+void metricsBegin() {
+  webServerOn("GET", "/metrics", handleMetrics);
+}
+
+
+/*************************************************************
+********************** CONSOLE OUTPUT ************************
+**************************************************************/
+
+bool metricsPrintStatsLine(Print& out, uint32_t index) {
+  uint32_t frames = frameCountTotal ? frameCountTotal : 1; // averages are 0 before the first frame
+  switch (index) {
+    case 0:
+      out.printf("uptime %.1f s, frames %u, dropped %u (>%u us)\n", millis() / 1e3,
+                 (unsigned)frameCountTotal, (unsigned)droppedFrames, (unsigned)METRICS_FRAME_BUDGET_US);
+      return true;
+    case 1:
+      out.printf("frame last %u us, avg %u us\n", (unsigned)lastFrameMicros, (unsigned)(frameMicrosTotal / frames));
+      return true;
+    case 2:
+      out.printf("cpu last %u us, avg %u us (frame minus push_wait)\n",
+                 (unsigned)(lastFrameMicros - stageMicrosLast[STAGE_PUSH_WAIT]),
+                 (unsigned)((frameMicrosTotal - stageMicrosTotal[STAGE_PUSH_WAIT]) / frames));
+      return true;
+  }
+
+  // One line per stage
+  index -= 3;
+  if (index < STAGE_COUNT) {
+    out.printf("  %-9s last %6u us, avg %6u us\n", stageNames[index], (unsigned)stageMicrosLast[index],
+               (unsigned)(stageMicrosTotal[index] / frames));
+    return true;
+  }
+  index -= STAGE_COUNT;
+#ifdef CACHE_PROFILING
+  if (index == 0) {
+    out.println("stall cycles per frame (instruction / data), avg:");
+    return true;
+  }
+  if (index <= STAGE_COUNT) {
+    out.printf("  %-9s %8u / %8u\n", stageNames[index - 1], (unsigned)(stageIStallTotal[index - 1] / frames),
+               (unsigned)(stageDStallTotal[index - 1] / frames));
+    return true;
+  }
+  index -= STAGE_COUNT + 1;
+#endif
+
+  if (index >= 2 && !tickStats.ticks) index++; // no tick-to-photon line before the first tick
+  switch (index) {
+    case 0:
+      out.printf("draw commands last frame %u recorded, %u executed (avg %u / %u)\n",
+                 (unsigned)drawRecordedLast, (unsigned)drawExecutedLast,
+                 (unsigned)(drawRecordedTotal / frames), (unsigned)(drawExecutedTotal / frames));
+      return true;
+    case 1:
+      out.printf("push last %u bytes in %u rects, avg %u bytes/frame (%u of %u frames as dirty rects)\n",
+                 (unsigned)pushBytesLast, (unsigned)pushRectsLast,
+                 (unsigned)(pushFramesTotal ? pushBytesTotal / pushFramesTotal : 0), (unsigned)pushRegionFrames,
+                 (unsigned)pushFramesTotal);
+      return true;
+    case 2:
+      out.printf("tick-to-photon ms: last %.1f, avg %.1f, min %.1f, max %.1f, lead %.1f, %u early of %u\n",
+                 tickStats.lastMicros / 1e3, tickStats.totalMicros / 1e3 / tickStats.ticks, tickStats.minMicros / 1e3,
+                 tickStats.maxMicros / 1e3, tickLeadMicros / 1e3, (unsigned)tickStats.early, (unsigned)tickStats.ticks);
+      return true;
+    case 3:
+      out.printf("heap free %u (min %u), psram free %u of %u\n", (unsigned)ESP.getFreeHeap(),
+                 (unsigned)ESP.getMinFreeHeap(), (unsigned)ESP.getFreePsram(), (unsigned)ESP.getPsramSize());
+      return true;
+    case 4:
+      out.printf("wifi %s, reconnects %u\n", wifiStateName(wifiCurrent), (unsigned)reconnectAttempts);
+      return true;
+    case 5:
+      out.printf("ntp syncs %u, offset %d ms, last sync %.0f s ago\n", (unsigned)ntpSyncs, (int)ntpOffsetMillis,
+                 ntpSyncs ? (millis() - ntpLastSync) / 1e3 : -1.0);
+      return false;
+  }
+  return false;
+}
+
+bool metricsPrintTraceLine(Print& out, uint32_t index) {
+  uint32_t available = frameCountTotal < METRICS_TRACE_FRAMES ? frameCountTotal : METRICS_TRACE_FRAMES;
+  if (index == 0) {
+    out.print("ms        total");
+    for (uint8_t i = 0; i < STAGE_COUNT; i++) out.printf(" %9s", stageNames[i]);
+    out.println();
+    return available > 0;
+  }
+  if (index > available) {
+    return false;
+  }
+
+  // Oldest first
+  const FrameTrace& entry = trace[(traceNext + METRICS_TRACE_FRAMES - available + index - 1) % METRICS_TRACE_FRAMES];
+  out.printf("%-9u %5u", (unsigned)entry.startMillis, (unsigned)entry.totalMicros);
+  for (uint8_t i = 0; i < STAGE_COUNT; i++) out.printf(" %9u", (unsigned)entry.stageMicros[i]);
+  out.println();
+  return index < available;
+}
@@ -0,0 +1,402 @@
+/*************************************************************
+*********************** LAYERED NYANCAT **********************
+**************************************************************/
+
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include "nyan_layers.h"
+#include "pixel_kernels.h"
+#include "hot_code.h"
+
+// Rainbow stripes, top to bottom (native RGB565, as in the art)
+static const uint16_t RAINBOW_COLOURS[6] = { 0xF800, 0xFCC0, 0xFFC0, 0x2FE0, 0x049F, 0x695F };
+static const int RAINBOW_HEIGHT = 6 * NYAN_RAINBOW_STRIPE;
+static const uint16_t STAR_COLOUR = 0xFFFF;
+
+// Star shapes (rows of NYAN_STAR_SIZE bits, leftmost pixel in bit 6), cycled 0 1 2 3 2 1
+static const uint8_t STAR_SHAPES[4][NYAN_STAR_SIZE] = {
+  { 0x00, 0x00, 0x00, 0x08, 0x00, 0x00, 0x00 }, // dot
+  { 0x00, 0x00, 0x08, 0x1C, 0x08, 0x00, 0x00 }, // small cross
+  { 0x00, 0x08, 0x08, 0x36, 0x08, 0x08, 0x00 }, // open cross
+  { 0x08, 0x22, 0x00, 0x41, 0x00, 0x22, 0x08 }, // burst
+};
+static const uint8_t STAR_CYCLE[6] = { 0, 1, 2, 3, 2, 1 };
+
+// Scenery colours for the cut-out (8-bit RGB): background anchor, star white, stripes
+struct Rgb {
+  float r, g, b;
+};
+static const Rgb SCENERY_BACKGROUND = { 0, 60, 125 };
+static const Rgb SCENERY_STAR = { 255, 255, 255 };
+static const Rgb SCENERY_STRIPES[6] = { { 255, 0, 0 }, { 255, 153, 0 }, { 255, 250, 0 },
+                                        { 41, 255, 0 }, { 0, 145, 255 }, { 106, 40, 255 } };
+static const float SCENERY_BLEND_DISTANCE = 28; // from the nearest scenery colour or blend of two
+
+// Cut-out scratch marks per pixel
+typedef enum {
+  MARK_NONE,
+  MARK_SCENERY, // reached from the frame edges
+  MARK_PIECE,   // inside an outline, not yet known to be the cat
+  MARK_CAT
+} mark_t;
+
+
+/*************************************************************
+************************ CAT CUT-OUT *************************
+**************************************************************/
+
+static inline Rgb expand(uint16_t colour) {
+  return { (float)((colour >> 11) * 255 / 31), (float)(((colour >> 5) & 63) * 255 / 63), (float)((colour & 31) * 255 / 31) };
+}
+
+// Function to check the art's background colours (dark blue, darker towards the edges)
+static inline bool backgroundColour(const Rgb& c) {
+  return c.r <= 24 && c.g >= 36 && c.g <= 72 && c.b >= 80 && c.b <= 150;
+}
+
+// Function to measure how far c is from the blends of a and b (the line segment between them)
+static float blendDistance(const Rgb& c, const Rgb& a, const Rgb& b) {
+  float dr = b.r - a.r, dg = b.g - a.g, db = b.b - a.b;
+  float t = ((c.r - a.r) * dr + (c.g - a.g) * dg + (c.b - a.b) * db) / (dr * dr + dg * dg + db * db);
+  t = t < 0 ? 0 : t > 1 ? 1 : t;
+  float er = a.r + t * dr - c.r, eg = a.g + t * dg - c.g, eb = a.b + t * db - c.b;
+  return sqrtf(er * er + eg * eg + eb * eb);
+}
+
+// Function to classify a colour as scenery: background, or a blend of it with a star or stripe, or of two stripes
+static bool sceneryColour(uint16_t colour) {
+  Rgb c = expand(colour);
+  if (backgroundColour(c) || blendDistance(c, SCENERY_BACKGROUND, SCENERY_STAR) < SCENERY_BLEND_DISTANCE) {
+    return true;
+  }
+  for (uint8_t i = 0; i < 6; i++) {
+    if (blendDistance(c, SCENERY_BACKGROUND, SCENERY_STRIPES[i]) < SCENERY_BLEND_DISTANCE) return true;
+    if (i < 5 && blendDistance(c, SCENERY_STRIPES[i], SCENERY_STRIPES[i + 1]) < SCENERY_BLEND_DISTANCE) return true;
+  }
+  return false;
+}
+
+// Scratch for one cut-out (the art has a few thousand colours: each is classified once)
+struct CutOut {
+  uint8_t* marks;       // mark_t per pixel
+  uint16_t* stack;      // pixel indices, each pushed at most once per flood
+  uint8_t* classes;     // 2 bits per RGB565 colour: 0 unknown, 1 scenery, 2 not
+  int width, height;
+};
+
+static bool scenery(CutOut& cut, uint16_t colour) {
+  uint8_t shift = (colour & 3) * 2;
+  uint8_t& bits = cut.classes[colour >> 2];
+  uint8_t known = (bits >> shift) & 3;
+  if (!known) {
+    known = sceneryColour(colour) ? 1 : 2;
+    bits |= known << shift;
+  }
+  return known == 1;
+}
+
+// Function to mark everything the edges reach through scenery colours (4-connected)
+static void floodScenery(CutOut& cut, const uint16_t* frame) {
+  int width = cut.width, height = cut.height;
+  size_t top = 0;
+  auto push = [&](int i) {
+    if (cut.marks[i] == MARK_NONE && scenery(cut, frame[i])) {
+      cut.marks[i] = MARK_SCENERY;
+      cut.stack[top++] = i;
+    }
+  };
+  for (int x = 0; x < width; x++) {
+    push(x);
+    push((height - 1) * width + x);
+  }
+  for (int y = 0; y < height; y++) {
+    push(y * width);
+    push(y * width + width - 1);
+  }
+  while (top) {
+    int i = cut.stack[--top];
+    int x = i % width, y = i / width;
+    if (x > 0) push(i - 1);
+    if (x < width - 1) push(i + 1);
+    if (y > 0) push(i - width);
+    if (y < height - 1) push(i + width);
+  }
+}
+
+// Function to mark the 8-connected piece of from-marked pixels around seed as to; returns its size
+static size_t floodPiece(CutOut& cut, int seed, uint8_t from, uint8_t to) {
+  int width = cut.width, height = cut.height;
+  size_t top = 0, size = 0;
+  cut.marks[seed] = to;
+  cut.stack[top++] = seed;
+  while (top) {
+    int i = cut.stack[--top];
+    int x = i % width, y = i / width;
+    size++;
+    for (int dy = -1; dy <= 1; dy++) {
+      for (int dx = -1; dx <= 1; dx++) {
+        int nx = x + dx, ny = y + dy;
+        if (nx < 0 || ny < 0 || nx >= width || ny >= height) continue;
+        int j = ny * width + nx;
+        if (cut.marks[j] == from) {
+          cut.marks[j] = to;
+          cut.stack[top++] = j;
+        }
+      }
+    }
+  }
+  return size;
+}
+
+// Function to cut the cat out of one frame into spans; false if it doesn't fit or there is none
+static bool cutFrame(NyanLayers& layers, CutOut& cut, int index, size_t& used, size_t capacity) {
+  const uint16_t* frame = layers.frames + (size_t)index * layers.width * layers.height;
+  size_t pixels = (size_t)layers.width * layers.height;
+  memset(cut.marks, MARK_NONE, pixels);
+  floodScenery(cut, frame);
+
+  // The largest piece inside the outlines is the cat
+  int best = -1;
+  size_t bestSize = 0;
+  for (size_t i = 0; i < pixels; i++) {
+    if (cut.marks[i] != MARK_NONE) continue;
+    size_t size = floodPiece(cut, i, MARK_NONE, MARK_PIECE);
+    if (size > bestSize) {
+      best = i;
+      bestSize = size;
+    }
+  }
+  if (best < 0) {
+    return false;
+  }
+  floodPiece(cut, best, MARK_PIECE, MARK_CAT);
+
+  CatFrame& cat = layers.cats[index];
+  cat.first = used;
+  int x0 = layers.width, y0 = layers.height, x1 = 0, y1 = 0;
+  for (int y = 0; y < layers.height; y++) {
+    const uint8_t* row = cut.marks + (size_t)y * layers.width;
+    for (int x = 0; x < layers.width; x++) {
+      if (row[x] != MARK_CAT) continue;
+      int start = x;
+      while (x < layers.width && row[x] == MARK_CAT) x++;
+      if (used >= capacity) {
+        return false;
+      }
+      layers.spans[used++] = { (int16_t)y, (int16_t)start, (int16_t)(x - start) };
+      if (start < x0) x0 = start;
+      if (x > x1) x1 = x;
+      if (y < y0) y0 = y;
+      y1 = y + 1;
+    }
+  }
+  cat.count = used - cat.first;
+  cat.bounds = { (int16_t)x0, (int16_t)y0, (int16_t)(x1 - x0), (int16_t)(y1 - y0) };
+  return true;
+}
+
+// Function to sample the background colour of every row (mean of its background pixels in the first frame)
+static void sampleBackground(NyanLayers& layers) {
+  uint16_t previous = 0x01EF;
+  for (int y = 0; y < layers.height; y++) {
+    const uint16_t* row = layers.frames + (size_t)y * layers.width;
+    uint32_t r = 0, g = 0, b = 0, count = 0;
+    for (int x = 0; x < layers.width; x++) {
+      if (!backgroundColour(expand(row[x]))) continue;
+      r += row[x] >> 11;
+      g += (row[x] >> 5) & 63;
+      b += row[x] & 31;
+      count++;
+    }
+    if (count) {
+      previous = (uint16_t)((r + count / 2) / count << 11 | (g + count / 2) / count << 5 | (b + count / 2) / count);
+    }
+    layers.rowColour[y] = previous;
+  }
+}
+
+bool nyanLayersInit(NyanLayers& layers, const uint16_t* frames, int frameCount, int width, int height,
+                    CatSpan* spans, size_t capacity) {
+  memset(&layers, 0, sizeof(layers));
+  size_t pixels = (size_t)width * height;
+  if (!frames || !spans || frameCount <= 0 || frameCount > NYAN_MAX_FRAMES || height > NYAN_MAX_HEIGHT ||
+      pixels > 65536) {
+    return false;
+  }
+  layers.frames = frames;
+  layers.frameCount = frameCount;
+  layers.width = width;
+  layers.height = height;
+  layers.spans = spans;
+
+  CutOut cut;
+  cut.width = width;
+  cut.height = height;
+  cut.marks = (uint8_t*)malloc(pixels);
+  cut.stack = (uint16_t*)malloc(pixels * sizeof(uint16_t));
+  cut.classes = (uint8_t*)calloc(65536 / 4, 1);
+  bool ok = cut.marks && cut.stack && cut.classes;
+  size_t used = 0;
+  for (int i = 0; ok && i < frameCount; i++) {
+    ok = cutFrame(layers, cut, i, used, capacity);
+  }
+  free(cut.marks);
+  free(cut.stack);
+  free(cut.classes);
+  if (!ok) {
+    layers.frameCount = 0;
+    return false;
+  }
+
+  sampleBackground(layers);
+  return true;
+}
+
+size_t nyanLayersSpanCount(const NyanLayers& layers) {
+  size_t count = 0;
+  for (int i = 0; i < layers.frameCount; i++) count += layers.cats[i].count;
+  return count;
+}
+
+
+/*************************************************************
+*************************** SCENE ****************************
+**************************************************************/
+
+int nyanLayersCatFrame(const NyanLayers& layers, uint32_t timeMs) {
+  return layers.frameCount ? (timeMs / NYAN_ART_FRAME_MS) % layers.frameCount : 0;
+}
+
+// Function to scatter the stars (integer hash of star and lap)
+static inline uint32_t starHash(uint32_t star, uint32_t lap) {
+  uint32_t hash = star * 2654435761u ^ lap * 2246822519u;
+  hash ^= hash >> 15;
+  hash *= 2246822519u;
+  return hash ^ (hash >> 13);
+}
+
+// Box and shape of star at scroll/twinkle; the odd stars are on the faster plane
+static DirtyRect starBox(const NyanLayers& layers, uint8_t star, uint32_t scroll, uint32_t twinkle, uint8_t& shape) {
+  uint32_t track = layers.width + NYAN_STAR_SIZE;
+  uint32_t distance = scroll * (1 + (star & 1)) + starHash(star, 0) % track;
+  uint32_t lap = distance / track;
+  int x = layers.width - (int)(distance % track);
+  int y = starHash(star, lap + 1) % (layers.height - NYAN_STAR_SIZE);
+  shape = STAR_CYCLE[(twinkle + star) % 6];
+  return { (int16_t)x, (int16_t)y, NYAN_STAR_SIZE, NYAN_STAR_SIZE };
+}
+
+void nyanLayersReset(NyanLayers& layers) {
+  layers.placed = false;
+}
+
+void nyanLayersAdvance(NyanLayers& layers, uint32_t timeMs, int catFrame, DirtyRegion& region) {
+  uint32_t scroll = (uint32_t)((uint64_t)timeMs * NYAN_SCROLL_PX_PER_S / 1000);
+  uint32_t twinkle = timeMs / NYAN_ART_FRAME_MS;
+  if (catFrame < 0 || catFrame >= layers.frameCount) catFrame = 0;
+
+  if (!layers.placed || scroll < layers.scroll) {
+    dirtyAll(region);
+  } else {
+    // Stars: where they were and where they are now
+    if (scroll != layers.scroll || twinkle != layers.twinkle) {
+      for (uint8_t star = 0; star < NYAN_STAR_COUNT; star++) {
+        uint8_t oldShape, newShape;
+        DirtyRect was = starBox(layers, star, layers.scroll, layers.twinkle, oldShape);
+        DirtyRect now = starBox(layers, star, scroll, twinkle, newShape);
+        if (was.x == now.x && was.y == now.y && oldShape == newShape) continue;
+        dirtyAdd(region, was);
+        dirtyAdd(region, now);
+      }
+    }
+
+    // Rainbow: only the columns the steps between segments swept over change
+    uint32_t moved = scroll - layers.scroll;
+    int rainbowTop = NYAN_RAINBOW_TOP - NYAN_RAINBOW_WAVE, rainbowHeight = RAINBOW_HEIGHT + NYAN_RAINBOW_WAVE;
+    if (moved >= (uint32_t)NYAN_RAINBOW_SEGMENT) {
+      dirtyAdd(region, 0, rainbowTop, NYAN_RAINBOW_END, rainbowHeight);
+    } else if (moved) {
+      for (int edge = NYAN_RAINBOW_SEGMENT - (int)(layers.scroll % NYAN_RAINBOW_SEGMENT);
+           edge - (int)moved < NYAN_RAINBOW_END; edge += NYAN_RAINBOW_SEGMENT) {
+        int right = edge < NYAN_RAINBOW_END ? edge : NYAN_RAINBOW_END;
+        dirtyAdd(region, edge - moved, rainbowTop, right - (edge - moved), rainbowHeight);
+      }
+    }
+
+    // Cat: the old frame's box and the new one's
+    if (catFrame != layers.catFrame) {
+      dirtyAdd(region, layers.cats[layers.catFrame].bounds);
+      dirtyAdd(region, layers.cats[catFrame].bounds);
+    }
+  }
+
+  layers.scroll = scroll;
+  layers.twinkle = twinkle;
+  layers.catFrame = catFrame;
+  layers.placed = true;
+}
+
+// Function to draw the rainbow rows of rect (square wave of segments, alternately NYAN_RAINBOW_WAVE higher)
+static void drawRainbow(const NyanLayers& layers, uint16_t* dst, int x0, int x1, int y0, int y1) {
+  if (x1 > NYAN_RAINBOW_END) x1 = NYAN_RAINBOW_END;
+  for (int y = y0; y < y1; y++) {
+    uint16_t* row = dst + (size_t)y * layers.width;
+    for (int x = x0; x < x1;) {
+      uint32_t segment = (x + layers.scroll) / NYAN_RAINBOW_SEGMENT;
+      int end = (int)((segment + 1) * NYAN_RAINBOW_SEGMENT - layers.scroll);
+      if (end > x1) end = x1;
+      int top = NYAN_RAINBOW_TOP - ((segment & 1) ? NYAN_RAINBOW_WAVE : 0);
+      if (y >= top && y < top + RAINBOW_HEIGHT) {
+        pixelFill(row + x, pixelSwap(RAINBOW_COLOURS[(y - top) / NYAN_RAINBOW_STRIPE]), end - x);
+      }
+      x = end;
+    }
+  }
+}
+
+HOT_CODE void nyanLayersDraw(const NyanLayers& layers, uint16_t* dst, const DirtyRect& rect) {
+  int x0 = rect.x, y0 = rect.y, x1 = rect.x + rect.w, y1 = rect.y + rect.h;
+
+  // Background
+  for (int y = y0; y < y1; y++) {
+    pixelFill(dst + (size_t)y * layers.width + x0, pixelSwap(layers.rowColour[y]), rect.w);
+  }
+
+  // Stars
+  for (uint8_t star = 0; star < NYAN_STAR_COUNT; star++) {
+    uint8_t shape;
+    DirtyRect box = starBox(layers, star, layers.scroll, layers.twinkle, shape);
+    if (box.x >= x1 || box.x + box.w <= x0 || box.y >= y1 || box.y + box.h <= y0) continue;
+    for (int row = 0; row < NYAN_STAR_SIZE; row++) {
+      int y = box.y + row;
+      uint8_t bits = STAR_SHAPES[shape][row];
+      if (!bits || y < y0 || y >= y1) continue;
+      for (int column = 0; column < NYAN_STAR_SIZE; column++) {
+        int x = box.x + column;
+        if ((bits & (0x40 >> column)) && x >= x0 && x < x1) {
+          dst[(size_t)y * layers.width + x] = pixelSwap(STAR_COLOUR);
+        }
+      }
+    }
+  }
+
+  // Rainbow
+  int rainbowTop = NYAN_RAINBOW_TOP - NYAN_RAINBOW_WAVE, rainbowBottom = NYAN_RAINBOW_TOP + RAINBOW_HEIGHT;
+  if (x0 < NYAN_RAINBOW_END && y0 < rainbowBottom && y1 > rainbowTop) {
+    drawRainbow(layers, dst, x0, x1, y0 > rainbowTop ? y0 : rainbowTop, y1 < rainbowBottom ? y1 : rainbowBottom);
+  }
+
+  // Cat, straight from the art
+  const CatFrame& cat = layers.cats[layers.catFrame];
+  const uint16_t* frame = layers.frames + (size_t)layers.catFrame * layers.width * layers.height;
+  for (uint16_t i = cat.first; i < cat.first + cat.count; i++) {
+    const CatSpan& span = layers.spans[i];
+    if (span.y < y0 || span.y >= y1) continue;
+    int start = span.x > x0 ? span.x : x0;
+    int end = span.x + span.length < x1 ? span.x + span.length : x1;
+    if (end <= start) continue;
+    size_t offset = (size_t)span.y * layers.width + start;
+    pixelCopySwap(dst + offset, frame + offset, end - start);
+  }
+}
@@ -0,0 +1,167 @@
+/*************************************************************
+*********************** PIXEL KERNELS ************************
+**************************************************************/
+
+#include <string.h>
+#include "pixel_kernels.h"
+#include "hot_code.h"
+
+/*
+Word-at-a-time kernels (key copy and half-width copy; the plain copy and
+fill stay per-pixel, which measured faster than the word versions):
+ - work on two pixels per 32-bit access once both pointers are 4-byte aligned
+ - fall back to one pixel at a time for the unaligned head/tail
+ - the ESP32-S3 has no unaligned 32-bit loads from flash, so mismatched
+   alignment between src and dst always takes the scalar path
+ - words are loaded and stored with memcpy (loadPair/storePair): the
+   buffers are uint16_t, and reading them through uint32_t* breaks strict
+   aliasing, which GCC relies on at -Os. The pointer is declared 4-byte
+   aligned, so on the S3 (no unaligned access) the memcpy is still a
+   single l32i/s32i rather than two halfword accesses
+*/
+
+// Load / store two pixels as one 32-bit word (p 4-byte aligned)
+static inline uint32_t loadPair(const uint16_t* p) {
+  uint32_t pair;
+  memcpy(&pair, __builtin_assume_aligned(p, 4), 4);
+  return pair;
+}
+
+static inline void storePair(uint16_t* p, uint32_t pair) {
+  memcpy(__builtin_assume_aligned(p, 4), &pair, 4);
+}
+
+// Check whether two pointers share the same 4-byte alignment
+static inline bool sameAlignment(const void* a, const void* b) {
+  return (((uintptr_t)a ^ (uintptr_t)b) & 3u) == 0;
+}
+
+HOT_CODE void pixelCopySwap(uint16_t* dst, const uint16_t* src, size_t count) {
+  // Plain loop: the compiler does at least as well with it as with a hand-written word path
+  while (count--) {
+    *dst++ = pixelSwap(*src++);
+  }
+}
+
+HOT_CODE void pixelCopySwapHalf(uint16_t* dst, const uint16_t* src, size_t count) {
+#ifndef PIXEL_KERNELS_SCALAR
+  // Both copies of a source pixel in one 32-bit store
+  if (((uintptr_t)dst & 3u) == 0) {
+    size_t pairs = count >> 1;
+    while (pairs--) {
+      uint32_t colour = pixelSwap(*src);
+      storePair(dst, colour | (colour << 16));
+      dst += 2; src += 2;
+    }
+    count &= 1;
+  }
+#endif
+  for (size_t i = 0; i < count; i++) {
+    dst[i] = pixelSwap(src[i & ~(size_t)1]);
+  }
+}
+
+HOT_CODE void pixelKeyCopy(uint16_t* dst, const uint16_t* src, size_t count, uint16_t key) {
+#ifndef PIXEL_KERNELS_SCALAR
+  if (sameAlignment(dst, src)) {
+    // Align to a word boundary
+    if (((uintptr_t)dst & 3u) && count) {
+      if (*src != key) *dst = *src;
+      dst++; src++; count--;
+    }
+
+    /*
+    Compare two pixels at once against the doubled key:
+    - both transparent: skip the store (most common case for overlays)
+    - both opaque: store the whole word
+    - mixed: store only the opaque half
+    */
+    uint32_t keyPair = ((uint32_t)key << 16) | key;
+    size_t pairs = count >> 1;
+    while (pairs--) {
+      uint32_t pair = loadPair(src);
+      uint32_t diff = pair ^ keyPair;
+      if (diff) {
+        if ((diff & 0xFFFFu) && (diff >> 16)) {
+          storePair(dst, pair);
+        } else {
+          uint32_t mask = (diff & 0xFFFFu) ? 0x0000FFFFu : 0xFFFF0000u;
+          storePair(dst, (loadPair(dst) & ~mask) | (pair & mask));
+        }
+      }
+      dst += 2; src += 2;
+    }
+
+    // Odd pixel left over
+    count &= 1;
+  }
+#endif
+  while (count--) {
+    if (*src != key) *dst = *src;
+    dst++; src++;
+  }
+}
+
+HOT_CODE void pixelFill(uint16_t* dst, uint16_t colour, size_t count) {
+  // Plain loop, as for pixelCopySwap
+  while (count--) {
+    *dst++ = colour;
+  }
+}
+
+
+/*************************************************************
+********************* RECTANGLE HELPERS **********************
+**************************************************************/
+
+// Clip a w x h rectangle at (x, y) to the destination surface
+// Returns false when nothing is left; srcX/srcY give the first visible source pixel
+HOT_CODE static bool clipRect(int dstWidth, int dstHeight, int& x, int& y, int& w, int& h, int& srcX, int& srcY) {
+  srcX = 0;
+  srcY = 0;
+  if (x < 0) { srcX = -x; w += x; x = 0; }
+  if (y < 0) { srcY = -y; h += y; y = 0; }
+  if (x + w > dstWidth) w = dstWidth - x;
+  if (y + h > dstHeight) h = dstHeight - y;
+  return w > 0 && h > 0;
+}
+
+HOT_CODE void pixelBlitSwapRect(uint16_t* dst, int dstWidth, int dstHeight, int x, int y,
+                       const uint16_t* src, int srcWidth, int srcHeight) {
+  int w = srcWidth, h = srcHeight, srcX, srcY;
+  if (!clipRect(dstWidth, dstHeight, x, y, w, h, srcX, srcY)) return;
+
+  // Full-width blits are a single contiguous run
+  if (x == 0 && w == dstWidth && w == srcWidth) {
+    pixelCopySwap(dst + y * dstWidth, src + srcY * srcWidth, (size_t)w * h);
+    return;
+  }
+  for (int row = 0; row < h; row++) {
+    pixelCopySwap(dst + (y + row) * dstWidth + x, src + (srcY + row) * srcWidth + srcX, w);
+  }
+}
+
+HOT_CODE void pixelKeyBlitRect(uint16_t* dst, int dstWidth, int dstHeight, int x, int y,
+                      const uint16_t* src, int srcWidth, int srcHeight, uint16_t key) {
+  int w = srcWidth, h = srcHeight, srcX, srcY;
+  if (!clipRect(dstWidth, dstHeight, x, y, w, h, srcX, srcY)) return;
+
+  for (int row = 0; row < h; row++) {
+    pixelKeyCopy(dst + (y + row) * dstWidth + x, src + (srcY + row) * srcWidth + srcX, w, key);
+  }
+}
+
+HOT_CODE void pixelFillRect(uint16_t* dst, int dstWidth, int dstHeight, int x, int y,
+                   int w, int h, uint16_t colour) {
+  int srcX, srcY;
+  if (!clipRect(dstWidth, dstHeight, x, y, w, h, srcX, srcY)) return;
+
+  if (x == 0 && w == dstWidth) {
+    pixelFill(dst + y * dstWidth, colour, (size_t)w * h);
+    return;
+  }
+  for (int row = 0; row < h; row++) {
+    pixelFill(dst + (y + row) * dstWidth + x, colour, w);
+  }
+}
+
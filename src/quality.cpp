@@ -0,0 +1,113 @@
+/*************************************************************
+********************** ADAPTIVE QUALITY **********************
+**************************************************************/
+
+#include <string.h>
+#include "quality.h"
+
+static const char* levelNames[QUALITY_LEVEL_COUNT] = {
+  "full", "reduced-overlays", "half-res", "half-rate", "clock-only"
+};
+
+// Function to start a fresh window
+static void resetWindow(QualityController& controller) {
+  memset(controller.histogram, 0, sizeof(controller.histogram));
+  controller.windowFrames = 0;
+}
+
+// Function to change level and log it
+static void changeLevel(QualityController& controller, quality_level_t to, uint32_t nowMillis,
+                        uint8_t overPercent, uint8_t headroomPercent) {
+  QualityTransition& entry = controller.log[controller.logNext];
+  entry.atMillis = nowMillis;
+  entry.from = controller.level;
+  entry.to = to;
+  entry.overPercent = overPercent;
+  entry.headroomPercent = headroomPercent;
+  entry.pinned = controller.pinned;
+  controller.logNext = (controller.logNext + 1) % QUALITY_LOG_SIZE;
+  controller.transitions++;
+
+  controller.level = to;
+  controller.changedMillis = nowMillis;
+  controller.calmWindows = 0;
+  resetWindow(controller);
+}
+
+void qualityInit(QualityController& controller, uint32_t targetMicros) {
+  memset(&controller, 0, sizeof(controller));
+  controller.targetMicros = targetMicros;
+  controller.level = QUALITY_FULL;
+}
+
+bool qualityFrame(QualityController& controller, uint32_t periodMicros, uint32_t nowMillis) {
+  if (controller.pinned) return false;
+
+  // Bucket of this frame, as a share of its level's budget
+  uint32_t budget = controller.targetMicros * qualityFrameInterval(controller.level);
+  uint32_t percent = budget ? (uint32_t)((uint64_t)periodMicros * 100 / budget) : 0;
+  uint8_t bucket = 0;
+  while (bucket < QUALITY_BUCKETS - 1 && percent >= QUALITY_BUCKET_BOUNDS[bucket]) {
+    bucket++;
+  }
+  controller.histogram[bucket]++;
+  if (++controller.windowFrames < QUALITY_WINDOW_FRAMES) {
+    return false;
+  }
+
+  // Window complete: over budget (>= 100%) and headroom (< QUALITY_HEADROOM_PERCENT) shares
+  uint16_t over = controller.histogram[3] + controller.histogram[4];
+  uint16_t headroom = controller.histogram[0] + controller.histogram[1];
+  uint8_t overPercent = (uint8_t)(over * 100 / QUALITY_WINDOW_FRAMES);
+  uint8_t headroomPercent = (uint8_t)(headroom * 100 / QUALITY_WINDOW_FRAMES);
+  resetWindow(controller);
+
+  if (overPercent >= QUALITY_DOWN_PERCENT) {
+    controller.calmWindows = 0;
+    if (controller.level + 1 < QUALITY_LEVEL_COUNT) {
+      changeLevel(controller, (quality_level_t)(controller.level + 1), nowMillis, overPercent, headroomPercent);
+      return true;
+    }
+    return false;
+  }
+
+  if (headroomPercent >= QUALITY_UP_PERCENT) {
+    controller.calmWindows++;
+  } else {
+    controller.calmWindows = 0;
+  }
+  if (controller.level > QUALITY_FULL && controller.calmWindows >= QUALITY_UP_WINDOWS &&
+      nowMillis - controller.changedMillis >= QUALITY_UP_HOLD_MS) {
+    changeLevel(controller, (quality_level_t)(controller.level - 1), nowMillis, overPercent, headroomPercent);
+    return true;
+  }
+  return false;
+}
+
+void qualityPin(QualityController& controller, quality_level_t level, uint32_t nowMillis) {
+  if (level >= QUALITY_LEVEL_COUNT) {
+    controller.pinned = false;
+    controller.calmWindows = 0;
+    resetWindow(controller);
+    return;
+  }
+  controller.pinned = true;
+  if (level != controller.level) {
+    changeLevel(controller, level, nowMillis, 0, 0);
+  }
+}
+
+uint8_t qualityFrameInterval(quality_level_t level) {
+  return level >= QUALITY_HALF_RATE && level != QUALITY_CLOCK_ONLY ? 2 : 1;
+}
+
+const char* qualityLevelName(quality_level_t level) {
+  return level < QUALITY_LEVEL_COUNT ? levelNames[level] : "?";
+}
+
+bool qualityTransition(const QualityController& controller, uint8_t n, QualityTransition& transition) {
+  uint32_t kept = controller.transitions < QUALITY_LOG_SIZE ? controller.transitions : QUALITY_LOG_SIZE;
+  if (n >= kept) return false;
+  transition = controller.log[(controller.logNext + QUALITY_LOG_SIZE - kept + n) % QUALITY_LOG_SIZE];
+  return true;
+}
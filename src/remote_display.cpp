@@ -0,0 +1,114 @@
+/*************************************************************
+*********************** REMOTE DISPLAY ***********************
+**************************************************************/
+
+#include <Arduino.h>
+#include <WiFi.h>
+#include <WiFiUdp.h>
+#include "remote_display.h"
+#include "mem_arena.h"
+
+const uint8_t REMOTE_PACKETS_PER_POLL = 32; // bound on packets drained per loop()
+
+static WiFiUDP remoteSocket;
+static IPAddress boundAddress;
+static RemoteSlot* remoteSlots = nullptr;
+static RemoteJitterBuffer jitterBuffer;
+static uint8_t packetBuffer[REMOTE_MAX_PACKET];
+
+// Sender of the latest packet (acks go back there)
+static IPAddress senderAddress;
+static uint16_t senderPort = 0;
+
+// Pending ack for the frame applied this loop
+static RemoteAck pendingAck;
+static bool ackPending = false;
+static uint32_t ackAppliedMicros = 0;
+
+// Persistent canvas for overlay mode
+static uint16_t* canvas = nullptr;
+
+bool remoteDisplayBegin() {
+  if (!remoteSlots) {
+    remoteSlots = (RemoteSlot*)memArenaAlloc("remote display", sizeof(RemoteSlot) * REMOTE_SLOTS, MEM_TIER_PSRAM);
+    if (!remoteSlots) return false;
+  }
+  remoteJitterInit(jitterBuffer, remoteSlots);
+  return true;
+}
+
+// Function to (re)open the socket whenever the IP address changes
+static bool ensureSocket() {
+  IPAddress localAddress = WiFi.localIP();
+  if (localAddress == boundAddress) {
+    return (uint32_t)boundAddress != 0;
+  }
+  remoteSocket.stop();
+  boundAddress = localAddress;
+  if ((uint32_t)localAddress == 0) {
+    return false;
+  }
+  remoteSocket.begin(REMOTE_PORT);
+  return true;
+}
+
+void remoteDisplayPoll() {
+  if (!remoteSlots || !ensureSocket()) {
+    return;
+  }
+
+  for (uint8_t n = 0; n < REMOTE_PACKETS_PER_POLL; n++) {
+    int length = remoteSocket.parsePacket();
+    if (length <= 0) break;
+    int received = remoteSocket.read(packetBuffer, sizeof(packetBuffer));
+    if (received != length) continue; // oversized datagram, truncated
+    if (remoteJitterPush(jitterBuffer, packetBuffer, received, micros())) {
+      senderAddress = remoteSocket.remoteIP();
+      senderPort = remoteSocket.remotePort();
+    }
+  }
+}
+
+void remoteDisplayRender(uint16_t* frame, int width, int height, bool overlay) {
+  if (!remoteSlots) {
+    return;
+  }
+
+  uint16_t* target = frame;
+  if (overlay) {
+    if (!canvas) {
+      canvas = (uint16_t*)memArenaAlloc("remote display", (size_t)width * height * 2, MEM_TIER_PSRAM); // zeroed
+      if (!canvas) return;
+    }
+    target = canvas;
+  }
+
+  RemoteAck ack;
+  if (remoteJitterApply(jitterBuffer, target, width, height, micros(), ack)) {
+    pendingAck = ack;
+    ackPending = true;
+    ackAppliedMicros = micros();
+  }
+
+  // Overlays are redrawn every frame, so the remote content is restored underneath
+  if (overlay) {
+    memcpy(frame, canvas, (size_t)width * height * 2);
+  }
+}
+
+void remoteDisplayShown() {
+  if (!ackPending || senderPort == 0) {
+    return;
+  }
+
+  // Include decode and panel push time in the device hold time
+  pendingAck.holdMicros += micros() - ackAppliedMicros;
+  remoteSocket.beginPacket(senderAddress, senderPort);
+  remoteSocket.write((const uint8_t*)&pendingAck, sizeof(pendingAck));
+  remoteSocket.endPacket();
+  ackPending = false;
+}
+
+const RemoteStats& remoteDisplayStats() {
+  return jitterBuffer.stats;
+}
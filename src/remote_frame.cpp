@@ -0,0 +1,212 @@
+/*************************************************************
+*********************** REMOTE FRAMES ************************
+**************************************************************/
+
+#include <string.h>
+#include "remote_frame.h"
+#include "rle565.h"
+
+// Wrap-safe frame id comparison
+static inline bool frameBefore(uint32_t a, uint32_t b) {
+  return (int32_t)(a - b) < 0;
+}
+
+static inline const RemotePacketHeader& slotHeader(const RemoteSlot& slot) {
+  return *(const RemotePacketHeader*)slot.data;
+}
+
+// Summary of the packets held for one frame
+struct FrameInfo {
+  uint16_t received;
+  uint16_t expected;
+  uint32_t firstArrival;
+  uint32_t lastArrival;
+  uint32_t senderMicros;
+};
+
+static FrameInfo frameInfo(const RemoteJitterBuffer& buffer, uint32_t frameId) {
+  FrameInfo info = { 0, 0, 0, 0, 0 };
+  for (uint8_t i = 0; i < REMOTE_SLOTS; i++) {
+    const RemoteSlot& slot = buffer.slots[i];
+    if (!slot.used || slotHeader(slot).frameId != frameId) continue;
+    if (info.received == 0 || frameBefore(slot.arrivalMicros, info.firstArrival)) info.firstArrival = slot.arrivalMicros;
+    if (info.received == 0 || frameBefore(info.lastArrival, slot.arrivalMicros)) info.lastArrival = slot.arrivalMicros;
+    info.received++;
+    info.expected = slotHeader(slot).packetCount;
+    info.senderMicros = slotHeader(slot).senderMicros;
+  }
+  return info;
+}
+
+// Function to find the oldest (or, after 'after', the next) frame id held; false if none
+static bool nextFrame(const RemoteJitterBuffer& buffer, bool hasAfter, uint32_t after, uint32_t& frameId) {
+  bool found = false;
+  for (uint8_t i = 0; i < REMOTE_SLOTS; i++) {
+    const RemoteSlot& slot = buffer.slots[i];
+    if (!slot.used) continue;
+    uint32_t id = slotHeader(slot).frameId;
+    if (hasAfter && !frameBefore(after, id)) continue;
+    if (!found || frameBefore(id, frameId)) {
+      frameId = id;
+      found = true;
+    }
+  }
+  return found;
+}
+
+static void releaseFrame(RemoteJitterBuffer& buffer, uint32_t frameId) {
+  for (uint8_t i = 0; i < REMOTE_SLOTS; i++) {
+    RemoteSlot& slot = buffer.slots[i];
+    if (slot.used && slotHeader(slot).frameId == frameId) slot.used = false;
+  }
+}
+
+static void dropFrame(RemoteJitterBuffer& buffer, uint32_t frameId) {
+  releaseFrame(buffer, frameId);
+  buffer.stats.framesDropped++;
+  buffer.needKeyframe = true;
+}
+
+void remoteJitterInit(RemoteJitterBuffer& buffer, RemoteSlot* slots) {
+  memset(&buffer, 0, sizeof(buffer));
+  buffer.slots = slots;
+  for (uint8_t i = 0; i < REMOTE_SLOTS; i++) slots[i].used = false;
+}
+
+bool remoteJitterPush(RemoteJitterBuffer& buffer, const uint8_t* packet, size_t length, uint32_t nowMicros) {
+  const RemotePacketHeader* header = (const RemotePacketHeader*)packet;
+
+  // Validate before touching the buffer
+  bool valid = length >= sizeof(RemotePacketHeader) && length <= REMOTE_MAX_PACKET &&
+               memcmp(header->magic, "NYRD", 4) == 0 && header->version == REMOTE_VERSION &&
+               header->payloadLength == length - sizeof(RemotePacketHeader) &&
+               header->packetIndex < header->packetCount && header->w > 0 && header->h > 0;
+  if (!valid || (buffer.anyShown && !frameBefore(buffer.lastShownFrame, header->frameId))) {
+    buffer.stats.packetsRejected++;
+    return false;
+  }
+
+  // Ignore duplicates and find a free slot
+  RemoteSlot* freeSlot = nullptr;
+  for (uint8_t i = 0; i < REMOTE_SLOTS; i++) {
+    RemoteSlot& slot = buffer.slots[i];
+    if (!slot.used) {
+      if (!freeSlot) freeSlot = &slot;
+    } else if (slotHeader(slot).frameId == header->frameId && slotHeader(slot).packetIndex == header->packetIndex) {
+      buffer.stats.packetsRejected++;
+      return false;
+    }
+  }
+
+  // Buffer full: the oldest frame makes room
+  while (!freeSlot) {
+    uint32_t oldest = 0;
+    if (!nextFrame(buffer, false, 0, oldest) || oldest == header->frameId) {
+      buffer.stats.packetsRejected++; // frame larger than the whole buffer
+      return false;
+    }
+    dropFrame(buffer, oldest);
+    for (uint8_t i = 0; i < REMOTE_SLOTS && !freeSlot; i++) {
+      if (!buffer.slots[i].used) freeSlot = &buffer.slots[i];
+    }
+  }
+
+  memcpy(freeSlot->data, packet, length);
+  freeSlot->length = (uint16_t)length;
+  freeSlot->arrivalMicros = nowMicros;
+  freeSlot->used = true;
+  buffer.stats.packetsReceived++;
+  return true;
+}
+
+// Function to decode one packet's rectangle into the target
+static bool decodePacket(const RemoteSlot& slot, uint16_t* target, int width, int height) {
+  const RemotePacketHeader& header = slotHeader(slot);
+  if (header.x + header.w > width || header.y + header.h > height) {
+    return false;
+  }
+
+  const uint8_t* payload = slot.data + sizeof(RemotePacketHeader);
+  uint16_t* origin = target + header.y * width + header.x;
+  if (header.flags & REMOTE_FLAG_RLE) {
+    return rle565DecodeRect(payload, header.payloadLength, origin, width, header.w, header.h);
+  }
+
+  if (header.payloadLength != (size_t)header.w * header.h * 2) {
+    return false;
+  }
+  for (int row = 0; row < header.h; row++) {
+    memcpy(origin + row * width, payload + row * header.w * 2, header.w * 2);
+  }
+  return true;
+}
+
+bool remoteJitterApply(RemoteJitterBuffer& buffer, uint16_t* target, int width, int height,
+                       uint32_t nowMicros, RemoteAck& ack) {
+  bool applied = false;
+  uint32_t frameId = 0;
+
+  while (nextFrame(buffer, false, 0, frameId)) {
+    FrameInfo info = frameInfo(buffer, frameId);
+
+    if (info.received < info.expected) {
+      // Incomplete: give up on it only once a newer frame is complete
+      bool overtaken = false;
+      uint32_t newer = frameId;
+      while (!overtaken && nextFrame(buffer, true, newer, newer)) {
+        FrameInfo newerInfo = frameInfo(buffer, newer);
+        overtaken = newerInfo.received == newerInfo.expected;
+      }
+      if (!overtaken) break;
+      dropFrame(buffer, frameId);
+      continue;
+    }
+
+    // Complete but still inside the playout delay
+    if (nowMicros - info.firstArrival < REMOTE_JITTER_US) {
+      break;
+    }
+
+    for (uint8_t i = 0; i < REMOTE_SLOTS; i++) {
+      const RemoteSlot& slot = buffer.slots[i];
+      if (slot.used && slotHeader(slot).frameId == frameId && !decodePacket(slot, target, width, height)) {
+        buffer.stats.decodeErrors++;
+        buffer.needKeyframe = true;
+      }
+    }
+    releaseFrame(buffer, frameId);
+
+    buffer.anyShown = true;
+    buffer.lastShownFrame = frameId;
+    buffer.stats.framesShown++;
+    buffer.stats.lastHoldMicros = nowMicros - info.lastArrival;
+
+    memcpy(ack.magic, "NYRA", 4);
+    ack.version = REMOTE_VERSION;
+    ack.flags = buffer.needKeyframe ? REMOTE_ACK_NEED_KEYFRAME : 0;
+    ack.reserved = 0;
+    ack.frameId = frameId;
+    ack.senderMicros = info.senderMicros;
+    ack.holdMicros = nowMicros - info.lastArrival;
+    buffer.needKeyframe = false;
+    applied = true;
+  }
+  return applied;
+}
+
+void remotePacketInit(RemotePacketHeader& header, uint32_t frameId, uint16_t packetIndex, uint16_t packetCount,
+                      uint32_t senderMicros, uint8_t flags, uint16_t x, uint16_t y, uint16_t w, uint16_t h,
+                      uint16_t payloadLength) {
+  memcpy(header.magic, "NYRD", 4);
+  header.version = REMOTE_VERSION;
+  header.flags = flags;
+  header.payloadLength = payloadLength;
+  header.frameId = frameId;
+  header.packetIndex = packetIndex;
+  header.packetCount = packetCount;
+  header.senderMicros = senderMicros;
+  header.x = x;
+  header.y = y;
+  header.w = w;
+  header.h = h;
+}
@@ -0,0 +1,104 @@
+/*************************************************************
+*********************** RLE565 CODEC *************************
+**************************************************************/
+
+#include <string.h>
+#include "rle565.h"
+
+const int RLE_MAX_TOKEN = 128;  // pixels per token
+const int RLE_MIN_RUN = 3;      // shorter repeats are cheaper as literals
+
+// Rectangle walker so runs can span row ends
+struct RectCursor {
+  const uint16_t* row;
+  int stride, w, x;
+};
+
+static inline uint16_t cursorPeek(const RectCursor& c, int ahead) {
+  int x = c.x + ahead;
+  return c.row[(x / c.w) * c.stride + x % c.w];
+}
+
+size_t rle565EncodeRect(const uint16_t* src, int stride, int w, int h, uint8_t* out, size_t capacity) {
+  RectCursor cursor = { src, stride, w, 0 };
+  int remaining = w * h;
+  size_t used = 0;
+
+  while (remaining > 0) {
+    // Measure the run at the cursor
+    uint16_t pixel = cursorPeek(cursor, 0);
+    int run = 1;
+    while (run < remaining && run < RLE_MAX_TOKEN && cursorPeek(cursor, run) == pixel) run++;
+
+    if (run >= RLE_MIN_RUN) {
+      if (used + 3 > capacity) return 0;
+      out[used++] = (uint8_t)(0x80 | (run - 1));
+      memcpy(out + used, &pixel, 2);
+      used += 2;
+      cursor.x += run;
+      remaining -= run;
+      continue;
+    }
+
+    // Literal until the next worthwhile run
+    int literal = 0;
+    while (literal < remaining && literal < RLE_MAX_TOKEN) {
+      uint16_t value = cursorPeek(cursor, literal);
+      int repeat = 1;
+      while (repeat < RLE_MIN_RUN && literal + repeat < remaining &&
+             cursorPeek(cursor, literal + repeat) == value) repeat++;
+      if (repeat >= RLE_MIN_RUN) break;
+      literal++;
+    }
+    if (used + 1 + (size_t)literal * 2 > capacity) return 0;
+    out[used++] = (uint8_t)(literal - 1);
+    for (int i = 0; i < literal; i++) {
+      uint16_t value = cursorPeek(cursor, i);
+      memcpy(out + used, &value, 2);
+      used += 2;
+    }
+    cursor.x += literal;
+    remaining -= literal;
+  }
+  return used;
+}
+
+bool rle565DecodeRect(const uint8_t* in, size_t length, uint16_t* dst, int stride, int w, int h) {
+  const uint8_t* end = in + length;
+  int x = 0, y = 0;
+  uint16_t* row = dst;
+
+  while (y < h) {
+    if (in >= end) return false;
+    uint8_t token = *in++;
+    int count = (token & 0x7F) + 1;
+    bool isRun = token & 0x80;
+    uint16_t pixel = 0;
+    if (isRun) {
+      if (end - in < 2) return false;
+      memcpy(&pixel, in, 2);
+      in += 2;
+    } else if (end - in < count * 2) {
+      return false;
+    }
+
+    // Emit, wrapping to the next row at the rectangle edge
+    while (count > 0) {
+      int span = count < w - x ? count : w - x;
+      if (isRun) {
+        for (int i = 0; i < span; i++) row[x + i] = pixel;
+      } else {
+        memcpy(row + x, in, span * 2);
+        in += span * 2;
+      }
+      x += span;
+      count -= span;
+      if (x == w) {
+        x = 0;
+        row += stride;
+        if (++y == h) return count == 0;
+      }
+    }
+  }
+  return true;
+}
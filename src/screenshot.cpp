@@ -0,0 +1,152 @@
+/*************************************************************
+************************ SCREENSHOTS *************************
+**************************************************************/
+
+#include <Arduino.h>
+#include "screenshot.h"
+#include "screenshot_codec.h"
+#include "web_server.h"
+#include "console.h"
+#include "mem_arena.h"
+
+const size_t SCREENSHOT_LINE_BYTES = 57; // raw bytes per serial line (76 base64 characters)
+
+// Who is reading the current capture
+typedef enum {
+  CAPTURE_IDLE,
+  CAPTURE_HTTP,
+  CAPTURE_SERIAL
+} capture_owner_t;
+
+// Framebuffer being captured
+static const uint16_t* sourceBuffer = nullptr;
+static int sourceWidth = 0, sourceHeight = 0;
+
+// Capture in progress
+static capture_owner_t captureOwner = CAPTURE_IDLE;
+static unsigned long captureLastUse = 0;
+static uint16_t* snapshot = nullptr;
+static uint8_t* chunk = nullptr;
+static ScreenshotEncoder encoder;
+
+// Serial output position inside the current piece
+static size_t chunkLength = 0, chunkOffset = 0;
+
+// Function to end a capture (the buffers stay reserved for the next one)
+static void releaseCapture() {
+  captureOwner = CAPTURE_IDLE;
+}
+
+// Function to copy the framebuffer and start encoding; false if busy or out of memory
+static bool startCapture(capture_owner_t owner) {
+  if (captureOwner != CAPTURE_IDLE) {
+    if (millis() - captureLastUse < SCREENSHOT_STALE_MS) {
+      return false;
+    }
+    releaseCapture();
+  }
+
+  size_t bytes = (size_t)sourceWidth * sourceHeight * 2;
+  if (!snapshot || !chunk) {
+    return false;
+  }
+
+  memcpy(snapshot, sourceBuffer, bytes);
+  screenshotEncoderInit(encoder, snapshot, sourceWidth, sourceHeight, SCREENSHOT_FLAG_SWAPPED, chunk);
+  captureOwner = owner;
+  captureLastUse = millis();
+  chunkLength = chunkOffset = 0;
+  return true;
+}
+
+// GET /screenshot handler
+static bool handleScreenshot(WebConnection& conn) {
+  if (conn.handlerCalls == 0) {
+    if (!startCapture(CAPTURE_HTTP)) {
+      webSendText(conn, 503, "screenshot busy\n");
+      return false;
+    }
+    webSendHeader(conn, 200, "application/octet-stream", true);
+  }
+
+  if (captureOwner != CAPTURE_HTTP || !conn.client.connected()) {
+    if (captureOwner == CAPTURE_HTTP) releaseCapture();
+    return false;
+  }
+
+  for (uint8_t sent = 0; sent < SCREENSHOT_CHUNKS_PER_POLL; sent++) {
+    size_t length = screenshotEncodeNext(encoder);
+    if (length == 0) {
+      webEndChunks(conn);
+      releaseCapture();
+      return false;
+    }
+    webSendChunk(conn, chunk, length);
+  }
+  captureLastUse = millis();
+  return true;
+}
+
+// Function to print bytes as one base64 line
+static void printBase64Line(Print& out, const uint8_t* data, size_t length) {
+  static const char alphabet[] = "ABCDEFGHIJKLMNOPQRSTUVWXYZabcdefghijklmnopqrstuvwxyz0123456789+/";
+  char line[5 + (SCREENSHOT_LINE_BYTES + 2) / 3 * 4 + 1] = "SHOT ";
+  char* cursor = line + 5;
+  for (size_t i = 0; i < length; i += 3) {
+    uint32_t group = (uint32_t)data[i] << 16;
+    if (i + 1 < length) group |= data[i + 1] << 8;
+    if (i + 2 < length) group |= data[i + 2];
+    *cursor++ = alphabet[(group >> 18) & 0x3F];
+    *cursor++ = alphabet[(group >> 12) & 0x3F];
+    *cursor++ = i + 1 < length ? alphabet[(group >> 6) & 0x3F] : '=';
+    *cursor++ = i + 2 < length ? alphabet[group & 0x3F] : '=';
+  }
+  *cursor = '\0';
+  out.println(line);
+}
+
+// Console stream step: one base64 line per call
+static bool screenshotSerialStep(Print& out, uint32_t index) {
+  if (captureOwner != CAPTURE_SERIAL) {
+    return false; // taken over after going stale
+  }
+  if (index == 0) {
+    out.printf("SHOT BEGIN %dx%d\n", sourceWidth, sourceHeight);
+    return true;
+  }
+
+  if (chunkOffset == chunkLength) {
+    chunkLength = screenshotEncodeNext(encoder);
+    chunkOffset = 0;
+    if (chunkLength == 0) {
+      out.println("SHOT END");
+      releaseCapture();
+      return false;
+    }
+  }
+
+  size_t length = min(chunkLength - chunkOffset, SCREENSHOT_LINE_BYTES);
+  printBase64Line(out, chunk + chunkOffset, length);
+  chunkOffset += length;
+  captureLastUse = millis();
+  return true;
+}
+
+// Console "screenshot" command
+static void consoleScreenshot(int argc, char** argv) {
+  if (!startCapture(CAPTURE_SERIAL)) {
+    Serial.println("screenshot busy");
+    return;
+  }
+  consoleStream(screenshotSerialStep);
+}
+
+void screenshotBegin(const uint16_t* buffer, int width, int height) {
+  sourceBuffer = buffer;
+  sourceWidth = width;
+  sourceHeight = height;
+  snapshot = (uint16_t*)memArenaAlloc("screenshot", (size_t)width * height * 2, MEM_TIER_PSRAM);
+  chunk = (uint8_t*)memArenaAlloc("screenshot", screenshotChunkCapacity(width), MEM_TIER_INTERNAL);
+  webServerOn("GET", "/screenshot", handleScreenshot);
+  consoleRegister("screenshot", "capture the screen as base64 (decode with tools/screenshot_png)", consoleScreenshot);
+}
@@ -0,0 +1,122 @@
+/*************************************************************
+********************* SCREENSHOT CODEC ***********************
+**************************************************************/
+
+#include <string.h>
+#include "screenshot_codec.h"
+#include "rle565.h"
+#include "anim_container.h" // crc32Update
+
+size_t screenshotChunkCapacity(int width) {
+  size_t band = 2 + rle565MaxSize((size_t)width * SCREENSHOT_BAND_ROWS);
+  return band > sizeof(ScreenshotHeader) ? band : sizeof(ScreenshotHeader);
+}
+
+void screenshotEncoderInit(ScreenshotEncoder& encoder, const uint16_t* pixels, int width, int height,
+                           uint8_t flags, uint8_t* out) {
+  encoder.pixels = pixels;
+  encoder.width = width;
+  encoder.height = height;
+  encoder.flags = flags;
+  encoder.nextBand = -1;
+  encoder.bandCount = (height + SCREENSHOT_BAND_ROWS - 1) / SCREENSHOT_BAND_ROWS;
+  encoder.finished = false;
+  encoder.crc = 0;
+  encoder.out = out;
+}
+
+size_t screenshotEncodeNext(ScreenshotEncoder& encoder) {
+  if (encoder.finished) {
+    return 0;
+  }
+
+  if (encoder.nextBand < 0) {
+    ScreenshotHeader header;
+    memcpy(header.magic, "NYSS", 4);
+    header.version = SCREENSHOT_VERSION;
+    header.flags = encoder.flags;
+    header.bandRows = SCREENSHOT_BAND_ROWS;
+    header.width = encoder.width;
+    header.height = encoder.height;
+    memcpy(encoder.out, &header, sizeof(header));
+    encoder.nextBand = 0;
+    return sizeof(header);
+  }
+
+  if (encoder.nextBand == encoder.bandCount) {
+    ScreenshotTrailer trailer;
+    memcpy(trailer.magic, "NYSE", 4);
+    trailer.pixelCrc32 = encoder.crc;
+    memcpy(encoder.out, &trailer, sizeof(trailer));
+    encoder.finished = true;
+    return sizeof(trailer);
+  }
+
+  int firstRow = encoder.nextBand * SCREENSHOT_BAND_ROWS;
+  int rows = encoder.height - firstRow < SCREENSHOT_BAND_ROWS ? encoder.height - firstRow : SCREENSHOT_BAND_ROWS;
+  const uint16_t* band = encoder.pixels + (size_t)firstRow * encoder.width;
+  encoder.crc = crc32Update(encoder.crc, band, (size_t)rows * encoder.width * 2);
+
+  size_t capacity = screenshotChunkCapacity(encoder.width) - 2;
+  uint16_t length = (uint16_t)rle565EncodeRect(band, encoder.width, encoder.width, rows, encoder.out + 2, capacity);
+  memcpy(encoder.out, &length, 2);
+  encoder.nextBand++;
+  return 2 + length;
+}
+
+bool screenshotReadHeader(const uint8_t* data, size_t length, int& width, int& height) {
+  if (length < sizeof(ScreenshotHeader)) {
+    return false;
+  }
+  ScreenshotHeader header;
+  memcpy(&header, data, sizeof(header));
+  if (memcmp(header.magic, "NYSS", 4) != 0 || header.version != SCREENSHOT_VERSION ||
+      header.bandRows == 0 || header.width == 0 || header.height == 0) {
+    return false;
+  }
+  width = header.width;
+  height = header.height;
+  return true;
+}
+
+bool screenshotDecode(const uint8_t* data, size_t length, uint16_t* pixels) {
+  int width, height;
+  if (!screenshotReadHeader(data, length, width, height)) {
+    return false;
+  }
+  ScreenshotHeader header;
+  memcpy(&header, data, sizeof(header));
+  size_t offset = sizeof(header);
+
+  uint32_t crc = 0;
+  for (int firstRow = 0; firstRow < height; firstRow += header.bandRows) {
+    int rows = height - firstRow < header.bandRows ? height - firstRow : header.bandRows;
+    uint16_t bandLength;
+    if (offset + 2 > length) return false;
+    memcpy(&bandLength, data + offset, 2);
+    offset += 2;
+    if (offset + bandLength > length) return false;
+
+    uint16_t* band = pixels + (size_t)firstRow * width;
+    if (!rle565DecodeRect(data + offset, bandLength, band, width, width, rows)) {
+      return false;
+    }
+    crc = crc32Update(crc, band, (size_t)rows * width * 2);
+    offset += bandLength;
+  }
+
+  ScreenshotTrailer trailer;
+  if (offset + sizeof(trailer) > length) return false;
+  memcpy(&trailer, data + offset, sizeof(trailer));
+  if (memcmp(trailer.magic, "NYSE", 4) != 0 || trailer.pixelCrc32 != crc) {
+    return false;
+  }
+
+  // Back to native byte order
+  if (header.flags & SCREENSHOT_FLAG_SWAPPED) {
+    for (size_t i = 0; i < (size_t)width * height; i++) {
+      pixels[i] = (uint16_t)((pixels[i] << 8) | (pixels[i] >> 8));
+    }
+  }
+  return true;
+}
@@ -0,0 +1,78 @@
+/*************************************************************
+************************ SYNC CLOCK **************************
+**************************************************************/
+
+#include <string.h>
+#include "sync_clock.h"
+
+void syncBeaconInit(SyncBeacon& beacon, uint32_t sequence, uint32_t leaderMillis,
+                    uint32_t epochMillis, uint32_t framePeriodUs, uint16_t frameCount) {
+  memset(&beacon, 0, sizeof(beacon));
+  memcpy(beacon.magic, "NYSY", 4);
+  beacon.version = SYNC_VERSION;
+  beacon.sequence = sequence;
+  beacon.leaderMillis = leaderMillis;
+  beacon.epochMillis = epochMillis;
+  beacon.framePeriodUs = framePeriodUs;
+  beacon.frameCount = frameCount;
+}
+
+bool syncBeaconValid(const void* data, int length) {
+  const SyncBeacon* beacon = (const SyncBeacon*)data;
+  return length == (int)sizeof(SyncBeacon) && memcmp(beacon->magic, "NYSY", 4) == 0 &&
+         beacon->version == SYNC_VERSION && beacon->framePeriodUs > 0 && beacon->frameCount > 0;
+}
+
+void syncClockReset(SyncClock& clock) {
+  memset(&clock, 0, sizeof(clock));
+}
+
+void syncClockSample(SyncClock& clock, const SyncBeacon& beacon, uint32_t localMillis) {
+  // Newest sample replaces the oldest
+  int32_t sample = (int32_t)(beacon.leaderMillis - localMillis);
+  clock.samples[clock.nextSample] = sample;
+  clock.nextSample = (clock.nextSample + 1) % SYNC_WINDOW;
+  if (clock.sampleCount < SYNC_WINDOW) clock.sampleCount++;
+
+  // Least delayed sample in the window
+  int32_t target = clock.samples[0];
+  for (uint8_t i = 1; i < clock.sampleCount; i++) {
+    if (clock.samples[i] > target) target = clock.samples[i];
+  }
+
+  // Step on first lock or large error, otherwise slew
+  int32_t error = target - clock.offset;
+  if (!clock.locked || error > SYNC_STEP_MS || error < -SYNC_STEP_MS) {
+    clock.offset = target;
+  } else if (error > SYNC_SLEW_MS) {
+    clock.offset += SYNC_SLEW_MS;
+  } else if (error < -SYNC_SLEW_MS) {
+    clock.offset -= SYNC_SLEW_MS;
+  } else {
+    clock.offset = target;
+  }
+
+  // Timeline changes on the leader restart the filter window
+  if (clock.locked && (clock.epochMillis != beacon.epochMillis || clock.framePeriodUs != beacon.framePeriodUs)) {
+    clock.sampleCount = 1;
+    clock.samples[0] = sample;
+    clock.nextSample = 1;
+    clock.offset = sample;
+  }
+
+  clock.epochMillis = beacon.epochMillis;
+  clock.framePeriodUs = beacon.framePeriodUs;
+  clock.frameCount = beacon.frameCount;
+  clock.lastBeaconMillis = localMillis;
+  clock.locked = true;
+}
+
+uint64_t syncClockTimelineMicros(const SyncClock& clock, uint32_t localMillis) {
+  uint32_t leaderMillis = localMillis + (uint32_t)clock.offset;
+  return (uint64_t)(uint32_t)(leaderMillis - clock.epochMillis) * 1000;
+}
+
+uint16_t syncClockFrame(const SyncClock& clock, uint32_t localMillis) {
+  if (!clock.locked) return 0;
+  return (uint16_t)((syncClockTimelineMicros(clock, localMillis) / clock.framePeriodUs) % clock.frameCount);
+}
@@ -0,0 +1,41 @@
+/*************************************************************
+*********************** TICK LATENCY *************************
+**************************************************************/
+
+#include <string.h>
+#include "tick_latency.h"
+
+void tickLatencyInit(TickLatency& tick) {
+  memset(&tick, 0, sizeof(tick));
+}
+
+void tickLatencyFrame(TickLatency& tick, uint32_t renderMicros) {
+  tick.renderMicros[tick.renderNext] = renderMicros;
+  tick.renderNext = (tick.renderNext + 1) % TICK_LEAD_FRAMES;
+  if (tick.renderCount < TICK_LEAD_FRAMES) tick.renderCount++;
+}
+
+uint32_t tickLatencyLeadMicros(const TickLatency& tick) {
+  if (tick.renderCount == 0) return 0;
+  uint32_t shortest = tick.renderMicros[0];
+  for (uint8_t i = 1; i < tick.renderCount; i++) {
+    if (tick.renderMicros[i] < shortest) shortest = tick.renderMicros[i];
+  }
+  return shortest < TICK_LEAD_MAX_US ? shortest : TICK_LEAD_MAX_US;
+}
+
+void tickLatencyShown(TickLatency& tick, int32_t latencyMicros) {
+  TickLatencyStats& stats = tick.stats;
+  if (stats.ticks == 0 || latencyMicros < stats.minMicros) stats.minMicros = latencyMicros;
+  if (stats.ticks == 0 || latencyMicros > stats.maxMicros) stats.maxMicros = latencyMicros;
+  stats.ticks++;
+  stats.lastMicros = latencyMicros;
+  stats.totalMicros += latencyMicros;
+  if (latencyMicros < 0) stats.early++;
+
+  uint8_t bucket = 0;
+  while (bucket < TICK_HISTOGRAM_BUCKETS && latencyMicros > (int32_t)TICK_HISTOGRAM_BOUNDS_US[bucket]) {
+    bucket++;
+  }
+  stats.histogram[bucket]++;
+}
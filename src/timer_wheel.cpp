@@ -0,0 +1,222 @@
+/*************************************************************
+************************ TIMER WHEEL *************************
+**************************************************************/
+
+#include <string.h>
+#include "timer_wheel.h"
+
+const uint32_t SLOT_MASK = TIMER_WHEEL_SLOTS - 1;
+const uint32_t WHEEL_SPAN = 1u << (TIMER_WHEEL_SLOT_BITS * TIMER_WHEEL_LEVELS); // ms covered by all levels
+
+// Function to get the slot index of time at a level
+static inline uint8_t slotOf(uint32_t time, uint8_t level) {
+  return (time >> (TIMER_WHEEL_SLOT_BITS * level)) & SLOT_MASK;
+}
+
+// Function to find the first occupied slot at or after start (wrapping around); -1 if the level is empty
+static int firstOccupied(uint64_t bits, uint8_t start) {
+  if (!bits) return -1;
+  uint64_t rotated = start ? (bits >> start) | (bits << (TIMER_WHEEL_SLOTS - start)) : bits;
+  return (start + __builtin_ctzll(rotated)) & SLOT_MASK;
+}
+
+// Function to put an armed timer into the slot for its deadline
+static void place(TimerWheel& wheel, Timer& timer) {
+  uint32_t delta = timer.deadline - wheel.next;
+  uint32_t position = timer.deadline;
+  if ((int32_t)delta < 0) {
+    delta = 0;
+    position = wheel.next;            // overdue: first tick processed
+  } else if (delta >= WHEEL_SPAN) {
+    position = wheel.next + WHEEL_SPAN - 1; // beyond the wheel: last slot of the top level
+    delta = WHEEL_SPAN - 1;
+  }
+  uint8_t level = 0;
+  while (level < TIMER_WHEEL_LEVELS - 1 && delta >= (1u << (TIMER_WHEEL_SLOT_BITS * (level + 1)))) {
+    level++;
+  }
+  uint8_t slot = slotOf(position, level);
+
+  Timer*& head = wheel.slots[level][slot];
+  timer.prev = nullptr;
+  timer.next = head;
+  if (head) head->prev = &timer;
+  head = &timer;
+  timer.level = level;
+  timer.slot = slot;
+  wheel.occupied[level] |= 1ull << slot;
+}
+
+// Function to get the list a timer is in: its slot, or the due list while its tick is expired
+static inline Timer*& listOf(TimerWheel& wheel, const Timer& timer) {
+  return timer.level == TIMER_DUE_LEVEL ? wheel.due : wheel.slots[timer.level][timer.slot];
+}
+
+// Function to take a timer out of its slot (or the due list)
+static void unlink(TimerWheel& wheel, Timer& timer) {
+  Timer*& head = listOf(wheel, timer);
+  if (timer.prev) {
+    timer.prev->next = timer.next;
+  } else {
+    head = timer.next;
+  }
+  if (timer.next) timer.next->prev = timer.prev;
+  if (timer.level != TIMER_DUE_LEVEL && !head) {
+    wheel.occupied[timer.level] &= ~(1ull << timer.slot);
+  }
+  timer.next = timer.prev = nullptr;
+}
+
+// Function to spread the slot of a level that the wheel has just reached over the levels below
+static void cascade(TimerWheel& wheel, uint8_t level) {
+  uint8_t slot = slotOf(wheel.next, level);
+  Timer* timer = wheel.slots[level][slot];
+  wheel.slots[level][slot] = nullptr;
+  wheel.occupied[level] &= ~(1ull << slot);
+  while (timer) {
+    Timer* following = timer->next;
+    place(wheel, *timer);
+    timer = following;
+  }
+}
+
+// Function to move the wheel to tick next; when level 0 wraps there, bring down the next slot of
+// level 1 (and of the levels above, if they wrapped too), so the current slots above level 0 stay empty
+static void moveTo(TimerWheel& wheel, uint32_t next) {
+  wheel.next = next;
+  if (slotOf(next, 0) != 0) return;
+  for (uint8_t level = 1; level < TIMER_WHEEL_LEVELS; level++) {
+    cascade(wheel, level);
+    if (slotOf(next, level) != 0) break;
+  }
+}
+
+// Function to run the level 0 slot of a tick: moved to the due list and taken off it one timer at a
+// time, so a callback that cancels or re-arms another timer of the same tick unlinks it from there
+static uint32_t expire(TimerWheel& wheel, uint8_t slot) {
+  wheel.due = wheel.slots[0][slot];
+  wheel.slots[0][slot] = nullptr;
+  wheel.occupied[0] &= ~(1ull << slot);
+  for (Timer* timer = wheel.due; timer; timer = timer->next) {
+    timer->level = TIMER_DUE_LEVEL;
+  }
+
+  uint32_t count = 0;
+  while (Timer* timer = wheel.due) {
+    timerCancel(wheel, *timer);
+    if (timer->period) {
+      // Next deadline on the timer's own schedule, skipping whole periods already missed
+      uint32_t late = wheel.now - timer->deadline;
+      uint32_t deadline = timer->deadline + (late / timer->period + 1) * timer->period;
+      timerArmAt(wheel, *timer, deadline, timer->period);
+    }
+    timer->callback(timer->context);
+    wheel.fired++;
+    count++;
+  }
+  return count;
+}
+
+void timerWheelInit(TimerWheel& wheel, uint32_t now) {
+  memset(&wheel, 0, sizeof(wheel));
+  wheel.now = now;
+  moveTo(wheel, now + 1);
+}
+
+void timerInit(Timer& timer, const char* name, timer_callback_t callback, void* context) {
+  memset(&timer, 0, sizeof(timer));
+  timer.name = name;
+  timer.callback = callback;
+  timer.context = context;
+}
+
+void timerArm(TimerWheel& wheel, Timer& timer, uint32_t delayMillis, uint32_t periodMillis) {
+  timerArmAt(wheel, timer, wheel.now + delayMillis, periodMillis);
+}
+
+void timerArmAt(TimerWheel& wheel, Timer& timer, uint32_t deadline, uint32_t periodMillis) {
+  timerCancel(wheel, timer);
+  timer.deadline = deadline;
+  timer.period = periodMillis;
+  timer.armed = true;
+  wheel.armedCount++;
+  place(wheel, timer);
+}
+
+void timerCancel(TimerWheel& wheel, Timer& timer) {
+  if (!timer.armed) return;
+  unlink(wheel, timer);
+  timer.armed = false;
+  wheel.armedCount--;
+}
+
+uint32_t timerRemaining(const TimerWheel& wheel, const Timer& timer) {
+  if (!timer.armed) return 0;
+  int32_t remaining = (int32_t)(timer.deadline - wheel.now);
+  return remaining > 0 ? remaining : 0;
+}
+
+uint32_t timerWheelAdvance(TimerWheel& wheel, uint32_t now) {
+  wheel.now = now;
+  uint32_t count = 0;
+  while ((int32_t)(now - wheel.next) >= 0) {
+    // First occupied level 0 slot in the rest of this revolution, up to now
+    uint32_t revolutionEnd = wheel.next | SLOT_MASK;
+    uint32_t limit = (int32_t)(now - revolutionEnd) < 0 ? now : revolutionEnd;
+    uint8_t start = slotOf(wheel.next, 0);
+    uint64_t ahead = wheel.occupied[0] & (~0ull << start);
+    uint32_t tick = ahead ? (wheel.next & ~SLOT_MASK) | __builtin_ctzll(ahead) : 0;
+    if (!ahead || (int32_t)(limit - tick) < 0) {
+      moveTo(wheel, limit + 1); // nothing due before the limit
+      continue;
+    }
+
+    moveTo(wheel, tick + 1); // re-arming for tick or earlier lands on the next tick
+    count += expire(wheel, slotOf(tick, 0));
+  }
+  return count;
+}
+
+bool timerWheelNextDeadline(const TimerWheel& wheel, uint32_t& deadline) {
+  bool found = false;
+  for (const Timer* timer = wheel.due; timer; timer = timer->next) { // asked from a callback
+    if (!found || (int32_t)(timer->deadline - deadline) < 0) {
+      deadline = timer->deadline;
+      found = true;
+    }
+  }
+  for (uint8_t level = 0; level < TIMER_WHEEL_LEVELS; level++) {
+    // Slots come round in time order from the current one (level 0) or the one after it (above, the
+    // current slot was spread out when the wheel reached it and only takes deadlines a full turn ahead).
+    // The top level also holds deadlines beyond the wheel, out of order: all its slots are looked at
+    bool top = level == TIMER_WHEEL_LEVELS - 1;
+    uint64_t remaining = wheel.occupied[level];
+    uint8_t start = (slotOf(wheel.next, level) + (level ? 1 : 0)) & SLOT_MASK;
+    int slot;
+    while ((slot = firstOccupied(remaining, start)) >= 0) {
+      for (const Timer* timer = wheel.slots[level][slot]; timer; timer = timer->next) {
+        if (!found || (int32_t)(timer->deadline - deadline) < 0) {
+          deadline = timer->deadline;
+          found = true;
+        }
+      }
+      if (!top) break;
+      remaining &= ~(1ull << slot);
+    }
+  }
+  return found;
+}
+
+void timerSave(const Timer& timer, TimerSnapshot& snapshot) {
+  snapshot.deadline = timer.deadline;
+  snapshot.period = timer.period;
+  snapshot.armed = timer.armed;
+}
+
+void timerRestore(TimerWheel& wheel, Timer& timer, const TimerSnapshot& snapshot) {
+  if (snapshot.armed) {
+    timerArmAt(wheel, timer, snapshot.deadline, snapshot.period);
+  } else {
+    timerCancel(wheel, timer);
+  }
+}
@@ -0,0 +1,236 @@
+/*************************************************************
+************************ WEB SERVER **************************
+**************************************************************/
+
+#include "web_server.h"
+
+// Route table (fixed size, filled at startup)
+struct WebRoute {
+  const char* method;
+  const char* path;
+  WebHandler handler;
+};
+
+const uint8_t WEB_MAX_ROUTES = 8;
+static WebRoute routes[WEB_MAX_ROUTES];
+static uint8_t routeCount = 0;
+
+static WiFiServer server(WEB_SERVER_PORT);
+static WebConnection connections[WEB_MAX_CONNECTIONS];
+static uint8_t nextConnection = 0; // round-robin start so one client can't hog the budget
+
+bool webServerOn(const char* method, const char* path, WebHandler handler) {
+  if (routeCount >= WEB_MAX_ROUTES) {
+    return false;
+  }
+  routes[routeCount++] = { method, path, handler };
+  return true;
+}
+
+void webServerBegin() {
+  server.begin();
+  server.setNoDelay(true);
+}
+
+// Function to release a connection slot
+static void closeConnection(WebConnection& conn) {
+  conn.client.stop();
+  conn.state = WEB_CONN_FREE;
+}
+
+// Function to find the handler for a parsed request
+static WebHandler findRoute(const WebConnection& conn) {
+  for (uint8_t i = 0; i < routeCount; i++) {
+    if (strcmp(routes[i].method, conn.method) == 0 && strcmp(routes[i].path, conn.path) == 0) {
+      return routes[i].handler;
+    }
+  }
+  return nullptr;
+}
+
+// Function to parse one complete header line; returns true on the blank line ending the headers
+static bool parseHeaderLine(WebConnection& conn) {
+  conn.line[conn.lineLength] = '\0';
+
+  // Blank line: headers complete
+  if (conn.lineLength == 0) {
+    return true;
+  }
+
+  // Request line: "METHOD /path?query HTTP/1.1"
+  if (conn.method[0] == '\0') {
+    char* space = strchr(conn.line, ' ');
+    if (!space) return false;
+    size_t methodLength = space - conn.line;
+    if (methodLength >= sizeof(conn.method)) methodLength = sizeof(conn.method) - 1;
+    memcpy(conn.method, conn.line, methodLength);
+    conn.method[methodLength] = '\0';
+
+    char* path = space + 1;
+    size_t pathLength = strcspn(path, " ?");
+    if (pathLength >= sizeof(conn.path)) pathLength = sizeof(conn.path) - 1;
+    memcpy(conn.path, path, pathLength);
+    conn.path[pathLength] = '\0';
+    return false;
+  }
+
+  // Only Content-Length matters to the handlers
+  if (strncasecmp(conn.line, "Content-Length:", 15) == 0) {
+    conn.contentLength = strtoul(conn.line + 15, nullptr, 10);
+  }
+  return false;
+}
+
+// Function to read request headers without blocking; returns true once complete
+static bool readHeaders(WebConnection& conn) {
+  while (conn.client.available()) {
+    int c = conn.client.read();
+    if (c < 0) break;
+    conn.lastActivity = millis();
+
+    if (c == '\r') continue;
+    if (c == '\n') {
+      bool done = parseHeaderLine(conn);
+      conn.lineLength = 0;
+      if (done) return true;
+      continue;
+    }
+
+    // Overlong lines are truncated (only the start of each line is parsed)
+    if (conn.lineLength < sizeof(conn.line) - 1) {
+      conn.line[conn.lineLength++] = (char)c;
+    }
+  }
+  return false;
+}
+
+// Function to service one connection for a single step
+static void serviceConnection(WebConnection& conn) {
+  if (!conn.client.connected() && !conn.client.available()) {
+    closeConnection(conn);
+    return;
+  }
+
+  // A running handler that moved no data for a while (client stopped sending or reading) frees its slot
+  if (conn.state == WEB_CONN_HANDLER && millis() - conn.lastActivity > WEB_IDLE_TIMEOUT) {
+    closeConnection(conn);
+    return;
+  }
+
+  if (conn.state == WEB_CONN_HEADERS) {
+    if (!readHeaders(conn)) {
+      if (millis() - conn.lastActivity > WEB_IDLE_TIMEOUT) closeConnection(conn);
+      return;
+    }
+    conn.state = WEB_CONN_HANDLER;
+  }
+
+  WebHandler handler = findRoute(conn);
+  if (!handler) {
+    webSendText(conn, 404, "not found\n");
+    closeConnection(conn);
+    return;
+  }
+
+  bool active = handler(conn);
+  conn.handlerCalls++;
+  if (!active) {
+    closeConnection(conn);
+  }
+}
+
+void webServerPoll() {
+  unsigned long start = micros();
+
+  // Accept new clients into free slots
+  WiFiClient incoming = server.available();
+  if (incoming) {
+    bool placed = false;
+    for (uint8_t i = 0; i < WEB_MAX_CONNECTIONS; i++) {
+      WebConnection& conn = connections[i];
+      if (conn.state != WEB_CONN_FREE) continue;
+      conn.client = incoming;
+      conn.client.setNoDelay(true);
+      conn.state = WEB_CONN_HEADERS;
+      conn.method[0] = '\0';
+      conn.path[0] = '\0';
+      conn.lineLength = 0;
+      conn.contentLength = 0;
+      conn.handlerCalls = 0;
+      conn.lastActivity = millis();
+      memset(conn.scratch, 0, sizeof(conn.scratch));
+      placed = true;
+      break;
+    }
+    if (!placed) {
+      incoming.stop(); // pool exhausted
+    }
+  }
+
+  // Service active connections round-robin until the budget runs out
+  for (uint8_t n = 0; n < WEB_MAX_CONNECTIONS; n++) {
+    WebConnection& conn = connections[(nextConnection + n) % WEB_MAX_CONNECTIONS];
+    if (conn.state == WEB_CONN_FREE) continue;
+    serviceConnection(conn);
+    if (micros() - start > WEB_POLL_BUDGET_US) break;
+  }
+  nextConnection = (nextConnection + 1) % WEB_MAX_CONNECTIONS;
+}
+
+
+/*************************************************************
+********************* RESPONSE HELPERS ***********************
+**************************************************************/
+
+// Function to get the reason phrase for the status codes used here
+static const char* statusText(int status) {
+  switch (status) {
+    case 200: return "OK";
+    case 201: return "Created";
+    case 400: return "Bad Request";
+    case 404: return "Not Found";
+    case 409: return "Conflict";
+    case 413: return "Payload Too Large";
+    case 500: return "Internal Server Error";
+    case 503: return "Service Unavailable";
+    default: return "Error";
+  }
+}
+
+void webSendHeader(WebConnection& conn, int status, const char* contentType, bool chunked) {
+  char header[160];
+  int length = snprintf(header, sizeof(header),
+                        "HTTP/1.1 %d %s\r\nContent-Type: %s\r\n%sCache-Control: no-cache\r\nConnection: close\r\n\r\n",
+                        status, statusText(status), contentType,
+                        chunked ? "Transfer-Encoding: chunked\r\n" : "");
+  conn.client.write((const uint8_t*)header, length);
+  conn.lastActivity = millis();
+}
+
+void webSendChunk(WebConnection& conn, const void* data, size_t length) {
+  webSendChunkParts(conn, data, length, nullptr, 0);
+}
+
+void webSendChunkParts(WebConnection& conn, const void* a, size_t aLength, const void* b, size_t bLength) {
+  if (aLength + bLength == 0) return; // a zero-length chunk would end the response
+  char size[12];
+  int sizeLength = snprintf(size, sizeof(size), "%X\r\n", (unsigned)(aLength + bLength));
+  conn.client.write((const uint8_t*)size, sizeLength);
+  if (aLength) conn.client.write((const uint8_t*)a, aLength);
+  if (bLength) conn.client.write((const uint8_t*)b, bLength);
+  conn.client.write((const uint8_t*)"\r\n", 2);
+  conn.lastActivity = millis();
+}
+
+void webEndChunks(WebConnection& conn) {
+  conn.client.write((const uint8_t*)"0\r\n\r\n", 5);
+}
+
+void webSendText(WebConnection& conn, int status, const char* text) {
+  webSendHeader(conn, status, "text/plain", false);
+  conn.client.write((const uint8_t*)text, strlen(text));
+}
+
+bool webConnectionServes(const WebConnection* conn, const char* method, const char* path) {
+  return conn && conn->state == WEB_CONN_HANDLER && strcmp(conn->method, method) == 0 && strcmp(conn->path, path) == 0;
+}
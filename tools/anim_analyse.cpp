@@ -0,0 +1,337 @@
+/*************************************************************
+******************** ANIMATION ANALYSER (HOST) ***************
+**************************************************************/
+
+/*
+Per-frame statistics of an animation, to choose its encoding from data:
+
+  anim_analyse [--tile N] [--json FILE] include/nyancat.h
+  anim_analyse --json - cat.nyan > cat.json
+
+For every frame:
+ - pixels changed against the previous frame, and their bounding box
+   (frame 0 against the last one: playback loops)
+ - unique colours
+ - run-length distribution: maximal runs of one colour, rows continued
+   as in an RLE565 stream, in power-of-two buckets
+ - NxN tiles (default 16) unchanged from the previous frame, and tiles
+   repeating one seen earlier anywhere in the animation
+ - estimated bytes under each candidate codec:
+     raw565   2 bytes per pixel
+     rle565   the RLE565 stream and its offset, exactly as anim_pack --rle stores it
+     pal8     1 byte per pixel, plus the palette once (lossless only for
+              animations of at most 256 colours; anim_import --pal8 otherwise)
+     delta    the changed rectangle as RGB565 with an 8-byte rectangle
+              header; frame 0 is a whole key frame
+     tiles    tiles not seen before as RGB565, plus a 2-byte index per tile
+
+and a summary for the whole animation. A table goes to stdout; --json
+writes the same as JSON ("-" for stdout, in place of the table).
+*/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unordered_set>
+#include "asset_cache.h"
+#include "frame_source.h"
+
+const int DEFAULT_TILE = 16;
+const int RUN_BUCKETS = 9; // 1, 2, 3-4, 5-8, ... 129+
+const int DELTA_RECT_BYTES = 8;
+const int TILE_INDEX_BYTES = 2;
+
+static const char* RUN_BUCKET_NAMES[RUN_BUCKETS] = { "1", "2", "3-4", "5-8", "9-16", "17-32", "33-64", "65-128", "129+" };
+
+typedef enum {
+  CODEC_RAW565,
+  CODEC_RLE565,
+  CODEC_PAL8,
+  CODEC_DELTA,
+  CODEC_TILES,
+  CODEC_COUNT
+} codec_t;
+
+static const char* CODEC_NAMES[CODEC_COUNT] = { "raw565", "rle565", "pal8", "delta", "tiles" };
+
+struct ChangeBox {
+  int x = 0, y = 0, width = 0, height = 0; // empty when width is 0
+};
+
+struct FrameStats {
+  uint32_t changed = 0;
+  ChangeBox box;
+  uint32_t colours = 0;
+  uint32_t runs = 0;
+  uint32_t runHistogram[RUN_BUCKETS] = {};
+  uint32_t tiles = 0;
+  uint32_t unchangedTiles = 0;
+  uint32_t repeatedTiles = 0;
+  uint64_t bytes[CODEC_COUNT] = {};
+};
+
+// Function to get the run-length bucket of a run (power-of-two upper bounds)
+static int runBucket(uint32_t length) {
+  int bucket = 0;
+  while (bucket < RUN_BUCKETS - 1 && length > (1u << bucket)) bucket++;
+  return bucket;
+}
+
+// Function to measure one frame against the previous one (and the tiles seen so far)
+static void analyseFrame(const HostAnimation& animation, size_t index, int tile, std::unordered_set<uint64_t>& seenTiles,
+                         FrameStats& stats) {
+  int width = animation.width, height = animation.height;
+  size_t count = (size_t)width * height;
+  const std::vector<uint16_t>& frame = animation.frames[index];
+  const std::vector<uint16_t>& previous = animation.frames[(index + animation.frames.size() - 1) % animation.frames.size()];
+
+  // Changes and their bounding box
+  int left = width, top = height, right = -1, bottom = -1;
+  for (int y = 0; y < height; y++) {
+    for (int x = 0; x < width; x++) {
+      size_t i = (size_t)y * width + x;
+      if (frame[i] == previous[i]) continue;
+      stats.changed++;
+      if (x < left) left = x;
+      if (x > right) right = x;
+      if (y < top) top = y;
+      if (y > bottom) bottom = y;
+    }
+  }
+  if (stats.changed) {
+    stats.box.x = left;
+    stats.box.y = top;
+    stats.box.width = right - left + 1;
+    stats.box.height = bottom - top + 1;
+  }
+
+  // Colours and runs
+  std::vector<uint8_t> seen(65536, 0);
+  for (size_t i = 0; i < count;) {
+    if (!seen[frame[i]]) {
+      seen[frame[i]] = 1;
+      stats.colours++;
+    }
+    size_t end = i + 1;
+    while (end < count && frame[end] == frame[i]) end++;
+    stats.runs++;
+    stats.runHistogram[runBucket((uint32_t)(end - i))]++;
+    i = end;
+  }
+
+  // Tiles (edge tiles are smaller), keyed by position-independent content
+  uint32_t newTilePixels = 0;
+  std::vector<uint16_t> pixels;
+  for (int tileY = 0; tileY < height; tileY += tile) {
+    for (int tileX = 0; tileX < width; tileX += tile) {
+      int tileWidth = tileX + tile <= width ? tile : width - tileX;
+      int tileHeight = tileY + tile <= height ? tile : height - tileY;
+      pixels.clear();
+      bool unchanged = true;
+      for (int y = tileY; y < tileY + tileHeight; y++) {
+        const uint16_t* row = &frame[(size_t)y * width + tileX];
+        pixels.insert(pixels.end(), row, row + tileWidth);
+        unchanged = unchanged && memcmp(row, &previous[(size_t)y * width + tileX], tileWidth * 2) == 0;
+      }
+      uint32_t size[2] = { (uint32_t)tileWidth, (uint32_t)tileHeight };
+      uint64_t key = assetHash(pixels.data(), pixels.size() * 2, assetHash(size, sizeof(size)));
+      stats.tiles++;
+      if (unchanged) stats.unchangedTiles++;
+      if (!seenTiles.insert(key).second) {
+        stats.repeatedTiles++;
+      } else {
+        newTilePixels += tileWidth * tileHeight;
+      }
+    }
+  }
+
+  stats.bytes[CODEC_RAW565] = count * 2;
+  stats.bytes[CODEC_RLE565] = encodeContainerFrame(frame, width, height, ANIM_ENC_RLE565).size() + 4;
+  stats.bytes[CODEC_PAL8] = count;
+  stats.bytes[CODEC_DELTA] = index == 0 ? count * 2 : DELTA_RECT_BYTES + (uint64_t)stats.box.width * stats.box.height * 2;
+  stats.bytes[CODEC_TILES] = (uint64_t)newTilePixels * 2 + (uint64_t)stats.tiles * TILE_INDEX_BYTES;
+}
+
+static void writeBoxJson(FILE* out, const ChangeBox& box) {
+  if (!box.width) {
+    fprintf(out, "null");
+    return;
+  }
+  fprintf(out, "{\"x\": %d, \"y\": %d, \"width\": %d, \"height\": %d}", box.x, box.y, box.width, box.height);
+}
+
+// Function to write the statistics shared by a frame and the summary as JSON members
+static void writeStatsJson(FILE* out, const FrameStats& stats, const char* indent) {
+  fprintf(out, "%s\"changedPixels\": %u,\n%s\"changedBox\": ", indent, stats.changed, indent);
+  writeBoxJson(out, stats.box);
+  fprintf(out, ",\n%s\"colours\": %u,\n", indent, stats.colours);
+  fprintf(out, "%s\"runs\": {\"count\": %u, \"histogram\": [", indent, stats.runs);
+  for (int b = 0; b < RUN_BUCKETS; b++) fprintf(out, "%s%u", b ? ", " : "", stats.runHistogram[b]);
+  fprintf(out, "]},\n%s\"tiles\": {\"count\": %u, \"unchanged\": %u, \"repeated\": %u},\n", indent, stats.tiles,
+          stats.unchangedTiles, stats.repeatedTiles);
+  fprintf(out, "%s\"bytes\": {", indent);
+  for (int c = 0; c < CODEC_COUNT; c++) {
+    fprintf(out, "%s\"%s\": %llu", c ? ", " : "", CODEC_NAMES[c], (unsigned long long)stats.bytes[c]);
+  }
+  fprintf(out, "}");
+}
+
+static void writeJson(FILE* out, const std::string& source, const HostAnimation& animation, int tile,
+                      const std::vector<FrameStats>& frames, const FrameStats& summary, bool pal8Lossless, int best) {
+  fprintf(out, "{\n  \"source\": \"");
+  for (char c : source) fprintf(out, c == '"' || c == '\\' ? "\\%c" : "%c", c);
+  fprintf(out, "\",\n  \"width\": %d,\n  \"height\": %d,\n  \"frameCount\": %zu,\n  \"tileSize\": %d,\n",
+          animation.width, animation.height, animation.frames.size(), tile);
+  fprintf(out, "  \"runBuckets\": [");
+  for (int b = 0; b < RUN_BUCKETS; b++) fprintf(out, "%s\"%s\"", b ? ", " : "", RUN_BUCKET_NAMES[b]);
+  fprintf(out, "],\n  \"frames\": [\n");
+  for (size_t i = 0; i < frames.size(); i++) {
+    fprintf(out, "    {\n      \"index\": %zu,\n", i);
+    writeStatsJson(out, frames[i], "      ");
+    fprintf(out, "\n    }%s\n", i + 1 < frames.size() ? "," : "");
+  }
+  fprintf(out, "  ],\n  \"summary\": {\n");
+  writeStatsJson(out, summary, "    ");
+  fprintf(out, ",\n    \"pal8Lossless\": %s,\n    \"bestLossless\": \"%s\"\n  }\n}\n", pal8Lossless ? "true" : "false",
+          CODEC_NAMES[best]);
+}
+
+// Function to format a change box as "x,y wxh" ("-" when empty)
+static std::string boxText(const ChangeBox& box) {
+  char text[32] = "-";
+  if (box.width) snprintf(text, sizeof(text), "%d,%d %dx%d", box.x, box.y, box.width, box.height);
+  return text;
+}
+
+static void printTable(const std::string& source, const HostAnimation& animation, int tile,
+                       const std::vector<FrameStats>& frames, const FrameStats& summary, bool pal8Lossless, int best) {
+  size_t count = (size_t)animation.width * animation.height;
+  printf("%s: %zu frames, %dx%d, %dx%d tiles\n\n", source.c_str(), animation.frames.size(), animation.width,
+         animation.height, tile, tile);
+
+  printf("frame  changed      %%  changed box       colours  tiles same  repeat");
+  for (int c = 0; c < CODEC_COUNT; c++) printf(" %9s", CODEC_NAMES[c]);
+  printf("\n");
+  for (size_t i = 0; i < frames.size(); i++) {
+    const FrameStats& stats = frames[i];
+    printf("%5zu  %7u  %5.1f %-16s  %6u  %5u %4u  %6u", i, stats.changed, 100.0 * stats.changed / count,
+           boxText(stats.box).c_str(), stats.colours, stats.tiles, stats.unchangedTiles, stats.repeatedTiles);
+    for (int c = 0; c < CODEC_COUNT; c++) printf(" %9llu", (unsigned long long)stats.bytes[c]);
+    printf("\n");
+  }
+
+  printf("\nframe     runs  mean");
+  for (int b = 0; b < RUN_BUCKETS; b++) printf(" %7s", RUN_BUCKET_NAMES[b]);
+  printf("\n");
+  for (size_t i = 0; i <= frames.size(); i++) {
+    const FrameStats& stats = i < frames.size() ? frames[i] : summary;
+    if (i < frames.size()) printf("%5zu", i);
+    else printf("  all");
+    printf("  %7u  %4.1f", stats.runs, (double)count * (i < frames.size() ? 1 : frames.size()) / stats.runs);
+    for (int b = 0; b < RUN_BUCKETS; b++) printf(" %7u", stats.runHistogram[b]);
+    printf("\n");
+  }
+
+  size_t frameCount = frames.size();
+  printf("\nsummary: %u colours (pal8 %s), %.1f%% of pixels changed per frame, all changes inside %s\n", summary.colours,
+         pal8Lossless ? "lossless" : "lossy", 100.0 * summary.changed / (count * frameCount), boxText(summary.box).c_str());
+  printf("         tiles %.1f%% unchanged from the previous frame, %.1f%% repeats of an earlier tile\n",
+         100.0 * summary.unchangedTiles / summary.tiles, 100.0 * summary.repeatedTiles / summary.tiles);
+  printf("\ncodec        bytes  of raw565\n");
+  for (int c = 0; c < CODEC_COUNT; c++) {
+    printf("%-8s %9llu  %6.1f%%%s\n", CODEC_NAMES[c], (unsigned long long)summary.bytes[c],
+           100.0 * summary.bytes[c] / summary.bytes[CODEC_RAW565],
+           c == best ? "  <- smallest lossless" : c == CODEC_PAL8 && !pal8Lossless ? "  (lossy)" : "");
+  }
+}
+
+int main(int argc, char** argv) {
+  int tile = DEFAULT_TILE;
+  const char* jsonPath = nullptr;
+  int arg = 1;
+  for (; arg + 1 < argc && strncmp(argv[arg], "--", 2) == 0; arg += 2) {
+    if (strcmp(argv[arg], "--tile") == 0) {
+      tile = atoi(argv[arg + 1]);
+      if (tile <= 0) arg = argc;
+    } else if (strcmp(argv[arg], "--json") == 0) {
+      jsonPath = argv[arg + 1];
+    } else {
+      arg = argc;
+    }
+  }
+  if (argc - arg != 1) {
+    fprintf(stderr, "usage: %s [--tile N] [--json FILE|-] <frames.h|input.nyan>\n", argv[0]);
+    return 2;
+  }
+
+  std::string source = argv[arg];
+  HostAnimation animation;
+  std::string error;
+  if (!loadAnimation(source, animation, error)) {
+    fprintf(stderr, "%s\n", error.c_str());
+    return 1;
+  }
+  if (animation.frames.empty()) {
+    fprintf(stderr, "%s: no frames\n", source.c_str());
+    return 1;
+  }
+
+  // Frames in order (tile repeats count against every earlier frame), and the whole animation
+  std::vector<FrameStats> frames(animation.frames.size());
+  std::unordered_set<uint64_t> seenTiles;
+  FrameStats summary;
+  int left = animation.width, top = animation.height, right = -1, bottom = -1;
+  for (size_t i = 0; i < frames.size(); i++) {
+    analyseFrame(animation, i, tile, seenTiles, frames[i]);
+    const FrameStats& stats = frames[i];
+    summary.changed += stats.changed;
+    summary.runs += stats.runs;
+    for (int b = 0; b < RUN_BUCKETS; b++) summary.runHistogram[b] += stats.runHistogram[b];
+    summary.tiles += stats.tiles;
+    summary.unchangedTiles += stats.unchangedTiles;
+    summary.repeatedTiles += stats.repeatedTiles;
+    for (int c = 0; c < CODEC_COUNT; c++) summary.bytes[c] += stats.bytes[c];
+    if (stats.box.width) {
+      if (stats.box.x < left) left = stats.box.x;
+      if (stats.box.y < top) top = stats.box.y;
+      if (stats.box.x + stats.box.width - 1 > right) right = stats.box.x + stats.box.width - 1;
+      if (stats.box.y + stats.box.height - 1 > bottom) bottom = stats.box.y + stats.box.height - 1;
+    }
+  }
+  if (right >= 0) {
+    summary.box.x = left;
+    summary.box.y = top;
+    summary.box.width = right - left + 1;
+    summary.box.height = bottom - top + 1;
+  }
+  std::vector<uint8_t> seen(65536, 0);
+  for (const std::vector<uint16_t>& frame : animation.frames) {
+    for (uint16_t colour : frame) {
+      if (!seen[colour]) {
+        seen[colour] = 1;
+        summary.colours++;
+      }
+    }
+  }
+  summary.bytes[CODEC_RLE565] += 4;                // the offset table's end entry
+  summary.bytes[CODEC_PAL8] += ANIM_PALETTE_BYTES; // one palette for the animation
+  bool pal8Lossless = summary.colours <= ANIM_PALETTE_SIZE;
+  int best = CODEC_RAW565;
+  for (int c = 0; c < CODEC_COUNT; c++) {
+    if ((c != CODEC_PAL8 || pal8Lossless) && summary.bytes[c] < summary.bytes[best]) best = c;
+  }
+
+  if (jsonPath) {
+    bool toStdout = strcmp(jsonPath, "-") == 0;
+    FILE* out = toStdout ? stdout : fopen(jsonPath, "w");
+    if (!out) {
+      fprintf(stderr, "cannot write %s\n", jsonPath);
+      return 1;
+    }
+    writeJson(out, source, animation, tile, frames, summary, pal8Lossless, best);
+    if (!toStdout) fclose(out);
+    if (toStdout) return 0;
+  }
+  printTable(source, animation, tile, frames, summary, pal8Lossless, best);
+  return 0;
+}
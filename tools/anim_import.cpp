@@ -0,0 +1,555 @@
+/*************************************************************
+******************** ANIMATION IMPORTER (HOST) ***************
+**************************************************************/
+
+/*
+Turn a GIF, a sequence of PNGs or an existing animation (nyancat.h-style
+header or container) into an animation container with per-frame
+durations, ready for OTA upload (PUT /animation):
+
+  anim_import [options] <output.nyan> <input.gif>
+  anim_import [options] --fps 12 <output.nyan> frame000.png frame001.png ...
+  anim_import [options] --pal8 --report <output.nyan> include/nyancat.h
+
+Each frame is composited over black, resized to the panel with a tent
+filter and rounded to RGB565 (or to a palette, --pal8). GIF frame delays
+and container durations become the output's durations table; PNG
+sequences take --delay or --fps (without either they are untimed: one
+frame per loop(), like the built-in animation).
+
+Options:
+  --size WxH         output size (default 320x170, the panel's animation area)
+  --fit MODE         contain (letterbox, default), cover (crop) or stretch
+  --delay MS         duration of every frame (GIFs keep their own)
+  --fps N            same as --delay 1000/N
+  --rle              store RLE565-compressed frames
+  --pal8             store 8-bit palette indices (half of RGB565) with one
+                     palette for the whole animation (colour_quant.h):
+  --colours N          palette size, 2..256 (default 256)
+  --palette METHOD     kmeans (default) or median-cut
+  --dither MODE      none (default), ordered or diffusion; with or without --pal8
+  --report           per-frame PSNR and SSIM of the output against the resized
+                     source (image_quality.h), with the mean and the worst frame
+  --threads N        worker threads (default: all cores)
+  --cache DIR        reuse resized frames, palettes and encoded frames from
+                     earlier builds (asset_cache.h): only what depends on a
+                     changed source or setting is redone
+
+Frames are decoded (PNG), resized and encoded on a pool of worker threads;
+GIF frames are composited in order first, since each depends on the last.
+*/
+
+#include <ctype.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include <atomic>
+#include <chrono>
+#include <thread>
+#include "asset_cache.h"
+#include "colour_quant.h"
+#include "frame_source.h"
+#include "image_decode.h"
+#include "image_quality.h"
+
+const int DEFAULT_WIDTH = 320;
+const int DEFAULT_HEIGHT = 170;
+
+typedef enum {
+  FIT_CONTAIN,
+  FIT_COVER,
+  FIT_STRETCH
+} fit_mode_t;
+
+struct ImportOptions {
+  int width = DEFAULT_WIDTH;
+  int height = DEFAULT_HEIGHT;
+  fit_mode_t fit = FIT_CONTAIN;
+  uint16_t delayMs = 0;
+  uint8_t encoding = ANIM_ENC_RAW565;
+  int colours = ANIM_PALETTE_SIZE;
+  palette_method_t palette = PALETTE_KMEANS;
+  dither_mode_t dither = DITHER_NONE;
+  bool report = false;
+  unsigned threads = 0;
+  std::string cacheDir;
+};
+
+// A frame through the pipeline: source -> resized (8-bit RGB at the output size) -> encoded.
+// Both stages are cached; the resized frame is only needed for a palette, a miss or a report
+struct ImportFrame {
+  uint64_t resizedKey = 0;
+  uint64_t encodedKey = 0;
+  std::vector<uint8_t> resized;
+  std::vector<uint8_t> encoded;
+  uint32_t resizeMicros = 0; // what the resized frame cost
+  uint32_t costMicros = 0;   // what the encoded frame cost, resize included
+  bool resizedCached = false;
+  bool encodedCached = false;
+  std::string error;
+};
+
+const uint32_t IMPORT_FORMAT_VERSION = 2; // bump when the conversion changes, so cached frames are rebuilt
+
+// Cache entry kinds (part of their keys)
+const uint32_t STAGE_RESIZED = 1;
+const uint32_t STAGE_PALETTE = 2;
+const uint32_t STAGE_ENCODED = 3;
+
+// Function to resample one line of channels-interleaved floats with a tent filter
+// (source window [start, start + length) onto count outputs; wider than 1 pixel when shrinking)
+static void resampleLine(const float* source, int sourceCount, int stride, double start, double length,
+                         float* out, int count, int outStride, int channels) {
+  double scale = count / length;
+  double support = scale < 1.0 ? 1.0 / scale : 1.0;
+  for (int i = 0; i < count; i++) {
+    double centre = start + (i + 0.5) / scale;
+    int first = (int)floor(centre - support);
+    int last = (int)ceil(centre + support);
+    float sums[4] = {};
+    double total = 0;
+    for (int j = first; j <= last; j++) {
+      double weight = 1.0 - fabs(j + 0.5 - centre) / support;
+      if (weight <= 0) continue;
+      int clamped = j < 0 ? 0 : j >= sourceCount ? sourceCount - 1 : j;
+      for (int c = 0; c < channels; c++) sums[c] += (float)(weight * source[clamped * stride + c]);
+      total += weight;
+    }
+    for (int c = 0; c < channels; c++) out[i * outStride + c] = total > 0 ? (float)(sums[c] / total) : 0.0f;
+  }
+}
+
+// Function to composite and resize one decoded frame to 8-bit RGB at the output size
+static void resizeFrame(const DecodedImage& image, const ImportOptions& options, std::vector<uint8_t>& rgbOut) {
+  // Over black: RGB premultiplied by alpha
+  size_t count = (size_t)image.width * image.height;
+  std::vector<float> rgb(count * 3);
+  for (size_t i = 0; i < count; i++) {
+    const uint8_t* pixel = &image.rgba[i * 4];
+    float alpha = pixel[3] / 255.0f;
+    for (int c = 0; c < 3; c++) rgb[i * 3 + c] = pixel[c] * alpha;
+  }
+
+  // Source window and destination rectangle for the fit mode
+  double sourceX = 0, sourceY = 0, sourceWidth = image.width, sourceHeight = image.height;
+  int outX = 0, outY = 0, outWidth = options.width, outHeight = options.height;
+  double scaleX = (double)options.width / image.width, scaleY = (double)options.height / image.height;
+  if (options.fit == FIT_CONTAIN) {
+    double scale = scaleX < scaleY ? scaleX : scaleY;
+    outWidth = (int)lround(image.width * scale);
+    outHeight = (int)lround(image.height * scale);
+    if (outWidth < 1) outWidth = 1;
+    if (outHeight < 1) outHeight = 1;
+    outX = (options.width - outWidth) / 2;
+    outY = (options.height - outHeight) / 2;
+  } else if (options.fit == FIT_COVER) {
+    double scale = scaleX > scaleY ? scaleX : scaleY;
+    sourceWidth = options.width / scale;
+    sourceHeight = options.height / scale;
+    sourceX = (image.width - sourceWidth) / 2;
+    sourceY = (image.height - sourceHeight) / 2;
+  }
+
+  // Separable: rows first, then columns
+  std::vector<float> wide((size_t)outWidth * image.height * 3);
+  for (int y = 0; y < image.height; y++) {
+    resampleLine(&rgb[(size_t)y * image.width * 3], image.width, 3, sourceX, sourceWidth,
+                 &wide[(size_t)y * outWidth * 3], outWidth, 3, 3);
+  }
+  std::vector<float> scaled((size_t)outWidth * outHeight * 3);
+  for (int x = 0; x < outWidth; x++) {
+    resampleLine(&wide[(size_t)x * 3], image.height, outWidth * 3, sourceY, sourceHeight,
+                 &scaled[(size_t)x * 3], outHeight, outWidth * 3, 3);
+  }
+
+  // Round to 8 bits (letterbox stays black); colour reduction is quantiseFrame()'s job
+  rgbOut.assign((size_t)options.width * options.height * 3, 0);
+  for (int y = 0; y < outHeight; y++) {
+    for (int x = 0; x < outWidth; x++) {
+      const float* colour = &scaled[((size_t)y * outWidth + x) * 3];
+      uint8_t* out = &rgbOut[((size_t)(outY + y) * options.width + outX + x) * 3];
+      for (int c = 0; c < 3; c++) {
+        int value = (int)lround(colour[c]);
+        out[c] = (uint8_t)(value < 0 ? 0 : value > 255 ? 255 : value);
+      }
+    }
+  }
+}
+
+// Function to run job(i) for i in [0, count) on a pool of threads
+template <typename Job>
+static void runPool(size_t count, unsigned threads, Job job) {
+  std::atomic<size_t> next(0);
+  auto worker = [&]() {
+    for (size_t i = next++; i < count; i = next++) job(i);
+  };
+  std::vector<std::thread> pool;
+  for (unsigned t = 1; t < threads && t < count; t++) pool.emplace_back(worker);
+  worker();
+  for (std::thread& thread : pool) thread.join();
+}
+
+// Function to get the hash of the settings a resized frame depends on
+static uint64_t resizeSettingsKey(const ImportOptions& options) {
+  uint32_t settings[] = { IMPORT_FORMAT_VERSION, STAGE_RESIZED, (uint32_t)options.width, (uint32_t)options.height,
+                          (uint32_t)options.fit };
+  return assetHash(settings, sizeof(settings));
+}
+
+// Function to get the hash of the settings an encoded frame depends on (besides its resized frame and palette)
+static uint64_t encodeSettingsKey(const ImportOptions& options) {
+  uint32_t settings[] = { IMPORT_FORMAT_VERSION, STAGE_ENCODED, options.encoding, (uint32_t)options.dither };
+  return assetHash(settings, sizeof(settings));
+}
+
+// Function to get the hash of every setting the output depends on
+static uint64_t settingsKey(const ImportOptions& options) {
+  uint32_t settings[] = { (uint32_t)options.colours, (uint32_t)options.palette };
+  return assetHash(settings, sizeof(settings), encodeSettingsKey(options) ^ resizeSettingsKey(options));
+}
+
+static double elapsedSeconds(std::chrono::steady_clock::time_point since) {
+  return std::chrono::duration<double>(std::chrono::steady_clock::now() - since).count();
+}
+
+static bool endsWith(const std::string& text, const char* suffix) {
+  size_t length = strlen(suffix);
+  if (text.size() < length) return false;
+  for (size_t i = 0; i < length; i++) {
+    if (tolower(text[text.size() - length + i]) != suffix[i]) return false;
+  }
+  return true;
+}
+
+static int usage(const char* program) {
+  fprintf(stderr,
+          "usage: %s [--size WxH] [--fit contain|cover|stretch] [--delay MS | --fps N] [--rle | --pal8]\n"
+          "       [--colours N] [--palette kmeans|median-cut] [--dither none|ordered|diffusion] [--report]\n"
+          "       [--threads N] [--cache DIR] <output.nyan> <input.gif | frame.png... | animation.h | .nyan>\n",
+          program);
+  return 2;
+}
+
+int main(int argc, char** argv) {
+  ImportOptions options;
+  int arg = 1;
+  for (; arg < argc && strncmp(argv[arg], "--", 2) == 0; arg++) {
+    const char* option = argv[arg];
+    const char* value = arg + 1 < argc ? argv[arg + 1] : nullptr;
+    if (strcmp(option, "--rle") == 0) {
+      options.encoding = ANIM_ENC_RLE565;
+      continue;
+    }
+    if (strcmp(option, "--pal8") == 0) {
+      options.encoding = ANIM_ENC_PAL8;
+      continue;
+    }
+    if (strcmp(option, "--report") == 0) {
+      options.report = true;
+      continue;
+    }
+    if (!value) return usage(argv[0]);
+    arg++;
+    if (strcmp(option, "--size") == 0) {
+      if (sscanf(value, "%dx%d", &options.width, &options.height) != 2 || options.width <= 0 || options.height <= 0 ||
+          options.width > 0xFFFF || options.height > 0xFFFF) {
+        return usage(argv[0]);
+      }
+    } else if (strcmp(option, "--fit") == 0) {
+      if (strcmp(value, "contain") == 0) options.fit = FIT_CONTAIN;
+      else if (strcmp(value, "cover") == 0) options.fit = FIT_COVER;
+      else if (strcmp(value, "stretch") == 0) options.fit = FIT_STRETCH;
+      else return usage(argv[0]);
+    } else if (strcmp(option, "--delay") == 0) {
+      int delay = atoi(value);
+      if (delay <= 0 || delay > 0xFFFF) return usage(argv[0]);
+      options.delayMs = (uint16_t)delay;
+    } else if (strcmp(option, "--fps") == 0) {
+      double fps = atof(value);
+      if (fps <= 0 || fps > 1000 || 1000.0 / fps > 0xFFFF) return usage(argv[0]);
+      options.delayMs = (uint16_t)lround(1000.0 / fps);
+    } else if (strcmp(option, "--colours") == 0) {
+      options.colours = atoi(value);
+      if (options.colours < 2 || options.colours > ANIM_PALETTE_SIZE) return usage(argv[0]);
+    } else if (strcmp(option, "--palette") == 0) {
+      if (strcmp(value, "kmeans") == 0) options.palette = PALETTE_KMEANS;
+      else if (strcmp(value, "median-cut") == 0) options.palette = PALETTE_MEDIAN_CUT;
+      else return usage(argv[0]);
+    } else if (strcmp(option, "--dither") == 0) {
+      if (strcmp(value, "none") == 0) options.dither = DITHER_NONE;
+      else if (strcmp(value, "ordered") == 0) options.dither = DITHER_ORDERED;
+      else if (strcmp(value, "diffusion") == 0) options.dither = DITHER_DIFFUSION;
+      else return usage(argv[0]);
+    } else if (strcmp(option, "--threads") == 0) {
+      options.threads = (unsigned)atoi(value);
+    } else if (strcmp(option, "--cache") == 0) {
+      options.cacheDir = value;
+    } else {
+      return usage(argv[0]);
+    }
+  }
+  if (argc - arg < 2) return usage(argv[0]);
+  std::string output = argv[arg++];
+  std::vector<std::string> inputs(argv + arg, argv + argc);
+  if (options.threads == 0) options.threads = std::thread::hardware_concurrency();
+  if (options.threads == 0) options.threads = 1;
+  bool pal8 = options.encoding == ANIM_ENC_PAL8;
+  bool caching = !options.cacheDir.empty();
+
+  auto started = std::chrono::steady_clock::now();
+  std::string error;
+  if (caching && !assetCacheOpen(options.cacheDir, error)) {
+    fprintf(stderr, "%s\n", error.c_str());
+    return 1;
+  }
+
+  // Input files, and the key of the whole build (inputs, durations, settings)
+  std::vector<std::vector<uint8_t>> sources(inputs.size());
+  std::vector<std::string> errors(inputs.size());
+  std::vector<uint64_t> sourceHashes(inputs.size());
+  runPool(inputs.size(), options.threads, [&](size_t i) {
+    if (readFileBytes(inputs[i], sources[i], errors[i])) sourceHashes[i] = assetHash(sources[i].data(), sources[i].size());
+  });
+  uint64_t inputsKey = assetHash(&options.delayMs, sizeof(options.delayMs), settingsKey(options));
+  for (size_t i = 0; i < inputs.size(); i++) {
+    if (!errors[i].empty()) {
+      fprintf(stderr, "%s\n", errors[i].c_str());
+      return 1;
+    }
+    inputsKey = assetHash(&sourceHashes[i], sizeof(sourceHashes[i]), inputsKey);
+  }
+
+  // Nothing changed since the last build: leave the output alone (a report needs the frames)
+  AssetManifest manifest;
+  std::vector<uint8_t> existing;
+  std::string ignored;
+  if (caching && !options.report && assetManifestLoad(options.cacheDir, output, manifest) &&
+      manifest.inputsKey == inputsKey && readFileBytes(output, existing, ignored) &&
+      assetHash(existing.data(), existing.size()) == manifest.outputHash) {
+    double seconds = elapsedSeconds(started);
+    printf("%s: up to date (%.2f s; encoding every frame takes %.2f s)\n", output.c_str(), seconds,
+           manifest.costMicros / 1e6);
+    return 0;
+  }
+
+  // Frames: GIF canvases are composited in order, animations expanded, PNGs decoded per frame later
+  bool gif = inputs.size() == 1 && endsWith(inputs[0], ".gif");
+  bool animation = inputs.size() == 1 && (endsWith(inputs[0], ".h") || endsWith(inputs[0], ".nyan"));
+  std::vector<DecodedImage> images;
+  std::vector<uint16_t> sourceDurationsMs;
+  uint64_t decodeMicros = 0;
+  size_t frameCount = inputs.size();
+  auto decodeStart = std::chrono::steady_clock::now();
+  if (gif) {
+    if (!decodeGif(sources[0], images, error)) {
+      fprintf(stderr, "%s: %s\n", inputs[0].c_str(), error.c_str());
+      return 1;
+    }
+    for (const DecodedImage& image : images) sourceDurationsMs.push_back(image.delayMs);
+  } else if (animation) {
+    HostAnimation source;
+    if (!loadAnimation(inputs[0], source, error)) {
+      fprintf(stderr, "%s: %s\n", inputs[0].c_str(), error.c_str());
+      return 1;
+    }
+    images.resize(source.frames.size());
+    for (size_t i = 0; i < images.size(); i++) {
+      size_t count = (size_t)source.width * source.height;
+      std::vector<uint8_t> rgb(count * 3);
+      expandRgb565(source.frames[i].data(), count, rgb.data());
+      images[i].width = source.width;
+      images[i].height = source.height;
+      images[i].rgba.resize(count * 4);
+      for (size_t p = 0; p < count; p++) {
+        memcpy(&images[i].rgba[p * 4], &rgb[p * 3], 3);
+        images[i].rgba[p * 4 + 3] = 0xFF;
+      }
+    }
+    sourceDurationsMs = source.durationsMs;
+  } else {
+    images.resize(inputs.size());
+  }
+  if (gif || animation) {
+    decodeMicros = (uint64_t)(elapsedSeconds(decodeStart) * 1e6);
+    frameCount = images.size();
+  }
+  if (frameCount == 0 || frameCount > 0xFFFF) {
+    fprintf(stderr, "%s frames (%zu)\n", frameCount ? "too many" : "no", frameCount);
+    return 1;
+  }
+
+  // Cache keys: a resized frame by its source, the palette by every resized frame, an encoded frame by both
+  std::vector<ImportFrame> frames(frameCount);
+  uint64_t resizeSettings = resizeSettingsKey(options);
+  runPool(frameCount, options.threads, [&](size_t i) {
+    uint64_t sourceKey;
+    if (gif || animation) {
+      uint32_t size[2] = { (uint32_t)images[i].width, (uint32_t)images[i].height };
+      sourceKey = assetHash(images[i].rgba.data(), images[i].rgba.size(), assetHash(size, sizeof(size)));
+    } else {
+      sourceKey = sourceHashes[i];
+    }
+    frames[i].resizedKey = assetHash(&sourceKey, sizeof(sourceKey), resizeSettings);
+  });
+  uint32_t paletteSettings[] = { IMPORT_FORMAT_VERSION, STAGE_PALETTE, (uint32_t)options.colours, (uint32_t)options.palette };
+  uint64_t paletteKey = assetHash(paletteSettings, sizeof(paletteSettings));
+  for (const ImportFrame& frame : frames) paletteKey = assetHash(&frame.resizedKey, sizeof(frame.resizedKey), paletteKey);
+  uint64_t encodeSettings = encodeSettingsKey(options);
+  if (pal8) encodeSettings = assetHash(&paletteKey, sizeof(paletteKey), encodeSettings);
+  runPool(frameCount, options.threads, [&](size_t i) {
+    ImportFrame& frame = frames[i];
+    frame.encodedKey = assetHash(&frame.resizedKey, sizeof(frame.resizedKey), encodeSettings);
+    frame.encodedCached = caching && assetCacheLoad(options.cacheDir, frame.encodedKey, frame.encoded, frame.costMicros);
+  });
+
+  std::vector<uint16_t> palette;
+  uint32_t paletteMicros = 0;
+  bool paletteCached = false;
+  if (pal8 && caching) {
+    std::vector<uint8_t> bytes;
+    if (assetCacheLoad(options.cacheDir, paletteKey, bytes, paletteMicros) && !bytes.empty() && bytes.size() % 2 == 0) {
+      palette.resize(bytes.size() / 2);
+      memcpy(palette.data(), bytes.data(), bytes.size());
+      paletteCached = true;
+    }
+  }
+
+  // Resized frames: for every miss, for a palette that isn't cached and for a report
+  std::vector<size_t> misses, resizes;
+  for (size_t i = 0; i < frameCount; i++) {
+    if (!frames[i].encodedCached) misses.push_back(i);
+    if (!frames[i].encodedCached || options.report || (pal8 && !paletteCached)) resizes.push_back(i);
+  }
+  size_t resizedBytes = (size_t)options.width * options.height * 3;
+  runPool(resizes.size(), options.threads, [&](size_t r) {
+    size_t i = resizes[r];
+    ImportFrame& frame = frames[i];
+    if (caching && assetCacheLoad(options.cacheDir, frame.resizedKey, frame.resized, frame.resizeMicros) &&
+        frame.resized.size() == resizedBytes) {
+      frame.resizedCached = true;
+      return;
+    }
+    auto frameStart = std::chrono::steady_clock::now();
+    if (!gif && !animation && !decodePng(sources[i], images[i], frame.error)) return;
+    resizeFrame(images[i], options, frame.resized);
+    images[i].rgba = std::vector<uint8_t>(); // done with the source
+    frame.resizeMicros = (uint32_t)(elapsedSeconds(frameStart) * 1e6);
+    if (caching) assetCacheStore(options.cacheDir, frame.resizedKey, frame.resized, frame.resizeMicros);
+  });
+  for (size_t i : resizes) {
+    if (!frames[i].error.empty()) {
+      fprintf(stderr, "%s: %s\n", inputs[i].c_str(), frames[i].error.c_str());
+      return 1;
+    }
+  }
+
+  // One palette for the whole animation, from the histogram of every frame
+  if (pal8 && !paletteCached) {
+    auto paletteStart = std::chrono::steady_clock::now();
+    ColourHistogram histogram;
+    for (const ImportFrame& frame : frames) histogramAdd(histogram, frame.resized.data(), frame.resized.size() / 3);
+    palette = buildPalette(histogram, options.colours, options.palette);
+    paletteMicros = (uint32_t)(elapsedSeconds(paletteStart) * 1e6);
+    if (caching) {
+      std::vector<uint8_t> bytes(palette.size() * 2);
+      memcpy(bytes.data(), palette.data(), bytes.size());
+      assetCacheStore(options.cacheDir, paletteKey, bytes, paletteMicros);
+    }
+  }
+  PaletteLookup lookup;
+  if (pal8 && !misses.empty()) paletteLookupInit(lookup, palette);
+
+  // Only the frames not in the cache are quantised, dithered and encoded
+  runPool(misses.size(), options.threads, [&](size_t m) {
+    ImportFrame& frame = frames[misses[m]];
+    auto frameStart = std::chrono::steady_clock::now();
+    std::vector<uint16_t> pixels;
+    std::vector<uint8_t> indices;
+    quantiseFrame(frame.resized.data(), options.width, options.height, options.dither, pal8 ? &lookup : nullptr, pixels,
+                  pal8 ? &indices : nullptr);
+    frame.encoded = pal8 ? std::move(indices) : encodeContainerFrame(pixels, options.width, options.height, options.encoding);
+    frame.costMicros = frame.resizeMicros + (uint32_t)(elapsedSeconds(frameStart) * 1e6);
+    if (caching) assetCacheStore(options.cacheDir, frame.encodedKey, frame.encoded, frame.costMicros);
+    if (!options.report) frame.resized = std::vector<uint8_t>();
+  });
+
+  std::vector<std::vector<uint8_t>> encoded(frameCount);
+  std::vector<uint16_t> durationsMs;
+  uint32_t totalMs = 0;
+  uint64_t costMicros = decodeMicros + (pal8 ? paletteMicros : 0), savedMicros = paletteCached ? paletteMicros : 0;
+  bool timed = gif || options.delayMs || sourceDurationsMs.size() == frameCount;
+  for (size_t i = 0; i < frameCount; i++) {
+    encoded[i] = std::move(frames[i].encoded);
+    costMicros += frames[i].costMicros;
+    if (frames[i].encodedCached) savedMicros += frames[i].costMicros;
+    else if (frames[i].resizedCached) savedMicros += frames[i].resizeMicros;
+    if (timed) {
+      uint16_t delayMs = gif || !options.delayMs ? sourceDurationsMs[i] : options.delayMs;
+      durationsMs.push_back(delayMs);
+      totalMs += delayMs;
+    }
+  }
+
+  if (!saveEncodedContainer(output, options.width, options.height, options.encoding, encoded, durationsMs, error, palette)) {
+    fprintf(stderr, "%s\n", error.c_str());
+    return 1;
+  }
+  if (caching && readFileBytes(output, existing, error)) {
+    manifest.inputsKey = inputsKey;
+    manifest.outputHash = assetHash(existing.data(), existing.size());
+    manifest.costMicros = costMicros;
+    assetManifestStore(options.cacheDir, output, manifest);
+  }
+
+  double seconds = elapsedSeconds(started);
+  printf("%s: %zu frames, %dx%d, ", output.c_str(), frameCount, options.width, options.height);
+  if (totalMs) {
+    printf("%.2f s loop", totalMs / 1000.0);
+  } else {
+    printf("untimed");
+  }
+  printf(" (%.2f s on %u thread%s)\n", seconds, options.threads, options.threads == 1 ? "" : "s");
+  if (pal8) {
+    printf("palette: %zu colours (%s%s)\n", palette.size(),
+           options.palette == PALETTE_KMEANS ? "k-means" : "median cut", paletteCached ? ", cached" : "");
+  }
+  if (caching) {
+    printf("cache: %zu of %zu frames encoded, %zu reused (saved %.2f s of %.2f s)\n", misses.size(), frameCount,
+           frameCount - misses.size(), savedMicros / 1e6, costMicros / 1e6);
+  }
+
+  // Quality of what was written (decoded back from the file) against the resized source
+  if (options.report) {
+    HostAnimation written;
+    if (!loadContainer(output, written, error)) {
+      fprintf(stderr, "%s: %s\n", output.c_str(), error.c_str());
+      return 1;
+    }
+    size_t pixelCount = (size_t)options.width * options.height;
+    std::vector<double> psnr(frameCount), ssim(frameCount);
+    runPool(frameCount, options.threads, [&](size_t i) {
+      std::vector<uint8_t> shown(pixelCount * 3);
+      expandRgb565(written.frames[i].data(), pixelCount, shown.data());
+      psnr[i] = psnrRgb(frames[i].resized.data(), shown.data(), pixelCount);
+      ssim[i] = ssimLuma(frames[i].resized.data(), shown.data(), options.width, options.height);
+    });
+    printf("frame  PSNR (dB)    SSIM\n");
+    double psnrSum = 0, ssimSum = 0;
+    size_t worstPsnr = 0, worstSsim = 0;
+    for (size_t i = 0; i < frameCount; i++) {
+      printf("%5zu  %9.2f  %.4f\n", i, psnr[i], ssim[i]);
+      psnrSum += psnr[i];
+      ssimSum += ssim[i];
+      if (psnr[i] < psnr[worstPsnr]) worstPsnr = i;
+      if (ssim[i] < ssim[worstSsim]) worstSsim = i;
+    }
+    printf("mean   %9.2f  %.4f  (worst: %.2f dB frame %zu, SSIM %.4f frame %zu)\n", psnrSum / frameCount,
+           ssimSum / frameCount, psnr[worstPsnr], worstPsnr, ssim[worstSsim], worstSsim);
+    size_t payload = 0;
+    for (const std::vector<uint8_t>& frame : encoded) payload += frame.size();
+    if (pal8) payload += ANIM_PALETTE_BYTES;
+    printf("payload %zu bytes (%.0f%% of RGB565)\n", payload, 100.0 * payload / (pixelCount * 2 * frameCount));
+  }
+  return 0;
+}
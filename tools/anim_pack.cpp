@@ -0,0 +1,41 @@
+/*************************************************************
+******************** ANIMATION PACKER (HOST) *****************
+**************************************************************/
+
+/*
+Convert a nyancat.h-style frame header into an animation container for
+OTA upload (PUT /animation):
+
+  anim_pack [--rle] include/nyancat.h nyancat.nyan
+  curl -T nyancat.nyan http://<clock-ip>/animation
+
+--rle stores RLE565-compressed frames; the clock decodes them ahead of time
+on its second core. --pal8 stores 8-bit palette indices (animations of at
+most 256 colours; anim_import --pal8 reduces the colours of others).
+*/
+
+#include <stdio.h>
+#include <string.h>
+#include "frame_source.h"
+
+int main(int argc, char** argv) {
+  uint8_t encoding = ANIM_ENC_RAW565;
+  if (argc == 4 && (strcmp(argv[1], "--rle") == 0 || strcmp(argv[1], "--pal8") == 0)) {
+    encoding = strcmp(argv[1], "--rle") == 0 ? ANIM_ENC_RLE565 : ANIM_ENC_PAL8;
+    argv++;
+    argc--;
+  }
+  if (argc != 3) {
+    fprintf(stderr, "usage: %s [--rle|--pal8] <frames.h|input.nyan> <output.nyan>\n", argv[0]);
+    return 2;
+  }
+
+  HostAnimation animation;
+  std::string error;
+  if (!loadAnimation(argv[1], animation, error) || !saveContainer(argv[2], animation, error, encoding)) {
+    fprintf(stderr, "%s\n", error.c_str());
+    return 1;
+  }
+  printf("%s: %zu frames, %dx%d\n", argv[2], animation.frames.size(), animation.width, animation.height);
+  return 0;
+}
@@ -0,0 +1,129 @@
+/*************************************************************
+********************* ASSET CACHE (HOST) *********************
+**************************************************************/
+
+#include <stdio.h>
+#include <string.h>
+#include <filesystem>
+#include <fstream>
+#include <functional>
+#include <thread>
+#include "asset_cache.h"
+
+static const char ENTRY_MAGIC[4] = { 'N', 'Y', 'F', 'C' };
+static const char MANIFEST_MAGIC[4] = { 'N', 'Y', 'F', 'M' };
+
+// Cache entry header (followed by the encoded bytes)
+struct EntryHeader {
+  char magic[4];
+  uint32_t costMicros;
+  uint32_t bytes;
+  uint32_t bytesHash; // low half of the encoded bytes' hash (catches truncated or damaged entries)
+};
+
+struct ManifestRecord {
+  char magic[4];
+  uint32_t reserved;
+  AssetManifest manifest;
+};
+
+static uint64_t rotateLeft(uint64_t value, int bits) {
+  return (value << bits) | (value >> (64 - bits));
+}
+
+uint64_t assetHash(const void* data, size_t size, uint64_t seed) {
+  const uint64_t K1 = 0x87c37b91114253d5ull, K2 = 0x4cf5ad432745937full;
+  const uint8_t* bytes = (const uint8_t*)data;
+  uint64_t hash = seed ^ (size * K2);
+  size_t words = size / 8;
+  for (size_t i = 0; i < words; i++) {
+    uint64_t word;
+    memcpy(&word, bytes + i * 8, 8);
+    hash = rotateLeft(hash ^ (word * K1), 31) * K2;
+  }
+  uint64_t tail = 0;
+  memcpy(&tail, bytes + words * 8, size % 8);
+  hash = rotateLeft(hash ^ (tail * K1), 31) * K2;
+
+  hash ^= hash >> 33;
+  hash *= 0xff51afd7ed558ccdull;
+  hash ^= hash >> 33;
+  hash *= 0xc4ceb9fe1a85ec53ull;
+  return hash ^ (hash >> 33);
+}
+
+// Function to get the file of a cache entry
+static std::string entryPath(const std::string& dir, uint64_t key) {
+  char name[32];
+  snprintf(name, sizeof(name), "%016llx.frame", (unsigned long long)key);
+  return dir + "/" + name;
+}
+
+// Function to get the manifest file of an output (named after its file name, so outputs can share a cache)
+static std::string manifestPath(const std::string& dir, const std::string& output) {
+  return dir + "/" + std::filesystem::path(output).filename().string() + ".manifest";
+}
+
+bool assetCacheOpen(const std::string& dir, std::string& error) {
+  std::error_code code;
+  std::filesystem::create_directories(dir, code);
+  if (!std::filesystem::is_directory(dir)) {
+    error = "cannot create cache directory " + dir;
+    return false;
+  }
+  return true;
+}
+
+bool assetCacheLoad(const std::string& dir, uint64_t key, std::vector<uint8_t>& encoded, uint32_t& costMicros) {
+  std::ifstream file(entryPath(dir, key), std::ios::binary);
+  EntryHeader header;
+  if (!file.read((char*)&header, sizeof(header)) || memcmp(header.magic, ENTRY_MAGIC, 4) != 0) {
+    return false;
+  }
+  encoded.resize(header.bytes);
+  if (!file.read((char*)encoded.data(), header.bytes) || (uint32_t)assetHash(encoded.data(), encoded.size()) != header.bytesHash) {
+    return false;
+  }
+  costMicros = header.costMicros;
+  return true;
+}
+
+bool assetCacheStore(const std::string& dir, uint64_t key, const std::vector<uint8_t>& encoded, uint32_t costMicros) {
+  EntryHeader header;
+  memcpy(header.magic, ENTRY_MAGIC, 4);
+  header.costMicros = costMicros;
+  header.bytes = (uint32_t)encoded.size();
+  header.bytesHash = (uint32_t)assetHash(encoded.data(), encoded.size());
+
+  // Written under a temporary name and renamed, so a parallel or interrupted build never sees half an entry
+  std::string path = entryPath(dir, key);
+  std::string temporary = path + ".tmp" + std::to_string(std::hash<std::thread::id>()(std::this_thread::get_id()));
+  {
+    std::ofstream file(temporary, std::ios::binary);
+    file.write((const char*)&header, sizeof(header));
+    file.write((const char*)encoded.data(), encoded.size());
+    if (!file) return false;
+  }
+  std::error_code code;
+  std::filesystem::rename(temporary, path, code);
+  return !code;
+}
+
+bool assetManifestLoad(const std::string& dir, const std::string& output, AssetManifest& manifest) {
+  std::ifstream file(manifestPath(dir, output), std::ios::binary);
+  ManifestRecord record;
+  if (!file.read((char*)&record, sizeof(record)) || memcmp(record.magic, MANIFEST_MAGIC, 4) != 0) {
+    return false;
+  }
+  manifest = record.manifest;
+  return true;
+}
+
+bool assetManifestStore(const std::string& dir, const std::string& output, const AssetManifest& manifest) {
+  ManifestRecord record = {};
+  memcpy(record.magic, MANIFEST_MAGIC, 4);
+  record.manifest = manifest;
+  std::ofstream file(manifestPath(dir, output), std::ios::binary);
+  file.write((const char*)&record, sizeof(record));
+  return (bool)file;
+}
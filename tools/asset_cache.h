@@ -0,0 +1,44 @@
+/*************************************************************
+********************* ASSET CACHE (HOST) *********************
+**************************************************************/
+
+/*
+Content-addressed cache for the asset build (anim_import --cache):
+ - every frame is keyed by a hash of its source content and the encoder
+   settings; the entry holds the encoded frame as stored in the container
+   and what it cost to make it, so a rebuild only re-encodes changed frames
+   and can report the time it saved
+ - a manifest per output holds the hash of all its inputs and of the output
+   written from them, so an unchanged asset is recognised from the files
+   alone, without decoding anything
+
+Entries are never evicted; delete the directory to start over.
+*/
+
+#pragma once
+
+#include <stdint.h>
+#include <string>
+#include <vector>
+
+const uint64_t ASSET_HASH_SEED = 0x9e3779b97f4a7c15ull;
+
+struct AssetManifest {
+  uint64_t inputsKey;   // input files, durations and encoder settings
+  uint64_t outputHash;  // the output file as written
+  uint64_t costMicros;  // decoding and encoding every frame from scratch
+};
+
+// 64-bit hash of size bytes, 8 at a time (multiply-rotate, murmur-style finish); chain pieces through seed
+uint64_t assetHash(const void* data, size_t size, uint64_t seed = ASSET_HASH_SEED);
+
+// Create the cache directory; false if it can't be created
+bool assetCacheOpen(const std::string& dir, std::string& error);
+
+// Encoded frame stored under key, and the microseconds it took to make; false on a miss
+bool assetCacheLoad(const std::string& dir, uint64_t key, std::vector<uint8_t>& encoded, uint32_t& costMicros);
+bool assetCacheStore(const std::string& dir, uint64_t key, const std::vector<uint8_t>& encoded, uint32_t costMicros);
+
+// Manifest recorded for an output (by its file name); false if none
+bool assetManifestLoad(const std::string& dir, const std::string& output, AssetManifest& manifest);
+bool assetManifestStore(const std::string& dir, const std::string& output, const AssetManifest& manifest);
@@ -0,0 +1,132 @@
+/*************************************************************
+********************* BAND BENCHMARK (HOST) ******************
+**************************************************************/
+
+/*
+Scaling of the firmware's band compositing (band_pool.cpp, pixel_kernels.cpp)
+with 1..N threads, for both band schedules:
+
+  band_bench include/nyancat.h [max-threads] [seconds-per-run]
+
+Each frame is the animation blit (with byte swap) plus the clock's four
+keyed overlays, as loop() composes it. Every run's output is checked
+against the single-threaded result.
+*/
+
+#include <chrono>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <thread>
+#include <vector>
+#include "band_pool.h"
+#include "frame_source.h"
+#include "pixel_kernels.h"
+
+const int FRAME_WIDTH = 320;
+const int FRAME_HEIGHT = 170;
+
+// Overlay layout of the clock (sprite size and position on mainSprite)
+static const struct {
+  int x, y, w, h;
+} overlayLayout[] = {
+  { 7, 8, 218, 26 }, { 235, 30, 80, 40 }, { 231, 100, 100, 64 }, { 5, 145, 70, 20 }
+};
+
+struct BenchFrame {
+  uint16_t* dst;
+  const uint16_t* animation;
+  int animationWidth, animationHeight;
+  const std::vector<uint16_t>* overlays;
+};
+
+// Band job: animation rows, then every overlay clipped to the band
+static void compositeBand(int y0, int y1, void* context) {
+  const BenchFrame& frame = *(const BenchFrame*)context;
+  uint16_t* dst = frame.dst + y0 * FRAME_WIDTH;
+  pixelBlitSwapRect(dst, FRAME_WIDTH, y1 - y0, 0, -y0, frame.animation, frame.animationWidth, frame.animationHeight);
+  for (size_t i = 0; i < sizeof(overlayLayout) / sizeof(overlayLayout[0]); i++) {
+    pixelKeyBlitRect(dst, FRAME_WIDTH, y1 - y0, overlayLayout[i].x, overlayLayout[i].y - y0,
+                     frame.overlays[i].data(), overlayLayout[i].w, overlayLayout[i].h, 0);
+  }
+}
+
+static double nowSeconds() {
+  return std::chrono::duration<double>(std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+// Function to composite frames for a while; returns microseconds per frame
+static double runFrames(const HostAnimation& animation, const std::vector<uint16_t>* overlays,
+                        std::vector<uint16_t>& output, double seconds) {
+  BenchFrame frame = { output.data(), nullptr, animation.width, animation.height, overlays };
+  size_t frames = 0;
+  double start = nowSeconds(), elapsed = 0;
+  while (elapsed < seconds) {
+    frame.animation = animation.frames[frames % animation.frames.size()].data();
+    bandPoolRun(FRAME_HEIGHT, BAND_ROWS, compositeBand, &frame);
+    frames++;
+    if (frames % 16 == 0) elapsed = nowSeconds() - start;
+  }
+  // Leave the output on frame 0 for the comparison
+  frame.animation = animation.frames[0].data();
+  bandPoolRun(FRAME_HEIGHT, BAND_ROWS, compositeBand, &frame);
+  return elapsed * 1e6 / frames;
+}
+
+int main(int argc, char** argv) {
+  if (argc < 2) {
+    fprintf(stderr, "usage: %s <frames.h|input.nyan> [max-threads] [seconds-per-run]\n", argv[0]);
+    return 2;
+  }
+  int maxThreads = argc > 2 ? atoi(argv[2]) : (int)std::thread::hardware_concurrency();
+  double seconds = argc > 3 ? atof(argv[3]) : 1.0;
+  if (maxThreads < 1) maxThreads = 1;
+  if (maxThreads > BAND_MAX_THREADS) maxThreads = BAND_MAX_THREADS;
+
+  HostAnimation animation;
+  std::string error;
+  if (!loadAnimation(argv[1], animation, error)) {
+    fprintf(stderr, "%s\n", error.c_str());
+    return 1;
+  }
+
+  // Overlay contents: opaque text-like blocks on a transparent (black) background
+  std::vector<uint16_t> overlays[4];
+  for (int i = 0; i < 4; i++) {
+    overlays[i].resize((size_t)overlayLayout[i].w * overlayLayout[i].h);
+    for (size_t p = 0; p < overlays[i].size(); p++) {
+      overlays[i][p] = (p / 3) % 5 < 2 ? 0 : (uint16_t)(0xFFFF - p);
+    }
+  }
+
+  std::vector<uint16_t> reference(FRAME_WIDTH * FRAME_HEIGHT), output(FRAME_WIDTH * FRAME_HEIGHT);
+  printf("%zu frames %dx%d, %d hardware threads\n", animation.frames.size(), animation.width, animation.height,
+         (int)std::thread::hardware_concurrency());
+  printf("schedule  threads  us/frame  speedup\n");
+
+  const band_schedule_t schedules[] = { BAND_SCHEDULE_DYNAMIC, BAND_SCHEDULE_STATIC };
+  double single = 0;
+  bool mismatch = false;
+  for (band_schedule_t schedule : schedules) {
+    bandPoolBegin((uint8_t)maxThreads, schedule);
+    for (int threads = 1; threads <= maxThreads; threads++) {
+      bandPoolSetActive((uint8_t)threads);
+      std::vector<uint16_t>& target = single == 0 ? reference : output;
+      double micros = runFrames(animation, overlays, target, seconds);
+      if (single == 0) {
+        single = micros;
+      } else if (output != reference) {
+        mismatch = true;
+      }
+      printf("%-8s  %7d  %8.1f  %6.2fx\n", schedule == BAND_SCHEDULE_DYNAMIC ? "dynamic" : "static",
+             threads, micros, single / micros);
+    }
+    bandPoolEnd();
+  }
+
+  if (mismatch) {
+    printf("output differs from the single-threaded composite\n");
+    return 1;
+  }
+  return 0;
+}
@@ -0,0 +1,92 @@
+# PlatformIO pre-build script: turn the animation sources in assets/ into upload-ready containers
+#
+#   assets/<name>.gif          -> build/assets/<name>.nyan
+#   assets/<name>/*.png        -> build/assets/<name>.nyan (frames in file name order)
+#   assets/<name>.args         optional extra anim_import options, e.g. "--fps 12 --rle"
+#
+# Frames are cached by content in build/assets/cache (tools/asset_cache.h), so a build only
+# re-encodes frames whose source or settings changed, and skips an asset whose inputs are all
+# unchanged. anim_import itself is built from tools/ with CMake on first use.
+
+Import("env")
+
+import glob
+import os
+import shlex
+import shutil
+import subprocess
+import time
+
+PROJECT_DIR = env.subst("$PROJECT_DIR")
+ASSETS_DIR = os.path.join(PROJECT_DIR, "assets")
+OUTPUT_DIR = os.path.join(PROJECT_DIR, "build", "assets")
+CACHE_DIR = os.path.join(OUTPUT_DIR, "cache")
+TOOLS_DIR = os.path.join(PROJECT_DIR, "tools")
+TOOLS_BUILD_DIR = os.path.join(PROJECT_DIR, "build", "tools")
+
+
+def find_assets():
+    """(name, inputs, extra options) for every asset source, sorted by name."""
+    assets = []
+    for entry in sorted(os.listdir(ASSETS_DIR)):
+        path = os.path.join(ASSETS_DIR, entry)
+        name, extension = os.path.splitext(entry)
+        if os.path.isdir(path):
+            inputs = sorted(glob.glob(os.path.join(path, "*.png")))
+            name = entry
+        elif extension.lower() == ".gif":
+            inputs = [path]
+        else:
+            continue
+        if not inputs:
+            continue
+        args_file = os.path.join(ASSETS_DIR, name + ".args")
+        options = []
+        if os.path.isfile(args_file):
+            with open(args_file) as f:
+                options = shlex.split(f.read(), comments=True)
+        assets.append((name, inputs, options))
+    return assets
+
+
+def build_importer():
+    """Path of a built anim_import, or None if the host tools can't be built here."""
+    if shutil.which("cmake") is None:
+        print("assets: cmake not found, skipping the asset build")
+        return None
+    quiet = {"stdout": subprocess.DEVNULL}
+    if not os.path.isfile(os.path.join(TOOLS_BUILD_DIR, "CMakeCache.txt")):
+        if subprocess.call(["cmake", "-S", TOOLS_DIR, "-B", TOOLS_BUILD_DIR], **quiet) != 0:
+            print("assets: configuring the host tools failed, skipping the asset build")
+            return None
+    if subprocess.call(["cmake", "--build", TOOLS_BUILD_DIR, "--target", "anim_import"], **quiet) != 0:
+        print("assets: building anim_import failed, skipping the asset build")
+        return None
+    return os.path.join(TOOLS_BUILD_DIR, "anim_import")
+
+
+def build_assets():
+    if not os.path.isdir(ASSETS_DIR):
+        return
+    assets = find_assets()
+    if not assets:
+        return
+    importer = build_importer()
+    if importer is None:
+        return
+
+    os.makedirs(OUTPUT_DIR, exist_ok=True)
+    started = time.time()
+    for name, inputs, options in assets:
+        output = os.path.join(OUTPUT_DIR, name + ".nyan")
+        command = [importer, "--cache", CACHE_DIR] + options + [output] + inputs
+        result = subprocess.run(command, stdout=subprocess.PIPE, stderr=subprocess.STDOUT, universal_newlines=True)
+        for line in result.stdout.splitlines():
+            print("assets: " + line)
+        if result.returncode != 0:
+            print("assets: %s failed" % name)
+            env.Exit(1)
+    print("assets: %d asset(s) checked in %.2f s" % (len(assets), time.time() - started))
+
+
+build_assets()
@@ -0,0 +1,303 @@
+/*************************************************************
+******************* COLOUR QUANTISATION (HOST) ***************
+**************************************************************/
+
+#include <math.h>
+#include <string.h>
+#include <algorithm>
+#include <array>
+#include "colour_quant.h"
+
+// Perceptual weights of a squared RGB difference (the eye is most sensitive to green, least to blue)
+static const int WEIGHT_R = 3, WEIGHT_G = 4, WEIGHT_B = 2;
+
+// 8x8 Bayer matrix (thresholds 0..63)
+static const uint8_t BAYER[8][8] = {
+  { 0, 32, 8, 40, 2, 34, 10, 42 },  { 48, 16, 56, 24, 50, 18, 58, 26 },
+  { 12, 44, 4, 36, 14, 46, 6, 38 }, { 60, 28, 52, 20, 62, 30, 54, 22 },
+  { 3, 35, 11, 43, 1, 33, 9, 41 },  { 51, 19, 59, 27, 49, 17, 57, 25 },
+  { 15, 47, 7, 39, 13, 45, 5, 37 }, { 63, 31, 55, 23, 61, 29, 53, 21 }
+};
+
+// Function to expand one RGB565 colour to 8-bit channels
+static void expand(uint16_t colour, int rgb[3]) {
+  int r = colour >> 11, g = (colour >> 5) & 0x3F, b = colour & 0x1F;
+  rgb[0] = (r << 3) | (r >> 2);
+  rgb[1] = (g << 2) | (g >> 4);
+  rgb[2] = (b << 3) | (b >> 2);
+}
+
+// Function to round 8-bit channels (any range) to the nearest RGB565 colour
+static uint16_t nearest565(float r, float g, float b) {
+  int r5 = (int)lroundf(r * 31 / 255), g6 = (int)lroundf(g * 63 / 255), b5 = (int)lroundf(b * 31 / 255);
+  r5 = r5 < 0 ? 0 : r5 > 31 ? 31 : r5;
+  g6 = g6 < 0 ? 0 : g6 > 63 ? 63 : g6;
+  b5 = b5 < 0 ? 0 : b5 > 31 ? 31 : b5;
+  return (uint16_t)((r5 << 11) | (g6 << 5) | b5);
+}
+
+static float distance(const float a[3], const int b[3]) {
+  float dr = a[0] - b[0], dg = a[1] - b[1], db = a[2] - b[2];
+  return WEIGHT_R * dr * dr + WEIGHT_G * dg * dg + WEIGHT_B * db * db;
+}
+
+void histogramAdd(ColourHistogram& histogram, const uint8_t* rgb, size_t pixels) {
+  for (size_t i = 0; i < pixels; i++, rgb += 3) {
+    histogram.counts[nearest565(rgb[0], rgb[1], rgb[2])]++;
+  }
+}
+
+void expandRgb565(const uint16_t* pixels, size_t count, uint8_t* rgb) {
+  for (size_t i = 0; i < count; i++, rgb += 3) {
+    int channels[3];
+    expand(pixels[i], channels);
+    rgb[0] = (uint8_t)channels[0];
+    rgb[1] = (uint8_t)channels[1];
+    rgb[2] = (uint8_t)channels[2];
+  }
+}
+
+/*************************************************************
+*************************** PALETTES *************************
+**************************************************************/
+
+// A histogram colour with its (expanded) channels
+struct HistogramColour {
+  int rgb[3];
+  uint32_t count;
+};
+
+// Function to get the count-weighted mean of colours as the nearest RGB565 colour
+static uint16_t meanColour(const HistogramColour* colours, size_t n) {
+  double sums[3] = {}, total = 0;
+  for (size_t i = 0; i < n; i++) {
+    for (int c = 0; c < 3; c++) sums[c] += (double)colours[i].rgb[c] * colours[i].count;
+    total += colours[i].count;
+  }
+  return nearest565((float)(sums[0] / total), (float)(sums[1] / total), (float)(sums[2] / total));
+}
+
+// Median cut: split the box with the largest weighted extent x population at its population median
+static std::vector<uint16_t> medianCut(std::vector<HistogramColour>& colours, int count) {
+  static const int WEIGHTS[3] = { WEIGHT_R, WEIGHT_G, WEIGHT_B };
+  struct Box {
+    size_t begin, end;
+    int channel;
+    double score;
+  };
+  auto measure = [&](Box& box) {
+    int low[3] = { 255, 255, 255 }, high[3] = { 0, 0, 0 };
+    double population = 0;
+    for (size_t i = box.begin; i < box.end; i++) {
+      for (int c = 0; c < 3; c++) {
+        low[c] = std::min(low[c], colours[i].rgb[c]);
+        high[c] = std::max(high[c], colours[i].rgb[c]);
+      }
+      population += colours[i].count;
+    }
+    double widest = -1;
+    for (int c = 0; c < 3; c++) {
+      double extent = (high[c] - low[c]) * sqrt((double)WEIGHTS[c]);
+      if (extent > widest) {
+        widest = extent;
+        box.channel = c;
+      }
+    }
+    box.score = box.end - box.begin > 1 ? widest * population : -1;
+  };
+
+  std::vector<Box> boxes(1, Box { 0, colours.size(), 0, 0 });
+  measure(boxes[0]);
+  while ((int)boxes.size() < count) {
+    size_t pick = 0;
+    for (size_t i = 1; i < boxes.size(); i++) {
+      if (boxes[i].score > boxes[pick].score) pick = i;
+    }
+    Box box = boxes[pick];
+    if (box.score < 0) break; // every box is a single colour
+    int channel = box.channel;
+    std::sort(colours.begin() + box.begin, colours.begin() + box.end,
+              [channel](const HistogramColour& a, const HistogramColour& b) { return a.rgb[channel] < b.rgb[channel]; });
+    double half = 0, population = 0;
+    for (size_t i = box.begin; i < box.end; i++) population += colours[i].count;
+    size_t split = box.begin + 1;
+    for (size_t i = box.begin; i < box.end - 1; i++) {
+      half += colours[i].count;
+      split = i + 1;
+      if (half >= population / 2) break;
+    }
+    Box lower { box.begin, split, 0, 0 }, upper { split, box.end, 0, 0 };
+    measure(lower);
+    measure(upper);
+    boxes[pick] = lower;
+    boxes.push_back(upper);
+  }
+
+  std::vector<uint16_t> palette;
+  for (const Box& box : boxes) palette.push_back(meanColour(&colours[box.begin], box.end - box.begin));
+  return palette;
+}
+
+// K-means (Lloyd) over the histogram colours, seeded by median cut
+static std::vector<uint16_t> kMeans(std::vector<HistogramColour>& colours, int count) {
+  std::vector<uint16_t> seed = medianCut(colours, count);
+  std::vector<std::array<float, 3>> centres(seed.size());
+  for (size_t k = 0; k < seed.size(); k++) {
+    int rgb[3];
+    expand(seed[k], rgb);
+    centres[k] = { (float)rgb[0], (float)rgb[1], (float)rgb[2] };
+  }
+
+  std::vector<int> assigned(colours.size(), -1);
+  for (int iteration = 0; iteration < KMEANS_MAX_ITERATIONS; iteration++) {
+    bool changed = false;
+    for (size_t i = 0; i < colours.size(); i++) {
+      int best = 0;
+      float bestDistance = INFINITY;
+      for (size_t k = 0; k < centres.size(); k++) {
+        float d = distance(centres[k].data(), colours[i].rgb);
+        if (d < bestDistance) {
+          bestDistance = d;
+          best = (int)k;
+        }
+      }
+      if (assigned[i] != best) {
+        assigned[i] = best;
+        changed = true;
+      }
+    }
+    if (!changed) break;
+
+    std::vector<std::array<double, 4>> sums(centres.size(), { 0, 0, 0, 0 });
+    for (size_t i = 0; i < colours.size(); i++) {
+      std::array<double, 4>& sum = sums[assigned[i]];
+      for (int c = 0; c < 3; c++) sum[c] += (double)colours[i].rgb[c] * colours[i].count;
+      sum[3] += colours[i].count;
+    }
+    for (size_t k = 0; k < centres.size(); k++) {
+      if (sums[k][3] == 0) continue; // empty cluster keeps its centre
+      for (int c = 0; c < 3; c++) centres[k][c] = (float)(sums[k][c] / sums[k][3]);
+    }
+  }
+
+  std::vector<uint16_t> palette;
+  for (const std::array<float, 3>& centre : centres) palette.push_back(nearest565(centre[0], centre[1], centre[2]));
+  return palette;
+}
+
+std::vector<uint16_t> buildPalette(const ColourHistogram& histogram, int count, palette_method_t method) {
+  std::vector<HistogramColour> colours;
+  for (uint32_t colour = 0; colour < 65536; colour++) {
+    if (!histogram.counts[colour]) continue;
+    HistogramColour entry;
+    expand((uint16_t)colour, entry.rgb);
+    entry.count = histogram.counts[colour];
+    colours.push_back(entry);
+  }
+  if ((int)colours.size() <= count) {
+    std::vector<uint16_t> exact;
+    for (uint32_t colour = 0; colour < 65536; colour++) {
+      if (histogram.counts[colour]) exact.push_back((uint16_t)colour);
+    }
+    return exact;
+  }
+  std::vector<uint16_t> palette = method == PALETTE_KMEANS ? kMeans(colours, count) : medianCut(colours, count);
+  std::sort(palette.begin(), palette.end());
+  palette.erase(std::unique(palette.begin(), palette.end()), palette.end()); // boxes/centres that round to one colour
+  return palette;
+}
+
+void paletteLookupInit(PaletteLookup& lookup, const std::vector<uint16_t>& palette) {
+  lookup.palette = palette;
+  std::vector<std::array<int, 3>> entries(palette.size());
+  for (size_t k = 0; k < palette.size(); k++) expand(palette[k], entries[k].data());
+
+  lookup.nearest.assign(65536, 0);
+  for (uint32_t colour = 0; colour < 65536; colour++) {
+    int rgb[3];
+    expand((uint16_t)colour, rgb);
+    float target[3] = { (float)rgb[0], (float)rgb[1], (float)rgb[2] };
+    float bestDistance = INFINITY;
+    for (size_t k = 0; k < entries.size(); k++) {
+      float d = distance(target, entries[k].data());
+      if (d < bestDistance) {
+        bestDistance = d;
+        lookup.nearest[colour] = (uint8_t)k;
+      }
+    }
+  }
+
+  // Typical gap between a colour and its nearest neighbour in the palette (ordered dither amplitude)
+  double total = 0;
+  for (size_t k = 0; k < entries.size(); k++) {
+    float self[3] = { (float)entries[k][0], (float)entries[k][1], (float)entries[k][2] };
+    float bestDistance = INFINITY;
+    for (size_t j = 0; j < entries.size(); j++) {
+      if (j != k) bestDistance = std::min(bestDistance, distance(self, entries[j].data()));
+    }
+    if (bestDistance < INFINITY) total += sqrt(bestDistance / (WEIGHT_R + WEIGHT_G + WEIGHT_B));
+  }
+  lookup.ditherAmplitude = entries.size() > 1 ? (float)(total / entries.size()) : 0;
+}
+
+/*************************************************************
+************************** DITHERING *************************
+**************************************************************/
+
+void quantiseFrame(const uint8_t* rgb, int width, int height, dither_mode_t dither, const PaletteLookup* lookup,
+                   std::vector<uint16_t>& pixels, std::vector<uint8_t>* indices) {
+  size_t count = (size_t)width * height;
+  pixels.resize(count);
+  if (indices) indices->resize(count);
+
+  // Ordered dither: +-half a quantisation step (per channel for RGB565, the palette's gap otherwise)
+  float amplitude[3] = { 255.0f / 31, 255.0f / 63, 255.0f / 31 };
+  if (lookup) amplitude[0] = amplitude[1] = amplitude[2] = lookup->ditherAmplitude;
+
+  // Error diffusion: this row and the next, with a pixel of margin either side
+  std::vector<float> errors(dither == DITHER_DIFFUSION ? (size_t)(width + 2) * 3 * 2 : 0, 0.0f);
+
+  for (int y = 0; y < height; y++) {
+    bool reverse = dither == DITHER_DIFFUSION && (y & 1); // serpentine
+    float* current = errors.empty() ? nullptr : &errors[(size_t)(y & 1) * (width + 2) * 3];
+    float* next = errors.empty() ? nullptr : &errors[(size_t)((y + 1) & 1) * (width + 2) * 3];
+    if (next) memset(next, 0, (size_t)(width + 2) * 3 * sizeof(float));
+
+    for (int step = 0; step < width; step++) {
+      int x = reverse ? width - 1 - step : step;
+      size_t i = (size_t)y * width + x;
+      float target[3] = { (float)rgb[i * 3], (float)rgb[i * 3 + 1], (float)rgb[i * 3 + 2] };
+      if (dither == DITHER_ORDERED) {
+        float threshold = (BAYER[y & 7][x & 7] + 0.5f) / 64 - 0.5f;
+        for (int c = 0; c < 3; c++) target[c] += threshold * amplitude[c];
+      } else if (current) {
+        for (int c = 0; c < 3; c++) {
+          target[c] += current[(x + 1) * 3 + c];
+          target[c] = target[c] < 0 ? 0 : target[c] > 255 ? 255 : target[c];
+        }
+      }
+
+      uint16_t colour = nearest565(target[0], target[1], target[2]);
+      if (lookup) {
+        uint8_t index = lookup->nearest[colour];
+        colour = lookup->palette[index];
+        if (indices) (*indices)[i] = index;
+      }
+      pixels[i] = colour;
+
+      if (current) {
+        // Spread what the panel will be off by (7/16 ahead, 3/16, 5/16, 1/16 on the next row)
+        int shown[3];
+        expand(colour, shown);
+        int ahead = reverse ? -1 : 1;
+        for (int c = 0; c < 3; c++) {
+          float error = target[c] - shown[c];
+          current[(x + 1 + ahead) * 3 + c] += error * 7 / 16;
+          next[(x + 1 - ahead) * 3 + c] += error * 3 / 16;
+          next[(x + 1) * 3 + c] += error * 5 / 16;
+          next[(x + 1 + ahead) * 3 + c] += error * 1 / 16;
+        }
+      }
+    }
+  }
+}
@@ -0,0 +1,60 @@
+/*************************************************************
+******************* COLOUR QUANTISATION (HOST) ***************
+**************************************************************/
+
+/*
+Colour reduction for the compact container formats (anim_import):
+ - palettes (ANIM_ENC_PAL8) by median cut or k-means over a histogram of
+   the frames at RGB565 resolution (the panel can't show finer steps), with
+   a perceptually weighted RGB distance; entries are RGB565 colours
+ - dithering tuned for RGB565: the ordered (8x8 Bayer) threshold spans one
+   quantisation step per channel (8.2 levels for red/blue, 4.0 for green),
+   and error diffusion (Floyd-Steinberg, serpentine) carries the error to
+   the colour the panel actually shows (565 expanded back to 888)
+
+Frames are 8-bit RGB (3 bytes per pixel).
+*/
+
+#pragma once
+
+#include <stdint.h>
+#include <vector>
+
+typedef enum {
+  PALETTE_MEDIAN_CUT,
+  PALETTE_KMEANS
+} palette_method_t;
+
+typedef enum {
+  DITHER_NONE,
+  DITHER_ORDERED,
+  DITHER_DIFFUSION
+} dither_mode_t;
+
+const int KMEANS_MAX_ITERATIONS = 16;
+
+// Pixel counts per RGB565 colour
+struct ColourHistogram {
+  std::vector<uint32_t> counts = std::vector<uint32_t>(65536, 0);
+};
+
+void histogramAdd(ColourHistogram& histogram, const uint8_t* rgb, size_t pixels);
+
+// Palette of at most count RGB565 colours (all of them, unchanged, if the histogram has no more)
+std::vector<uint16_t> buildPalette(const ColourHistogram& histogram, int count, palette_method_t method);
+
+// Nearest palette entry for every RGB565 colour, and the ordered dither amplitude for the palette
+struct PaletteLookup {
+  std::vector<uint16_t> palette;
+  std::vector<uint8_t> nearest; // 65536 entries
+  float ditherAmplitude;        // mean distance between neighbouring entries
+};
+
+void paletteLookupInit(PaletteLookup& lookup, const std::vector<uint16_t>& palette);
+
+// Quantise a frame to RGB565 pixels; with a lookup, to its palette (indices as well as pixels)
+void quantiseFrame(const uint8_t* rgb, int width, int height, dither_mode_t dither, const PaletteLookup* lookup,
+                   std::vector<uint16_t>& pixels, std::vector<uint8_t>* indices);
+
+// RGB565 expanded to 8-bit RGB the way the panel shows it (top bits repeated)
+void expandRgb565(const uint16_t* pixels, size_t count, uint8_t* rgb);
@@ -0,0 +1,341 @@
+/*************************************************************
+********************** CONSOLE CHECK (HOST) ******************
+**************************************************************/
+
+/*
+Console line handling (console_line.cpp) and its cost per frame:
+
+  console_check [frames]
+
+Fixed cases (spaces and tabs, CR, empty lines, more words than
+CONSOLE_MAX_ARGS, lines of exactly the buffer size and one more) and
+random input are checked against a std::string reference splitter.
+
+Then a frame loop composites a full 320x170 frame with the pixel kernels
+and polls a console the way console.cpp does: the bytes a 115200 baud
+UART delivers in one 60 fps frame are fed, complete lines are split and
+looked up in a command table. Frame times are compared with and without
+that traffic, and heap allocations during it are counted.
+
+Then the output path: long responses are streamed through the firmware's
+consoleStreamContinue() into a model of the UART TX FIFO (128 bytes,
+drained at 115200 baud between frames), with steps printing the longest
+lines of "trace", "quality" and "help" in the firmware's formats. Per
+response: frames to finish, bytes and time per poll, and any byte written
+without room (on the device that write would block the loop).
+Handlers are stubs and the serial driver runs on the device only, so
+its time is not included.
+Exits 1 on any mismatch, any allocation, any blocking write, or if the
+traffic or a streaming poll adds more than CONSOLE_CHECK_MAX_COST_US per frame.
+*/
+
+#include <algorithm>
+#include <chrono>
+#include <new>
+#include <stdarg.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <string>
+#include <vector>
+#include "console_line.h"
+#include "pixel_kernels.h"
+
+const int FRAME_WIDTH = 320;
+const int FRAME_HEIGHT = 170;
+const int UART_BYTES_PER_FRAME = 115200 / 10 / 60;      // 8N1 at 60 fps
+const double CONSOLE_CHECK_MAX_COST_US = 50;              // vs a 16667 us frame and the 300 us poll budget
+const int UART_TX_FIFO_BYTES = 128;                       // ESP32-S3 UART FIFO (no TX ring buffer configured)
+const int STAGE_COUNT = 8;                                // render stages in metrics.h
+
+static int errors = 0;
+static size_t allocations = 0;
+
+// Count every heap allocation made by this program
+void* operator new(size_t size) {
+  allocations++;
+  void* p = malloc(size ? size : 1);
+  if (!p) throw std::bad_alloc();
+  return p;
+}
+void operator delete(void* p) noexcept { free(p); }
+void operator delete(void* p, size_t) noexcept { free(p); }
+
+// Reference: split at spaces and tabs, keep the first CONSOLE_MAX_ARGS words
+static std::vector<std::string> referenceSplit(const std::string& text) {
+  std::vector<std::string> words;
+  size_t i = 0;
+  while (i < text.size() && words.size() < CONSOLE_MAX_ARGS) {
+    while (i < text.size() && (text[i] == ' ' || text[i] == '\t')) i++;
+    size_t start = i;
+    while (i < text.size() && text[i] != ' ' && text[i] != '\t') i++;
+    if (i > start) words.push_back(text.substr(start, i - start));
+  }
+  return words;
+}
+
+// Function to feed input and compare every finished line with the reference
+static void checkInput(const char* name, const std::string& input) {
+  ConsoleLine line;
+  consoleLineInit(line);
+  std::string pending;
+  for (char c : input) {
+    console_line_t result = consoleLineFeed(line, c);
+    if (c != '\n') {
+      if (c != '\r') pending += c;
+      if (result != CONSOLE_LINE_PENDING && ++errors <= 10) printf("  %s: line ended early\n", name);
+      continue;
+    }
+
+    bool tooLong = pending.size() > CONSOLE_LINE_LENGTH - 1;
+    if (result != (tooLong ? CONSOLE_LINE_TOO_LONG : CONSOLE_LINE_READY)) {
+      if (++errors <= 10) printf("  %s: %u-character line reported %d\n", name, (unsigned)pending.size(), result);
+    } else if (!tooLong) {
+      char* argv[CONSOLE_MAX_ARGS];
+      int argc = consoleLineSplit(line, argv);
+      std::vector<std::string> want = referenceSplit(pending);
+      bool same = argc == (int)want.size();
+      for (int i = 0; same && i < argc; i++) same = want[i] == argv[i];
+      if (!same && ++errors <= 10) printf("  %s: \"%s\" split into %d words\n", name, pending.c_str(), argc);
+    }
+    pending.clear();
+  }
+}
+
+static void checkLines() {
+  checkInput("command", "stats\n");
+  checkInput("arguments", " \t brightness   128 \t\n");
+  checkInput("CR", "anim\r 2\r\n");
+  checkInput("empty", "\n\r\n \t \n");
+  checkInput("extra words", "a b c d e f\nhud on\n");
+  checkInput("fits", std::string(CONSOLE_LINE_LENGTH - 1, 'x') + "\n");
+  checkInput("too long", std::string(CONSOLE_LINE_LENGTH, 'x') + "\nstats\n");
+  checkInput("far too long", std::string(1000, 'y') + "\n\nntp\n");
+  printf("fixed lines: %d errors\n", errors);
+
+  const char alphabet[] = "ab \t\r\n";
+  for (int run = 0; run < 2000; run++) {
+    std::string input;
+    int length = rand() % 300;
+    for (int i = 0; i < length; i++) {
+      input += rand() % 20 ? alphabet[rand() % 6] : (char)(33 + rand() % 90);
+    }
+    input += '\n';
+    checkInput("random", input);
+  }
+  printf("random input: %d errors\n", errors);
+}
+
+// Command table as console.cpp looks it up; handlers only count
+static int handled = 0;
+static const char* const COMMANDS[] = { "stats", "trace", "brightness", "ntp", "anim", "hud", "screenshot", "mem" };
+static const char TRAFFIC[] = "stats\nbrightness 200\nanim 3\nhud on\ntrace\nbogus command here\r\n\n"
+                              "screenshot\nntp\nmem\nthis line is far too long for the console line buffer, it gets dropped\n";
+
+// Function to poll the console once: feed what arrived this frame, run finished lines
+static void pollConsole(ConsoleLine& line, size_t& cursor, int bytes) {
+  for (int i = 0; i < bytes; i++) {
+    char c = TRAFFIC[cursor++ % (sizeof(TRAFFIC) - 1)];
+    if (consoleLineFeed(line, c) != CONSOLE_LINE_READY) continue;
+    char* argv[CONSOLE_MAX_ARGS];
+    int argc = consoleLineSplit(line, argv);
+    if (argc == 0) continue;
+    for (const char* name : COMMANDS) {
+      if (strcmp(argv[0], name) == 0) {
+        handled += argc;
+        break;
+      }
+    }
+  }
+}
+
+static double nowMicros() {
+  return std::chrono::duration<double, std::micro>(std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+// Function to time frames with bytesPerFrame of console input, return the sorted frame times
+static std::vector<double> frameTimes(int frames, int bytesPerFrame, double& consoleMedian) {
+  static std::vector<uint16_t> art((size_t)FRAME_WIDTH * FRAME_HEIGHT), frame((size_t)FRAME_WIDTH * FRAME_HEIGHT);
+  for (uint16_t& pixel : art) pixel = (uint16_t)rand();
+  std::vector<double> times(frames), polls(frames);
+  ConsoleLine line;
+  consoleLineInit(line);
+  size_t cursor = 0;
+  size_t allocationsBefore = allocations;
+  for (int i = 0; i < frames; i++) {
+    double start = nowMicros();
+    pixelBlitSwapRect(frame.data(), FRAME_WIDTH, FRAME_HEIGHT, 0, 0, art.data(), FRAME_WIDTH, FRAME_HEIGHT);
+    pixelKeyBlitRect(frame.data(), FRAME_WIDTH, FRAME_HEIGHT, 40, 30, art.data(), 200, 100, 0);
+    double console = nowMicros();
+    pollConsole(line, cursor, bytesPerFrame);
+    double end = nowMicros();
+    times[i] = end - start;
+    polls[i] = end - console;
+  }
+  if (allocations != allocationsBefore && ++errors <= 10) {
+    printf("  %u allocations during console traffic\n", (unsigned)(allocations - allocationsBefore));
+  }
+  std::sort(times.begin(), times.end());
+  std::sort(polls.begin(), polls.end());
+  consoleMedian = polls[frames / 2];
+  return times;
+}
+
+static void checkFrameTimes(int frames) {
+  double quietPoll, busyPoll, floodPoll;
+  std::vector<double> quiet = frameTimes(frames, 0, quietPoll);
+  std::vector<double> busy = frameTimes(frames, UART_BYTES_PER_FRAME, busyPoll);
+  std::vector<double> flood = frameTimes(frames, UART_BYTES_PER_FRAME * 10, floodPoll);
+
+  printf("\n%d frames, console input per frame: median / p99 frame time, median poll\n", frames);
+  printf("  none          %8.1f / %8.1f us %6.2f us\n", quiet[frames / 2], quiet[frames * 99 / 100], quietPoll);
+  printf("  %4d bytes    %8.1f / %8.1f us %6.2f us\n", UART_BYTES_PER_FRAME, busy[frames / 2],
+         busy[frames * 99 / 100], busyPoll);
+  printf("  %4d bytes    %8.1f / %8.1f us %6.2f us\n", UART_BYTES_PER_FRAME * 10, flood[frames / 2],
+         flood[frames * 99 / 100], floodPoll);
+  printf("  %d command words handled\n", handled);
+
+  double cost = busy[frames / 2] - quiet[frames / 2];
+  if (cost > CONSOLE_CHECK_MAX_COST_US && ++errors <= 10) {
+    printf("  console traffic adds %.1f us per frame (limit %.1f)\n", cost, CONSOLE_CHECK_MAX_COST_US);
+  }
+}
+
+/*************************************************************
+*********************** OUTPUT PATH **************************
+**************************************************************/
+
+// Host stand-in for Arduino's Print: writes into the TX FIFO model
+class Print {
+ public:
+  int queued = 0;          // bytes in the FIFO
+  size_t pollBytes = 0;    // bytes written during the current poll
+  size_t blocked = 0;      // bytes written while the FIFO was full
+  size_t line = 0;         // bytes of the line being written
+  size_t longestLine = 0;
+
+  size_t write(const char* text, size_t length) {
+    int room = UART_TX_FIFO_BYTES - queued;
+    if ((int)length > room) blocked += length - std::max(room, 0);
+    queued = std::min(UART_TX_FIFO_BYTES, queued + (int)length);
+    pollBytes += length;
+    for (size_t i = 0; i < length; i++) {
+      line++;
+      if (text[i] == '\n') {
+        longestLine = std::max(longestLine, line);
+        line = 0;
+      }
+    }
+    return length;
+  }
+
+  size_t printf(const char* format, ...) {
+    char text[256];
+    va_list args;
+    va_start(args, format);
+    int length = vsnprintf(text, sizeof(text), format, args);
+    va_end(args);
+    return write(text, std::min(length, (int)sizeof(text) - 1));
+  }
+
+  size_t print(const char* text) { return write(text, strlen(text)); }
+  size_t println(const char* text = "") { return print(text) + print("\r\n"); }
+};
+
+static Print uart;
+
+// TX room as Serial.availableForWrite() reports it
+static int uartRoom() {
+  return UART_TX_FIFO_BYTES - uart.queued;
+}
+
+static unsigned long hostMicros() {
+  return (unsigned long)nowMicros();
+}
+
+// "trace": header and 64 frames, widest values (metricsPrintTraceLine)
+static bool traceLine(Print& out, uint32_t index) {
+  if (index == 0) {
+    out.print("ms        total");
+    for (int i = 0; i < STAGE_COUNT; i++) out.printf(" %9s", "push_wait");
+  } else {
+    out.printf("%-9u %5u", 999999999u, 99999u);
+    for (int i = 0; i < STAGE_COUNT; i++) out.printf(" %9u", 999999999u);
+  }
+  out.println();
+  return index < 64;
+}
+
+// "quality": level and a full log, widest values (consoleQualityLine in main.cpp)
+static bool qualityLine(Print& out, uint32_t index) {
+  if (index == 0) {
+    out.printf("quality %s (%s), %u transitions\n", "reduced-overlays", "pinned", 4000000000u);
+  } else {
+    out.printf("  %s (uptime %9u ms) %-16s -> %-16s", "23:59:59", 999999999u, "reduced-overlays", "reduced-overlays");
+    out.printf(" %u%% over budget, %u%% with headroom\n", 100u, 100u);
+  }
+  return index < 16;
+}
+
+// "help": a full command table (printHelpLine in console.cpp)
+static bool helpLine(Print& out, uint32_t index) {
+  out.printf("%s - %s\n", "quality", "pin an adaptive quality level or hand it back to the controller");
+  return index + 1 < 16;
+}
+
+// Function to stream one response, one console poll per frame as consolePoll() runs it
+static void checkStream(const char* name, ConsoleStreamStep step) {
+  static std::vector<uint16_t> art((size_t)FRAME_WIDTH * FRAME_HEIGHT), screen((size_t)FRAME_WIDTH * FRAME_HEIGHT);
+  const int maxFrames = 1000;
+  ConsoleStream stream = { step, 0 };
+  std::vector<double> polls;
+  polls.reserve(maxFrames);
+  size_t maxPollBytes = 0;
+  size_t allocationsBefore = allocations;
+  uart = Print();
+  bool streaming = true;
+  for (int i = 0; i < maxFrames && streaming; i++) {
+    pixelBlitSwapRect(screen.data(), FRAME_WIDTH, FRAME_HEIGHT, 0, 0, art.data(), FRAME_WIDTH, FRAME_HEIGHT);
+    uart.queued = std::max(0, uart.queued - UART_BYTES_PER_FRAME); // sent since the last poll
+    uart.pollBytes = 0;
+    double start = nowMicros();
+    streaming = consoleStreamContinue(stream, uart, uartRoom, hostMicros, hostMicros());
+    polls.push_back(nowMicros() - start);
+    maxPollBytes = std::max(maxPollBytes, uart.pollBytes);
+  }
+  if (allocations != allocationsBefore && ++errors <= 10) {
+    printf("  %s: %u allocations while streaming\n", name, (unsigned)(allocations - allocationsBefore));
+  }
+
+  std::sort(polls.begin(), polls.end());
+  double median = polls[polls.size() / 2];
+  printf("  %-8s %4u lines in %4u frames, %4u bytes/poll max, %4u-byte lines, %6.2f / %6.2f us\n", name,
+         (unsigned)stream.index, (unsigned)polls.size(), (unsigned)maxPollBytes, (unsigned)uart.longestLine, median,
+         polls.back());
+  if (streaming && ++errors <= 10) printf("  %s: not finished after %d frames\n", name, maxFrames);
+  if (uart.blocked && ++errors <= 10) printf("  %s: %u bytes written without TX room\n", name, (unsigned)uart.blocked);
+  if (uart.longestLine > (size_t)CONSOLE_MIN_TX_ROOM && ++errors <= 10) {
+    printf("  %s: line longer than CONSOLE_MIN_TX_ROOM (%d)\n", name, CONSOLE_MIN_TX_ROOM);
+  }
+  if (median > CONSOLE_CHECK_MAX_COST_US && ++errors <= 10) {
+    printf("  %s: streaming poll takes %.1f us (limit %.1f)\n", name, median, CONSOLE_CHECK_MAX_COST_US);
+  }
+}
+
+static void checkOutput() {
+  printf("\nstreamed responses (%d-byte TX FIFO, %d bytes sent per frame): frames, max per poll, median / max poll\n",
+         UART_TX_FIFO_BYTES, UART_BYTES_PER_FRAME);
+  checkStream("trace", traceLine);
+  checkStream("quality", qualityLine);
+  checkStream("help", helpLine);
+}
+
+int main(int argc, char** argv) {
+  int frames = argc > 1 ? atoi(argv[1]) : 5000;
+  srand(1);
+  checkLines();
+  checkFrameTimes(frames > 100 ? frames : 100);
+  checkOutput();
+  printf("%s\n", errors ? "FAILED" : "ok");
+  return errors ? 1 : 0;
+}
@@ -0,0 +1,141 @@
+/*************************************************************
+******************** DECODE BENCHMARK (HOST) *****************
+**************************************************************/
+
+/*
+Runs the firmware's background decoder (frame_ring.cpp, frame_cache.cpp
+and animDecodeFrame) with the producer on a std::thread, for throughput
+testing:
+
+  anim_pack --rle include/nyancat.h nyancat.nyan
+  decode_bench nyancat.nyan [fps] [seconds] [cache-KB]
+
+First the decoder alone (frames/s one thread can decode), then a renderer
+consuming frames at fps (0 = as fast as it can) while the producer decodes
+ahead through a decoded-frame cache of cache-KB (default 0 = none), with
+the ring's underrun/discard counters, final read-ahead and cache stats.
+*/
+
+#include <atomic>
+#include <chrono>
+#include <fstream>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <thread>
+#include <vector>
+#include "anim_container.h"
+#include "frame_cache.h"
+#include "frame_ring.h"
+
+struct Container {
+  AnimHeader header;
+  std::vector<uint8_t> data;
+  const uint8_t* payload() const { return data.data() + header.headerSize; }
+};
+
+static FrameCache cache;
+
+static double nowSeconds() {
+  return std::chrono::duration<double>(std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+static uint32_t clockMicros() {
+  return (uint32_t)(uint64_t)(nowSeconds() * 1e6);
+}
+
+static bool decodeContainerFrame(int index, uint16_t* pixels, void* context) {
+  const Container& container = *(const Container*)context;
+  return animDecodeFrame(container.header, container.payload(), index, pixels);
+}
+
+// Decode callback for the ring, through the cache as on the device
+static bool decodeFrame(int index, uint16_t* pixels, void* context) {
+  return frameCacheFill(cache, index, pixels, decodeContainerFrame, context, clockMicros);
+}
+
+int main(int argc, char** argv) {
+  if (argc < 2) {
+    fprintf(stderr, "usage: %s <animation.nyan> [fps] [seconds] [cache-KB]\n", argv[0]);
+    return 2;
+  }
+  double fps = argc > 2 ? atof(argv[2]) : 30;
+  double seconds = argc > 3 ? atof(argv[3]) : 5;
+  size_t cacheBytes = argc > 4 ? (size_t)atoi(argv[4]) * 1024 : 0;
+
+  Container container;
+  std::ifstream file(argv[1], std::ios::binary);
+  container.data.assign(std::istreambuf_iterator<char>(file), std::istreambuf_iterator<char>());
+  if (container.data.size() < sizeof(AnimHeader)) {
+    fprintf(stderr, "cannot read %s\n", argv[1]);
+    return 1;
+  }
+  memcpy(&container.header, container.data.data(), sizeof(AnimHeader));
+  const AnimHeader& header = container.header;
+  if (!animHeaderValid(header, (uint32_t)container.data.size())) {
+    fprintf(stderr, "invalid container header in %s\n", argv[1]);
+    return 1;
+  }
+  printf("%u frames %ux%u, %s, %.1f KB payload\n", header.frameCount, header.width, header.height,
+         header.encoding == ANIM_ENC_RLE565 ? "rle565" : header.encoding == ANIM_ENC_PAL8 ? "pal8" : "raw565", header.payloadBytes / 1024.0);
+
+  // Decoder alone
+  std::vector<uint16_t> scratch(header.frameBytes / 2);
+  int decoded = 0;
+  double start = nowSeconds();
+  while (nowSeconds() - start < 1.0) {
+    decodeContainerFrame(decoded % header.frameCount, scratch.data(), &container);
+    decoded++;
+  }
+  double elapsed = nowSeconds() - start;
+  printf("decoder alone: %.0f frames/s (%.1f us/frame)\n", decoded / elapsed, elapsed * 1e6 / decoded);
+
+  // Producer thread + paced renderer
+  std::vector<std::vector<uint16_t>> buffers(FRAME_RING_SLOTS, std::vector<uint16_t>(header.frameBytes / 2));
+  uint16_t* slots[FRAME_RING_SLOTS];
+  for (int i = 0; i < FRAME_RING_SLOTS; i++) slots[i] = buffers[i].data();
+  uint8_t cacheEntries = frameCacheEntriesFor(cacheBytes, header.frameBytes, header.frameCount);
+  std::vector<std::vector<uint16_t>> cacheBuffers(cacheEntries, std::vector<uint16_t>(header.frameBytes / 2));
+  uint16_t* cacheSlots[FRAME_CACHE_MAX_ENTRIES];
+  for (int i = 0; i < cacheEntries; i++) cacheSlots[i] = cacheBuffers[i].data();
+  frameCacheInit(cache, cacheSlots, cacheEntries, header.frameBytes);
+  static FrameRing ring;
+  frameRingInit(ring, slots, header.frameCount, decodeFrame, &container);
+
+  std::atomic<bool> running(true);
+  std::thread producer([&] {
+    while (running) {
+      if (!frameRingProduce(ring)) std::this_thread::yield();
+    }
+  });
+
+  std::vector<uint16_t> framebuffer(header.frameBytes / 2);
+  int frame = 0, rendered = 0;
+  start = nowSeconds();
+  double next = start;
+  while (nowSeconds() - start < seconds) {
+    const uint16_t* pixels = frameRingAcquire(ring, frame);
+    if (pixels) memcpy(framebuffer.data(), pixels, header.frameBytes); // the blit
+    rendered++;
+    frame = (frame + 1) % header.frameCount;
+    if (fps > 0) {
+      next += 1.0 / fps;
+      while (nowSeconds() < next) std::this_thread::yield();
+    }
+  }
+  elapsed = nowSeconds() - start;
+  running = false;
+  producer.join();
+  frameRingStop(ring);
+
+  const FrameRingStats& stats = ring.stats;
+  printf("renderer: %.1f frames/s over %.1f s\n", rendered / elapsed, elapsed);
+  printf("ring: %u decoded, %u shown, %u underruns, %u discarded, %u errors, read-ahead %u\n",
+         stats.decoded, stats.shown, stats.underruns, stats.discarded, stats.decodeErrors, stats.ahead);
+  if (cache.capacity) {
+    printf("cache: %u frames, %u KB held, %u%% hits, %u evictions, %u ms decode saved\n", (unsigned)cache.capacity,
+           (unsigned)(cache.stats.bytesHeld / 1024), (unsigned)frameCacheHitPercent(cache),
+           (unsigned)cache.stats.evictions, (unsigned)cache.stats.msSaved);
+  }
+  return stats.decodeErrors ? 1 : 0;
+}
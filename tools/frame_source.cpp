@@ -0,0 +1,226 @@
+/*************************************************************
+******************** FRAME SOURCE (HOST) *********************
+**************************************************************/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <fstream>
+#include <map>
+#include <sstream>
+#include "frame_source.h"
+#include "anim_container.h"
+#include "rle565.h"
+
+// Function to read an integer assignment such as "framesNumber=17"
+static bool findInt(const std::string& text, const char* name, int& value) {
+  size_t at = text.find(name);
+  if (at == std::string::npos) return false;
+  at = text.find('=', at);
+  if (at == std::string::npos) return false;
+  value = atoi(text.c_str() + at + 1);
+  return true;
+}
+
+bool loadFrameHeader(const std::string& path, HostAnimation& animation, std::string& error) {
+  std::ifstream file(path, std::ios::binary);
+  if (!file) {
+    error = "cannot open " + path;
+    return false;
+  }
+  std::stringstream contents;
+  contents << file.rdbuf();
+  std::string text = contents.str();
+
+  int frameCount = 0;
+  if (!findInt(text, "framesNumber", frameCount) || !findInt(text, "aniWidth", animation.width) ||
+      !findInt(text, "aniHeigth", animation.height)) {
+    error = "missing framesNumber/aniWidth/aniHeigth in " + path;
+    return false;
+  }
+
+  // Every hex literal after the array declaration is a pixel
+  size_t pixelsPerFrame = (size_t)animation.width * animation.height;
+  std::vector<uint16_t> pixels;
+  pixels.reserve(pixelsPerFrame * frameCount);
+  const char* cursor = text.c_str() + text.find('{');
+  while ((cursor = strstr(cursor, "0x")) != nullptr) {
+    char* end;
+    pixels.push_back((uint16_t)strtoul(cursor, &end, 16));
+    cursor = end;
+  }
+  if (pixels.size() != pixelsPerFrame * frameCount) {
+    error = "expected " + std::to_string(pixelsPerFrame * frameCount) + " pixels, found " + std::to_string(pixels.size());
+    return false;
+  }
+
+  animation.frames.clear();
+  for (int i = 0; i < frameCount; i++) {
+    animation.frames.emplace_back(pixels.begin() + i * pixelsPerFrame, pixels.begin() + (i + 1) * pixelsPerFrame);
+  }
+  animation.durationsMs.clear();
+  return true;
+}
+
+bool loadContainer(const std::string& path, HostAnimation& animation, std::string& error) {
+  std::ifstream file(path, std::ios::binary);
+  std::vector<uint8_t> data((std::istreambuf_iterator<char>(file)), std::istreambuf_iterator<char>());
+  if (data.size() < sizeof(AnimHeader)) {
+    error = "cannot read " + path;
+    return false;
+  }
+  AnimHeader header;
+  memcpy(&header, data.data(), sizeof(header));
+  if (!animHeaderValid(header, (uint32_t)data.size())) {
+    error = "invalid container header in " + path;
+    return false;
+  }
+  const uint8_t* payload = data.data() + header.headerSize;
+  if (crc32Update(0, payload, header.payloadBytes) != header.payloadCrc32) {
+    error = "payload CRC mismatch in " + path;
+    return false;
+  }
+  if (!animDurationsValid(header, payload)) {
+    error = "zero frame duration in " + path;
+    return false;
+  }
+
+  animation.width = header.width;
+  animation.height = header.height;
+  animation.frames.assign(header.frameCount, std::vector<uint16_t>((size_t)header.width * header.height));
+  for (int i = 0; i < header.frameCount; i++) {
+    if (!animDecodeFrame(header, payload, i, animation.frames[i].data())) {
+      error = "frame " + std::to_string(i) + " is malformed in " + path;
+      return false;
+    }
+  }
+  animation.durationsMs.clear();
+  if (header.flags & ANIM_FLAG_DURATIONS) {
+    for (int i = 0; i < header.frameCount; i++) {
+      animation.durationsMs.push_back(animFrameDurationMs(header, payload, i));
+    }
+  }
+  return true;
+}
+
+std::vector<uint8_t> encodeContainerFrame(const std::vector<uint16_t>& pixels, int width, int height, uint8_t encoding) {
+  size_t count = (size_t)width * height;
+  if (encoding == ANIM_ENC_RLE565) {
+    std::vector<uint8_t> encoded(rle565MaxSize(count));
+    encoded.resize(rle565EncodeRect(pixels.data(), width, width, height, encoded.data(), encoded.size()));
+    return encoded;
+  }
+  const uint8_t* bytes = (const uint8_t*)pixels.data();
+  return std::vector<uint8_t>(bytes, bytes + count * 2);
+}
+
+bool saveContainer(const std::string& path, const HostAnimation& animation, std::string& error, uint8_t encoding) {
+  std::vector<std::vector<uint8_t>> frames;
+  std::vector<uint16_t> palette;
+  if (encoding == ANIM_ENC_PAL8) {
+    // Exact palette of the colours used
+    std::map<uint16_t, uint8_t> indices;
+    for (const std::vector<uint16_t>& frame : animation.frames) {
+      for (uint16_t colour : frame) {
+        if (indices.count(colour)) continue;
+        if (palette.size() == ANIM_PALETTE_SIZE) {
+          error = "more than " + std::to_string(ANIM_PALETTE_SIZE) + " colours, reduce them with anim_import --pal8";
+          return false;
+        }
+        indices[colour] = (uint8_t)palette.size();
+        palette.push_back(colour);
+      }
+    }
+    for (const std::vector<uint16_t>& frame : animation.frames) {
+      std::vector<uint8_t> encoded(frame.size());
+      for (size_t i = 0; i < frame.size(); i++) encoded[i] = indices[frame[i]];
+      frames.push_back(std::move(encoded));
+    }
+  } else {
+    for (const std::vector<uint16_t>& frame : animation.frames) {
+      frames.push_back(encodeContainerFrame(frame, animation.width, animation.height, encoding));
+    }
+  }
+  return saveEncodedContainer(path, animation.width, animation.height, encoding, frames, animation.durationsMs, error,
+                              palette);
+}
+
+bool saveEncodedContainer(const std::string& path, int width, int height, uint8_t encoding,
+                          const std::vector<std::vector<uint8_t>>& frames, const std::vector<uint16_t>& durationsMs,
+                          std::string& error, const std::vector<uint16_t>& palette) {
+  AnimHeader header = {};
+  header.width = (uint16_t)width;
+  header.height = (uint16_t)height;
+  header.frameCount = (uint16_t)frames.size();
+  header.encoding = encoding;
+  header.frameBytes = (uint32_t)width * height * 2;
+
+  std::vector<uint8_t> payload;
+  if (encoding == ANIM_ENC_PAL8) {
+    // Palette (unused entries black), then one index per pixel
+    if (palette.empty() || palette.size() > ANIM_PALETTE_SIZE) {
+      error = "PAL8 needs 1 to " + std::to_string(ANIM_PALETTE_SIZE) + " palette colours";
+      return false;
+    }
+    std::vector<uint16_t> entries(palette);
+    entries.resize(ANIM_PALETTE_SIZE, 0);
+    const uint8_t* bytes = (const uint8_t*)entries.data();
+    payload.insert(payload.end(), bytes, bytes + ANIM_PALETTE_BYTES);
+    for (const std::vector<uint8_t>& frame : frames) {
+      if (frame.size() != (size_t)width * height) {
+        error = "PAL8 frame of the wrong size";
+        return false;
+      }
+      payload.insert(payload.end(), frame.begin(), frame.end());
+    }
+  } else if (encoding == ANIM_ENC_RLE565) {
+    // Offset table first, filled in as the frames are appended
+    payload.resize(((size_t)header.frameCount + 1) * 4);
+    for (size_t i = 0; i <= frames.size(); i++) {
+      uint32_t offset = (uint32_t)payload.size();
+      memcpy(payload.data() + i * 4, &offset, 4);
+      if (i < frames.size()) payload.insert(payload.end(), frames[i].begin(), frames[i].end());
+    }
+  } else {
+    for (const std::vector<uint8_t>& frame : frames) {
+      if (frame.size() != header.frameBytes) {
+        error = "raw frame of the wrong size";
+        return false;
+      }
+      payload.insert(payload.end(), frame.begin(), frame.end());
+    }
+  }
+  if (!durationsMs.empty()) {
+    if (durationsMs.size() != frames.size()) {
+      error = "durations don't match the frame count";
+      return false;
+    }
+    for (size_t i = 0; i < durationsMs.size(); i++) {
+      if (durationsMs[i] == 0) {
+        error = "frame " + std::to_string(i) + " has a zero duration";
+        return false;
+      }
+    }
+    header.flags = ANIM_FLAG_DURATIONS;
+    const uint8_t* bytes = (const uint8_t*)durationsMs.data();
+    payload.insert(payload.end(), bytes, bytes + durationsMs.size() * 2);
+  }
+  header.payloadBytes = (uint32_t)payload.size();
+  animHeaderFinish(header, crc32Update(0, payload.data(), payload.size()));
+
+  std::ofstream file(path, std::ios::binary);
+  file.write((const char*)&header, sizeof(header));
+  file.write((const char*)payload.data(), payload.size());
+  if (!file) {
+    error = "cannot write " + path;
+    return false;
+  }
+  return true;
+}
+
+bool loadAnimation(const std::string& path, HostAnimation& animation, std::string& error) {
+  if (path.size() > 2 && path.compare(path.size() - 2, 2, ".h") == 0) {
+    return loadFrameHeader(path, animation, error);
+  }
+  return loadContainer(path, animation, error);
+}
@@ -0,0 +1,41 @@
+/*************************************************************
+******************** FRAME SOURCE (HOST) *********************
+**************************************************************/
+
+// Loading animation frames on the host (nyancat.h-style headers and containers)
+
+#pragma once
+
+#include <stdint.h>
+#include <string>
+#include <vector>
+#include "anim_container.h"
+
+struct HostAnimation {
+  int width = 0;
+  int height = 0;
+  std::vector<std::vector<uint16_t>> frames; // native-order RGB565
+  std::vector<uint16_t> durationsMs;         // per frame, empty if unknown
+};
+
+// Parse a header like include/nyancat.h (framesNumber/aniWidth/aniHeigth + hex arrays)
+bool loadFrameHeader(const std::string& path, HostAnimation& animation, std::string& error);
+
+// Read/write an animation container (anim_container.h), any ANIM_ENC_* encoding; durationsMs, when
+// not empty, is stored as the per-frame durations table (version 2). ANIM_ENC_PAL8 is lossless here:
+// it fails for more than ANIM_PALETTE_SIZE colours (anim_import --pal8 reduces them)
+bool loadContainer(const std::string& path, HostAnimation& animation, std::string& error);
+bool saveContainer(const std::string& path, const HostAnimation& animation, std::string& error,
+                   uint8_t encoding = ANIM_ENC_RAW565);
+
+// One frame's pixels as stored in a container payload (raw bytes or an RLE565 stream; not PAL8)
+std::vector<uint8_t> encodeContainerFrame(const std::vector<uint16_t>& pixels, int width, int height, uint8_t encoding);
+
+// Write a container from frames already encoded (so they can be cached): encodeContainerFrame() output,
+// or palette indices for ANIM_ENC_PAL8 with up to ANIM_PALETTE_SIZE palette colours
+bool saveEncodedContainer(const std::string& path, int width, int height, uint8_t encoding,
+                          const std::vector<std::vector<uint8_t>>& frames, const std::vector<uint16_t>& durationsMs,
+                          std::string& error, const std::vector<uint16_t>& palette = {});
+
+// Load either format, chosen by file extension (.h = header, otherwise container)
+bool loadAnimation(const std::string& path, HostAnimation& animation, std::string& error);
@@ -0,0 +1,597 @@
+/*************************************************************
+******************** IMAGE DECODING (HOST) *******************
+**************************************************************/
+
+#include <stdlib.h>
+#include <string.h>
+#include <fstream>
+#include "image_decode.h"
+
+bool readFileBytes(const std::string& path, std::vector<uint8_t>& data, std::string& error) {
+  std::ifstream file(path, std::ios::binary);
+  if (!file) {
+    error = "cannot open " + path;
+    return false;
+  }
+  file.seekg(0, std::ios::end);
+  data.resize((size_t)file.tellg());
+  file.seekg(0);
+  if (!file.read((char*)data.data(), data.size())) {
+    error = "cannot read " + path;
+    return false;
+  }
+  return true;
+}
+
+/*************************************************************
+*************************** INFLATE **************************
+**************************************************************/
+
+// Bit reader over a deflate stream (LSB first)
+struct BitReader {
+  const uint8_t* data;
+  size_t size;
+  size_t pos;
+  uint32_t buffer;
+  int count;
+  bool overrun;
+};
+
+static uint32_t readBits(BitReader& in, int bits) {
+  while (in.count < bits) {
+    if (in.pos >= in.size) {
+      in.overrun = true;
+      return 0;
+    }
+    in.buffer |= (uint32_t)in.data[in.pos++] << in.count;
+    in.count += 8;
+  }
+  uint32_t value = in.buffer & ((1u << bits) - 1);
+  in.buffer >>= bits;
+  in.count -= bits;
+  return value;
+}
+
+// Canonical Huffman table: code counts per length and symbols in code order
+struct Huffman {
+  uint16_t counts[16];
+  uint16_t symbols[288];
+};
+
+// Function to build a table from code lengths; false if the lengths are over-subscribed
+static bool buildHuffman(Huffman& table, const uint8_t* lengths, int symbolCount) {
+  memset(table.counts, 0, sizeof(table.counts));
+  for (int i = 0; i < symbolCount; i++) table.counts[lengths[i]]++;
+  table.counts[0] = 0;
+  int left = 1;
+  for (int length = 1; length < 16; length++) {
+    left = (left << 1) - table.counts[length];
+    if (left < 0) return false;
+  }
+  uint16_t offsets[16];
+  offsets[1] = 0;
+  for (int length = 1; length < 15; length++) offsets[length + 1] = offsets[length] + table.counts[length];
+  for (int i = 0; i < symbolCount; i++) {
+    if (lengths[i]) table.symbols[offsets[lengths[i]]++] = (uint16_t)i;
+  }
+  return true;
+}
+
+// Function to decode one symbol; -1 on a bad code or the end of input
+static int decodeSymbol(BitReader& in, const Huffman& table) {
+  int code = 0, first = 0, index = 0;
+  for (int length = 1; length < 16; length++) {
+    code |= (int)readBits(in, 1);
+    if (in.overrun) return -1;
+    int count = table.counts[length];
+    if (code - first < count) return table.symbols[index + code - first];
+    index += count;
+    first = (first + count) << 1;
+    code <<= 1;
+  }
+  return -1;
+}
+
+static const uint16_t LENGTH_BASE[29] = { 3, 4, 5, 6, 7, 8, 9, 10, 11, 13, 15, 17, 19, 23, 27, 31,
+                                          35, 43, 51, 59, 67, 83, 99, 115, 131, 163, 195, 227, 258 };
+static const uint8_t LENGTH_EXTRA[29] = { 0, 0, 0, 0, 0, 0, 0, 0, 1, 1, 1, 1, 2, 2, 2, 2,
+                                          3, 3, 3, 3, 4, 4, 4, 4, 5, 5, 5, 5, 0 };
+static const uint16_t DISTANCE_BASE[30] = { 1, 2, 3, 4, 5, 7, 9, 13, 17, 25, 33, 49, 65, 97, 129, 193,
+                                            257, 385, 513, 769, 1025, 1537, 2049, 3073, 4097, 6145,
+                                            8193, 12289, 16385, 24577 };
+static const uint8_t DISTANCE_EXTRA[30] = { 0, 0, 0, 0, 1, 1, 2, 2, 3, 3, 4, 4, 5, 5, 6, 6,
+                                            7, 7, 8, 8, 9, 9, 10, 10, 11, 11, 12, 12, 13, 13 };
+
+// Function to inflate the symbols of one compressed block
+static bool inflateCodes(BitReader& in, const Huffman& lengths, const Huffman& distances, std::vector<uint8_t>& out) {
+  for (;;) {
+    int symbol = decodeSymbol(in, lengths);
+    if (symbol < 0) return false;
+    if (symbol < 256) {
+      out.push_back((uint8_t)symbol);
+      continue;
+    }
+    if (symbol == 256) return true;
+    symbol -= 257;
+    if (symbol >= 29) return false;
+    size_t length = LENGTH_BASE[symbol] + readBits(in, LENGTH_EXTRA[symbol]);
+    int distanceSymbol = decodeSymbol(in, distances);
+    if (distanceSymbol < 0 || distanceSymbol >= 30) return false;
+    size_t distance = DISTANCE_BASE[distanceSymbol] + readBits(in, DISTANCE_EXTRA[distanceSymbol]);
+    if (in.overrun || distance > out.size()) return false;
+    size_t from = out.size() - distance;
+    for (size_t i = 0; i < length; i++) out.push_back(out[from + i]);
+  }
+}
+
+// Function to read the code length tables of a dynamic block
+static bool readDynamicTables(BitReader& in, Huffman& lengths, Huffman& distances) {
+  static const uint8_t ORDER[19] = { 16, 17, 18, 0, 8, 7, 9, 6, 10, 5, 11, 4, 12, 3, 13, 2, 14, 1, 15 };
+  int lengthCount = (int)readBits(in, 5) + 257;
+  int distanceCount = (int)readBits(in, 5) + 1;
+  int codeCount = (int)readBits(in, 4) + 4;
+  if (lengthCount > 286 || distanceCount > 30) return false;
+
+  uint8_t codeLengths[19] = {};
+  for (int i = 0; i < codeCount; i++) codeLengths[ORDER[i]] = (uint8_t)readBits(in, 3);
+  Huffman codes;
+  if (in.overrun || !buildHuffman(codes, codeLengths, 19)) return false;
+
+  uint8_t table[286 + 30] = {};
+  int filled = 0;
+  while (filled < lengthCount + distanceCount) {
+    int symbol = decodeSymbol(in, codes);
+    if (symbol < 0) return false;
+    if (symbol < 16) {
+      table[filled++] = (uint8_t)symbol;
+      continue;
+    }
+    uint8_t value = 0;
+    int repeat;
+    if (symbol == 16) {
+      if (filled == 0) return false;
+      value = table[filled - 1];
+      repeat = 3 + (int)readBits(in, 2);
+    } else if (symbol == 17) {
+      repeat = 3 + (int)readBits(in, 3);
+    } else {
+      repeat = 11 + (int)readBits(in, 7);
+    }
+    if (in.overrun || filled + repeat > lengthCount + distanceCount) return false;
+    while (repeat--) table[filled++] = value;
+  }
+  if (table[256] == 0) return false; // no end-of-block code
+  return buildHuffman(lengths, table, lengthCount) && buildHuffman(distances, table + lengthCount, distanceCount);
+}
+
+bool zlibInflate(const uint8_t* data, size_t size, std::vector<uint8_t>& out, std::string& error) {
+  if (size < 6 || (data[0] & 0x0F) != 8 || ((data[0] << 8) | data[1]) % 31 != 0 || (data[1] & 0x20)) {
+    error = "not a zlib stream";
+    return false;
+  }
+  BitReader in = { data, size - 4, 2, 0, 0, false };
+  out.clear();
+
+  bool last = false;
+  while (!last) {
+    last = readBits(in, 1) != 0;
+    uint32_t type = readBits(in, 2);
+    bool ok;
+    if (type == 0) {
+      // Stored: byte-aligned length, its complement, then the bytes
+      in.buffer = 0;
+      in.count = 0;
+      if (in.pos + 4 > in.size) {
+        ok = false;
+      } else {
+        uint16_t length = (uint16_t)(in.data[in.pos] | (in.data[in.pos + 1] << 8));
+        uint16_t check = (uint16_t)(in.data[in.pos + 2] | (in.data[in.pos + 3] << 8));
+        in.pos += 4;
+        ok = (uint16_t)~length == check && in.pos + length <= in.size;
+        if (ok) {
+          out.insert(out.end(), in.data + in.pos, in.data + in.pos + length);
+          in.pos += length;
+        }
+      }
+    } else if (type == 1) {
+      uint8_t lengths[288 + 30];
+      memset(lengths, 8, 144);
+      memset(lengths + 144, 9, 112);
+      memset(lengths + 256, 7, 24);
+      memset(lengths + 280, 8, 8);
+      memset(lengths + 288, 5, 30);
+      Huffman fixedLengths, fixedDistances;
+      buildHuffman(fixedLengths, lengths, 288);
+      buildHuffman(fixedDistances, lengths + 288, 30);
+      ok = inflateCodes(in, fixedLengths, fixedDistances, out);
+    } else if (type == 2) {
+      Huffman lengths, distances;
+      ok = readDynamicTables(in, lengths, distances) && inflateCodes(in, lengths, distances, out);
+    } else {
+      ok = false;
+    }
+    if (!ok || in.overrun) {
+      error = "corrupt deflate data";
+      return false;
+    }
+  }
+
+  uint32_t a = 1, b = 0;
+  for (uint8_t byte : out) {
+    a = (a + byte) % 65521;
+    b = (b + a) % 65521;
+  }
+  const uint8_t* trailer = data + size - 4;
+  uint32_t adler = ((uint32_t)trailer[0] << 24) | (trailer[1] << 16) | (trailer[2] << 8) | trailer[3];
+  if (adler != ((b << 16) | a)) {
+    error = "zlib checksum mismatch";
+    return false;
+  }
+  return true;
+}
+
+/*************************************************************
+***************************** PNG ****************************
+**************************************************************/
+
+static uint32_t bigEndian32(const uint8_t* bytes) {
+  return ((uint32_t)bytes[0] << 24) | (bytes[1] << 16) | (bytes[2] << 8) | bytes[3];
+}
+
+// Function to undo the per-scanline filters in place (raw holds a filter byte before each row)
+static bool unfilter(std::vector<uint8_t>& raw, size_t rowBytes, int rows, int pixelBytes) {
+  for (int y = 0; y < rows; y++) {
+    uint8_t* row = raw.data() + y * (rowBytes + 1);
+    uint8_t filter = row[0];
+    uint8_t* line = row + 1;
+    const uint8_t* above = y ? line - (rowBytes + 1) : nullptr;
+    for (size_t x = 0; x < rowBytes; x++) {
+      int left = x >= (size_t)pixelBytes ? line[x - pixelBytes] : 0;
+      int up = above ? above[x] : 0;
+      int upLeft = above && x >= (size_t)pixelBytes ? above[x - pixelBytes] : 0;
+      switch (filter) {
+        case 0: break;
+        case 1: line[x] += left; break;
+        case 2: line[x] += up; break;
+        case 3: line[x] += (left + up) >> 1; break;
+        case 4: {
+          int estimate = left + up - upLeft;
+          int distanceLeft = abs(estimate - left), distanceUp = abs(estimate - up), distanceUpLeft = abs(estimate - upLeft);
+          line[x] += distanceLeft <= distanceUp && distanceLeft <= distanceUpLeft ? left
+                     : distanceUp <= distanceUpLeft ? up : upLeft;
+          break;
+        }
+        default: return false;
+      }
+    }
+  }
+  return true;
+}
+
+// Function to read sample n (of depth bits) from a scanline
+static uint16_t sampleAt(const uint8_t* line, size_t n, int depth) {
+  if (depth == 16) return (uint16_t)((line[n * 2] << 8) | line[n * 2 + 1]);
+  if (depth == 8) return line[n];
+  size_t bit = n * depth;
+  return (line[bit / 8] >> (8 - depth - bit % 8)) & ((1 << depth) - 1);
+}
+
+bool decodePng(const std::vector<uint8_t>& data, DecodedImage& image, std::string& error) {
+  static const uint8_t SIGNATURE[8] = { 0x89, 'P', 'N', 'G', '\r', '\n', 0x1A, '\n' };
+  if (data.size() < 8 || memcmp(data.data(), SIGNATURE, 8) != 0) {
+    error = "not a PNG";
+    return false;
+  }
+
+  int width = 0, height = 0, depth = 0, colourType = 0, interlace = 0;
+  std::vector<uint8_t> palette, paletteAlpha, compressed;
+  uint16_t transparent[3] = {};
+  bool hasTransparent = false;
+  size_t at = 8;
+  while (at + 12 <= data.size()) {
+    uint32_t length = bigEndian32(&data[at]);
+    const uint8_t* type = &data[at + 4];
+    const uint8_t* body = &data[at + 8];
+    if (length > data.size() - at - 12) break;
+    if (memcmp(type, "IHDR", 4) == 0 && length >= 13) {
+      width = (int)bigEndian32(body);
+      height = (int)bigEndian32(body + 4);
+      depth = body[8];
+      colourType = body[9];
+      interlace = body[12];
+    } else if (memcmp(type, "PLTE", 4) == 0) {
+      palette.assign(body, body + length);
+    } else if (memcmp(type, "tRNS", 4) == 0) {
+      if (colourType == 3) {
+        paletteAlpha.assign(body, body + length);
+      } else {
+        for (uint32_t i = 0; i + 1 < length && i < 6; i += 2) transparent[i / 2] = (uint16_t)((body[i] << 8) | body[i + 1]);
+        hasTransparent = true;
+      }
+    } else if (memcmp(type, "IDAT", 4) == 0) {
+      compressed.insert(compressed.end(), body, body + length);
+    } else if (memcmp(type, "IEND", 4) == 0) {
+      break;
+    }
+    at += 12 + length;
+  }
+
+  static const int CHANNELS[7] = { 1, 0, 3, 1, 2, 0, 4 };
+  int channels = colourType <= 6 ? CHANNELS[colourType] : 0;
+  if (width <= 0 || height <= 0 || channels == 0 || (depth != 1 && depth != 2 && depth != 4 && depth != 8 && depth != 16) ||
+      (colourType == 3 && (depth > 8 || palette.empty())) || (channels > 1 && colourType != 3 && depth < 8)) {
+    error = "unsupported PNG header";
+    return false;
+  }
+  if (interlace) {
+    error = "interlaced PNGs are not supported";
+    return false;
+  }
+
+  std::vector<uint8_t> raw;
+  if (!zlibInflate(compressed.data(), compressed.size(), raw, error)) return false;
+  size_t rowBytes = ((size_t)width * channels * depth + 7) / 8;
+  if (raw.size() < (rowBytes + 1) * height) {
+    error = "PNG image data is short";
+    return false;
+  }
+  int pixelBytes = channels * depth / 8 > 0 ? channels * depth / 8 : 1;
+  if (!unfilter(raw, rowBytes, height, pixelBytes)) {
+    error = "bad PNG filter";
+    return false;
+  }
+
+  // Expand every colour type to 8-bit RGBA
+  image.width = width;
+  image.height = height;
+  image.delayMs = 0;
+  image.rgba.assign((size_t)width * height * 4, 0);
+  int maximum = (1 << depth) - 1;
+  for (int y = 0; y < height; y++) {
+    const uint8_t* line = raw.data() + y * (rowBytes + 1) + 1;
+    uint8_t* out = image.rgba.data() + (size_t)y * width * 4;
+    for (int x = 0; x < width; x++, out += 4) {
+      uint16_t samples[4] = {};
+      for (int c = 0; c < channels; c++) samples[c] = sampleAt(line, (size_t)x * channels + c, depth);
+      if (colourType == 3) {
+        size_t index = samples[0];
+        if (index * 3 + 2 < palette.size()) {
+          out[0] = palette[index * 3];
+          out[1] = palette[index * 3 + 1];
+          out[2] = palette[index * 3 + 2];
+        }
+        out[3] = index < paletteAlpha.size() ? paletteAlpha[index] : 255;
+        continue;
+      }
+      bool clear = hasTransparent && (channels == 1 ? samples[0] == transparent[0]
+                                      : channels == 3 && samples[0] == transparent[0] && samples[1] == transparent[1] &&
+                                        samples[2] == transparent[2]);
+      for (int c = 0; c < channels; c++) samples[c] = (uint16_t)(samples[c] * 255 / maximum);
+      if (channels <= 2) {
+        out[0] = out[1] = out[2] = (uint8_t)samples[0];
+        out[3] = channels == 2 ? (uint8_t)samples[1] : 255;
+      } else {
+        out[0] = (uint8_t)samples[0];
+        out[1] = (uint8_t)samples[1];
+        out[2] = (uint8_t)samples[2];
+        out[3] = channels == 4 ? (uint8_t)samples[3] : 255;
+      }
+      if (clear) out[3] = 0;
+    }
+  }
+  return true;
+}
+
+/*************************************************************
+***************************** GIF ****************************
+**************************************************************/
+
+const uint16_t GIF_MIN_DELAY_MS = 20; // delays of 0 or 10 ms are shown at 100 ms by browsers
+const uint16_t GIF_DEFAULT_DELAY_MS = 100;
+
+// Function to decode an LZW image (sub-blocks already joined) into pixelCount palette indices
+static bool lzwDecode(const std::vector<uint8_t>& codes, int minimumCodeSize, size_t pixelCount, std::vector<uint8_t>& out) {
+  if (minimumCodeSize < 2 || minimumCodeSize > 11) return false;
+  const int clearCode = 1 << minimumCodeSize;
+  const int endCode = clearCode + 1;
+  static thread_local uint16_t prefix[4096];
+  static thread_local uint8_t suffix[4096], firstByte[4096];
+  uint8_t stack[4096];
+  for (int i = 0; i < clearCode; i++) {
+    suffix[i] = firstByte[i] = (uint8_t)i;
+  }
+
+  out.clear();
+  out.reserve(pixelCount);
+  int codeSize = minimumCodeSize + 1;
+  int nextCode = endCode + 1;
+  int previous = -1;
+  uint32_t buffer = 0;
+  int bits = 0;
+  size_t pos = 0;
+  while (out.size() < pixelCount) {
+    while (bits < codeSize && pos < codes.size()) {
+      buffer |= (uint32_t)codes[pos++] << bits;
+      bits += 8;
+    }
+    if (bits < codeSize) break; // truncated: keep what was decoded
+    int code = (int)(buffer & ((1u << codeSize) - 1));
+    buffer >>= codeSize;
+    bits -= codeSize;
+
+    if (code == clearCode) {
+      codeSize = minimumCodeSize + 1;
+      nextCode = endCode + 1;
+      previous = -1;
+      continue;
+    }
+    if (code == endCode) break;
+    if (code > nextCode || (previous < 0 && code >= clearCode)) return false;
+
+    // New entry: previous string + first byte of this one (KwKwK when code is not defined yet)
+    if (previous >= 0 && nextCode < 4096) {
+      prefix[nextCode] = (uint16_t)previous;
+      firstByte[nextCode] = firstByte[previous];
+      suffix[nextCode] = code < nextCode ? firstByte[code] : firstByte[previous];
+      if (++nextCode == (1 << codeSize) && codeSize < 12) codeSize++;
+    }
+
+    int depth = 0;
+    for (int walk = code; walk >= clearCode; walk = prefix[walk]) stack[depth++] = suffix[walk];
+    stack[depth++] = (uint8_t)(code < clearCode ? code : firstByte[code]);
+    while (depth && out.size() < pixelCount) out.push_back(stack[--depth]);
+    previous = code;
+  }
+  out.resize(pixelCount, 0); // short images leave the rest at index 0 (drawn as the background)
+  return true;
+}
+
+// Function to read and join the data sub-blocks at pos
+static bool readSubBlocks(const std::vector<uint8_t>& data, size_t& pos, std::vector<uint8_t>* joined) {
+  while (pos < data.size()) {
+    uint8_t length = data[pos++];
+    if (length == 0) return true;
+    if (pos + length > data.size()) return false;
+    if (joined) joined->insert(joined->end(), data.begin() + pos, data.begin() + pos + length);
+    pos += length;
+  }
+  return false;
+}
+
+bool decodeGif(const std::vector<uint8_t>& data, std::vector<DecodedImage>& frames, std::string& error) {
+  if (data.size() < 13 || (memcmp(data.data(), "GIF87a", 6) != 0 && memcmp(data.data(), "GIF89a", 6) != 0)) {
+    error = "not a GIF";
+    return false;
+  }
+  int width = data[6] | (data[7] << 8);
+  int height = data[8] | (data[9] << 8);
+  uint8_t screenFlags = data[10];
+  size_t pos = 13;
+  std::vector<uint8_t> globalPalette;
+  if (screenFlags & 0x80) {
+    size_t size = (size_t)3 << ((screenFlags & 7) + 1);
+    if (pos + size > data.size()) {
+      error = "truncated GIF palette";
+      return false;
+    }
+    globalPalette.assign(data.begin() + pos, data.begin() + pos + size);
+    pos += size;
+  }
+  if (width <= 0 || height <= 0) {
+    error = "bad GIF size";
+    return false;
+  }
+
+  // Canvas starts transparent (composited over black later)
+  std::vector<uint8_t> canvas((size_t)width * height * 4, 0), saved;
+  int disposal = 0, transparentIndex = -1;
+  uint16_t delayCs = 0;
+  bool hasDelay = false;
+  frames.clear();
+
+  while (pos < data.size()) {
+    uint8_t block = data[pos++];
+    if (block == 0x3B) break; // trailer
+    if (block == 0x21) {
+      if (pos >= data.size()) break;
+      uint8_t label = data[pos++];
+      if (label == 0xF9 && pos + 5 < data.size() && data[pos] == 4) {
+        // Graphics control: disposal, delay, transparent index for the next image
+        uint8_t flags = data[pos + 1];
+        disposal = (flags >> 2) & 7;
+        delayCs = (uint16_t)(data[pos + 2] | (data[pos + 3] << 8));
+        hasDelay = true;
+        transparentIndex = (flags & 1) ? data[pos + 4] : -1;
+      }
+      if (!readSubBlocks(data, pos, nullptr)) break;
+      continue;
+    }
+    if (block != 0x2C || pos + 9 > data.size()) {
+      error = "bad GIF block";
+      return false;
+    }
+
+    int left = data[pos] | (data[pos + 1] << 8);
+    int top = data[pos + 2] | (data[pos + 3] << 8);
+    int frameWidth = data[pos + 4] | (data[pos + 5] << 8);
+    int frameHeight = data[pos + 6] | (data[pos + 7] << 8);
+    uint8_t imageFlags = data[pos + 8];
+    pos += 9;
+    std::vector<uint8_t> palette = globalPalette;
+    if (imageFlags & 0x80) {
+      size_t size = (size_t)3 << ((imageFlags & 7) + 1);
+      if (pos + size > data.size()) {
+        error = "truncated GIF palette";
+        return false;
+      }
+      palette.assign(data.begin() + pos, data.begin() + pos + size);
+      pos += size;
+    }
+    if (pos >= data.size()) {
+      error = "truncated GIF image";
+      return false;
+    }
+    int minimumCodeSize = data[pos++];
+    std::vector<uint8_t> codes, indices;
+    if (!readSubBlocks(data, pos, &codes) ||
+        !lzwDecode(codes, minimumCodeSize, (size_t)frameWidth * frameHeight, indices)) {
+      error = "corrupt GIF image data in frame " + std::to_string(frames.size());
+      return false;
+    }
+
+    if (disposal == 3) saved = canvas;
+
+    // Rows in file order, de-interlaced if needed
+    static const int PASS_START[4] = { 0, 4, 2, 1 }, PASS_STEP[4] = { 8, 8, 4, 2 };
+    bool interlaced = (imageFlags & 0x40) != 0;
+    int pass = 0, y = 0;
+    for (int row = 0; row < frameHeight; row++) {
+      int destinationRow = row;
+      if (interlaced) {
+        while (y >= frameHeight && pass < 3) y = PASS_START[++pass];
+        destinationRow = y;
+        y += PASS_STEP[pass];
+      }
+      int canvasY = top + destinationRow;
+      if (canvasY < 0 || canvasY >= height) continue;
+      for (int x = 0; x < frameWidth; x++) {
+        int canvasX = left + x;
+        uint8_t index = indices[(size_t)row * frameWidth + x];
+        if (canvasX >= width || index == transparentIndex || (size_t)index * 3 + 2 >= palette.size()) continue;
+        uint8_t* pixel = &canvas[((size_t)canvasY * width + canvasX) * 4];
+        pixel[0] = palette[index * 3];
+        pixel[1] = palette[index * 3 + 1];
+        pixel[2] = palette[index * 3 + 2];
+        pixel[3] = 255;
+      }
+    }
+
+    DecodedImage frame;
+    frame.width = width;
+    frame.height = height;
+    frame.rgba = canvas;
+    frame.delayMs = !hasDelay ? GIF_DEFAULT_DELAY_MS
+                    : delayCs * 10 < GIF_MIN_DELAY_MS ? GIF_DEFAULT_DELAY_MS : (uint16_t)(delayCs * 10);
+    frames.push_back(std::move(frame));
+
+    // Disposal before the next image: 2 clears the frame's area, 3 restores the canvas before it
+    if (disposal == 2) {
+      for (int row = top; row < top + frameHeight && row < height; row++) {
+        for (int x = left; x < left + frameWidth && x < width; x++) {
+          memset(&canvas[((size_t)row * width + x) * 4], 0, 4);
+        }
+      }
+    } else if (disposal == 3 && !saved.empty()) {
+      canvas = saved;
+    }
+    disposal = 0;
+    transparentIndex = -1;
+    hasDelay = false;
+  }
+
+  if (frames.empty()) {
+    error = "GIF has no frames";
+    return false;
+  }
+  return true;
+}
@@ -0,0 +1,39 @@
+/*************************************************************
+******************** IMAGE DECODING (HOST) *******************
+**************************************************************/
+
+/*
+Reading GIF and PNG files on the host for the animation importer (no zlib
+or image library dependency):
+ - GIF: every frame is composited onto the logical screen (disposal methods
+   1-3, transparency), so each decoded frame is a full canvas; the delay is
+   the graphics control extension's, in milliseconds
+ - PNG: any colour type and bit depth, non-interlaced, tRNS honoured
+
+Decoded pixels are 8-bit RGBA, straight (not premultiplied) alpha.
+*/
+
+#pragma once
+
+#include <stdint.h>
+#include <string>
+#include <vector>
+
+struct DecodedImage {
+  int width = 0;
+  int height = 0;
+  std::vector<uint8_t> rgba; // width*height*4
+  uint16_t delayMs = 0;      // GIF frames only; 0 = not given
+};
+
+// Read a whole file
+bool readFileBytes(const std::string& path, std::vector<uint8_t>& data, std::string& error);
+
+// Decode every frame of a GIF as a full canvas
+bool decodeGif(const std::vector<uint8_t>& data, std::vector<DecodedImage>& frames, std::string& error);
+
+// Decode a PNG
+bool decodePng(const std::vector<uint8_t>& data, DecodedImage& image, std::string& error);
+
+// Inflate a zlib stream (header, deflate blocks, Adler-32)
+bool zlibInflate(const uint8_t* data, size_t size, std::vector<uint8_t>& out, std::string& error);
@@ -0,0 +1,63 @@
+/*************************************************************
+********************* IMAGE QUALITY (HOST) *******************
+**************************************************************/
+
+#include <math.h>
+#include <vector>
+#include "image_quality.h"
+
+const int SSIM_WINDOW = 8;
+const int SSIM_STEP = 4;
+
+double psnrRgb(const uint8_t* reference, const uint8_t* test, size_t pixels) {
+  uint64_t squared = 0;
+  for (size_t i = 0; i < pixels * 3; i++) {
+    int difference = (int)reference[i] - test[i];
+    squared += difference * difference;
+  }
+  if (squared == 0) return INFINITY;
+  double mse = (double)squared / (pixels * 3);
+  return 10 * log10(255.0 * 255.0 / mse);
+}
+
+// Function to convert RGB to luma
+static std::vector<float> luma(const uint8_t* rgb, size_t pixels) {
+  std::vector<float> y(pixels);
+  for (size_t i = 0; i < pixels; i++) {
+    y[i] = 0.299f * rgb[i * 3] + 0.587f * rgb[i * 3 + 1] + 0.114f * rgb[i * 3 + 2];
+  }
+  return y;
+}
+
+double ssimLuma(const uint8_t* reference, const uint8_t* test, int width, int height) {
+  const double C1 = (0.01 * 255) * (0.01 * 255), C2 = (0.03 * 255) * (0.03 * 255);
+  std::vector<float> a = luma(reference, (size_t)width * height), b = luma(test, (size_t)width * height);
+  int window = width < SSIM_WINDOW || height < SSIM_WINDOW ? (width < height ? width : height) : SSIM_WINDOW;
+  if (window <= 0) return 1.0;
+
+  double total = 0;
+  int windows = 0;
+  for (int top = 0; top + window <= height; top += SSIM_STEP) {
+    for (int left = 0; left + window <= width; left += SSIM_STEP) {
+      double sumA = 0, sumB = 0, sumAA = 0, sumBB = 0, sumAB = 0;
+      for (int y = top; y < top + window; y++) {
+        for (int x = left; x < left + window; x++) {
+          double va = a[(size_t)y * width + x], vb = b[(size_t)y * width + x];
+          sumA += va;
+          sumB += vb;
+          sumAA += va * va;
+          sumBB += vb * vb;
+          sumAB += va * vb;
+        }
+      }
+      double n = (double)window * window;
+      double meanA = sumA / n, meanB = sumB / n;
+      double varianceA = sumAA / n - meanA * meanA, varianceB = sumBB / n - meanB * meanB;
+      double covariance = sumAB / n - meanA * meanB;
+      total += ((2 * meanA * meanB + C1) * (2 * covariance + C2)) /
+               ((meanA * meanA + meanB * meanB + C1) * (varianceA + varianceB + C2));
+      windows++;
+    }
+  }
+  return windows ? total / windows : 1.0;
+}
@@ -0,0 +1,21 @@
+/*************************************************************
+********************* IMAGE QUALITY (HOST) *******************
+**************************************************************/
+
+/*
+Full-reference quality of an encoded frame against its source (8-bit
+RGB, same size), for trading flash bytes and decode speed against what is
+lost (anim_import --report):
+ - PSNR over the RGB channels, in dB (infinite when identical)
+ - SSIM of the luma (BT.601 weights), mean over 8x8 windows every 4
+   pixels, with the usual constants (K1 = 0.01, K2 = 0.03)
+*/
+
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+
+double psnrRgb(const uint8_t* reference, const uint8_t* test, size_t pixels);
+
+double ssimLuma(const uint8_t* reference, const uint8_t* test, int width, int height);
@@ -0,0 +1,185 @@
+/*************************************************************
+******************* PIXEL KERNEL CHECK (HOST) ****************
+**************************************************************/
+
+/*
+Equivalence and throughput of the firmware's pixel kernels
+(pixel_kernels.cpp) against plain per-pixel references:
+
+  kernel_check [runs]
+
+Every kernel is run for lengths 0..PIXEL_CHECK_MAX_LENGTH with the source
+and destination each at a 4-byte aligned and an odd-pixel (2-byte)
+offset, over random pixels (a quarter of them the colour key). The whole
+destination, guard pixels on both sides included, must match the
+reference. The rectangle helpers are checked the same way with rectangles
+partly off every edge. Then each kernel and its reference are timed on a
+full 320x170 frame and printed in MB/s (bytes written).
+Exits 1 on any mismatch.
+*/
+
+#include <chrono>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <vector>
+#include "pixel_kernels.h"
+
+const int PIXEL_CHECK_MAX_LENGTH = 100;
+const int PIXEL_CHECK_GUARD = 4;         // pixels around the destination that must stay untouched
+const uint16_t PIXEL_CHECK_KEY = 0x0000;
+const int FRAME_WIDTH = 320;
+const int FRAME_HEIGHT = 170;
+
+static int errors = 0;
+
+// Per-pixel references (what TFT_eSPI's pushImage/pushToSprite/fillRect amount to)
+static void referenceCopySwap(uint16_t* dst, const uint16_t* src, size_t count) {
+  for (size_t i = 0; i < count; i++) dst[i] = pixelSwap(src[i]);
+}
+
+static void referenceKeyCopy(uint16_t* dst, const uint16_t* src, size_t count, uint16_t key) {
+  for (size_t i = 0; i < count; i++) {
+    if (src[i] != key) dst[i] = src[i];
+  }
+}
+
+static void referenceCopySwapHalf(uint16_t* dst, const uint16_t* src, size_t count) {
+  for (size_t i = 0; i < count; i++) dst[i] = pixelSwap(src[i & ~(size_t)1]);
+}
+
+static void referenceFill(uint16_t* dst, uint16_t colour, size_t count) {
+  for (size_t i = 0; i < count; i++) dst[i] = colour;
+}
+
+static uint16_t randomPixel() {
+  return rand() % 4 ? (uint16_t)rand() : PIXEL_CHECK_KEY;
+}
+
+static void randomize(std::vector<uint16_t>& pixels) {
+  for (uint16_t& pixel : pixels) pixel = randomPixel();
+}
+
+static void compare(const char* kernel, const std::vector<uint16_t>& got, const std::vector<uint16_t>& want,
+                    int length, int srcOffset, int dstOffset) {
+  if (got != want && ++errors <= 10) {
+    printf("  %s differs: length %d, src offset %d, dst offset %d\n", kernel, length, srcOffset, dstOffset);
+  }
+}
+
+// Function to check the run kernels at every length and alignment
+static void checkRuns() {
+  const size_t size = PIXEL_CHECK_MAX_LENGTH * 2 + 2 * PIXEL_CHECK_GUARD + 2;
+  std::vector<uint16_t> src(size), got(size), want(size);
+  for (int length = 0; length <= PIXEL_CHECK_MAX_LENGTH; length++) {
+    for (int srcOffset = 0; srcOffset < 2; srcOffset++) {
+      for (int dstOffset = 0; dstOffset < 2; dstOffset++) {
+        // Vectors are at least 8-byte aligned: offset 1 puts a pointer on an odd pixel
+        const uint16_t* s = src.data() + PIXEL_CHECK_GUARD + srcOffset;
+        uint16_t* g = got.data() + PIXEL_CHECK_GUARD + dstOffset;
+        uint16_t* w = want.data() + PIXEL_CHECK_GUARD + dstOffset;
+        uint16_t colour = randomPixel();
+
+        randomize(src);
+        randomize(got);
+        want = got;
+        pixelCopySwap(g, s, length);
+        referenceCopySwap(w, s, length);
+        compare("pixelCopySwap", got, want, length, srcOffset, dstOffset);
+
+        randomize(got);
+        want = got;
+        pixelKeyCopy(g, s, length, PIXEL_CHECK_KEY);
+        referenceKeyCopy(w, s, length, PIXEL_CHECK_KEY);
+        compare("pixelKeyCopy", got, want, length, srcOffset, dstOffset);
+
+        randomize(got);
+        want = got;
+        pixelCopySwapHalf(g, s, length);
+        referenceCopySwapHalf(w, s, length);
+        compare("pixelCopySwapHalf", got, want, length, srcOffset, dstOffset);
+
+        randomize(got);
+        want = got;
+        pixelFill(g, colour, length);
+        referenceFill(w, colour, length);
+        compare("pixelFill", got, want, length, srcOffset, dstOffset);
+      }
+    }
+  }
+  printf("runs of 0..%d pixels, aligned and odd src/dst: %d errors\n", PIXEL_CHECK_MAX_LENGTH, errors);
+}
+
+// Function to check the rectangle helpers with clipping on every side
+static void checkRects() {
+  const int width = 37, height = 23;   // odd stride: rows alternate alignment
+  std::vector<uint16_t> src((width + 8) * (height + 8)), got(width * height), want(width * height);
+  for (int run = 0; run < 2000; run++) {
+    int w = 1 + rand() % (width + 8), h = 1 + rand() % (height + 8);
+    int x = rand() % (width + 16) - 8 - w / 2, y = rand() % (height + 16) - 8 - h / 2;
+    randomize(src);
+    uint16_t colour = randomPixel();
+
+    for (int kernel = 0; kernel < 3; kernel++) {
+      randomize(got);
+      want = got;
+      for (int row = 0; row < h; row++) {
+        for (int column = 0; column < w; column++) {
+          int dx = x + column, dy = y + row;
+          if (dx < 0 || dy < 0 || dx >= width || dy >= height) continue;
+          uint16_t pixel = src[row * w + column];
+          if (kernel == 0) want[dy * width + dx] = pixelSwap(pixel);
+          if (kernel == 1 && pixel != PIXEL_CHECK_KEY) want[dy * width + dx] = pixel;
+          if (kernel == 2) want[dy * width + dx] = colour;
+        }
+      }
+      if (kernel == 0) pixelBlitSwapRect(got.data(), width, height, x, y, src.data(), w, h);
+      if (kernel == 1) pixelKeyBlitRect(got.data(), width, height, x, y, src.data(), w, h, PIXEL_CHECK_KEY);
+      if (kernel == 2) pixelFillRect(got.data(), width, height, x, y, w, h, colour);
+      const char* names[] = { "pixelBlitSwapRect", "pixelKeyBlitRect", "pixelFillRect" };
+      if (got != want && ++errors <= 10) printf("  %s differs: %dx%d at %d,%d\n", names[kernel], w, h, x, y);
+    }
+  }
+  printf("rectangles clipped on every edge: %d errors\n", errors);
+}
+
+static double nowMicros() {
+  return std::chrono::duration<double, std::micro>(std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+// Function to time fn over runs full frames and print MB/s of destination bytes
+template <typename Fn>
+static void timeKernel(const char* name, int runs, Fn fn) {
+  double start = nowMicros();
+  for (int i = 0; i < runs; i++) fn();
+  double micros = nowMicros() - start;
+  double bytes = (double)FRAME_WIDTH * FRAME_HEIGHT * 2 * runs;
+  printf("%-22s %9.1f MB/s %8.1f us/frame\n", name, bytes / micros, micros / runs);
+}
+
+static void benchmark(int runs) {
+  const size_t pixels = (size_t)FRAME_WIDTH * FRAME_HEIGHT;
+  std::vector<uint16_t> src(pixels), dst(pixels);
+  randomize(src);
+  volatile uint16_t sink = 0; // keeps the reference loops from being dropped
+  printf("\nfull %dx%d frame, %d runs:\n", FRAME_WIDTH, FRAME_HEIGHT, runs);
+  timeKernel("pixelCopySwap", runs, [&] { pixelCopySwap(dst.data(), src.data(), pixels); sink = dst[runs % pixels]; });
+  timeKernel("  reference", runs, [&] { referenceCopySwap(dst.data(), src.data(), pixels); sink = dst[runs % pixels]; });
+  timeKernel("pixelKeyCopy", runs, [&] { pixelKeyCopy(dst.data(), src.data(), pixels, PIXEL_CHECK_KEY); sink = dst[7]; });
+  timeKernel("  reference", runs, [&] { referenceKeyCopy(dst.data(), src.data(), pixels, PIXEL_CHECK_KEY); sink = dst[7]; });
+  timeKernel("pixelCopySwapHalf", runs, [&] { pixelCopySwapHalf(dst.data(), src.data(), pixels); sink = dst[9]; });
+  timeKernel("  reference", runs, [&] { referenceCopySwapHalf(dst.data(), src.data(), pixels); sink = dst[9]; });
+  timeKernel("pixelFill", runs, [&] { pixelFill(dst.data(), (uint16_t)runs, pixels); sink = dst[3]; });
+  timeKernel("  reference", runs, [&] { referenceFill(dst.data(), (uint16_t)runs, pixels); sink = dst[3]; });
+  (void)sink;
+}
+
+int main(int argc, char** argv) {
+  int runs = argc > 1 ? atoi(argv[1]) : 2000;
+  srand(1);
+  checkRuns();
+  checkRects();
+  benchmark(runs > 0 ? runs : 1);
+  printf("%s\n", errors ? "FAILED" : "ok");
+  return errors ? 1 : 0;
+}
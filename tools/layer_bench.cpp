@@ -0,0 +1,192 @@
+/*************************************************************
+******************** LAYER BENCHMARK (HOST) ******************
+**************************************************************/
+
+/*
+Layered playback (nyan_layers.cpp, dirty_region.cpp) against the full-frame
+blit loop() does otherwise, at a simulated panel rate:
+
+  layer_bench [--fps N] [--seconds S] [--png FILE] include/nyancat.h
+
+Per displayed frame, both ways:
+ - full: the art frame blitted to the whole sprite (pixelBlitSwapRect, as
+   blitAnimationBand) and all 108800 bytes pushed
+ - layered: the scene advanced to the frame's time, the dirty rects and the
+   overlay areas repainted with the layers (as loop() does, so the keyed
+   overlays composite over fresh pixels), and only the dirty rects plus the
+   seconds and FPS panels once a second pushed
+
+Bus time is the bytes at LCD_I80_PCLK_HZ on the 8-bit bus (one byte per
+clock), plus LAYER_BENCH_WINDOW_US per rect for its address window. Every
+layered frame is checked against a full repaint of the same scene.
+--png writes the last layered frame.
+*/
+
+#include <algorithm>
+#include <chrono>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <string>
+#include <vector>
+#include "dirty_region.h"
+#include "frame_source.h"
+#include "nyan_layers.h"
+#include "pixel_kernels.h"
+#include "png_io.h"
+
+const double LCD_I80_PCLK_HZ = 10000000;   // as lcd_backend.h
+const double LAYER_BENCH_WINDOW_US = 15;   // CASET + RASET + RAMWR per rect (synchronous tx_param)
+
+// Overlay layout of the clock (sprite size and position on mainSprite); seconds and FPS change every second
+static const struct {
+  int x, y, w, h;
+  bool everySecond;
+} overlayLayout[] = {
+  { 7, 8, 218, 26, false }, { 235, 30, 80, 40, true }, { 231, 100, 100, 64, false }, { 5, 145, 70, 20, true }
+};
+
+struct Totals {
+  double composeMicros = 0, composeMax = 0;
+  double bytes = 0, bytesMax = 0;
+  double rects = 0;
+  double busMicros = 0, busMax = 0;
+};
+
+static double nowMicros() {
+  return std::chrono::duration<double, std::micro>(std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+static double busMicros(double bytes, int rects) {
+  return bytes / LCD_I80_PCLK_HZ * 1e6 + rects * LAYER_BENCH_WINDOW_US;
+}
+
+static void account(Totals& totals, double compose, double bytes, int rects) {
+  double bus = busMicros(bytes, rects);
+  totals.composeMicros += compose;
+  totals.bytes += bytes;
+  totals.rects += rects;
+  totals.busMicros += bus;
+  if (compose > totals.composeMax) totals.composeMax = compose;
+  if (bytes > totals.bytesMax) totals.bytesMax = bytes;
+  if (bus > totals.busMax) totals.busMax = bus;
+}
+
+static void printRow(const char* name, const Totals& totals, int frames) {
+  double bus = totals.busMicros / frames;
+  printf("%-8s %9.1f %9.1f %11.0f %11.0f %6.1f %9.2f %9.2f %8.0f\n", name, totals.composeMicros / frames,
+         totals.composeMax, totals.bytes / frames, totals.bytesMax, totals.rects / frames, bus / 1000,
+         totals.busMax / 1000, 1e6 / bus);
+}
+
+int main(int argc, char** argv) {
+  int fps = 60;
+  double seconds = 10;
+  std::string pngPath, input;
+  for (int i = 1; i < argc; i++) {
+    std::string arg = argv[i];
+    if (arg == "--fps" && i + 1 < argc) {
+      fps = atoi(argv[++i]);
+    } else if (arg == "--seconds" && i + 1 < argc) {
+      seconds = atof(argv[++i]);
+    } else if (arg == "--png" && i + 1 < argc) {
+      pngPath = argv[++i];
+    } else if (input.empty() && arg[0] != '-') {
+      input = arg;
+    } else {
+      input.clear();
+      break;
+    }
+  }
+  if (input.empty() || fps <= 0 || seconds <= 0) {
+    fprintf(stderr, "usage: %s [--fps N] [--seconds S] [--png FILE] <frames.h|input.nyan>\n", argv[0]);
+    return 2;
+  }
+
+  HostAnimation animation;
+  std::string error;
+  if (!loadAnimation(input, animation, error)) {
+    fprintf(stderr, "%s\n", error.c_str());
+    return 1;
+  }
+  int width = animation.width, height = animation.height;
+  size_t pixels = (size_t)width * height;
+  std::vector<uint16_t> frames;
+  for (const std::vector<uint16_t>& frame : animation.frames) frames.insert(frames.end(), frame.begin(), frame.end());
+
+  static NyanLayers layers;
+  std::vector<CatSpan> spans(NYAN_MAX_CAT_SPANS);
+  double start = nowMicros();
+  if (!nyanLayersInit(layers, frames.data(), (int)animation.frames.size(), width, height, spans.data(), spans.size())) {
+    fprintf(stderr, "no cat found (or more than %u spans)\n", (unsigned)NYAN_MAX_CAT_SPANS);
+    return 1;
+  }
+  printf("cut-out: %d frames, %u spans (%u bytes) in %.1f ms\n", layers.frameCount,
+         (unsigned)nyanLayersSpanCount(layers), (unsigned)(nyanLayersSpanCount(layers) * sizeof(CatSpan)),
+         (nowMicros() - start) / 1000);
+  for (int i = 0; i < layers.frameCount; i++) {
+    const DirtyRect& box = layers.cats[i].bounds;
+    printf("  frame %2d: cat %dx%d at %d,%d, %u spans\n", i, box.w, box.h, box.x, box.y, (unsigned)layers.cats[i].count);
+  }
+
+  std::vector<uint16_t> full(pixels), layered(pixels), reference(pixels);
+  DirtyRegion region;
+  dirtyInit(region, width, height);
+  const DirtyRect whole = { 0, 0, (int16_t)width, (int16_t)height };
+  Totals fullTotals, layeredTotals;
+  int frameCount = (int)(seconds * fps), mismatched = 0, fullPushes = 0;
+
+  for (int frame = 0; frame < frameCount; frame++) {
+    uint32_t timeMs = (uint32_t)((double)frame * 1000 / fps);
+    int catFrame = nyanLayersCatFrame(layers, timeMs);
+
+    // Full-frame blit of the art frame (loop() steps the art once per displayed frame)
+    double t0 = nowMicros();
+    pixelBlitSwapRect(full.data(), width, height, 0, 0, frames.data() + (frame % layers.frameCount) * pixels, width, height);
+    account(fullTotals, nowMicros() - t0, pixels * 2.0, 1);
+
+    // Layered: dirty rects and the overlay areas repainted, dirty rects (and changed overlays) pushed
+    t0 = nowMicros();
+    dirtyClear(region);
+    nyanLayersAdvance(layers, timeMs, catFrame, region);
+    for (uint8_t i = 0; i < region.count; i++) nyanLayersDraw(layers, layered.data(), region.rects[i]);
+    for (const auto& overlay : overlayLayout) {
+      DirtyRect area = { (int16_t)overlay.x, (int16_t)overlay.y, (int16_t)std::min(overlay.w, width - overlay.x),
+                         (int16_t)std::min(overlay.h, height - overlay.y) };
+      nyanLayersDraw(layers, layered.data(), area);
+    }
+    double compose = nowMicros() - t0;
+    bool newSecond = frame > 0 && timeMs / 1000 != (uint32_t)((double)(frame - 1) * 1000 / fps) / 1000;
+    for (const auto& overlay : overlayLayout) {
+      if (overlay.everySecond && newSecond) dirtyAdd(region, overlay.x, overlay.y, overlay.w, overlay.h);
+    }
+    if (dirtyWorthFullPush(region)) {
+      fullPushes++;
+      account(layeredTotals, compose, pixels * 2.0, 1);
+    } else {
+      account(layeredTotals, compose, dirtyPixels(region) * 2.0, region.count);
+    }
+
+    // The incremental frame must match a repaint of the whole scene
+    nyanLayersDraw(layers, reference.data(), whole);
+    if (memcmp(reference.data(), layered.data(), pixels * 2) != 0) mismatched++;
+  }
+
+  printf("\n%d frames at %d fps (%.1f s), cat every %u ms\n\n", frameCount, fps, seconds, (unsigned)NYAN_ART_FRAME_MS);
+  printf("%-8s %9s %9s %11s %11s %6s %9s %9s %8s\n", "", "compose", "max", "bytes", "max", "rects", "bus ms",
+         "max", "bus fps");
+  printRow("full", fullTotals, frameCount);
+  printRow("layered", layeredTotals, frameCount);
+  printf("\nlayered: %.1f%% of the full frame's bytes, %d full pushes, %d frames differing from a full repaint\n",
+         100.0 * layeredTotals.bytes / fullTotals.bytes, fullPushes, mismatched);
+
+  if (!pngPath.empty()) {
+    std::vector<uint16_t> native(pixels);
+    for (size_t i = 0; i < pixels; i++) native[i] = pixelSwap(layered[i]);
+    if (!savePng(pngPath, width, height, native, error)) {
+      fprintf(stderr, "%s\n", error.c_str());
+      return 1;
+    }
+  }
+  return mismatched ? 1 : 0;
+}
@@ -0,0 +1,293 @@
+/*************************************************************
+******************* METRICS SCRAPER (HOST) *******************
+**************************************************************/
+
+/*
+Scrape GET /metrics the way Prometheus would and check the exposition
+format, or check a saved response:
+
+  metrics_scrape <host>[:port] [scrapes] [interval-ms]
+  metrics_scrape <response.txt|->
+
+Checked per response:
+ - status 200 (a 500 carries the "metrics need N bytes" reason: printed)
+ - every line complete, the last one included
+ - one "# TYPE" per family, directly before its samples, and no sample
+   outside the family typed last
+ - values parse; counters end in _total; no sample repeated
+ - histogram buckets: increasing bounds, non-decreasing counts, ending
+   in le="+Inf" equal to _count, with a _sum
+Across scrapes, counters must not go down unless uptime did (a reboot).
+Prints bytes, families and samples per scrape and the headroom left in
+the firmware's response buffer. Exits 1 on any error.
+*/
+
+#include <netdb.h>
+#include <sys/socket.h>
+#include <unistd.h>
+#include <chrono>
+#include <map>
+#include <math.h>
+#include <set>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <string>
+#include <thread>
+
+const size_t METRICS_BUFFER_BYTES = 9728;   // metricsBuffer in metrics.cpp
+
+static int errors = 0;
+
+static void fail(int line, const char* what, const std::string& detail) {
+  if (++errors <= 20) printf("  line %d: %s: %s\n", line, what, detail.c_str());
+}
+
+// Function to fetch http://host:port/metrics; false if the connection fails
+static bool fetch(const std::string& host, const std::string& port, std::string& response) {
+  addrinfo hints = {}, *addresses = nullptr;
+  hints.ai_family = AF_UNSPEC;
+  hints.ai_socktype = SOCK_STREAM;
+  if (getaddrinfo(host.c_str(), port.c_str(), &hints, &addresses) != 0) {
+    fprintf(stderr, "%s: cannot resolve\n", host.c_str());
+    return false;
+  }
+  int sock = -1;
+  for (addrinfo* address = addresses; address && sock < 0; address = address->ai_next) {
+    sock = socket(address->ai_family, address->ai_socktype, address->ai_protocol);
+    if (sock >= 0 && connect(sock, address->ai_addr, address->ai_addrlen) != 0) {
+      close(sock);
+      sock = -1;
+    }
+  }
+  freeaddrinfo(addresses);
+  if (sock < 0) {
+    fprintf(stderr, "%s:%s: cannot connect\n", host.c_str(), port.c_str());
+    return false;
+  }
+
+  std::string request = "GET /metrics HTTP/1.1\r\nHost: " + host + "\r\nConnection: close\r\n\r\n";
+  send(sock, request.data(), request.size(), 0);
+  response.clear();
+  char buffer[4096];
+  ssize_t received;
+  while ((received = recv(sock, buffer, sizeof(buffer), 0)) > 0) response.append(buffer, received);
+  close(sock);
+  return true;
+}
+
+// Function to split "name{labels} value" into its parts; false if malformed
+static bool parseSample(const std::string& text, std::string& name, std::string& labels, double& value) {
+  size_t end = text.find_first_of("{ ");
+  if (end == std::string::npos || end == 0) return false;
+  name = text.substr(0, end);
+  labels.clear();
+  if (text[end] == '{') {
+    size_t close = text.find('}', end);
+    if (close == std::string::npos) return false;
+    labels = text.substr(end, close - end + 1);
+    end = close + 1;
+  }
+  if (end >= text.size() || text[end] != ' ') return false;
+  const char* start = text.c_str() + end + 1;
+  char* stop;
+  value = strtod(start, &stop);
+  return stop != start && *stop == '\0';
+}
+
+// Function to get the le bound of a bucket's labels ("+Inf" as infinity); false without one
+static bool bucketBound(const std::string& labels, double& bound) {
+  size_t at = labels.find("le=\"");
+  if (at == std::string::npos) return false;
+  std::string text = labels.substr(at + 4, labels.find('"', at + 4) - at - 4);
+  bound = text == "+Inf" ? HUGE_VAL : strtod(text.c_str(), nullptr);
+  return true;
+}
+
+struct Scrape {
+  size_t bytes = 0;
+  int families = 0, samples = 0;
+  std::map<std::string, double> counters;   // name{labels} -> value
+  double uptime = -1;
+};
+
+// Function to check one /metrics body
+static void checkBody(const std::string& body, Scrape& scrape) {
+  scrape.bytes = body.size();
+  if (!body.empty() && body.back() != '\n') fail(0, "last line incomplete", body.substr(body.rfind('\n') + 1));
+
+  std::set<std::string> typed, seen;
+  std::string family, type;
+  bool familyHasSamples = true;
+  double lastBound = 0, lastBucket = 0, bucketCount = -1;
+  bool histogramSum = false;
+  int lineNumber = 0;
+
+  // Histogram wrap-up when its family ends
+  auto endFamily = [&](int line) {
+    if (!familyHasSamples) fail(line, "# TYPE without samples", family);
+    if (type != "histogram") return;
+    if (bucketCount < 0) fail(line, "histogram without +Inf bucket", family);
+    if (!histogramSum) fail(line, "histogram without _sum", family);
+  };
+
+  size_t start = 0;
+  while (start < body.size()) {
+    size_t end = body.find('\n', start);
+    if (end == std::string::npos) break;
+    std::string line = body.substr(start, end - start);
+    start = end + 1;
+    lineNumber++;
+    if (line.empty()) continue;
+
+    if (line[0] == '#') {
+      char name[128], kind[32];
+      if (sscanf(line.c_str(), "# TYPE %127s %31s", name, kind) != 2) continue; // HELP and comments
+      if (!family.empty()) endFamily(lineNumber);
+      family = name;
+      type = kind;
+      if (!typed.insert(family).second) fail(lineNumber, "family typed twice", family);
+      if (type == "counter" && (family.size() < 6 || family.compare(family.size() - 6, 6, "_total") != 0)) {
+        fail(lineNumber, "counter name without _total", family);
+      }
+      if (type != "counter" && type != "gauge" && type != "histogram" && type != "summary" && type != "untyped") {
+        fail(lineNumber, "unknown type", type);
+      }
+      familyHasSamples = false;
+      lastBound = -HUGE_VAL;
+      lastBucket = 0;
+      bucketCount = -1;
+      histogramSum = false;
+      scrape.families++;
+      continue;
+    }
+
+    std::string name, labels;
+    double value;
+    if (!parseSample(line, name, labels, value)) {
+      fail(lineNumber, "malformed sample", line);
+      continue;
+    }
+    scrape.samples++;
+    familyHasSamples = true;
+    if (!seen.insert(name + labels).second) fail(lineNumber, "sample repeated", name + labels);
+
+    std::string base = name;
+    if (type == "histogram") {
+      for (const char* suffix : { "_bucket", "_sum", "_count" }) {
+        size_t length = strlen(suffix);
+        if (name.size() > length && name.compare(name.size() - length, length, suffix) == 0) {
+          base = name.substr(0, name.size() - length);
+        }
+      }
+    }
+    if (family.empty() || base != family) {
+      fail(lineNumber, "sample not under its # TYPE", name);
+      continue;
+    }
+
+    if (type == "counter") scrape.counters[name + labels] = value;
+    if (name == "nyan_uptime_seconds") scrape.uptime = value;
+    if (type != "histogram") continue;
+
+    double bound;
+    if (name == family + "_bucket") {
+      if (!bucketBound(labels, bound)) {
+        fail(lineNumber, "bucket without le", line);
+        continue;
+      }
+      if (bound <= lastBound || value < lastBucket) fail(lineNumber, "buckets not cumulative", line);
+      if (bound == HUGE_VAL) bucketCount = value;
+      lastBound = bound;
+      lastBucket = value;
+    } else if (name == family + "_sum") {
+      histogramSum = true;
+    } else if (name == family + "_count") {
+      if (value != bucketCount) fail(lineNumber, "_count differs from the +Inf bucket", line);
+    } else {
+      fail(lineNumber, "histogram sample without _bucket/_sum/_count", line);
+    }
+  }
+  if (!family.empty()) endFamily(lineNumber);
+}
+
+// Function to check a full HTTP response (or a bare body); false if it is not a 200
+static bool checkResponse(const std::string& response, Scrape& scrape) {
+  std::string body = response;
+  if (response.compare(0, 5, "HTTP/") == 0) {
+    size_t headerEnd = response.find("\r\n\r\n");
+    int status = 0;
+    sscanf(response.c_str(), "HTTP/%*s %d", &status);
+    body = headerEnd == std::string::npos ? "" : response.substr(headerEnd + 4);
+    if (status != 200) {
+      fail(0, "status", std::to_string(status) + " " + body);
+      return false;
+    }
+  }
+  checkBody(body, scrape);
+  return true;
+}
+
+// Function to compare counters with the previous scrape
+static void checkCounters(const Scrape& previous, const Scrape& current) {
+  if (current.uptime >= 0 && current.uptime < previous.uptime) {
+    printf("  uptime went from %.3f to %.3f s: rebooted, counters restart\n", previous.uptime, current.uptime);
+    return;
+  }
+  for (const auto& counter : current.counters) {
+    auto before = previous.counters.find(counter.first);
+    if (before != previous.counters.end() && counter.second < before->second) {
+      fail(0, "counter went down", counter.first);
+    }
+  }
+}
+
+static void printScrape(int index, const Scrape& scrape, double millis) {
+  printf("scrape %d: %zu bytes (%zu left in the %zu byte buffer), %d families, %d samples",
+         index, scrape.bytes, scrape.bytes < METRICS_BUFFER_BYTES ? METRICS_BUFFER_BYTES - scrape.bytes : 0,
+         METRICS_BUFFER_BYTES, scrape.families, scrape.samples);
+  if (millis >= 0) printf(", %.1f ms", millis);
+  printf("\n");
+}
+
+int main(int argc, char** argv) {
+  if (argc < 2) {
+    fprintf(stderr, "usage: %s <host>[:port] [scrapes] [interval-ms]\n       %s <response.txt|->\n", argv[0], argv[0]);
+    return 2;
+  }
+  std::string target = argv[1];
+
+  // A saved response: file or stdin
+  FILE* input = target == "-" ? stdin : fopen(target.c_str(), "rb");
+  if (input) {
+    std::string response;
+    char buffer[4096];
+    size_t length;
+    while ((length = fread(buffer, 1, sizeof(buffer), input)) > 0) response.append(buffer, length);
+    if (input != stdin) fclose(input);
+    Scrape scrape;
+    if (checkResponse(response, scrape)) printScrape(1, scrape, -1);
+  } else {
+    size_t colon = target.rfind(':');
+    std::string host = colon == std::string::npos ? target : target.substr(0, colon);
+    std::string port = colon == std::string::npos ? "80" : target.substr(colon + 1);
+    int scrapes = argc > 2 ? atoi(argv[2]) : 1;
+    int interval = argc > 3 ? atoi(argv[3]) : 1000;
+
+    Scrape previous;
+    for (int i = 1; i <= scrapes; i++) {
+      auto start = std::chrono::steady_clock::now();
+      std::string response;
+      if (!fetch(host, port, response)) return 1;
+      double millis = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+      Scrape scrape;
+      if (!checkResponse(response, scrape)) break;
+      printScrape(i, scrape, millis);
+      if (i > 1) checkCounters(previous, scrape);
+      previous = scrape;
+      if (i < scrapes) std::this_thread::sleep_for(std::chrono::milliseconds(interval));
+    }
+  }
+  printf("%s\n", errors ? "FAILED" : "ok");
+  return errors ? 1 : 0;
+}
@@ -0,0 +1,87 @@
+/*************************************************************
+*********************** PNG I/O (HOST) ***********************
+**************************************************************/
+
+#include <stdio.h>
+#include "png_io.h"
+#include "anim_container.h" // crc32Update (same CRC-32 as PNG)
+
+static void putBigEndian(std::vector<uint8_t>& out, uint32_t value) {
+  out.push_back(value >> 24);
+  out.push_back(value >> 16);
+  out.push_back(value >> 8);
+  out.push_back(value);
+}
+
+static void putChunk(std::vector<uint8_t>& out, const char* type, const std::vector<uint8_t>& data) {
+  putBigEndian(out, (uint32_t)data.size());
+  size_t start = out.size();
+  out.insert(out.end(), type, type + 4);
+  out.insert(out.end(), data.begin(), data.end());
+  putBigEndian(out, crc32Update(0, out.data() + start, out.size() - start));
+}
+
+// Function to wrap raw bytes in a zlib stream of stored (uncompressed) deflate blocks
+static std::vector<uint8_t> zlibStored(const std::vector<uint8_t>& raw) {
+  std::vector<uint8_t> out = { 0x78, 0x01 };
+  size_t offset = 0;
+  do {
+    size_t length = raw.size() - offset < 65535 ? raw.size() - offset : 65535;
+    bool last = offset + length == raw.size();
+    out.push_back(last ? 1 : 0);
+    out.push_back(length & 0xFF);
+    out.push_back(length >> 8);
+    out.push_back(~length & 0xFF);
+    out.push_back((~length >> 8) & 0xFF);
+    out.insert(out.end(), raw.begin() + offset, raw.begin() + offset + length);
+    offset += length;
+  } while (offset < raw.size());
+
+  uint32_t a = 1, b = 0;
+  for (uint8_t byte : raw) {
+    a = (a + byte) % 65521;
+    b = (b + a) % 65521;
+  }
+  putBigEndian(out, (b << 16) | a);
+  return out;
+}
+
+bool savePng(const std::string& path, int width, int height, const std::vector<uint16_t>& pixels, std::string& error) {
+  if (width <= 0 || height <= 0 || pixels.size() < (size_t)width * height) {
+    error = path + ": bad image size";
+    return false;
+  }
+
+  // Scanlines: filter byte 0, then RGB888 expanded from RGB565
+  std::vector<uint8_t> raw;
+  raw.reserve((size_t)height * (1 + width * 3));
+  for (int y = 0; y < height; y++) {
+    raw.push_back(0);
+    for (int x = 0; x < width; x++) {
+      uint16_t pixel = pixels[(size_t)y * width + x];
+      uint8_t r = pixel >> 11, g = (pixel >> 5) & 0x3F, b = pixel & 0x1F;
+      raw.push_back((r << 3) | (r >> 2));
+      raw.push_back((g << 2) | (g >> 4));
+      raw.push_back((b << 3) | (b >> 2));
+    }
+  }
+
+  std::vector<uint8_t> header;
+  putBigEndian(header, width);
+  putBigEndian(header, height);
+  header.insert(header.end(), { 8, 2, 0, 0, 0 }); // 8-bit RGB, no interlace
+
+  std::vector<uint8_t> file = { 0x89, 'P', 'N', 'G', '\r', '\n', 0x1A, '\n' };
+  putChunk(file, "IHDR", header);
+  putChunk(file, "IDAT", zlibStored(raw));
+  putChunk(file, "IEND", {});
+
+  FILE* output = fopen(path.c_str(), "wb");
+  if (!output || fwrite(file.data(), 1, file.size(), output) != file.size()) {
+    if (output) fclose(output);
+    error = path + ": cannot write";
+    return false;
+  }
+  fclose(output);
+  return true;
+}
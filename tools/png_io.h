@@ -0,0 +1,14 @@
+/*************************************************************
+*********************** PNG I/O (HOST) ***********************
+**************************************************************/
+
+// Writing RGB565 images as PNG on the host (no zlib dependency)
+
+#pragma once
+
+#include <stdint.h>
+#include <string>
+#include <vector>
+
+// Save width*height native-order RGB565 pixels as an 8-bit RGB PNG
+bool savePng(const std::string& path, int width, int height, const std::vector<uint16_t>& pixels, std::string& error);
@@ -0,0 +1,278 @@
+/*************************************************************
+******************* REMOTE SENDER (HOST) *********************
+**************************************************************/
+
+/*
+Reference sender for remote-display mode, plus a loopback benchmark.
+
+  remote_sender send <device-ip> [fps] [seconds]
+  remote_sender bench [fps] [seconds]
+
+The sender renders a synthetic dashboard, finds the 32x10 tiles that changed
+since the previous frame, RLE565-codes them into packets and reports
+end-to-end latency from the device acks. 'bench' runs the firmware's jitter
+buffer and decoder (remote_frame.cpp) in a receiver thread on 127.0.0.1,
+showing frames on the framebuffer display backend.
+*/
+
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <sys/socket.h>
+#include <unistd.h>
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <thread>
+#include <vector>
+#include "display_backend.h"
+#include "remote_frame.h"
+#include "rle565.h"
+
+const int FRAME_WIDTH = 320;
+const int FRAME_HEIGHT = 170;
+const int TILE_WIDTH = 32;
+const int TILE_HEIGHT = 10;
+const int KEYFRAME_INTERVAL = 120; // frames
+
+static uint32_t nowMicros() {
+  return (uint32_t)std::chrono::duration_cast<std::chrono::microseconds>(
+      std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+static uint16_t swap565(uint16_t colour) {
+  return (uint16_t)((colour << 8) | (colour >> 8));
+}
+
+static uint16_t rgb565(int r, int g, int b) {
+  return (uint16_t)(((r & 0xF8) << 8) | ((g & 0xFC) << 3) | (b >> 3));
+}
+
+// Function to render the synthetic dashboard for frame n (sprite byte order)
+static void renderDashboard(std::vector<uint16_t>& frame, uint32_t n) {
+  for (int y = 0; y < FRAME_HEIGHT; y++) {
+    for (int x = 0; x < FRAME_WIDTH; x++) {
+      frame[y * FRAME_WIDTH + x] = swap565(rgb565(x * 255 / FRAME_WIDTH / 4, 20, 40 + y / 2));
+    }
+  }
+
+  // Moving alert box and a level bar
+  int boxX = (int)(n * 3 % (FRAME_WIDTH - 40));
+  for (int y = 60; y < 100; y++) {
+    for (int x = boxX; x < boxX + 40; x++) frame[y * FRAME_WIDTH + x] = swap565(rgb565(255, 80, 0));
+  }
+  int level = (int)(FRAME_WIDTH * (0.5 + 0.5 * ((n % 100) / 100.0)));
+  for (int y = 150; y < 160; y++) {
+    for (int x = 0; x < level; x++) frame[y * FRAME_WIDTH + x] = swap565(rgb565(0, 255, 0));
+  }
+}
+
+struct SenderStats {
+  uint32_t framesSent = 0, packetsSent = 0, acks = 0, keyframeRequests = 0;
+  uint64_t bytesSent = 0;
+  std::vector<uint32_t> latencies;
+  std::vector<uint32_t> holds;
+};
+
+// Function to packetise the changed tiles of one frame; returns packet count
+static int sendFrame(int sock, const sockaddr_in& device, const std::vector<uint16_t>& frame,
+                     const std::vector<uint16_t>& previous, bool keyframe, uint32_t frameId, SenderStats& stats) {
+  struct Strip { int x, y, w, h; };
+  std::vector<Strip> strips;
+
+  // Horizontal runs of changed tiles per tile row
+  for (int ty = 0; ty < FRAME_HEIGHT; ty += TILE_HEIGHT) {
+    int th = std::min(TILE_HEIGHT, FRAME_HEIGHT - ty);
+    int runStart = -1;
+    for (int tx = 0; tx <= FRAME_WIDTH; tx += TILE_WIDTH) {
+      bool dirty = false;
+      if (tx < FRAME_WIDTH) {
+        dirty = keyframe;
+        for (int y = ty; y < ty + th && !dirty; y++) {
+          dirty = memcmp(&frame[y * FRAME_WIDTH + tx], &previous[y * FRAME_WIDTH + tx], TILE_WIDTH * 2) != 0;
+        }
+      }
+      if (dirty && runStart < 0) runStart = tx;
+      if (!dirty && runStart >= 0) {
+        strips.push_back({ runStart, ty, tx - runStart, th });
+        runStart = -1;
+      }
+    }
+  }
+
+  // Encode strips, splitting rows until each fits one packet
+  const size_t capacity = REMOTE_MAX_PACKET - sizeof(RemotePacketHeader);
+  struct Packet { Strip strip; uint8_t flags; std::vector<uint8_t> payload; };
+  std::vector<Packet> packets;
+  std::vector<uint8_t> scratch(capacity);
+  for (size_t i = 0; i < strips.size(); i++) {
+    Strip strip = strips[i];
+    const uint16_t* origin = &frame[strip.y * FRAME_WIDTH + strip.x];
+    size_t length = rle565EncodeRect(origin, FRAME_WIDTH, strip.w, strip.h, scratch.data(), capacity);
+    if (length) {
+      packets.push_back({ strip, REMOTE_FLAG_RLE, std::vector<uint8_t>(scratch.begin(), scratch.begin() + length) });
+    } else if (strip.h > 1) {
+      strips.push_back({ strip.x, strip.y, strip.w, strip.h / 2 });
+      strips.push_back({ strip.x, strip.y + strip.h / 2, strip.w, strip.h - strip.h / 2 });
+    } else {
+      // Single incompressible row: split columns and send raw
+      int columns = (int)(capacity / 2);
+      for (int x = 0; x < strip.w; x += columns) {
+        int w = std::min(columns, strip.w - x);
+        const uint8_t* raw = (const uint8_t*)(origin + x);
+        packets.push_back({ { strip.x + x, strip.y, w, 1 }, 0, std::vector<uint8_t>(raw, raw + w * 2) });
+      }
+    }
+  }
+
+  uint32_t senderMicros = nowMicros();
+  uint8_t datagram[REMOTE_MAX_PACKET];
+  for (size_t i = 0; i < packets.size(); i++) {
+    const Packet& packet = packets[i];
+    RemotePacketHeader header;
+    remotePacketInit(header, frameId, (uint16_t)i, (uint16_t)packets.size(), senderMicros,
+                     packet.flags | (keyframe ? REMOTE_FLAG_KEYFRAME : 0),
+                     packet.strip.x, packet.strip.y, packet.strip.w, packet.strip.h,
+                     (uint16_t)packet.payload.size());
+    memcpy(datagram, &header, sizeof(header));
+    memcpy(datagram + sizeof(header), packet.payload.data(), packet.payload.size());
+    size_t length = sizeof(header) + packet.payload.size();
+    sendto(sock, datagram, length, 0, (const sockaddr*)&device, sizeof(device));
+    stats.bytesSent += length;
+  }
+  stats.packetsSent += packets.size();
+  stats.framesSent++;
+  return (int)packets.size();
+}
+
+// Function to collect acks without blocking; returns true if a keyframe was requested
+static bool drainAcks(int sock, SenderStats& stats) {
+  bool keyframe = false;
+  RemoteAck ack;
+  ssize_t length;
+  while ((length = recv(sock, &ack, sizeof(ack), MSG_DONTWAIT)) == (ssize_t)sizeof(ack)) {
+    if (memcmp(ack.magic, "NYRA", 4) != 0) continue;
+    stats.acks++;
+    stats.latencies.push_back(nowMicros() - ack.senderMicros);
+    stats.holds.push_back(ack.holdMicros);
+    if (ack.flags & REMOTE_ACK_NEED_KEYFRAME) {
+      keyframe = true;
+      stats.keyframeRequests++;
+    }
+  }
+  return keyframe;
+}
+
+static uint32_t percentile(std::vector<uint32_t> values, double p) {
+  if (values.empty()) return 0;
+  std::sort(values.begin(), values.end());
+  return values[std::min(values.size() - 1, (size_t)(p * values.size()))];
+}
+
+static int runSender(const char* deviceAddress, int fps, int seconds) {
+  int sock = socket(AF_INET, SOCK_DGRAM, 0);
+  sockaddr_in device = {};
+  device.sin_family = AF_INET;
+  device.sin_port = htons(REMOTE_PORT);
+  if (inet_pton(AF_INET, deviceAddress, &device.sin_addr) != 1) {
+    fprintf(stderr, "bad address %s\n", deviceAddress);
+    return 1;
+  }
+
+  std::vector<uint16_t> frame(FRAME_WIDTH * FRAME_HEIGHT), previous(FRAME_WIDTH * FRAME_HEIGHT);
+  SenderStats stats;
+  bool keyframe = true;
+  uint32_t start = nowMicros();
+  uint32_t frameInterval = 1000000 / fps;
+  uint32_t totalFrames = (uint32_t)(fps * seconds);
+
+  for (uint32_t n = 0; n < totalFrames; n++) {
+    renderDashboard(frame, n);
+    sendFrame(sock, device, frame, previous, keyframe || n % KEYFRAME_INTERVAL == 0, n, stats);
+    previous.swap(frame);
+    keyframe = drainAcks(sock, stats);
+
+    // Pace to the target frame rate
+    uint32_t due = start + (n + 1) * frameInterval;
+    while ((int32_t)(due - nowMicros()) > 0) {
+      if (drainAcks(sock, stats)) keyframe = true;
+      usleep(500);
+    }
+  }
+  usleep(200000);
+  drainAcks(sock, stats);
+
+  double elapsed = (nowMicros() - start) / 1e6;
+  printf("frames %u  packets %u  acks %u  keyframe requests %u\n",
+         stats.framesSent, stats.packetsSent, stats.acks, stats.keyframeRequests);
+  printf("throughput %.1f KB/s (%.0f bytes/frame)\n",
+         stats.bytesSent / 1024.0 / elapsed, (double)stats.bytesSent / std::max(1u, stats.framesSent));
+  printf("end-to-end latency  p50 %.2f ms  p95 %.2f ms  max %.2f ms\n",
+         percentile(stats.latencies, 0.5) / 1e3, percentile(stats.latencies, 0.95) / 1e3,
+         percentile(stats.latencies, 1.0) / 1e3);
+  printf("device hold time    p50 %.2f ms  p95 %.2f ms\n",
+         percentile(stats.holds, 0.5) / 1e3, percentile(stats.holds, 0.95) / 1e3);
+  close(sock);
+  return 0;
+}
+
+// Function to emulate the device on loopback with the firmware's jitter buffer
+static void runLoopbackReceiver(std::atomic<bool>& running, std::atomic<bool>& ready) {
+  int sock = socket(AF_INET, SOCK_DGRAM, 0);
+  sockaddr_in local = {};
+  local.sin_family = AF_INET;
+  local.sin_port = htons(REMOTE_PORT);
+  local.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+  bind(sock, (sockaddr*)&local, sizeof(local));
+  int bufferSize = 1 << 20;
+  setsockopt(sock, SOL_SOCKET, SO_RCVBUF, &bufferSize, sizeof(bufferSize));
+  ready = true;
+
+  std::vector<RemoteSlot> slots(REMOTE_SLOTS);
+  std::vector<uint16_t> framebuffer(FRAME_WIDTH * FRAME_HEIGHT);
+  RemoteJitterBuffer buffer;
+  remoteJitterInit(buffer, slots.data());
+  FramebufferBackend panel;
+  panel.begin(FRAME_WIDTH, FRAME_HEIGHT, framebuffer.data());
+  uint8_t datagram[REMOTE_MAX_PACKET];
+  sockaddr_in sender = {};
+
+  while (running) {
+    socklen_t senderLength = sizeof(sender);
+    ssize_t length;
+    while ((length = recvfrom(sock, datagram, sizeof(datagram), MSG_DONTWAIT, (sockaddr*)&sender, &senderLength)) > 0) {
+      remoteJitterPush(buffer, datagram, (size_t)length, nowMicros());
+    }
+    RemoteAck ack;
+    if (remoteJitterApply(buffer, framebuffer.data(), FRAME_WIDTH, FRAME_HEIGHT, nowMicros(), ack)) {
+      panel.pushFrame(framebuffer.data());
+      panel.waitIdle(); // acked once on the panel, as on the device
+      sendto(sock, &ack, sizeof(ack), 0, (sockaddr*)&sender, sizeof(sender));
+    }
+    usleep(1000); // roughly one render loop per millisecond
+  }
+  printf("receiver: shown %u  dropped %u  rejected %u  decode errors %u  panel frames %u\n",
+         buffer.stats.framesShown, buffer.stats.framesDropped, buffer.stats.packetsRejected, buffer.stats.decodeErrors,
+         panel.frames());
+  close(sock);
+}
+
+int main(int argc, char** argv) {
+  if (argc >= 3 && strcmp(argv[1], "send") == 0) {
+    return runSender(argv[2], argc > 3 ? atoi(argv[3]) : 30, argc > 4 ? atoi(argv[4]) : 10);
+  }
+  if (argc >= 2 && strcmp(argv[1], "bench") == 0) {
+    std::atomic<bool> running(true), ready(false);
+    std::thread receiver(runLoopbackReceiver, std::ref(running), std::ref(ready));
+    while (!ready) usleep(1000);
+    int result = runSender("127.0.0.1", argc > 2 ? atoi(argv[2]) : 30, argc > 3 ? atoi(argv[3]) : 5);
+    running = false;
+    receiver.join();
+    return result;
+  }
+  fprintf(stderr, "usage: %s send <device-ip> [fps] [seconds]\n"
+                  "       %s bench [fps] [seconds]\n", argv[0], argv[0]);
+  return 2;
+}
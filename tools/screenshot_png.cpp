@@ -0,0 +1,128 @@
+/*************************************************************
+****************** SCREENSHOT DECODER (HOST) *****************
+**************************************************************/
+
+/*
+Convert a screenshot from the clock into a PNG. The input is either the
+raw HTTP response or a serial log containing a "SHOT BEGIN".."SHOT END"
+block (the last complete block is used):
+
+  curl -o shot.bin http://<clock-ip>/screenshot
+  screenshot_png shot.bin shot.png
+
+  pio device monitor | tee serial.log     (type "screenshot")
+  screenshot_png serial.log shot.png
+*/
+
+#include <stdio.h>
+#include <string.h>
+#include <string>
+#include <vector>
+#include "screenshot_codec.h"
+#include "png_io.h"
+
+// Function to decode one base64 line; false on invalid characters
+static bool appendBase64(const char* text, std::vector<uint8_t>& out) {
+  uint32_t group = 0;
+  int bits = 0;
+  for (; *text && *text != '\r' && *text != '\n'; text++) {
+    char c = *text;
+    int value;
+    if (c >= 'A' && c <= 'Z') value = c - 'A';
+    else if (c >= 'a' && c <= 'z') value = c - 'a' + 26;
+    else if (c >= '0' && c <= '9') value = c - '0' + 52;
+    else if (c == '+') value = 62;
+    else if (c == '/') value = 63;
+    else if (c == '=') break;
+    else return false;
+    group = (group << 6) | value;
+    bits += 6;
+    if (bits >= 8) {
+      bits -= 8;
+      out.push_back((group >> bits) & 0xFF);
+    }
+  }
+  return true;
+}
+
+// Function to extract the last complete SHOT block from a serial log
+static bool extractFromLog(const std::vector<uint8_t>& log, std::vector<uint8_t>& stream) {
+  std::string text(log.begin(), log.end());
+  std::vector<uint8_t> current;
+  bool inside = false, found = false;
+
+  size_t start = 0;
+  while (start < text.size()) {
+    size_t end = text.find('\n', start);
+    if (end == std::string::npos) end = text.size();
+    std::string line = text.substr(start, end - start);
+    start = end + 1;
+
+    // Other output may share the line start (e.g. monitor timestamps)
+    size_t shot = line.find("SHOT ");
+    if (shot == std::string::npos) continue;
+    const char* payload = line.c_str() + shot + 5;
+
+    if (strncmp(payload, "BEGIN", 5) == 0) {
+      current.clear();
+      inside = true;
+    } else if (strncmp(payload, "END", 3) == 0) {
+      if (inside) {
+        stream = current;
+        found = true;
+      }
+      inside = false;
+    } else if (inside && !appendBase64(payload, current)) {
+      inside = false; // corrupted line, skip the block
+    }
+  }
+  return found;
+}
+
+int main(int argc, char** argv) {
+  if (argc != 3) {
+    fprintf(stderr, "usage: %s <screenshot.bin|serial.log> <output.png>\n", argv[0]);
+    return 2;
+  }
+
+  FILE* input = fopen(argv[1], "rb");
+  if (!input) {
+    fprintf(stderr, "%s: cannot open\n", argv[1]);
+    return 1;
+  }
+  std::vector<uint8_t> data;
+  uint8_t buffer[65536];
+  size_t length;
+  while ((length = fread(buffer, 1, sizeof(buffer), input)) > 0) {
+    data.insert(data.end(), buffer, buffer + length);
+  }
+  fclose(input);
+
+  std::vector<uint8_t> stream;
+  if (data.size() >= 4 && memcmp(data.data(), "NYSS", 4) == 0) {
+    stream = data;
+  } else if (!extractFromLog(data, stream)) {
+    fprintf(stderr, "%s: no screenshot found\n", argv[1]);
+    return 1;
+  }
+
+  int width, height;
+  if (!screenshotReadHeader(stream.data(), stream.size(), width, height)) {
+    fprintf(stderr, "%s: bad screenshot header\n", argv[1]);
+    return 1;
+  }
+  std::vector<uint16_t> pixels((size_t)width * height);
+  if (!screenshotDecode(stream.data(), stream.size(), pixels.data())) {
+    fprintf(stderr, "%s: screenshot truncated or corrupt\n", argv[1]);
+    return 1;
+  }
+
+  std::string error;
+  if (!savePng(argv[2], width, height, pixels, error)) {
+    fprintf(stderr, "%s\n", error.c_str());
+    return 1;
+  }
+  printf("%s: %dx%d, %zu bytes compressed (%.1f%% of raw)\n", argv[2], width, height, stream.size(),
+         100.0 * stream.size() / (width * height * 2));
+  return 0;
+}
@@ -0,0 +1,281 @@
+/*************************************************************
+******************* STREAM CLIENT (HOST) *********************
+**************************************************************/
+
+/*
+Viewer and throughput meter for GET /stream (format in fb_stream.h):
+
+  stream_client <host>[:port] [seconds] [last.png]
+
+The chunked response is de-chunked and parsed as a byte stream (frames
+and rects need not line up with chunks). The client keeps its own copy of
+the framebuffer and checks the stream:
+ - every frame starts with "NYFB", the first one is a keyframe and keyframes
+   cover the whole frame
+ - sequence numbers are consecutive and the size never changes
+ - every rect lies inside the frame
+Prints frames, keyframes/deltas, rects and bytes per second, then totals,
+and optionally saves the last complete frame as a PNG. Exits 1 on any
+error. The server side runs on the device only (web_server.cpp sits on
+WiFiClient), so this measures the real stream over the network.
+*/
+
+#include <netdb.h>
+#include <sys/socket.h>
+#include <sys/time.h>
+#include <unistd.h>
+#include <algorithm>
+#include <chrono>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <string>
+#include <vector>
+#include "png_io.h"
+
+const int STREAM_HEADER_BYTES = 16;
+const int STREAM_RECT_BYTES = 8;
+
+static int errors = 0;
+
+static void fail(const char* what, uint32_t sequence) {
+  if (++errors <= 20) printf("  frame %u: %s\n", (unsigned)sequence, what);
+}
+
+static uint16_t readU16(const uint8_t* p) {
+  return (uint16_t)(p[0] | p[1] << 8);
+}
+
+static uint32_t readU32(const uint8_t* p) {
+  return (uint32_t)p[0] | (uint32_t)p[1] << 8 | (uint32_t)p[2] << 16 | (uint32_t)p[3] << 24;
+}
+
+// Function to connect and send GET /stream; returns the socket or -1
+static int openStream(const std::string& host, const std::string& port) {
+  addrinfo hints = {}, *addresses = nullptr;
+  hints.ai_family = AF_UNSPEC;
+  hints.ai_socktype = SOCK_STREAM;
+  if (getaddrinfo(host.c_str(), port.c_str(), &hints, &addresses) != 0) {
+    fprintf(stderr, "%s: cannot resolve\n", host.c_str());
+    return -1;
+  }
+  int sock = -1;
+  for (addrinfo* address = addresses; address && sock < 0; address = address->ai_next) {
+    sock = socket(address->ai_family, address->ai_socktype, address->ai_protocol);
+    if (sock >= 0 && connect(sock, address->ai_addr, address->ai_addrlen) != 0) {
+      close(sock);
+      sock = -1;
+    }
+  }
+  freeaddrinfo(addresses);
+  if (sock < 0) {
+    fprintf(stderr, "%s:%s: cannot connect\n", host.c_str(), port.c_str());
+    return -1;
+  }
+  timeval timeout = { 1, 0 }; // recv wakes up at least once a second to check the deadline
+  setsockopt(sock, SOL_SOCKET, SO_RCVTIMEO, &timeout, sizeof(timeout));
+  std::string request = "GET /stream HTTP/1.1\r\nHost: " + host + "\r\nConnection: close\r\n\r\n";
+  send(sock, request.data(), request.size(), 0);
+  return sock;
+}
+
+// De-chunks the HTTP response into payload bytes
+struct Dechunker {
+  std::string input;          // received, not yet consumed
+  bool headersDone = false;
+  size_t chunkLeft = 0;       // payload bytes left in the current chunk
+  bool trailingCrlf = false;  // CRLF after the current chunk still to skip
+  bool ended = false;         // zero-length chunk seen
+  int status = 0;
+};
+
+// Function to move complete payload bytes from the dechunker into payload; false on a protocol error
+static bool dechunk(Dechunker& d, std::string& payload) {
+  if (!d.headersDone) {
+    size_t end = d.input.find("\r\n\r\n");
+    if (end == std::string::npos) return true;
+    sscanf(d.input.c_str(), "HTTP/%*s %d", &d.status);
+    std::string headers = d.input.substr(0, end);
+    d.input.erase(0, end + 4);
+    d.headersDone = true;
+    if (d.status != 200 || headers.find("Transfer-Encoding: chunked") == std::string::npos) {
+      printf("  response %d, not a chunked stream: %s\n", d.status, d.input.c_str());
+      return false;
+    }
+  }
+  while (!d.ended) {
+    if (d.chunkLeft) {
+      size_t take = std::min(d.chunkLeft, d.input.size());
+      payload.append(d.input, 0, take);
+      d.input.erase(0, take);
+      d.chunkLeft -= take;
+      if (d.chunkLeft) return true;
+      d.trailingCrlf = true;
+    }
+    if (d.trailingCrlf) {
+      if (d.input.size() < 2) return true;
+      if (d.input.compare(0, 2, "\r\n") != 0) return false;
+      d.input.erase(0, 2);
+      d.trailingCrlf = false;
+    }
+    size_t end = d.input.find("\r\n");
+    if (end == std::string::npos) return true;
+    d.chunkLeft = strtoul(d.input.c_str(), nullptr, 16);
+    d.input.erase(0, end + 2);
+    if (!d.chunkLeft) d.ended = true;
+  }
+  return true;
+}
+
+// Stream decoding state and counters
+struct Viewer {
+  int width = 0, height = 0;
+  std::vector<uint16_t> frame;     // native-order RGB565
+  bool haveKeyframe = false;
+  uint32_t nextSequence = 0;
+  uint64_t frames = 0, keyframes = 0, rects = 0, deltaRects = 0, bytes = 0;
+};
+
+// Function to take every complete stream frame off the front of payload
+static void decodeFrames(Viewer& viewer, std::string& payload) {
+  size_t at = 0;
+  while (payload.size() - at >= STREAM_HEADER_BYTES) {
+    const uint8_t* header = (const uint8_t*)payload.data() + at;
+    uint8_t type = header[4];
+    uint16_t count = readU16(header + 6);
+    uint32_t sequence = readU32(header + 8);
+    int width = readU16(header + 12), height = readU16(header + 14);
+    if (memcmp(header, "NYFB", 4) != 0 || type > 1) {
+      fail("bad frame header, stream out of step", sequence);
+      payload.clear();
+      return;
+    }
+
+    // Wait until the whole frame is here
+    size_t end = at + STREAM_HEADER_BYTES;
+    bool complete = true;
+    for (uint16_t i = 0; i < count; i++) {
+      if (payload.size() < end + STREAM_RECT_BYTES) {
+        complete = false;
+        break;
+      }
+      const uint8_t* rect = (const uint8_t*)payload.data() + end;
+      end += STREAM_RECT_BYTES + (size_t)readU16(rect + 4) * readU16(rect + 6) * 2;
+    }
+    if (!complete || payload.size() < end) break;
+
+    if (!viewer.haveKeyframe) {
+      if (type != 0) fail("stream does not start with a keyframe", sequence);
+      viewer.width = width;
+      viewer.height = height;
+      viewer.frame.assign((size_t)width * height, 0);
+      viewer.nextSequence = sequence;
+      viewer.haveKeyframe = true;
+    }
+    if (width != viewer.width || height != viewer.height) fail("frame size changed", sequence);
+    if (sequence != viewer.nextSequence) fail("sequence skipped", sequence);
+    viewer.nextSequence = sequence + 1;
+
+    // Apply the rects; a keyframe must cover every row
+    size_t rectAt = at + STREAM_HEADER_BYTES;
+    int rowsCovered = 0;
+    for (uint16_t i = 0; i < count; i++) {
+      const uint8_t* rect = (const uint8_t*)payload.data() + rectAt;
+      int x = readU16(rect), y = readU16(rect + 2), w = readU16(rect + 4), h = readU16(rect + 6);
+      const uint8_t* pixels = rect + STREAM_RECT_BYTES;
+      rectAt += STREAM_RECT_BYTES + (size_t)w * h * 2;
+      if (x + w > viewer.width || y + h > viewer.height) {
+        fail("rect outside the frame", sequence);
+        continue;
+      }
+      if (x == 0 && w == viewer.width) rowsCovered += h;
+      for (int row = 0; row < h; row++) {
+        for (int column = 0; column < w; column++) {
+          const uint8_t* pixel = pixels + ((size_t)row * w + column) * 2;
+          viewer.frame[(size_t)(y + row) * viewer.width + x + column] = (uint16_t)(pixel[0] << 8 | pixel[1]);
+        }
+      }
+    }
+    if (type == 0 && rowsCovered < viewer.height) fail("keyframe does not cover the frame", sequence);
+
+    viewer.frames++;
+    viewer.keyframes += type == 0;
+    viewer.rects += count;
+    if (type == 1) viewer.deltaRects += count;
+    viewer.bytes += end - at;
+    at = end;
+  }
+  payload.erase(0, at);
+}
+
+int main(int argc, char** argv) {
+  if (argc < 2) {
+    fprintf(stderr, "usage: %s <host>[:port] [seconds] [last.png]\n", argv[0]);
+    return 2;
+  }
+  std::string target = argv[1];
+  size_t colon = target.rfind(':');
+  std::string host = colon == std::string::npos ? target : target.substr(0, colon);
+  std::string port = colon == std::string::npos ? "80" : target.substr(colon + 1);
+  int seconds = argc > 2 ? atoi(argv[2]) : 10;
+
+  int sock = openStream(host, port);
+  if (sock < 0) return 1;
+
+  Dechunker dechunker;
+  Viewer viewer;
+  std::string payload;
+  auto start = std::chrono::steady_clock::now();
+  auto elapsed = [&] { return std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count(); };
+  Viewer lastSecond;
+  int reported = 0;
+  char buffer[16384];
+
+  while (elapsed() < seconds && !dechunker.ended) {
+    ssize_t received = recv(sock, buffer, sizeof(buffer), 0);
+    if (received == 0) {
+      printf("  connection closed by the clock\n");
+      break;
+    }
+    if (received > 0) {
+      dechunker.input.append(buffer, received);
+      if (!dechunk(dechunker, payload)) {
+        errors++;
+        break;
+      }
+      decodeFrames(viewer, payload);
+    }
+
+    // One line per second
+    if ((int)elapsed() > reported) {
+      reported = (int)elapsed();
+      printf("%3d s: %3u frames (%u key), %5u rects, %8.1f KB\n", reported, (unsigned)(viewer.frames - lastSecond.frames),
+             (unsigned)(viewer.keyframes - lastSecond.keyframes), (unsigned)(viewer.rects - lastSecond.rects),
+             (viewer.bytes - lastSecond.bytes) / 1024.0);
+      lastSecond.frames = viewer.frames;
+      lastSecond.keyframes = viewer.keyframes;
+      lastSecond.rects = viewer.rects;
+      lastSecond.bytes = viewer.bytes;
+    }
+  }
+  close(sock);
+
+  double time = elapsed();
+  uint64_t deltas = viewer.frames - viewer.keyframes;
+  printf("\n%dx%d, %.1f s: %llu frames (%.1f fps), %llu keyframes, %llu deltas (%.1f rects each), %.1f KB/s\n",
+         viewer.width, viewer.height, time, (unsigned long long)viewer.frames, viewer.frames / time,
+         (unsigned long long)viewer.keyframes, (unsigned long long)deltas,
+         deltas ? (double)viewer.deltaRects / deltas : 0.0,
+         viewer.bytes / 1024.0 / time);
+  if (!viewer.frames) fail("no complete frame received", 0);
+
+  if (argc > 3 && viewer.frames) {
+    std::string error;
+    if (!savePng(argv[3], viewer.width, viewer.height, viewer.frame, error)) {
+      fprintf(stderr, "%s: %s\n", argv[3], error.c_str());
+      errors++;
+    }
+  }
+  printf("%s\n", errors ? "FAILED" : "ok");
+  return errors ? 1 : 0;
+}
@@ -0,0 +1,129 @@
+/*************************************************************
+******************** SYNC BEACON (HOST) **********************
+**************************************************************/
+
+/*
+Host-side frame sync leader/follower using the same SyncClock as the firmware.
+
+  sync_beacon leader [framePeriodUs] [frameCount] [interface]
+  sync_beacon follower [interface]
+
+Several followers on one machine (interface 127.0.0.1, loopback multicast)
+share the leader's clock, so the offset a follower applies is directly its
+phase error. Followers print the applied offset and the frame index once per
+second; phase agreement is the spread of those offsets.
+*/
+
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <sys/socket.h>
+#include <unistd.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include "sync_clock.h"
+
+// Function to read the shared monotonic clock in milliseconds
+static uint32_t monotonicMillis() {
+  struct timespec now;
+  clock_gettime(CLOCK_MONOTONIC, &now);
+  return (uint32_t)((uint64_t)now.tv_sec * 1000 + now.tv_nsec / 1000000);
+}
+
+// Function to build the multicast group address
+static in_addr multicastGroup() {
+  const uint8_t group[4] = { SYNC_MULTICAST_GROUP };
+  in_addr address;
+  memcpy(&address.s_addr, group, 4);
+  return address;
+}
+
+static int runLeader(uint32_t framePeriodUs, uint16_t frameCount, const char* interfaceAddress) {
+  int sock = socket(AF_INET, SOCK_DGRAM, 0);
+  in_addr outgoing;
+  inet_pton(AF_INET, interfaceAddress, &outgoing);
+  setsockopt(sock, IPPROTO_IP, IP_MULTICAST_IF, &outgoing, sizeof(outgoing));
+  unsigned char loop = 1;
+  setsockopt(sock, IPPROTO_IP, IP_MULTICAST_LOOP, &loop, sizeof(loop));
+
+  sockaddr_in destination = {};
+  destination.sin_family = AF_INET;
+  destination.sin_port = htons(SYNC_PORT);
+  destination.sin_addr = multicastGroup();
+
+  uint32_t epoch = monotonicMillis();
+  printf("leader: period %u us, %u frames, epoch %u\n", framePeriodUs, frameCount, epoch);
+  fflush(stdout);
+  for (uint32_t sequence = 0;; sequence++) {
+    SyncBeacon beacon;
+    syncBeaconInit(beacon, sequence, monotonicMillis(), epoch, framePeriodUs, frameCount);
+    sendto(sock, &beacon, sizeof(beacon), 0, (sockaddr*)&destination, sizeof(destination));
+    usleep(SYNC_BEACON_INTERVAL * 1000);
+  }
+}
+
+static int runFollower(const char* interfaceAddress) {
+  int sock = socket(AF_INET, SOCK_DGRAM, 0);
+  int reuse = 1;
+  setsockopt(sock, SOL_SOCKET, SO_REUSEADDR, &reuse, sizeof(reuse));
+  setsockopt(sock, SOL_SOCKET, SO_REUSEPORT, &reuse, sizeof(reuse));
+
+  sockaddr_in local = {};
+  local.sin_family = AF_INET;
+  local.sin_port = htons(SYNC_PORT);
+  local.sin_addr.s_addr = htonl(INADDR_ANY);
+  if (bind(sock, (sockaddr*)&local, sizeof(local)) < 0) {
+    perror("bind");
+    return 1;
+  }
+
+  ip_mreq membership = {};
+  membership.imr_multiaddr = multicastGroup();
+  inet_pton(AF_INET, interfaceAddress, &membership.imr_interface);
+  if (setsockopt(sock, IPPROTO_IP, IP_ADD_MEMBERSHIP, &membership, sizeof(membership)) < 0) {
+    perror("IP_ADD_MEMBERSHIP");
+    return 1;
+  }
+
+  timeval timeout = { 0, 100000 };
+  setsockopt(sock, SOL_SOCKET, SO_RCVTIMEO, &timeout, sizeof(timeout));
+
+  SyncClock clock;
+  syncClockReset(clock);
+  uint32_t lastReport = monotonicMillis();
+  for (;;) {
+    SyncBeacon beacon;
+    ssize_t length = recv(sock, &beacon, sizeof(beacon), 0);
+    if (length > 0 && syncBeaconValid(&beacon, (int)length)) {
+      syncClockSample(clock, beacon, monotonicMillis());
+    }
+
+    uint32_t now = monotonicMillis();
+    if (now - lastReport >= 1000) {
+      lastReport = now;
+      if (clock.locked) {
+        uint64_t timeline = syncClockTimelineMicros(clock, now);
+        printf("frame %2u  phase %6.2f frames  offset %+d ms\n", syncClockFrame(clock, now),
+               (double)(timeline % clock.framePeriodUs) / clock.framePeriodUs, clock.offset);
+      } else {
+        printf("waiting for leader\n");
+      }
+      fflush(stdout);
+    }
+  }
+}
+
+int main(int argc, char** argv) {
+  if (argc >= 2 && strcmp(argv[1], "leader") == 0) {
+    uint32_t period = argc > 2 ? strtoul(argv[2], nullptr, 10) : 50000;
+    uint16_t frames = argc > 3 ? (uint16_t)strtoul(argv[3], nullptr, 10) : 17;
+    return runLeader(period, frames, argc > 4 ? argv[4] : "0.0.0.0");
+  }
+  if (argc >= 2 && strcmp(argv[1], "follower") == 0) {
+    return runFollower(argc > 2 ? argv[2] : "0.0.0.0");
+  }
+  fprintf(stderr, "usage: %s leader [framePeriodUs] [frameCount] [interface]\n"
+                  "       %s follower [interface]\n", argv[0], argv[0]);
+  return 2;
+}
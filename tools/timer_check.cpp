@@ -0,0 +1,195 @@
+/*************************************************************
+******************** TIMER WHEEL CHECK (HOST) ****************
+**************************************************************/
+
+/*
+Randomized check of timer_wheel.cpp against a brute-force scheduler:
+
+  timer_check [steps]
+
+Per step a random timer is armed (near, far, or beyond the wheel's span)
+or cancelled, then the wheel is advanced by a random amount. Callbacks
+cancel or re-arm other random timers, including ones due at the same
+tick. Checked against a plain list of deadlines:
+ - every callback is for an armed timer whose deadline has passed
+ - after each advance nothing due is left armed, and the armed flags and
+   armedCount match the list
+ - timerWheelNextDeadline() returns the earliest deadline in the list
+Run from three start times, one just before the millis() wrap, followed
+by fixed cases (a callback cancelling or re-arming a timer due at the
+same tick) and a periodic timer against its expected count.
+Exits 1 on any mismatch.
+*/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <vector>
+#include "timer_wheel.h"
+
+const int TIMER_CHECK_TIMERS = 300;
+
+struct Model {
+  bool armed;
+  uint32_t deadline;
+  int fires;
+};
+
+static TimerWheel wheel;
+static std::vector<Timer> timers;
+static std::vector<Model> model;
+static uint32_t now;
+static int errors = 0;
+static bool mutateInCallbacks = false;
+
+static void fail(const char* what, int id) {
+  if (++errors <= 10) printf("  %s: timer %d at %u\n", what, id, now);
+}
+
+// Function to arm a timer in the wheel and the model
+static void arm(int id, uint32_t delay) {
+  timerArm(wheel, timers[id], delay);
+  model[id] = { true, now + delay, model[id].fires };
+}
+
+static void cancel(int id) {
+  timerCancel(wheel, timers[id]);
+  model[id].armed = false;
+}
+
+// Function to get a random delay: mostly near, some far, a few beyond the wheel's span (min: at least this)
+static uint32_t randomDelay(uint32_t min) {
+  uint32_t delay = rand() % 3 ? rand() % 5000 : (rand() % 4 ? rand() % 3000000 : 20000000u + rand() % 1000);
+  return delay < min ? min : delay;
+}
+
+static void onFire(void* context) {
+  int id = (int)(intptr_t)context;
+  if (!model[id].armed) fail("fired while cancelled", id);
+  if ((int32_t)(now - model[id].deadline) < 0) fail("fired early", id);
+  model[id].armed = false;
+  model[id].fires++;
+
+  // Touch another timer (often one due at the same tick); new deadlines are after now so they wait
+  if (mutateInCallbacks && rand() % 2) {
+    int other = rand() % TIMER_CHECK_TIMERS;
+    if (rand() % 2) {
+      cancel(other);
+    } else {
+      arm(other, randomDelay(1));
+    }
+  }
+}
+
+// Function to compare the wheel with the model after an advance
+static void checkState() {
+  int armed = 0;
+  bool found = false;
+  uint32_t earliest = 0;
+  for (int k = 0; k < TIMER_CHECK_TIMERS; k++) {
+    if (timers[k].armed != model[k].armed) fail("armed flag differs", k);
+    if (!model[k].armed) continue;
+    armed++;
+    if ((int32_t)(now - model[k].deadline) >= 0) fail("due but not fired", k);
+    if (!found || (int32_t)(model[k].deadline - earliest) < 0) earliest = model[k].deadline;
+    found = true;
+  }
+  if (armed != wheel.armedCount) fail("armedCount differs", wheel.armedCount);
+  uint32_t next;
+  bool wheelFound = timerWheelNextDeadline(wheel, next);
+  if (wheelFound != found || (found && next != earliest)) fail("next deadline differs", -1);
+}
+
+// Function to start over with every timer disarmed at time start
+static void reset(uint32_t start) {
+  now = start;
+  timerWheelInit(wheel, now);
+  timers.assign(TIMER_CHECK_TIMERS, Timer());
+  model.assign(TIMER_CHECK_TIMERS, Model());
+  for (int k = 0; k < TIMER_CHECK_TIMERS; k++) timerInit(timers[k], "check", onFire, (void*)(intptr_t)k);
+}
+
+static void advance(uint32_t by) {
+  now += by;
+  timerWheelAdvance(wheel, now);
+  checkState();
+}
+
+static void randomRun(uint32_t start, int steps, bool mutate) {
+  reset(start);
+  srand(start + mutate);
+  mutateInCallbacks = mutate;
+  for (int step = 0; step < steps; step++) {
+    int id = rand() % TIMER_CHECK_TIMERS;
+    int op = rand() % 4;
+    if (op == 0) {
+      arm(id, randomDelay(0));
+    } else if (op == 1) {
+      cancel(id);
+    }
+    advance(1 + (rand() % 8 ? rand() % 40 : rand() % 200000));
+  }
+  mutateInCallbacks = false;
+  printf("random from %08x, %s: %d errors\n", start, mutate ? "callbacks arm/cancel others" : "plain", errors);
+}
+
+// Callbacks for the fixed cases: the first timer to run cancels (or re-arms) the other one
+static int sameTickMode = 0;
+static void onSameTick(void* context) {
+  int id = (int)(intptr_t)context;
+  model[id].armed = false;
+  model[id].fires++;
+  int other = id ^ 1;
+  if (model[other].fires == 0 && model[other].armed) {
+    if (sameTickMode == 0) {
+      cancel(other);
+    } else {
+      arm(other, 100);
+    }
+  }
+}
+
+static void sameTickCase(int mode) {
+  reset(0xFFFFFFF0u);
+  sameTickMode = mode;
+  timerInit(timers[0], "a", onSameTick, (void*)(intptr_t)0);
+  timerInit(timers[1], "b", onSameTick, (void*)(intptr_t)1);
+  arm(0, 20);
+  arm(1, 20);
+  advance(20);
+  int fired = model[0].fires + model[1].fires;
+  if (fired != 1) fail("same tick: both fired", fired);
+  if (mode == 1) {
+    advance(100);
+    if (model[0].fires + model[1].fires != 2) fail("same tick: re-armed timer did not fire once", -1);
+  }
+  printf("same tick, callback %s the other: %d errors\n", mode ? "re-arms" : "cancels", errors);
+}
+
+static void periodicCase() {
+  reset(123456);
+  timerArm(wheel, timers[0], 1000, 1000);
+  int fires = 0;
+  timers[0].callback = [](void* count) { (*(int*)count)++; };
+  timers[0].context = &fires;
+  uint32_t start = now;
+  for (int step = 0; step < 100000; step++) {
+    now += 33;
+    timerWheelAdvance(wheel, now);
+  }
+  int expected = (now - start) / 1000;
+  if (fires != expected || wheel.armedCount != 1) fail("periodic count", fires);
+  printf("periodic 1000 ms over %u ms: %d fires (expected %d): %d errors\n", now - start, fires, expected, errors);
+}
+
+int main(int argc, char** argv) {
+  int steps = argc > 1 ? atoi(argv[1]) : 200000;
+  for (uint32_t start : { 0u, 0xFFFF0000u, 123456u }) {
+    randomRun(start, steps, false);
+    randomRun(start, steps, true);
+  }
+  sameTickCase(0);
+  sameTickCase(1);
+  periodicCase();
+  printf("%s\n", errors ? "FAILED" : "ok");
+  return errors ? 1 : 0;
+}